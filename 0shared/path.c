@@ -7,146 +7,497 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "dynarray.h"
 #include "path.h"
 
-/* An absolute path */
+/*
+  An absolute path. Each path is a single allocation laid out as
+  this header, followed by an offset table of ulDepth+1 entries,
+  followed by a table of ulDepth prefix hashes,
+  followed by the pathname, followed by a copy of the pathname in
+  which each '/' delimiter is replaced by '\0' (so that every
+  component is available as a '\0'-terminated string in place).
+  The layout holds no pointers, so a path can be copied with memcpy.
+*/
 struct path {
-   /* The string representation of the path,
-      which uses '/' as the component delimiter */
-   const char *pcPath;
-   /* The string length of pcPath */
+   /* The string length of the pathname */
    size_t ulLength;
-   /* The ordered collection of component strings in the path */
-   DynArray_T oDComponents;
+   /* The number of components in the path */
+   size_t ulDepth;
 };
 
 /*
-  Frees pcStr. This wrapper is used to match the requirements of the
-  callback function pointer passed to DynArray_map. pvExtra is unused.
+  Returns the offset table of psPath. Entry i is the index into the
+  pathname at which component i begins; entry ulDepth is the sentinel
+  ulLength+1, so component i has length entry(i+1) - entry(i) - 1.
+*/
+static size_t *Path_offsets(const struct path *psPath) {
+   assert(psPath != NULL);
+
+   return (size_t *) (psPath + 1);
+}
+
+/*
+  Returns the prefix hash table of psPath. Entry i is the hash of the
+  prefix of psPath made up of components 0 through i, so the last
+  entry is the hash of the whole path. Prefix hashes are rolled
+  forward one component at a time, so a prefix of psPath has exactly
+  the corresponding entries of psPath's table.
+*/
+static size_t *Path_hashes(const struct path *psPath) {
+   assert(psPath != NULL);
+
+   return Path_offsets(psPath) + psPath->ulDepth + 1;
+}
+
+/* Returns the '/'-delimited pathname stored in psPath. */
+static char *Path_pathname(const struct path *psPath) {
+   assert(psPath != NULL);
+
+   return (char *) (Path_hashes(psPath) + psPath->ulDepth);
+}
+
+/* Returns the '\0'-delimited component strings stored in psPath. */
+static char *Path_components(const struct path *psPath) {
+   assert(psPath != NULL);
+
+   return Path_pathname(psPath) + psPath->ulLength + 1;
+}
+
+/*
+  Returns the number of bytes needed for a path with ulDepth
+  components and a pathname of string length ulLength.
+*/
+static size_t Path_allocSize(size_t ulDepth, size_t ulLength) {
+   return sizeof(struct path) + (2 * ulDepth + 1) * sizeof(size_t)
+      + 2 * (ulLength + 1);
+}
+
+/*
+  Allocates a path with room for ulDepth components and a pathname of
+  string length ulLength, and sets its header fields. Returns NULL if
+  memory could not be allocated.
+*/
+static struct path *Path_alloc(size_t ulDepth, size_t ulLength) {
+   struct path *psNew;
+
+   psNew = malloc(Path_allocSize(ulDepth, ulLength));
+   if(psNew == NULL)
+      return NULL;
+
+   psNew->ulLength = ulLength;
+   psNew->ulDepth = ulDepth;
+   return psNew;
+}
+
+/*
+  The validation and splitting of pathnames can scan for '/'
+  delimiters a block at a time. A block scanner returns a bit mask
+  with bit i set exactly when character i of the block at pc is '/',
+  and stores in *pulNuls the same mask for '\0', which no pathname
+  may hold.
+  Where the compiler and CPU support it, the scanner uses SSE2 (16
+  characters per block) or AVX2 (32 characters per block); it is
+  selected at run time on first use, or by Path_setImplementation.
+  Otherwise (and for the final partial block) a scalar loop is used.
+*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PATH_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* The width of the largest block any scanner examines */
+enum { PATH_MAX_BLOCK = 32 };
+
+/* The implementation in use, or PATH_IMPL_AUTO if not yet selected */
+static enum pathImpl eImpl = PATH_IMPL_AUTO;
+/* The number of characters per block, or 0 for the scalar loops */
+static size_t ulBlockWidth;
+/* The block scanner, or NULL for the scalar loops */
+static unsigned long (*pfScanBlock)(const char *pc,
+                                    unsigned long *pulNuls);
+
+/*
+  Returns the delimiter mask of the ulLength (at most PATH_MAX_BLOCK)
+  characters at pc, and stores their '\0' mask in *pulNuls, one
+  character at a time.
 */
-static void Path_freeString(char *pcStr, void *pvExtra) {
-   /* pcStr may be NULL, as this is a no-op to free.
-      pvExtra may be NULL, as it is unused. */
-   free(pcStr);
+static unsigned long Path_scanPartialBlock(const char *pc,
+                                           size_t ulLength,
+                                           unsigned long *pulNuls) {
+   unsigned long ulMask = 0;
+   size_t i;
+
+   assert(pc != NULL);
+   assert(ulLength <= PATH_MAX_BLOCK);
+   assert(pulNuls != NULL);
+
+   *pulNuls = 0;
+   for(i = 0; i < ulLength; i++) {
+      if(pc[i] == '/')
+         ulMask |= 1UL << i;
+      else if(pc[i] == '\0')
+         *pulNuls |= 1UL << i;
+   }
+   return ulMask;
+}
+
+#ifdef PATH_HAVE_X86_SIMD
+/* Returns the delimiter mask of the 16 characters at pc, and stores
+   their '\0' mask in *pulNuls. */
+__attribute__((target("sse2")))
+static unsigned long Path_scanBlockSSE2(const char *pc,
+                                        unsigned long *pulNuls) {
+   __m128i oBlock = _mm_loadu_si128((const __m128i *) pc);
+   __m128i oDelims = _mm_cmpeq_epi8(oBlock, _mm_set1_epi8('/'));
+   __m128i oNuls = _mm_cmpeq_epi8(oBlock, _mm_setzero_si128());
+   *pulNuls = (unsigned long) (unsigned int) _mm_movemask_epi8(oNuls);
+   return (unsigned long) (unsigned int) _mm_movemask_epi8(oDelims);
+}
+
+/* Returns the delimiter mask of the 32 characters at pc, and stores
+   their '\0' mask in *pulNuls. */
+__attribute__((target("avx2")))
+static unsigned long Path_scanBlockAVX2(const char *pc,
+                                        unsigned long *pulNuls) {
+   __m256i oBlock = _mm256_loadu_si256((const __m256i *) pc);
+   __m256i oDelims = _mm256_cmpeq_epi8(oBlock, _mm256_set1_epi8('/'));
+   __m256i oNuls = _mm256_cmpeq_epi8(oBlock, _mm256_setzero_si256());
+   *pulNuls = (unsigned long) (unsigned int) _mm256_movemask_epi8(oNuls);
+   return (unsigned long) (unsigned int) _mm256_movemask_epi8(oDelims);
+}
+#endif
+
+/* Returns the number of set bits in ulMask. */
+static size_t Path_countBits(unsigned long ulMask) {
+#ifdef __GNUC__
+   return (size_t) __builtin_popcountl(ulMask);
+#else
+   size_t ulCount = 0;
+   for(; ulMask != 0; ulMask &= ulMask - 1)
+      ulCount++;
+   return ulCount;
+#endif
+}
+
+/* Returns the index of the lowest set bit in ulMask, which is not 0. */
+static size_t Path_lowestBit(unsigned long ulMask) {
+   assert(ulMask != 0);
+#ifdef __GNUC__
+   return (size_t) __builtin_ctzl(ulMask);
+#else
+   {
+      size_t ulBit = 0;
+      for(; (ulMask & 1UL) == 0; ulMask >>= 1)
+         ulBit++;
+      return ulBit;
+   }
+#endif
+}
+
+boolean Path_setImplementation(enum pathImpl eNewImpl) {
+   switch(eNewImpl) {
+      case PATH_IMPL_AUTO:
+#ifdef PATH_HAVE_X86_SIMD
+         if(__builtin_cpu_supports("avx2"))
+            return Path_setImplementation(PATH_IMPL_AVX2);
+         if(__builtin_cpu_supports("sse2"))
+            return Path_setImplementation(PATH_IMPL_SSE2);
+#endif
+         return Path_setImplementation(PATH_IMPL_SCALAR);
+      case PATH_IMPL_SCALAR:
+         ulBlockWidth = 0;
+         pfScanBlock = NULL;
+         break;
+#ifdef PATH_HAVE_X86_SIMD
+      case PATH_IMPL_SSE2:
+         if(!__builtin_cpu_supports("sse2"))
+            return FALSE;
+         ulBlockWidth = 16;
+         pfScanBlock = Path_scanBlockSSE2;
+         break;
+      case PATH_IMPL_AVX2:
+         if(!__builtin_cpu_supports("avx2"))
+            return FALSE;
+         ulBlockWidth = 32;
+         pfScanBlock = Path_scanBlockAVX2;
+         break;
+#endif
+      default:
+         return FALSE;
+   }
+   eImpl = eNewImpl;
+   return TRUE;
+}
+
+enum pathImpl Path_getImplementation(void) {
+   if(eImpl == PATH_IMPL_AUTO)
+      (void) Path_setImplementation(PATH_IMPL_AUTO);
+   return eImpl;
 }
 
 /*
-  Sets *poDComponents to be an ordered collection of component strings
-  in pcPath, or NULL if an error occurs.
+  Validates pcPath, of string length ulLength, and sets *pulDepth to
+  its number of components, one character at a time.
   Returns one of the following statuses:
-  * SUCCESS if no error occurrs
-  * BAD_PATH if pcPath is the empty string,
-             or begins or ends with a '/',
-             or contains consecutive '/' delimiters
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  * SUCCESS if pcPath is a well-formatted path
+  * BAD_PATH if pcPath contains consecutive '/' delimiters or a '\0'
 */
-static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
-   const char *pcStart = pcPath;
-   const char *pcEnd = pcPath;
-   char *pcCopy;
-   DynArray_T oDSubstrings;
+static int Path_countComponentsScalar(const char *pcPath,
+                                      size_t ulLength,
+                                      size_t *pulDepth) {
+   size_t ulIndex;
+   size_t ulDepth = 1;
 
    assert(pcPath != NULL);
-   assert(poDComponents != NULL);
+   assert(pulDepth != NULL);
 
-   /* path cannot be empty string */
-   if(*pcPath == '\0') {
-      *poDComponents = NULL;
+   /* a length-delimited path may hide a '\0' within its length */
+   if(pcPath[0] == '\0')
       return BAD_PATH;
+   for(ulIndex = 1; ulIndex < ulLength; ulIndex++) {
+      if(pcPath[ulIndex] == '/') {
+         /* component can't start with delimiter */
+         if(pcPath[ulIndex-1] == '/')
+            return BAD_PATH;
+         ulDepth++;
+      }
+      else if(pcPath[ulIndex] == '\0')
+         return BAD_PATH;
    }
 
-   oDSubstrings = DynArray_new(0);
-   if(oDSubstrings == NULL) {
-      *poDComponents = NULL;
-      return MEMORY_ERROR;
-   }
+   *pulDepth = ulDepth;
+   return SUCCESS;
+}
 
-   /* validate and split pcPath */
-   while(*pcEnd != '\0') {
-      pcEnd = pcStart;
-      /* component can't start with delimiter */
-      if(*pcEnd == '/') {
-         DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
-         DynArray_free(oDSubstrings);
-         *poDComponents = NULL;
+/*
+  Validates pcPath, of string length ulLength, and sets *pulDepth to
+  its number of components, a block at a time.
+  Returns one of the following statuses:
+  * SUCCESS if pcPath is a well-formatted path
+  * BAD_PATH if pcPath contains consecutive '/' delimiters or a '\0'
+*/
+static int Path_countComponentsBlocks(const char *pcPath,
+                                      size_t ulLength,
+                                      size_t *pulDepth) {
+   size_t ulIndex = 0;
+   size_t ulDelims = 0;
+   unsigned long ulMask;
+   unsigned long ulNuls;
+   /* 1 if the character before the current block is a delimiter */
+   unsigned long ulCarry = 0;
+
+   assert(pcPath != NULL);
+   assert(pulDepth != NULL);
+
+   for(;;) {
+      if(ulIndex + ulBlockWidth <= ulLength)
+         ulMask = (*pfScanBlock)(pcPath + ulIndex, &ulNuls);
+      else
+         ulMask = Path_scanPartialBlock(pcPath + ulIndex,
+                                        ulLength - ulIndex, &ulNuls);
+
+      /* component can't start with delimiter, and no name can hold
+         a '\0' */
+      if((ulMask & ((ulMask << 1) | ulCarry)) || ulNuls != 0)
          return BAD_PATH;
-      }
+      ulDelims += Path_countBits(ulMask);
 
-      /* advance pcEnd to end of next token */
-      while(*pcEnd != '/' && *pcEnd != '\0')
-         pcEnd++;
+      if(ulIndex + ulBlockWidth >= ulLength)
+         break;
+      ulCarry = (ulMask >> (ulBlockWidth - 1)) & 1UL;
+      ulIndex += ulBlockWidth;
+   }
 
-      /* final component can't end with slash */
-      if(*pcEnd == '\0' && *(pcEnd-1) == '/') {
-         DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
-         DynArray_free(oDSubstrings);
-         *poDComponents = NULL;
-         return BAD_PATH;
-      }
+   *pulDepth = ulDelims + 1;
+   return SUCCESS;
+}
 
-      pcCopy = calloc((size_t)(pcEnd-pcStart+1), sizeof(char));
-      if(pcCopy == NULL) {
-         DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
-         DynArray_free(oDSubstrings);
-         *poDComponents = NULL;
-         return MEMORY_ERROR;
-      }
+/*
+  Validates pcPath, of string length ulLength, and sets *pulDepth to
+  its number of components.
+  Returns one of the following statuses:
+  * SUCCESS if pcPath is a well-formatted path
+  * BAD_PATH if pcPath is the empty string,
+             or begins or ends with a '/',
+             or contains consecutive '/' delimiters,
+             or contains a '\0', which no name can hold
+*/
+static int Path_countComponents(const char *pcPath, size_t ulLength,
+                                size_t *pulDepth) {
+   assert(pcPath != NULL);
+   assert(pulDepth != NULL);
 
-      if( DynArray_add(oDSubstrings, pcCopy) == 0) {
-         DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
-         DynArray_free(oDSubstrings);
-         *poDComponents = NULL;
-         return MEMORY_ERROR;
-      }
+   /* path cannot be empty string */
+   if(ulLength == 0)
+      return BAD_PATH;
 
-      while(pcStart != pcEnd) {
-         *pcCopy = *pcStart;
-         pcCopy++;
-         pcStart++;
-      }
+   /* path can't start or end with delimiter */
+   if(pcPath[0] == '/' || pcPath[ulLength-1] == '/')
+      return BAD_PATH;
 
-      pcStart++;
+   if(Path_getImplementation() == PATH_IMPL_SCALAR)
+      return Path_countComponentsScalar(pcPath, ulLength, pulDepth);
+   return Path_countComponentsBlocks(pcPath, ulLength, pulDepth);
+}
+
+/* Multipliers used by the path hash functions */
+#define PATH_HASH_MUL1 ((size_t) 0x9E3779B97F4A7C15UL)
+#define PATH_HASH_MUL2 ((size_t) 0xC2B2AE3D27D4EB4FUL)
+
+/*
+  Returns a hash of the ulLength characters at pc, computed a word at
+  a time.
+*/
+static size_t Path_hashComponent(const char *pc, size_t ulLength) {
+   size_t ulHash = ulLength * PATH_HASH_MUL2;
+   size_t ulWord;
+   size_t i;
+
+   assert(pc != NULL);
+
+   for(i = 0; i + sizeof(size_t) <= ulLength; i += sizeof(size_t)) {
+      memcpy(&ulWord, pc + i, sizeof(size_t));
+      ulHash = (ulHash ^ ulWord) * PATH_HASH_MUL1;
+      ulHash ^= ulHash >> 23;
    }
+   if(i < ulLength) {
+      size_t ulShift;
+      for(ulWord = 0, ulShift = 0; i < ulLength; i++, ulShift += 8)
+         ulWord |= (size_t) (unsigned char) pc[i] << ulShift;
+      ulHash = (ulHash ^ ulWord) * PATH_HASH_MUL1;
+      ulHash ^= ulHash >> 23;
+   }
+   return ulHash;
+}
 
-   *poDComponents = oDSubstrings;
-   return SUCCESS;
+/*
+  Returns the hash of a path whose prefix up to the previous
+  component has hash ulPrefixHash (0 if there is none), extended by
+  the ulLength-character component at pcComponent.
+*/
+static size_t Path_rollHash(size_t ulPrefixHash, const char *pcComponent,
+                            size_t ulLength) {
+   size_t ulHash;
+
+   assert(pcComponent != NULL);
+
+   ulHash = (ulPrefixHash * PATH_HASH_MUL2)
+      ^ Path_hashComponent(pcComponent, ulLength);
+   ulHash *= PATH_HASH_MUL1;
+   return ulHash ^ (ulHash >> 29);
 }
 
+/*
+  Fills in the prefix hash table of psPath, whose offset table and
+  pathname are already filled in.
+*/
+static void Path_fillHashes(struct path *psPath) {
+   const size_t *pulOffsets;
+   size_t *pulHashes;
+   size_t ulHash = 0;
+   size_t i;
+
+   assert(psPath != NULL);
+
+   pulOffsets = Path_offsets(psPath);
+   pulHashes = Path_hashes(psPath);
+   for(i = 0; i < psPath->ulDepth; i++) {
+      ulHash = Path_rollHash(ulHash, Path_pathname(psPath) + pulOffsets[i],
+                             pulOffsets[i+1] - pulOffsets[i] - 1);
+      pulHashes[i] = ulHash;
+   }
+}
+
+/*
+  Fills in the offset table, prefix hashes, pathname, and component
+  strings of psPath, whose header fields are already set, from pcPath.
+*/
+static void Path_split(struct path *psPath, const char *pcPath) {
+   size_t *pulOffsets;
+   char *pcComponents;
+   size_t ulLength;
+   size_t ulIndex;
+   size_t ulLevel = 0;
+
+   assert(psPath != NULL);
+   assert(pcPath != NULL);
+
+   pulOffsets = Path_offsets(psPath);
+   pcComponents = Path_components(psPath);
+   ulLength = psPath->ulLength;
+
+   memcpy(Path_pathname(psPath), pcPath, ulLength);
+   Path_pathname(psPath)[ulLength] = '\0';
+   memcpy(pcComponents, pcPath, ulLength);
+   pcComponents[ulLength] = '\0';
+
+   pulOffsets[ulLevel++] = 0;
+   if(Path_getImplementation() == PATH_IMPL_SCALAR) {
+      for(ulIndex = 0; ulIndex < ulLength; ulIndex++) {
+         if(pcPath[ulIndex] == '/') {
+            pcComponents[ulIndex] = '\0';
+            pulOffsets[ulLevel++] = ulIndex + 1;
+         }
+      }
+   }
+   else {
+      for(ulIndex = 0; ulIndex < ulLength; ulIndex += ulBlockWidth) {
+         unsigned long ulMask;
+         unsigned long ulNuls;
+         if(ulIndex + ulBlockWidth <= ulLength)
+            ulMask = (*pfScanBlock)(pcPath + ulIndex, &ulNuls);
+         else
+            ulMask = Path_scanPartialBlock(pcPath + ulIndex,
+                                           ulLength - ulIndex, &ulNuls);
+         /* terminate each component in place and record where the
+            next one begins */
+         for(; ulMask != 0; ulMask &= ulMask - 1) {
+            size_t ulDelim = ulIndex + Path_lowestBit(ulMask);
+            pcComponents[ulDelim] = '\0';
+            pulOffsets[ulLevel++] = ulDelim + 1;
+         }
+      }
+   }
+   pulOffsets[ulLevel] = ulLength + 1;
+
+   Path_fillHashes(psPath);
+}
 
 int Path_new(const char *pcPath, Path_T *poPResult) {
-   struct path *psNew;
-   int iSplitResult;
+   assert(pcPath != NULL);
+   assert(poPResult != NULL);
+
+   return Path_newN(pcPath, strlen(pcPath), poPResult);
+}
+
+int Path_newN(const char *pcPath, size_t ulLength, Path_T *poPResult) {
+   PathView oView;
+   int iStatus;
 
    assert(pcPath != NULL);
    assert(poPResult != NULL);
 
-   psNew = calloc(1, sizeof(struct path));
-   if(psNew == NULL) {
+   iStatus = Path_initView(&oView, pcPath, ulLength);
+   if(iStatus != SUCCESS) {
       *poPResult = NULL;
-      return MEMORY_ERROR;
+      return iStatus;
    }
 
-   /* instantiate and fill list of components */
-   iSplitResult = Path_split(pcPath, &psNew->oDComponents);
-   if(iSplitResult != SUCCESS) {
-      Path_free(psNew);
-      *poPResult = NULL;
-      return iSplitResult;
-   }
+   return Path_newFromView(&oView, poPResult);
+}
 
-   psNew->ulLength = strlen(pcPath);
-   psNew->pcPath = malloc(psNew->ulLength+1);
-   if(psNew->pcPath == NULL) {
-      Path_free(psNew);
+int Path_newFromView(const PathView *psView, Path_T *poPResult) {
+   struct path *psNew;
+
+   assert(psView != NULL);
+   assert(poPResult != NULL);
+
+   psNew = Path_alloc(psView->ulDepth, psView->ulLength);
+   if(psNew == NULL) {
       *poPResult = NULL;
       return MEMORY_ERROR;
    }
-   strcpy((char *)psNew->pcPath, pcPath);
+   Path_split(psNew, psView->pcPath);
 
    *poPResult = psNew;
    return SUCCESS;
@@ -154,11 +505,8 @@ int Path_new(const char *pcPath, Path_T *poPResult) {
 
 int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
    struct path *psNew;
-   size_t ulIndex, ulLength, ulSum;
-   const char *pcComponent;
-   char *pcCopy;
-   char *pcBuild;
-   char *pcInsert;
+   const size_t *pulOffsets;
+   size_t ulLength;
 
    assert(oPPath != NULL);
    assert(poPResult != NULL);
@@ -175,60 +523,39 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
       return NO_SUCH_PATH;
    }
 
-   psNew = calloc(1, sizeof(struct path));
-   if(psNew == NULL) {
-      *poPResult = NULL;
-      return MEMORY_ERROR;
-   }
-
-   psNew->oDComponents = DynArray_new(ulDepth);
-   if(psNew->oDComponents == NULL) {
-      Path_free(psNew);
-      *poPResult = NULL;
-      return MEMORY_ERROR;
-   }
-
-   pcBuild = calloc(Path_getStrLength(oPPath)+1, sizeof(char));
-   if(pcBuild == NULL) {
-      Path_free(psNew);
-      *poPResult = NULL;
-      return MEMORY_ERROR;
-   }
-
-   pcInsert = pcBuild;
-   ulSum = 0;
-
-   for(ulIndex = 0; ulIndex < ulDepth; ulIndex++) {
-      /* deep copy each component to new DynArray */
-      pcComponent = Path_getComponent(oPPath, ulIndex);
-      ulLength = strlen(pcComponent);
-      pcCopy = calloc(ulLength + 1, sizeof(char));
-      if(pcCopy == NULL) {
-         free(pcBuild);
-         Path_free(psNew);
+   /* a full-depth prefix is a byte-for-byte copy */
+   if(ulDepth == oPPath->ulDepth) {
+      size_t ulSize = Path_allocSize(oPPath->ulDepth,
+                                     oPPath->ulLength);
+      psNew = malloc(ulSize);
+      if(psNew == NULL) {
          *poPResult = NULL;
          return MEMORY_ERROR;
       }
-      strcpy(pcCopy, pcComponent);
-      (void) DynArray_set(psNew->oDComponents, ulIndex, pcCopy);
-      /* construct prefix's pathname string */
-      strcpy(pcInsert, pcComponent);
-      pcInsert[ulLength] = '/';
-      ulSum += ulLength + 1;
-      pcInsert += ulLength + 1;
+      memcpy(psNew, oPPath, ulSize);
+      *poPResult = psNew;
+      return SUCCESS;
    }
-   pcBuild[ulSum-1] = '\0';
 
-   /* shrink allocation to fit prefix's pathname string if needed */
-   pcInsert = realloc(pcBuild, ulSum);
-   if(pcInsert == NULL) {
-      free(pcBuild);
-      Path_free(psNew);
+   /* the prefix's pathname ends just before component ulDepth */
+   pulOffsets = Path_offsets(oPPath);
+   ulLength = pulOffsets[ulDepth] - 1;
+
+   psNew = Path_alloc(ulDepth, ulLength);
+   if(psNew == NULL) {
       *poPResult = NULL;
       return MEMORY_ERROR;
    }
-   psNew->ulLength = ulSum-1;
-   psNew->pcPath = pcInsert;
+
+   memcpy(Path_offsets(psNew), pulOffsets, ulDepth * sizeof(size_t));
+   Path_offsets(psNew)[ulDepth] = ulLength + 1;
+   memcpy(Path_hashes(psNew), Path_hashes(oPPath),
+          ulDepth * sizeof(size_t));
+   memcpy(Path_pathname(psNew), Path_pathname(oPPath), ulLength);
+   Path_pathname(psNew)[ulLength] = '\0';
+   memcpy(Path_components(psNew), Path_components(oPPath),
+          ulLength + 1);
+   Path_components(psNew)[ulLength] = '\0';
 
    *poPResult = psNew;
    return SUCCESS;
@@ -242,22 +569,13 @@ int Path_dup(Path_T oPPath, Path_T *poPResult) {
 }
 
 void Path_free(Path_T oPPath) {
-   if(oPPath != NULL) {
-      free((char *)oPPath->pcPath);
-
-      if(oPPath->oDComponents != NULL) {
-         DynArray_map(oPPath->oDComponents,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
-         DynArray_free(oPPath->oDComponents);
-      }
-   }
    free((struct path*) oPPath);
 }
 
 const char *Path_getPathname(Path_T oPPath) {
    assert(oPPath != NULL);
 
-   return oPPath->pcPath;
+   return Path_pathname(oPPath);
 }
 
 size_t Path_getStrLength(Path_T oPPath) {
@@ -270,37 +588,121 @@ int Path_comparePath(Path_T oPPath1, Path_T oPPath2) {
    assert(oPPath1 != NULL);
    assert(oPPath2 != NULL);
 
-   return strcmp(oPPath1->pcPath, oPPath2->pcPath);
+   if(oPPath1 == oPPath2)
+      return 0;
+   return strcmp(Path_pathname(oPPath1), Path_pathname(oPPath2));
+}
+
+boolean Path_equals(Path_T oPPath1, Path_T oPPath2) {
+   assert(oPPath1 != NULL);
+   assert(oPPath2 != NULL);
+
+   if(oPPath1 == oPPath2)
+      return TRUE;
+   /* unequal lengths or hashes prove the paths differ */
+   if(oPPath1->ulLength != oPPath2->ulLength)
+      return FALSE;
+   if(Path_getHash(oPPath1) != Path_getHash(oPPath2))
+      return FALSE;
+   return (boolean) (memcmp(Path_pathname(oPPath1),
+                            Path_pathname(oPPath2),
+                            oPPath1->ulLength) == 0);
+}
+
+size_t Path_getHash(Path_T oPPath) {
+   assert(oPPath != NULL);
+
+   return Path_hashes(oPPath)[oPPath->ulDepth - 1];
+}
+
+int Path_compareStringN(Path_T oPPath, const char *pcStr,
+                        size_t ulLength) {
+   size_t ulMin;
+   int iResult;
+
+   assert(oPPath != NULL);
+   assert(pcStr != NULL);
+
+   ulMin = oPPath->ulLength < ulLength ? oPPath->ulLength : ulLength;
+   iResult = memcmp(Path_pathname(oPPath), pcStr, ulMin);
+   if(iResult != 0)
+      return iResult;
+   if(oPPath->ulLength < ulLength)
+      return -1;
+   return oPPath->ulLength > ulLength;
 }
 
 int Path_compareString(Path_T oPPath, const char *pcStr) {
    assert(oPPath != NULL);
    assert(pcStr != NULL);
 
-   return strcmp(oPPath->pcPath, pcStr);
+   return strcmp(Path_pathname(oPPath), pcStr);
 }
 
 size_t Path_getDepth(Path_T oPPath) {
    assert(oPPath != NULL);
 
-   return DynArray_getLength(oPPath->oDComponents);
+   return oPPath->ulDepth;
+}
+
+/*
+  Returns TRUE if the prefixes of depth ulDepth of psPath1 and psPath2
+  have the same length and hash (and so are very likely equal), or
+  FALSE if they certainly differ.
+*/
+static boolean Path_prefixesMayMatch(const struct path *psPath1,
+                                     const struct path *psPath2,
+                                     size_t ulDepth) {
+   assert(psPath1 != NULL);
+   assert(psPath2 != NULL);
+   assert(ulDepth > 0);
+
+   return (boolean) (Path_offsets(psPath1)[ulDepth]
+                     == Path_offsets(psPath2)[ulDepth]
+                     && Path_hashes(psPath1)[ulDepth-1]
+                     == Path_hashes(psPath2)[ulDepth-1]);
 }
 
 size_t Path_getSharedPrefixDepth(Path_T oPPath1, Path_T oPPath2) {
-   size_t ulDepth1, ulDepth2, ulMin, i;
+   const size_t *pulOffsets1;
+   const size_t *pulOffsets2;
+   size_t ulLow, ulHigh, ulMin, i;
 
    assert(oPPath1 != NULL);
    assert(oPPath2 != NULL);
 
-   ulDepth1 = Path_getDepth(oPPath1);
-   ulDepth2 = Path_getDepth(oPPath2);
-   if(ulDepth1 < ulDepth2)
-      ulMin = ulDepth1;
+   if(oPPath1->ulDepth < oPPath2->ulDepth)
+      ulMin = oPPath1->ulDepth;
    else
-      ulMin = ulDepth2;
+      ulMin = oPPath2->ulDepth;
+
+   /* binary search the prefix hashes for the deepest prefixes that
+      appear to match: ulLow appears to match, ulHigh+1 does not */
+   ulLow = 0;
+   ulHigh = ulMin;
+   while(ulLow < ulHigh) {
+      size_t ulMid = ulLow + (ulHigh - ulLow + 1) / 2;
+      if(Path_prefixesMayMatch(oPPath1, oPPath2, ulMid))
+         ulLow = ulMid;
+      else
+         ulHigh = ulMid - 1;
+   }
+
+   /* confirm the candidate with a single byte comparison */
+   pulOffsets1 = Path_offsets(oPPath1);
+   if(ulLow == 0 || memcmp(Path_pathname(oPPath1),
+                           Path_pathname(oPPath2),
+                           pulOffsets1[ulLow] - 1) == 0)
+      return ulLow;
+
+   /* a hash collision: fall back to comparing component by component */
+   pulOffsets2 = Path_offsets(oPPath2);
    for(i = 0; i < ulMin; i++) {
-      if(strcmp(Path_getComponent(oPPath1, i),
-                Path_getComponent(oPPath2, i)))
+      if(pulOffsets1[i+1] != pulOffsets2[i+1])
+         return i;
+      if(memcmp(Path_pathname(oPPath1) + pulOffsets1[i],
+                Path_pathname(oPPath2) + pulOffsets2[i],
+                pulOffsets1[i+1] - pulOffsets1[i] - 1) != 0)
          return i;
    }
    return ulMin;
@@ -312,5 +714,122 @@ const char *Path_getComponent(Path_T oPPath, size_t ulLevel) {
    if(ulLevel >= Path_getDepth(oPPath))
       return NULL;
 
-   return DynArray_get(oPPath->oDComponents, ulLevel);
+   return Path_components(oPPath) + Path_offsets(oPPath)[ulLevel];
+}
+
+const char *Path_getComponentView(Path_T oPPath, size_t ulLevel,
+                                  size_t *pulLength) {
+   const size_t *pulOffsets;
+
+   assert(oPPath != NULL);
+   assert(pulLength != NULL);
+
+   if(ulLevel >= Path_getDepth(oPPath))
+      return NULL;
+
+   pulOffsets = Path_offsets(oPPath);
+   *pulLength = pulOffsets[ulLevel+1] - pulOffsets[ulLevel] - 1;
+   return Path_pathname(oPPath) + pulOffsets[ulLevel];
+}
+
+int Path_initView(PathView *psView, const char *pcPath,
+                  size_t ulLength) {
+   size_t ulDepth;
+   int iStatus;
+
+   assert(psView != NULL);
+   assert(pcPath != NULL);
+
+   iStatus = Path_countComponents(pcPath, ulLength, &ulDepth);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   psView->pcPath = pcPath;
+   psView->ulLength = ulLength;
+   psView->ulDepth = ulDepth;
+   return SUCCESS;
+}
+
+void Path_getView(Path_T oPPath, PathView *psView) {
+   assert(oPPath != NULL);
+   assert(psView != NULL);
+
+   psView->pcPath = Path_pathname(oPPath);
+   psView->ulLength = oPPath->ulLength;
+   psView->ulDepth = oPPath->ulDepth;
+}
+
+size_t Path_viewComponentEnd(const PathView *psView, size_t ulStart) {
+   const char *pcDelim;
+
+   assert(psView != NULL);
+   assert(ulStart <= psView->ulLength);
+
+   pcDelim = memchr(psView->pcPath + ulStart, '/',
+                    psView->ulLength - ulStart);
+   if(pcDelim == NULL)
+      return psView->ulLength;
+   return (size_t) (pcDelim - psView->pcPath);
+}
+
+size_t Path_getSharedViewDepth(const PathView *psView1,
+                               const PathView *psView2,
+                               size_t *pulEnd) {
+   const char *pcPath1;
+   const char *pcPath2;
+   size_t ulMin, ulEnd, ulDepth, i;
+
+   assert(psView1 != NULL);
+   assert(psView2 != NULL);
+   assert(pulEnd != NULL);
+
+   pcPath1 = psView1->pcPath;
+   pcPath2 = psView2->pcPath;
+   if(psView1->ulLength < psView2->ulLength)
+      ulMin = psView1->ulLength;
+   else
+      ulMin = psView2->ulLength;
+
+   /* find the first differing character, counting the delimiters
+      before it: ulEnd is just past the last component wholly shared */
+   ulEnd = 0;
+   ulDepth = 0;
+   for(i = 0; i < ulMin && pcPath1[i] == pcPath2[i]; i++)
+      if(pcPath1[i] == '/') {
+         ulEnd = i;
+         ulDepth++;
+      }
+
+   /* the component at i is shared too if it ends there in both */
+   if(i == ulMin &&
+      (i == psView1->ulLength || pcPath1[i] == '/') &&
+      (i == psView2->ulLength || pcPath2[i] == '/')) {
+      *pulEnd = i;
+      return ulDepth + 1;
+   }
+   *pulEnd = ulEnd;
+   return ulDepth;
+}
+
+size_t Path_extendHash(size_t ulPrefixHash, const char *pcComponent,
+                       size_t ulLength) {
+   assert(pcComponent != NULL);
+
+   return Path_rollHash(ulPrefixHash, pcComponent, ulLength);
+}
+
+size_t Path_hashView(const PathView *psView) {
+   size_t ulHash = 0;
+   size_t ulStart;
+   size_t ulEnd;
+
+   assert(psView != NULL);
+
+   for(ulStart = 0; ; ulStart = ulEnd + 1) {
+      ulEnd = Path_viewComponentEnd(psView, ulStart);
+      ulHash = Path_rollHash(ulHash, psView->pcPath + ulStart,
+                             ulEnd - ulStart);
+      if(ulEnd == psView->ulLength)
+         return ulHash;
+   }
 }
@@ -12,6 +12,22 @@
 /* An object representing an absolute path in a tree */
 typedef const struct path * Path_T;
 
+/*
+  A read-only view of an absolute path held in a caller-owned buffer.
+  Unlike a Path_T, a view is meant to be declared as a local variable:
+  initializing one validates the buffer in place without allocating
+  or copying, and the view is only valid while the buffer is.
+*/
+struct pathView {
+   /* The caller's pathname, which need not be '\0'-terminated */
+   const char *pcPath;
+   /* The number of characters of pcPath that make up the path */
+   size_t ulLength;
+   /* The number of components in the path */
+   size_t ulDepth;
+};
+typedef struct pathView PathView;
+
 /*
   Creates a new path object representing the absolute path in pcPath.
   Returns an int SUCCESS status and sets *poPResult to be the new path
@@ -23,6 +39,22 @@ typedef const struct path * Path_T;
 */
 int Path_new(const char *pcPath, Path_T *poPResult);
 
+/*
+  Behaves like Path_new for the absolute path made up of the ulLength
+  characters at pcPath, which need not be '\0'-terminated, but must
+  not contain a '\0' (else BAD_PATH).
+*/
+int Path_newN(const char *pcPath, size_t ulLength, Path_T *poPResult);
+
+/*
+  Creates a new path object representing the absolute path viewed by
+  psView, which has already been validated by Path_initView.
+  Returns an int SUCCESS status and sets *poPResult to be the new path
+  if successful. Otherwise, sets *poPResult to NULL and returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Path_newFromView(const PathView *psView, Path_T *poPResult);
+
 /*
   Creates a "deep copy" of oPPath, duplicating all its contents.
   Returns an int SUCCESS status and sets *poPResult to be the new path
@@ -62,6 +94,28 @@ size_t Path_getStrLength(Path_T oPPath);
 */
 int Path_comparePath(Path_T oPPath1, Path_T oPPath2);
 
+/*
+  Returns TRUE if oPPath1 and oPPath2 have the same pathname, or FALSE
+  otherwise. Unlike Path_comparePath, paths of different lengths or
+  hashes are rejected without examining their pathnames.
+*/
+boolean Path_equals(Path_T oPPath1, Path_T oPPath2);
+
+/*
+  Returns a hash of oPPath's pathname, computed when oPPath was
+  created. Equal paths always have equal hashes.
+*/
+size_t Path_getHash(Path_T oPPath);
+
+/*
+  Compares oPPath's pathname with the ulLength characters at pcStr,
+  which need not be '\0'-terminated, lexicographically.
+  Returns <0, 0, or >0 if oPPath is "less than", "equal to", or
+  "greater than" the string, respectively.
+*/
+int Path_compareStringN(Path_T oPPath, const char *pcStr,
+                        size_t ulLength);
+
 /*
   Compares oPPath's pathname with pcStr lexicographically.
   Returns <0, 0, or >0 if oPPath is "less than", "equal to", or
@@ -93,4 +147,90 @@ size_t Path_getSharedPrefixDepth(Path_T oPPath1, Path_T oPPath2);
 */
 const char *Path_getComponent(Path_T oPPath, size_t ulLevel);
 
+/*
+  Returns a view of the component of oPPath at level ulLevel: a
+  pointer into oPPath's pathname at the start of the component, which
+  is NOT '\0'-terminated, and sets *pulLength to its length. The view
+  is valid for as long as oPPath is.
+  Returns NULL and leaves *pulLength unchanged if ulLevel is greater
+  than oPPath's maximum level.
+*/
+const char *Path_getComponentView(Path_T oPPath, size_t ulLevel,
+                                  size_t *pulLength);
+
+/*
+  Initializes *psView as a view of the path made up of the ulLength
+  characters at pcPath, which need not be '\0'-terminated.
+  Performs no allocation. Returns SUCCESS if successful, or BAD_PATH
+  (leaving *psView unchanged) if the characters are empty,
+  begin or end with a '/', contain consecutive '/' delimiters, or
+  contain a '\0'.
+*/
+int Path_initView(PathView *psView, const char *pcPath,
+                  size_t ulLength);
+
+/* Initializes *psView as a view of oPPath's pathname. */
+void Path_getView(Path_T oPPath, PathView *psView);
+
+/*
+  Returns the index in psView's pathname just past the end of the
+  component that begins at index ulStart, i.e., the index of the
+  next '/' delimiter or psView's length if there is none. The
+  pathname prefix ending at the returned index is itself a path.
+*/
+size_t Path_viewComponentEnd(const PathView *psView, size_t ulStart);
+
+/*
+  Returns the length, in components, of the longest prefix shared by
+  the paths psView1 and psView2, as Path_getSharedPrefixDepth does
+  for path objects, and sets *pulEnd to the index, in either pathname,
+  just past that prefix (0 if the depth is 0). Costs one pass over
+  the characters the paths share.
+*/
+size_t Path_getSharedViewDepth(const PathView *psView1,
+                               const PathView *psView2,
+                               size_t *pulEnd);
+
+/*
+  Returns the hash of a path made up of a prefix whose hash is
+  ulPrefixHash (0 if there is no prefix) followed by the
+  ulLength-character component at pcComponent. A path's hash is that
+  of its components taken one by one from the first, as Path_getHash
+  returns it, so the hashes of a hierarchy of names can be found
+  without forming any pathnames.
+*/
+size_t Path_extendHash(size_t ulPrefixHash, const char *pcComponent,
+                       size_t ulLength);
+
+/* Returns the hash of the path viewed by psView, as Path_getHash
+   would return it. */
+size_t Path_hashView(const PathView *psView);
+
+/* Implementations of the scan that validates and splits pathnames */
+enum pathImpl {
+   /* select the fastest implementation the CPU supports */
+   PATH_IMPL_AUTO,
+   /* examine one character at a time */
+   PATH_IMPL_SCALAR,
+   /* examine 16 characters at a time with SSE2 */
+   PATH_IMPL_SSE2,
+   /* examine 32 characters at a time with AVX2 */
+   PATH_IMPL_AVX2
+};
+
+/*
+  Selects eImpl as the implementation used by all subsequent path
+  validation and splitting. Every implementation produces identical
+  results, so this is only useful for benchmarking and testing.
+  Returns TRUE if successful, or FALSE (leaving the implementation
+  unchanged) if eImpl is not supported by this compiler and CPU.
+*/
+boolean Path_setImplementation(enum pathImpl eImpl);
+
+/*
+  Returns the implementation currently used for path validation and
+  splitting, selecting one first if none has been yet.
+*/
+enum pathImpl Path_getImplementation(void);
+
 #endif
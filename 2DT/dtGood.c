@@ -40,23 +40,21 @@ static size_t ulCount;
 
 /*
   Traverses the DT starting at the root as far as possible towards
-  absolute path oPPath. If able to traverse, returns an int SUCCESS
-  status and sets *poNFurthest to the furthest node reached (which may
-  be only a prefix of oPPath, or even NULL if the root is NULL).
+  the absolute path viewed by psView. If able to traverse, returns an
+  int SUCCESS status and sets *poNFurthest to the furthest node reached
+  (which may be only a prefix of the path, or even NULL if the root is
+  NULL). Performs no allocation.
   Otherwise, sets *poNFurthest to NULL and returns with status:
-  * CONFLICTING_PATH if the root's path is not a prefix of oPPath
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if the root's path is not a prefix of the path
 */
-static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
+static int DT_traversePath(const PathView *psView, Node_T *poNFurthest) {
    int iStatus;
-   Path_T oPPrefix = NULL;
    Node_T oNCurr;
    Node_T oNChild = NULL;
-   size_t ulDepth;
-   size_t i;
+   size_t ulEnd;
    size_t ulChildID;
 
-   assert(oPPath != NULL);
+   assert(psView != NULL);
    assert(poNFurthest != NULL);
 
    /* root is NULL -> won't find anything */
@@ -65,32 +63,19 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
       return SUCCESS;
    }
 
-   iStatus = Path_prefix(oPPath, 1, &oPPrefix);
-   if(iStatus != SUCCESS) {
-      *poNFurthest = NULL;
-      return iStatus;
-   }
-
-   if(Path_comparePath(Node_getPath(oNRoot), oPPrefix)) {
-      Path_free(oPPrefix);
+   /* the root's path must be the first component of the path */
+   ulEnd = Path_viewComponentEnd(psView, 0);
+   if(Path_compareStringN(Node_getPath(oNRoot), psView->pcPath, ulEnd)) {
       *poNFurthest = NULL;
       return CONFLICTING_PATH;
    }
-   Path_free(oPPrefix);
-   oPPrefix = NULL;
 
    oNCurr = oNRoot;
-   ulDepth = Path_getDepth(oPPath);
-   for(i = 2; i <= ulDepth; i++) {
-      iStatus = Path_prefix(oPPath, i, &oPPrefix);
-      if(iStatus != SUCCESS) {
-         *poNFurthest = NULL;
-         return iStatus;
-      }
-      if(Node_hasChild(oNCurr, oPPrefix, &ulChildID)) {
+   while(ulEnd < psView->ulLength) {
+      /* extend the prefix by one more component */
+      ulEnd = Path_viewComponentEnd(psView, ulEnd + 1);
+      if(Node_hasChildN(oNCurr, psView->pcPath, ulEnd, &ulChildID)) {
          /* go to that child and continue with next prefix */
-         Path_free(oPPrefix);
-         oPPrefix = NULL;
          iStatus = Node_getChild(oNCurr, ulChildID, &oNChild);
          if(iStatus != SUCCESS) {
             *poNFurthest = NULL;
@@ -99,13 +84,12 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
          oNCurr = oNChild;
       }
       else {
-         /* oNCurr doesn't have child with path oPPrefix:
+         /* oNCurr doesn't have child with this prefix:
             this is as far as we can go */
          break;
       }
    }
 
-   Path_free(oPPrefix);
    *poNFurthest = oNCurr;
    return SUCCESS;
 }
@@ -113,15 +97,15 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
 /*
   Traverses the DT to find a node with absolute path pcPath. Returns a
   int SUCCESS status and sets *poNResult to be the node, if found.
+  pcPath is viewed in place, so the lookup performs no allocation.
   Otherwise, sets *poNResult to NULL and returns with status:
   * INITIALIZATION_ERROR if the DT is not in an initialized state
   * BAD_PATH if pcPath does not represent a well-formatted path
   * CONFLICTING_PATH if the root's path is not a prefix of pcPath
   * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
-  * MEMORY_ERROR if memory could not be allocated to complete request
  */
 static int DT_findNode(const char *pcPath, Node_T *poNResult) {
-   Path_T oPPath = NULL;
+   PathView oView;
    Node_T oNFound = NULL;
    int iStatus;
 
@@ -133,33 +117,31 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
       return INITIALIZATION_ERROR;
    }
 
-   iStatus = Path_new(pcPath, &oPPath);
+   iStatus = Path_initView(&oView, pcPath, strlen(pcPath));
    if(iStatus != SUCCESS) {
       *poNResult = NULL;
       return iStatus;
    }
 
-   iStatus = DT_traversePath(oPPath, &oNFound);
+   iStatus = DT_traversePath(&oView, &oNFound);
    if(iStatus != SUCCESS)
    {
-      Path_free(oPPath);
       *poNResult = NULL;
       return iStatus;
    }
 
    if(oNFound == NULL) {
-      Path_free(oPPath);
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
 
-   if(Path_comparePath(Node_getPath(oNFound), oPPath) != 0) {
-      Path_free(oPPath);
+   /* oNFound's path is a prefix of pcPath, so they match exactly
+      when their lengths do */
+   if(Path_getStrLength(Node_getPath(oNFound)) != oView.ulLength) {
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
 
-   Path_free(oPPath);
    *poNResult = oNFound;
    return SUCCESS;
 }
@@ -169,6 +151,7 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
 int DT_insert(const char *pcPath) {
    int iStatus;
    Path_T oPPath = NULL;
+   PathView oView;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
    size_t ulDepth, ulIndex;
@@ -186,7 +169,8 @@ int DT_insert(const char *pcPath) {
       return iStatus;
 
    /* find the closest ancestor of oPPath already in the tree */
-   iStatus= DT_traversePath(oPPath, &oNCurr);
+   Path_getView(oPPath, &oView);
+   iStatus= DT_traversePath(&oView, &oNCurr);
    if(iStatus != SUCCESS)
    {
       Path_free(oPPath);
@@ -207,7 +191,7 @@ int DT_insert(const char *pcPath) {
       ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
 
       /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
+      if(ulIndex == ulDepth+1 && Path_equals(oPPath,
                                        Node_getPath(oNCurr))) {
          Path_free(oPPath);
          return ALREADY_IN_TREE;
@@ -50,6 +50,13 @@ Path_T Node_getPath(Node_T oNNode);
 boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
                          size_t *pulChildID);
 
+/*
+  Behaves like Node_hasChild for the child whose absolute path is the
+  ulLength characters at pcPath, which need not be '\0'-terminated.
+*/
+boolean Node_hasChildN(Node_T oNParent, const char *pcPath,
+                       size_t ulLength, size_t *pulChildID);
+
 /* Returns the number of children that oNParent has. */
 size_t Node_getNumChildren(Node_T oNParent);
 
@@ -36,18 +36,27 @@ static int Node_addChild(Node_T oNParent, Node_T oNChild,
       return MEMORY_ERROR;
 }
 
+/* A pathname that need not be '\0'-terminated, used as a search key */
+struct nodeKey {
+   /* the characters of the pathname */
+   const char *pcPath;
+   /* the number of characters in the pathname */
+   size_t ulLength;
+};
+
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
+  Compares the string representation of oNfirst with the pathname
+  psSecond representing a node's path.
   Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
-  "greater than" pcSecond, respectively.
+  "greater than" psSecond, respectively.
 */
-static int Node_compareString(const Node_T oNFirst,
-                                 const char *pcSecond) {
+static int Node_compareKey(const Node_T oNFirst,
+                           const struct nodeKey *psSecond) {
    assert(oNFirst != NULL);
-   assert(pcSecond != NULL);
+   assert(psSecond != NULL);
 
-   return Path_compareString(oNFirst->oPPath, pcSecond);
+   return Path_compareStringN(oNFirst->oPPath, psSecond->pcPath,
+                              psSecond->ulLength);
 }
 
 
@@ -206,10 +215,24 @@ boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
    assert(oPPath != NULL);
    assert(pulChildID != NULL);
 
+   return Node_hasChildN(oNParent, Path_getPathname(oPPath),
+                         Path_getStrLength(oPPath), pulChildID);
+}
+
+boolean Node_hasChildN(Node_T oNParent, const char *pcPath,
+                       size_t ulLength, size_t *pulChildID) {
+   struct nodeKey sKey;
+
+   assert(oNParent != NULL);
+   assert(pcPath != NULL);
+   assert(pulChildID != NULL);
+
+   sKey.pcPath = pcPath;
+   sKey.ulLength = ulLength;
+
    /* *pulChildID is the index into oNParent->oDChildren */
-   return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) Node_compareString);
+   return DynArray_bsearch(oNParent->oDChildren, &sKey, pulChildID,
+            (int (*)(const void*,const void*)) Node_compareKey);
 }
 
 size_t Node_getNumChildren(Node_T oNParent) {
@@ -0,0 +1,170 @@
+/* Implementation of a size-classed slab arena */
+#include <stdlib.h>
+#include <assert.h>
+#include "arena.h"
+
+/* Parameters of the arena: blocks of up to 2^MAX_CLASS_LOG bytes are
+   carved from slabs of SLAB_SIZE bytes, in classes of
+   2^MIN_CLASS_LOG, 2^(MIN_CLASS_LOG+1), ... bytes */
+enum { MIN_CLASS_LOG = 4, MAX_CLASS_LOG = 14,
+       NUM_CLASSES = MAX_CLASS_LOG - MIN_CLASS_LOG + 1,
+       SLAB_SIZE = 1 << 16 };
+
+/* The header of a slab, or of a block too large for any class */
+struct chunk {
+   /* the previous and next chunks of the same kind */
+   struct chunk *psPrev;
+   struct chunk *psNext;
+   /* padding so that what follows is aligned for any type */
+   union { long double ld; void *pv; long l; } uAlign;
+};
+
+/* A released block, linked into its class's free list */
+struct freeBlock {
+   /* the next free block of the same class */
+   struct freeBlock *psNext;
+};
+
+/* An arena */
+struct arena {
+   /* the slabs obtained so far */
+   struct chunk *psSlabs;
+   /* the blocks too large for any class */
+   struct chunk *psLarge;
+   /* the next unused byte of the newest slab, and its end */
+   char *pcNext;
+   char *pcEnd;
+   /* the released blocks of each class */
+   struct freeBlock *apsFree[NUM_CLASSES];
+   /* the number of bytes obtained from malloc */
+   size_t ulFootprint;
+};
+
+/* Returns the size class for blocks of ulSize bytes, or NUM_CLASSES
+   if they are too large for any class. */
+static size_t Arena_class(size_t ulSize) {
+   size_t ulClass = 0;
+   while(ulClass < NUM_CLASSES &&
+         ((size_t) 1 << (ulClass + MIN_CLASS_LOG)) < ulSize)
+      ulClass++;
+   return ulClass;
+}
+
+/* Links psChunk in at the head of the list *ppsList. */
+static void Arena_link(struct chunk **ppsList, struct chunk *psChunk) {
+   psChunk->psPrev = NULL;
+   psChunk->psNext = *ppsList;
+   if(*ppsList != NULL)
+      (*ppsList)->psPrev = psChunk;
+   *ppsList = psChunk;
+}
+
+/* Frees every chunk on the list psList. */
+static void Arena_freeList(struct chunk *psList) {
+   while(psList != NULL) {
+      struct chunk *psNext = psList->psNext;
+      free(psList);
+      psList = psNext;
+   }
+}
+
+/* see arena.h for specification */
+Arena_T Arena_new(void) {
+   Arena_T oAArena;
+   size_t ulClass;
+   oAArena = malloc(sizeof(struct arena));
+   if(oAArena == NULL)
+      return NULL;
+   oAArena->psSlabs = NULL;
+   oAArena->psLarge = NULL;
+   oAArena->pcNext = NULL;
+   oAArena->pcEnd = NULL;
+   for(ulClass = 0; ulClass < NUM_CLASSES; ulClass++)
+      oAArena->apsFree[ulClass] = NULL;
+   oAArena->ulFootprint = 0;
+   return oAArena;
+}
+
+/* see arena.h for specification */
+void Arena_free(Arena_T oAArena) {
+   if(oAArena == NULL)
+      return;
+   Arena_freeList(oAArena->psSlabs);
+   Arena_freeList(oAArena->psLarge);
+   free(oAArena);
+}
+
+/* see arena.h for specification */
+void *Arena_alloc(Arena_T oAArena, size_t ulSize) {
+   size_t ulClass;
+   size_t ulBlock;
+   struct chunk *psChunk;
+   void *pvBlock;
+   assert(oAArena != NULL);
+
+   ulClass = Arena_class(ulSize);
+   if(ulClass == NUM_CLASSES) {
+      /* too large for any class: allocate it on its own */
+      psChunk = malloc(sizeof(struct chunk) + ulSize);
+      if(psChunk == NULL)
+         return NULL;
+      Arena_link(&oAArena->psLarge, psChunk);
+      oAArena->ulFootprint += sizeof(struct chunk) + ulSize;
+      return psChunk + 1;
+   }
+   /* reuse a released block of this class if there is one */
+   if(oAArena->apsFree[ulClass] != NULL) {
+      pvBlock = oAArena->apsFree[ulClass];
+      oAArena->apsFree[ulClass] = oAArena->apsFree[ulClass]->psNext;
+      return pvBlock;
+   }
+   /* otherwise carve one from the newest slab, starting a new slab if
+      it is full; what remains of the old one is abandoned */
+   ulBlock = (size_t) 1 << (ulClass + MIN_CLASS_LOG);
+   if(oAArena->pcNext == NULL ||
+      (size_t) (oAArena->pcEnd - oAArena->pcNext) < ulBlock) {
+      psChunk = malloc(sizeof(struct chunk) + SLAB_SIZE);
+      if(psChunk == NULL)
+         return NULL;
+      Arena_link(&oAArena->psSlabs, psChunk);
+      oAArena->ulFootprint += sizeof(struct chunk) + SLAB_SIZE;
+      oAArena->pcNext = (char *) (psChunk + 1);
+      oAArena->pcEnd = oAArena->pcNext + SLAB_SIZE;
+   }
+   pvBlock = oAArena->pcNext;
+   oAArena->pcNext += ulBlock;
+   return pvBlock;
+}
+
+/* see arena.h for specification */
+void Arena_release(Arena_T oAArena, void *pvBlock, size_t ulSize) {
+   size_t ulClass;
+   struct chunk *psChunk;
+   struct freeBlock *psFree;
+   assert(oAArena != NULL);
+   if(pvBlock == NULL)
+      return;
+
+   ulClass = Arena_class(ulSize);
+   if(ulClass == NUM_CLASSES) {
+      psChunk = (struct chunk *) pvBlock - 1;
+      if(psChunk->psPrev != NULL)
+         psChunk->psPrev->psNext = psChunk->psNext;
+      else
+         oAArena->psLarge = psChunk->psNext;
+      if(psChunk->psNext != NULL)
+         psChunk->psNext->psPrev = psChunk->psPrev;
+      oAArena->ulFootprint -= sizeof(struct chunk) + ulSize;
+      free(psChunk);
+      return;
+   }
+   psFree = pvBlock;
+   psFree->psNext = oAArena->apsFree[ulClass];
+   oAArena->apsFree[ulClass] = psFree;
+}
+
+/* see arena.h for specification */
+size_t Arena_getFootprint(Arena_T oAArena) {
+   assert(oAArena != NULL);
+   return oAArena->ulFootprint;
+}
@@ -0,0 +1,40 @@
+/*--------------------------------------------------------------------*/
+/* arena.h                                                            */
+/*--------------------------------------------------------------------*/
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+#include <stddef.h>
+
+/*
+  An Arena_T hands out blocks of memory carved from large slabs, so
+  that many small and medium allocations cost one malloc per slab and
+  are all released at once by Arena_free. Blocks are grouped into
+  power-of-two size classes; a released block is kept on its class's
+  free list for reuse. Blocks too large for any class are allocated
+  individually but still released by Arena_free.
+*/
+typedef struct arena *Arena_T;
+
+/* Returns a new, empty arena, or NULL if there is an allocation
+   error. */
+Arena_T Arena_new(void);
+
+/* Frees oAArena and every block allocated from it. */
+void Arena_free(Arena_T oAArena);
+
+/*
+  Returns a block of at least ulSize bytes from oAArena, aligned for
+  any type, or NULL if there is an allocation error. The block stays
+  valid until it is released or oAArena is freed.
+*/
+void *Arena_alloc(Arena_T oAArena, size_t ulSize);
+
+/*
+  Returns block pvBlock, which was allocated from oAArena with size
+  ulSize, to oAArena for reuse.
+*/
+void Arena_release(Arena_T oAArena, void *pvBlock, size_t ulSize);
+
+/* Returns the number of bytes oAArena has obtained from malloc. */
+size_t Arena_getFootprint(Arena_T oAArena);
+#endif
@@ -0,0 +1,177 @@
+/* Implementation of a bit vector with rank and select */
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include "bitsFT.h"
+
+/* Bits are kept in words; the index has an entry for each block of
+   BLOCK_BITS bits, and one for every SELECT_SAMPLE-th 0 */
+enum { WORD_BITS = sizeof(unsigned long) * CHAR_BIT, BLOCK_BITS = 512,
+       BLOCK_WORDS = BLOCK_BITS / WORD_BITS, SELECT_SAMPLE = 512 };
+
+/* A bit vector */
+struct bits {
+   /* the number of bits, and the words holding them from the lowest
+      bit of the first word */
+   size_t ulLength;
+   unsigned long *aulWords;
+   size_t ulWords;
+   /* for each block, and one past the last, the number of 1s before
+      it */
+   size_t *aulRanks;
+   size_t ulBlocks;
+   /* for every SELECT_SAMPLE-th 0, the block that holds it */
+   size_t *aulSamples;
+};
+
+/* Returns the number of set bits in ulWord. */
+static size_t Bits_countOnes(unsigned long ulWord) {
+#ifdef __GNUC__
+   return (size_t) __builtin_popcountl(ulWord);
+#else
+   size_t ulCount = 0;
+   for(; ulWord != 0; ulWord &= ulWord - 1)
+      ulCount++;
+   return ulCount;
+#endif
+}
+
+/* Returns the index of the lowest set bit in ulWord, which is not 0. */
+static size_t Bits_lowestOne(unsigned long ulWord) {
+   assert(ulWord != 0);
+#ifdef __GNUC__
+   return (size_t) __builtin_ctzl(ulWord);
+#else
+   {
+      size_t ulBit = 0;
+      for(; (ulWord & 1UL) == 0; ulWord >>= 1)
+         ulBit++;
+      return ulBit;
+   }
+#endif
+}
+
+/* see bitsFT.h for specification */
+Bits_T Bits_new(size_t ulLength) {
+   Bits_T oBBits;
+   oBBits = malloc(sizeof(struct bits));
+   if(oBBits == NULL)
+      return NULL;
+   oBBits->ulLength = ulLength;
+   oBBits->ulBlocks = ulLength / BLOCK_BITS + 1;
+   /* whole blocks, so that no scan of a block runs off the end */
+   oBBits->ulWords = oBBits->ulBlocks * BLOCK_WORDS;
+   oBBits->aulWords = calloc(oBBits->ulWords, sizeof(unsigned long));
+   oBBits->aulRanks = malloc((oBBits->ulBlocks + 1) * sizeof(size_t));
+   oBBits->aulSamples = malloc((ulLength / SELECT_SAMPLE + 1)
+                               * sizeof(size_t));
+   if(oBBits->aulWords == NULL || oBBits->aulRanks == NULL ||
+      oBBits->aulSamples == NULL) {
+      Bits_free(oBBits);
+      return NULL;
+   }
+   return oBBits;
+}
+
+/* see bitsFT.h for specification */
+void Bits_free(Bits_T oBBits) {
+   if(oBBits == NULL)
+      return;
+   free(oBBits->aulWords);
+   free(oBBits->aulRanks);
+   free(oBBits->aulSamples);
+   free(oBBits);
+}
+
+/* see bitsFT.h for specification */
+void Bits_set(Bits_T oBBits, size_t ulIndex) {
+   assert(oBBits != NULL);
+   assert(ulIndex < oBBits->ulLength);
+   oBBits->aulWords[ulIndex / WORD_BITS] |= 1UL << ulIndex % WORD_BITS;
+}
+
+/* see bitsFT.h for specification */
+void Bits_index(Bits_T oBBits) {
+   size_t ulOnes = 0;
+   size_t ulZeros;
+   size_t ulBlock;
+   size_t ulNext = 0;
+   size_t i;
+   assert(oBBits != NULL);
+   for(ulBlock = 0; ulBlock < oBBits->ulBlocks; ulBlock++) {
+      oBBits->aulRanks[ulBlock] = ulOnes;
+      for(i = 0; i < BLOCK_WORDS; i++)
+         ulOnes += Bits_countOnes(oBBits->aulWords[ulBlock * BLOCK_WORDS
+                                                   + i]);
+   }
+   oBBits->aulRanks[oBBits->ulBlocks] = ulOnes;
+
+   /* the 0s past the end are not counted */
+   for(ulBlock = 0; ulBlock < oBBits->ulBlocks; ulBlock++) {
+      ulZeros = (ulBlock + 1) * BLOCK_BITS
+         - oBBits->aulRanks[ulBlock + 1];
+      if(ulZeros > oBBits->ulLength - oBBits->aulRanks[oBBits->ulBlocks])
+         ulZeros = oBBits->ulLength - oBBits->aulRanks[oBBits->ulBlocks];
+      for(; ulNext * SELECT_SAMPLE < ulZeros; ulNext++)
+         oBBits->aulSamples[ulNext] = ulBlock;
+   }
+}
+
+/* see bitsFT.h for specification */
+boolean Bits_get(Bits_T oBBits, size_t ulIndex) {
+   assert(oBBits != NULL);
+   assert(ulIndex < oBBits->ulLength);
+   return (boolean) ((oBBits->aulWords[ulIndex / WORD_BITS]
+                      >> ulIndex % WORD_BITS) & 1UL);
+}
+
+/* see bitsFT.h for specification */
+size_t Bits_rank1(Bits_T oBBits, size_t ulIndex) {
+   size_t ulRank;
+   size_t ulWord;
+   assert(oBBits != NULL);
+   assert(ulIndex <= oBBits->ulLength);
+   ulRank = oBBits->aulRanks[ulIndex / BLOCK_BITS];
+   for(ulWord = ulIndex / BLOCK_BITS * BLOCK_WORDS;
+       ulWord < ulIndex / WORD_BITS; ulWord++)
+      ulRank += Bits_countOnes(oBBits->aulWords[ulWord]);
+   if(ulIndex % WORD_BITS != 0)
+      ulRank += Bits_countOnes(oBBits->aulWords[ulIndex / WORD_BITS]
+                               & ((1UL << ulIndex % WORD_BITS) - 1));
+   return ulRank;
+}
+
+/* see bitsFT.h for specification */
+size_t Bits_select0(Bits_T oBBits, size_t ulRank) {
+   size_t ulBlock;
+   size_t ulWord;
+   size_t ulZeros;
+   unsigned long ulFree;
+   assert(oBBits != NULL);
+   assert(ulRank < oBBits->ulLength - oBBits->aulRanks[oBBits->ulBlocks]);
+   /* from the sampled block, on to the block that holds it */
+   ulBlock = oBBits->aulSamples[ulRank / SELECT_SAMPLE];
+   while((ulBlock + 1) * BLOCK_BITS - oBBits->aulRanks[ulBlock + 1]
+         <= ulRank)
+      ulBlock++;
+   ulRank -= ulBlock * BLOCK_BITS - oBBits->aulRanks[ulBlock];
+   /* then to its word, and to its bit */
+   for(ulWord = ulBlock * BLOCK_WORDS; ; ulWord++) {
+      ulFree = ~oBBits->aulWords[ulWord];
+      ulZeros = Bits_countOnes(ulFree);
+      if(ulRank < ulZeros)
+         break;
+      ulRank -= ulZeros;
+   }
+   for(; ulRank > 0; ulRank--)
+      ulFree &= ulFree - 1;
+   return ulWord * WORD_BITS + Bits_lowestOne(ulFree);
+}
+
+/* see bitsFT.h for specification */
+size_t Bits_getSize(Bits_T oBBits) {
+   assert(oBBits != NULL);
+   return sizeof(struct bits) + oBBits->ulWords * sizeof(unsigned long)
+      + (oBBits->ulBlocks + 1) * sizeof(size_t)
+      + (oBBits->ulLength / SELECT_SAMPLE + 1) * sizeof(size_t);
+}
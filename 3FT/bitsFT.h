@@ -0,0 +1,53 @@
+/*--------------------------------------------------------------------*/
+/* bitsFT.h                                                           */
+/*--------------------------------------------------------------------*/
+#ifndef BITS_INCLUDED
+#define BITS_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A Bits_T is a fixed-length vector of bits that, once filled in and
+  indexed, answers rank queries (how many 1s come before a position)
+  and select queries (where the n-th 0 is) in close to constant time.
+  Its index takes about a quarter of a bit per bit: a count of the 1s
+  before every block of 512 bits, and the block of every 512th 0.
+*/
+typedef struct bits *Bits_T;
+
+/*
+  Returns a new vector of ulLength bits, all 0, or NULL if there is an
+  allocation error.
+*/
+Bits_T Bits_new(size_t ulLength);
+
+/* Frees oBBits. Does nothing if NULL. */
+void Bits_free(Bits_T oBBits);
+
+/* Sets bit ulIndex of oBBits, which must not yet be indexed, to 1. */
+void Bits_set(Bits_T oBBits, size_t ulIndex);
+
+/*
+  Indexes oBBits for Bits_rank1 and Bits_select0, after which its
+  bits must not change.
+*/
+void Bits_index(Bits_T oBBits);
+
+/* Returns bit ulIndex of oBBits. */
+boolean Bits_get(Bits_T oBBits, size_t ulIndex);
+
+/*
+  Returns the number of 1s before bit ulIndex of the indexed oBBits;
+  ulIndex may be its length.
+*/
+size_t Bits_rank1(Bits_T oBBits, size_t ulIndex);
+
+/*
+  Returns the position of the 0 of the indexed oBBits with ulRank 0s
+  before it, of which there must be one.
+*/
+size_t Bits_select0(Bits_T oBBits, size_t ulRank);
+
+/* Returns the number of bytes that oBBits and its index take. */
+size_t Bits_getSize(Bits_T oBBits);
+#endif
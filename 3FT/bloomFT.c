@@ -0,0 +1,125 @@
+/* Implementation of a blocked, counting Bloom filter of hashes */
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include "bloomFT.h"
+
+/* Parameters of the filter: COUNTERS_PER_HASH counters for each hash
+   it is sized for, in blocks of BLOCK_SIZE, which is a cache line;
+   each hash sets NUM_PROBES of its block's counters, chosen by
+   PROBE_BITS bits each */
+enum { COUNTERS_PER_HASH = 8, BLOCK_SIZE = 64, NUM_PROBES = 4,
+       PROBE_BITS = 6 };
+
+/* An odd multiplier that spreads a hash's bits for its probes */
+#define BLOOM_MUL ((size_t) 0xD6E8FEB86659FD93UL)
+
+/* A filter */
+struct bloom {
+   /* the allocated memory, and the first block within it */
+   unsigned char *pucAlloc;
+   unsigned char *pucBlocks;
+   /* the number of blocks */
+   size_t ulBlocks;
+   /* the number of hashes it is sized for, and that it holds */
+   size_t ulCapacity;
+   size_t ulCount;
+};
+
+/* see bloomFT.h for specification */
+Bloom_T Bloom_new(size_t ulCapacity) {
+   Bloom_T oBFilter;
+   size_t ulMisalign;
+   oBFilter = malloc(sizeof(struct bloom));
+   if(oBFilter == NULL)
+      return NULL;
+   oBFilter->ulBlocks = ulCapacity * COUNTERS_PER_HASH / BLOCK_SIZE + 1;
+   oBFilter->ulCapacity = ulCapacity;
+   oBFilter->ulCount = 0;
+   /* enough room to start the blocks on a cache line */
+   oBFilter->pucAlloc = calloc(oBFilter->ulBlocks + 1, BLOCK_SIZE);
+   if(oBFilter->pucAlloc == NULL) {
+      free(oBFilter);
+      return NULL;
+   }
+   ulMisalign = (size_t) oBFilter->pucAlloc % BLOCK_SIZE;
+   oBFilter->pucBlocks = oBFilter->pucAlloc
+      + (ulMisalign == 0 ? 0 : BLOCK_SIZE - ulMisalign);
+   return oBFilter;
+}
+
+/* see bloomFT.h for specification */
+void Bloom_free(Bloom_T oBFilter) {
+   if(oBFilter == NULL)
+      return;
+   free(oBFilter->pucAlloc);
+   free(oBFilter);
+}
+
+/*
+  Returns the block of oBFilter for ulHash, and sets *pulProbes to the
+  bits that choose its counters there, PROBE_BITS at a time from the
+  top.
+*/
+static unsigned char *Bloom_block(Bloom_T oBFilter, size_t ulHash,
+                                  size_t *pulProbes) {
+   assert(oBFilter != NULL);
+   assert(pulProbes != NULL);
+   *pulProbes = (ulHash ^ (ulHash >> (sizeof(size_t) * 4))) * BLOOM_MUL;
+   return oBFilter->pucBlocks + ulHash % oBFilter->ulBlocks * BLOCK_SIZE;
+}
+
+/* Returns the counter of probe i among ulProbes. */
+static size_t Bloom_probe(size_t ulProbes, size_t i) {
+   return (ulProbes >> (sizeof(size_t) * CHAR_BIT - PROBE_BITS * (i + 1)))
+      % BLOCK_SIZE;
+}
+
+/* see bloomFT.h for specification */
+void Bloom_add(Bloom_T oBFilter, size_t ulHash) {
+   unsigned char *pucBlock;
+   size_t ulProbes;
+   size_t i;
+   assert(oBFilter != NULL);
+   pucBlock = Bloom_block(oBFilter, ulHash, &ulProbes);
+   for(i = 0; i < NUM_PROBES; i++)
+      if(pucBlock[Bloom_probe(ulProbes, i)] != UCHAR_MAX)
+         pucBlock[Bloom_probe(ulProbes, i)]++;
+   oBFilter->ulCount++;
+}
+
+/* see bloomFT.h for specification */
+void Bloom_remove(Bloom_T oBFilter, size_t ulHash) {
+   unsigned char *pucBlock;
+   size_t ulProbes;
+   size_t i;
+   assert(oBFilter != NULL);
+   assert(oBFilter->ulCount > 0);
+   pucBlock = Bloom_block(oBFilter, ulHash, &ulProbes);
+   /* a saturated counter may stand for more hashes than it counts */
+   for(i = 0; i < NUM_PROBES; i++) {
+      assert(pucBlock[Bloom_probe(ulProbes, i)] != 0);
+      if(pucBlock[Bloom_probe(ulProbes, i)] != UCHAR_MAX)
+         pucBlock[Bloom_probe(ulProbes, i)]--;
+   }
+   oBFilter->ulCount--;
+}
+
+/* see bloomFT.h for specification */
+boolean Bloom_mayContain(Bloom_T oBFilter, size_t ulHash) {
+   const unsigned char *pucBlock;
+   size_t ulProbes;
+   size_t i;
+   assert(oBFilter != NULL);
+   pucBlock = Bloom_block(oBFilter, ulHash, &ulProbes);
+   for(i = 0; i < NUM_PROBES; i++)
+      if(pucBlock[Bloom_probe(ulProbes, i)] == 0)
+         return FALSE;
+   return TRUE;
+}
+
+/* see bloomFT.h for specification */
+boolean Bloom_isFull(Bloom_T oBFilter) {
+   assert(oBFilter != NULL);
+   return (boolean) (oBFilter->ulCount > oBFilter->ulCapacity);
+}
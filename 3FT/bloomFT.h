@@ -0,0 +1,45 @@
+/*--------------------------------------------------------------------*/
+/* bloomFT.h                                                          */
+/*--------------------------------------------------------------------*/
+#ifndef BLOOM_INCLUDED
+#define BLOOM_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A Bloom_T is a counting Bloom filter of hashes: it tells surely
+  whether a hash was never added, and otherwise that it may have been.
+  Each hash sets several one-byte counters, all within one cache-line
+  block, so that a check reads one line. Removing a hash decrements
+  its counters, except those that have saturated, which stay set for
+  good; the filter only ever errs towards "may have been added".
+*/
+typedef struct bloom *Bloom_T;
+
+/*
+  Returns a new, empty filter sized for ulCapacity hashes, or NULL if
+  there is an allocation error.
+*/
+Bloom_T Bloom_new(size_t ulCapacity);
+
+/* Frees oBFilter. Does nothing if NULL. */
+void Bloom_free(Bloom_T oBFilter);
+
+/* Adds ulHash to oBFilter. */
+void Bloom_add(Bloom_T oBFilter, size_t ulHash);
+
+/* Removes ulHash, which must have been added, from oBFilter. */
+void Bloom_remove(Bloom_T oBFilter, size_t ulHash);
+
+/*
+  Returns FALSE if ulHash is surely not in oBFilter, and TRUE if it may
+  be.
+*/
+boolean Bloom_mayContain(Bloom_T oBFilter, size_t ulHash);
+
+/*
+  Returns TRUE if oBFilter holds more hashes than it was sized for, so
+  that false positives grow more likely, and FALSE otherwise.
+*/
+boolean Bloom_isFull(Bloom_T oBFilter);
+#endif
@@ -13,8 +13,11 @@ stated restrictions */
 /* see checkerFT.h for specification */
 boolean CheckerFT_Node_isValid(Node_T oNNode) {
    Node_T oNParent;
-   Path_T oPNPath;
-   Path_T oPPPath;
+   Node_T oNFound = NULL;
+   Node_T oNShare;
+   const char *pcName;
+   size_t ulLength;
+   size_t ulIndex;
 
    /* Sample check: a NULL pointer is not a valid node */
    if(oNNode == NULL) {
@@ -22,17 +25,40 @@ boolean CheckerFT_Node_isValid(Node_T oNNode) {
       return FALSE;
    }
 
-   /* Sample check: parent's path must be the longest possible
-      proper prefix of the node's path */
+   /* a node's name must be a single, non-empty path component */
+   pcName = Node_getName(oNNode, &ulLength);
+   if(ulLength == 0 || memchr(pcName, '/', ulLength) != NULL) {
+      fprintf(stderr, "Node name is not a path component: (%.*s)\n",
+              (int) ulLength, pcName);
+      return FALSE;
+   }
+
+   /* a lazy copy must be a directory sharing a directory that is not
+      itself a lazy copy */
+   oNShare = Node_getShare(oNNode);
+   if(oNShare != NULL && (Node_getType(oNNode) ||
+                          Node_getType(oNShare) ||
+                          Node_getShare(oNShare) != NULL)) {
+      fprintf(stderr, "Lazy copy shares a non-directory: (%.*s)\n",
+              (int) ulLength, pcName);
+      return FALSE;
+   }
+
+   /* a node's parent must be a directory that lists the node under
+      its name, so that the paths derived from the parent links are
+      P-C paths */
    oNParent = Node_getParent(oNNode);
    if(oNParent != NULL) {
-      oPNPath = Node_getPath(oNNode);
-      oPPPath = Node_getPath(oNParent);
-
-      if(Path_getSharedPrefixDepth(oPNPath, oPPPath) !=
-         Path_getDepth(oPNPath) - 1) {
-         fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
-                 Path_getPathname(oPPPath), Path_getPathname(oPNPath));
+      if(Node_getType(oNParent)) {
+         fprintf(stderr, "A file has a child: (%.*s)\n",
+                 (int) ulLength, pcName);
+         return FALSE;
+      }
+      if(!Node_hasChildName(oNParent, pcName, ulLength, &ulIndex) ||
+         Node_getChild(oNParent, ulIndex, &oNFound) != SUCCESS ||
+         oNFound != oNNode) {
+         fprintf(stderr, "Parent does not list its child: (%.*s)\n",
+                 (int) ulLength, pcName);
          return FALSE;
       }
    }
@@ -40,6 +66,25 @@ boolean CheckerFT_Node_isValid(Node_T oNNode) {
    return TRUE;
 }
 
+/*
+  Compares the names of oNFirst and oNSecond, which are siblings, and
+  so orders them as their paths would be.
+*/
+static int CheckerFT_compareNames(Node_T oNFirst, Node_T oNSecond) {
+   const char *pcFirst, *pcSecond;
+   size_t ulFirst, ulSecond;
+   int iResult;
+   pcFirst = Node_getName(oNFirst, &ulFirst);
+   pcSecond = Node_getName(oNSecond, &ulSecond);
+   iResult = memcmp(pcFirst, pcSecond,
+                    ulFirst < ulSecond ? ulFirst : ulSecond);
+   if(iResult != 0)
+      return iResult;
+   if(ulFirst < ulSecond)
+      return -1;
+   return ulFirst > ulSecond;
+}
+
 /* Checks whether there are adjacent children nodes of the parent oNNode
 (oNChild and oNChildPrev) by passing ulIndex and if oNChildPrev is same
 as the passed in type of oNChild, performs validation checks for 
@@ -60,8 +105,7 @@ static boolean CheckerFT_checkNodeCompare(Node_T oNNode,
       consistent with the type */
       if((prevStatus == NOT_A_DIRECTORY && type == TRUE) || 
          (prevStatus == SUCCESS && type == FALSE)) {
-         nodeComparison = Path_comparePath(Node_getPath(oNChild), 
-            Node_getPath(oNChildPrev));
+         nodeComparison = CheckerFT_compareNames(oNChild, oNChildPrev);
          /* if same path, report duplicate path*/
          if(nodeComparison == 0) {
             fprintf(stderr, "Duplicate path detected in tree\n");
@@ -94,6 +138,18 @@ static boolean CheckerFT_treeCheck(Node_T oNNode, size_t *nodeCount) {
       if(!CheckerFT_Node_isValid(oNNode))
          return FALSE;
 
+      /* a lazy copy's children belong to, and are checked and counted
+         with, the directory it shares */
+      if(Node_getShare(oNNode) != NULL)
+         return TRUE;
+
+      /* a packed directory's children are files without nodes, which
+         the pack keeps in order as it is built */
+      if(Node_isPacked(oNNode)) {
+         *nodeCount += Node_getNumChildren(oNNode);
+         return TRUE;
+      }
+
       /* Recur on every child of oNNode */
       for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++)
       {
@@ -101,6 +157,13 @@ static boolean CheckerFT_treeCheck(Node_T oNNode, size_t *nodeCount) {
          Node_T oNChildPrev = NULL;
          iStatus = Node_getChild(oNNode, ulIndex, &oNChild);
 
+         /* the parent's record of the child's type must agree */
+         if(iStatus == SUCCESS &&
+            Node_isChildFile(oNNode, ulIndex) != Node_getType(oNChild)) {
+            fprintf(stderr, "Child's entry disagrees with its type\n");
+            return FALSE;
+         }
+
          /* if it's a file, then perform file checks. ordering of files
          first then directories handled in toString method of ft.c*/
          if (iStatus == NOT_A_DIRECTORY) {
@@ -0,0 +1,351 @@
+/* Implementation of reference-counted, optionally deduplicated file
+   contents in an arena or in mappings of files */
+/* for mmap, fstat, pread and sysconf */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "arena.h"
+#include "contentFT.h"
+
+/* The initial number of buckets in a deduplicating store's index,
+   which is always a power of two */
+enum { MIN_BUCKETS = 64 };
+
+/* A store of contents */
+struct contentStore {
+   /* the arena holding the contents */
+   Arena_T oAArena;
+   /* TRUE if identical contents are stored once */
+   boolean bDedup;
+   /* if bDedup, the hash chains indexing the contents; else NULL */
+   Content_T *aoCBuckets;
+   /* the number of buckets */
+   size_t ulBuckets;
+   /* the number of contents indexed */
+   size_t ulIndexed;
+};
+
+/* The header of a block of contents, which the bytes follow unless
+   they are mapped */
+struct content {
+   /* the store holding the contents */
+   ContentStore_T oSStore;
+   /* the number of references to the contents */
+   size_t ulRefs;
+   /* the number of bytes of contents */
+   size_t ulLength;
+   /* the hash of the bytes, if the store deduplicates */
+   unsigned long ulHash;
+   /* the next contents in the same hash chain */
+   Content_T oCNext;
+   /* TRUE if the contents are in the store's index */
+   boolean bIndexed;
+   /* the last pass of a walk that visited the contents */
+   unsigned long ulPass;
+   /* for contents mapped from a file, the start of the mapping, which
+      is page-aligned; otherwise NULL */
+   void *pvMapping;
+   /* the offset of the contents in the mapping */
+   size_t ulMapDelta;
+   /* padding so that the bytes are aligned for any type */
+   union { long double ld; void *pv; long l; } uAlign;
+};
+
+/*
+  Returns a hash of the ulLength bytes at pvBytes. It mixes in a word
+  at a time, so it costs little next to copying the bytes.
+*/
+static unsigned long Content_hash(const void *pvBytes, size_t ulLength) {
+   const unsigned char *pucBytes = pvBytes;
+   unsigned long ulHash = 14695981039346656037UL ^ ulLength;
+   unsigned long ulWord;
+   size_t ulAt = 0;
+   for(; ulAt + sizeof(ulWord) <= ulLength; ulAt += sizeof(ulWord)) {
+      memcpy(&ulWord, pucBytes + ulAt, sizeof(ulWord));
+      ulHash = (ulHash ^ ulWord) * 1099511628211UL;
+      ulHash ^= ulHash >> 29;
+   }
+   for(; ulAt < ulLength; ulAt++)
+      ulHash = (ulHash ^ pucBytes[ulAt]) * 1099511628211UL;
+   return ulHash ^ (ulHash >> 32);
+}
+
+/*
+  Doubles the number of buckets in oSStore's index. Returns TRUE, or
+  FALSE (leaving the index as it was) if there is an allocation error.
+*/
+static boolean ContentStore_grow(ContentStore_T oSStore) {
+   Content_T *aoCBuckets;
+   size_t ulBuckets = oSStore->ulBuckets * 2;
+   size_t ulBucket;
+   aoCBuckets = calloc(ulBuckets, sizeof(Content_T));
+   if(aoCBuckets == NULL)
+      return FALSE;
+   for(ulBucket = 0; ulBucket < oSStore->ulBuckets; ulBucket++) {
+      Content_T oCContent = oSStore->aoCBuckets[ulBucket];
+      while(oCContent != NULL) {
+         Content_T oCNext = oCContent->oCNext;
+         size_t ulNew = oCContent->ulHash & (ulBuckets - 1);
+         oCContent->oCNext = aoCBuckets[ulNew];
+         aoCBuckets[ulNew] = oCContent;
+         oCContent = oCNext;
+      }
+   }
+   free(oSStore->aoCBuckets);
+   oSStore->aoCBuckets = aoCBuckets;
+   oSStore->ulBuckets = ulBuckets;
+   return TRUE;
+}
+
+/* see contentFT.h for specification */
+ContentStore_T ContentStore_new(boolean bDedup) {
+   ContentStore_T oSStore;
+   oSStore = malloc(sizeof(struct contentStore));
+   if(oSStore == NULL)
+      return NULL;
+   oSStore->oAArena = Arena_new();
+   oSStore->bDedup = bDedup;
+   oSStore->aoCBuckets = NULL;
+   oSStore->ulBuckets = 0;
+   oSStore->ulIndexed = 0;
+   if(bDedup) {
+      oSStore->ulBuckets = MIN_BUCKETS;
+      oSStore->aoCBuckets = calloc(MIN_BUCKETS, sizeof(Content_T));
+   }
+   if(oSStore->oAArena == NULL ||
+      (bDedup && oSStore->aoCBuckets == NULL)) {
+      ContentStore_free(oSStore);
+      return NULL;
+   }
+   return oSStore;
+}
+
+/* see contentFT.h for specification */
+void ContentStore_free(ContentStore_T oSStore) {
+   if(oSStore == NULL)
+      return;
+   Arena_free(oSStore->oAArena);
+   free(oSStore->aoCBuckets);
+   free(oSStore);
+}
+
+/* see contentFT.h for specification */
+Content_T Content_new(ContentStore_T oSStore, const void *pvBytes,
+                      size_t ulLength) {
+   Content_T oCContent;
+   unsigned long ulHash = 0;
+   size_t ulBucket = 0;
+   assert(oSStore != NULL);
+   assert(pvBytes != NULL || ulLength == 0);
+
+   if(oSStore->bDedup) {
+      ulHash = Content_hash(pvBytes, ulLength);
+      ulBucket = ulHash & (oSStore->ulBuckets - 1);
+      for(oCContent = oSStore->aoCBuckets[ulBucket]; oCContent != NULL;
+          oCContent = oCContent->oCNext)
+         if(oCContent->ulHash == ulHash &&
+            oCContent->ulLength == ulLength &&
+            memcmp(oCContent + 1, pvBytes, ulLength) == 0)
+            return Content_ref(oCContent);
+   }
+   oCContent = Arena_alloc(oSStore->oAArena,
+                           sizeof(struct content) + ulLength);
+   if(oCContent == NULL)
+      return NULL;
+   oCContent->oSStore = oSStore;
+   oCContent->ulRefs = 1;
+   oCContent->ulLength = ulLength;
+   oCContent->ulHash = ulHash;
+   oCContent->oCNext = NULL;
+   oCContent->bIndexed = oSStore->bDedup;
+   oCContent->ulPass = 0;
+   oCContent->pvMapping = NULL;
+   oCContent->ulMapDelta = 0;
+   if(ulLength != 0)
+      memcpy(oCContent + 1, pvBytes, ulLength);
+   if(oSStore->bDedup) {
+      /* keep the chains short; if growing fails, they just get longer */
+      if(oSStore->ulIndexed >= oSStore->ulBuckets &&
+         ContentStore_grow(oSStore))
+         ulBucket = ulHash & (oSStore->ulBuckets - 1);
+      oCContent->oCNext = oSStore->aoCBuckets[ulBucket];
+      oSStore->aoCBuckets[ulBucket] = oCContent;
+      oSStore->ulIndexed++;
+   }
+   return oCContent;
+}
+
+/* see contentFT.h for specification */
+Content_T Content_newWritable(ContentStore_T oSStore,
+                              const void *pvBytes, size_t ulLength,
+                              size_t ulCapacity) {
+   Content_T oCContent;
+   assert(oSStore != NULL);
+   assert(pvBytes != NULL || ulLength == 0);
+   assert(ulLength <= ulCapacity);
+   oCContent = Arena_alloc(oSStore->oAArena,
+                           sizeof(struct content) + ulCapacity);
+   if(oCContent == NULL)
+      return NULL;
+   oCContent->oSStore = oSStore;
+   oCContent->ulRefs = 1;
+   oCContent->ulLength = ulCapacity;
+   oCContent->ulHash = 0;
+   oCContent->oCNext = NULL;
+   oCContent->bIndexed = FALSE;
+   oCContent->ulPass = 0;
+   oCContent->pvMapping = NULL;
+   oCContent->ulMapDelta = 0;
+   if(ulLength != 0)
+      memcpy(oCContent + 1, pvBytes, ulLength);
+   return oCContent;
+}
+
+/*
+  Returns a new Content_T holding the ulLength bytes of the file open
+  on iFd at offset ulOffset, copied into oSStore, or NULL if there is
+  an allocation error or they cannot all be read. If iFd cannot seek,
+  as for a pipe, the bytes before ulOffset are read and discarded.
+*/
+static Content_T Content_newRead(ContentStore_T oSStore, int iFd,
+                                 size_t ulOffset, size_t ulLength) {
+   Content_T oCContent;
+   char *pcBytes;
+   boolean bSeekable;
+   size_t ulSkip = 0;
+   size_t ulDone = 0;
+   ssize_t lRead;
+   oCContent = Content_newWritable(oSStore, NULL, 0, ulLength);
+   if(oCContent == NULL)
+      return NULL;
+   pcBytes = Content_getBytes(oCContent);
+   bSeekable = (boolean) (lseek(iFd, 0, SEEK_CUR) != (off_t) -1);
+   while(ulDone < ulLength) {
+      if(bSeekable)
+         lRead = pread(iFd, pcBytes + ulDone, ulLength - ulDone,
+                       (off_t) (ulOffset + ulDone));
+      else if(ulSkip < ulOffset)
+         lRead = read(iFd, pcBytes, ulOffset - ulSkip < ulLength ?
+                      ulOffset - ulSkip : ulLength);
+      else
+         lRead = read(iFd, pcBytes + ulDone, ulLength - ulDone);
+      if(lRead <= 0) {
+         Content_release(oCContent);
+         return NULL;
+      }
+      if(!bSeekable && ulSkip < ulOffset)
+         ulSkip += (size_t) lRead;
+      else
+         ulDone += (size_t) lRead;
+   }
+   return oCContent;
+}
+
+/* see contentFT.h for specification */
+Content_T Content_newMapped(ContentStore_T oSStore, int iFd,
+                            size_t ulOffset, size_t ulLength) {
+   Content_T oCContent;
+   struct stat sStat;
+   size_t ulDelta;
+   void *pvMapping;
+   assert(oSStore != NULL);
+   assert(ulLength != 0);
+
+   if(fstat(iFd, &sStat) != 0)
+      return NULL;
+   /* mapping past the end of a file would fault when read */
+   if(S_ISREG(sStat.st_mode) &&
+      ((size_t) sStat.st_size < ulOffset ||
+       (size_t) sStat.st_size - ulOffset < ulLength))
+      return NULL;
+   ulDelta = ulOffset % (size_t) sysconf(_SC_PAGESIZE);
+   pvMapping = mmap(NULL, ulDelta + ulLength, PROT_READ, MAP_PRIVATE,
+                    iFd, (off_t) (ulOffset - ulDelta));
+   if(pvMapping == MAP_FAILED)
+      /* pipes and the like cannot be mapped, so read those */
+      return Content_newRead(oSStore, iFd, ulOffset, ulLength);
+   oCContent = malloc(sizeof(struct content));
+   if(oCContent == NULL) {
+      (void) munmap(pvMapping, ulDelta + ulLength);
+      return NULL;
+   }
+   oCContent->oSStore = oSStore;
+   oCContent->ulRefs = 1;
+   oCContent->ulLength = ulLength;
+   oCContent->ulHash = 0;
+   oCContent->oCNext = NULL;
+   oCContent->bIndexed = FALSE;
+   oCContent->ulPass = 0;
+   oCContent->pvMapping = pvMapping;
+   oCContent->ulMapDelta = ulDelta;
+   return oCContent;
+}
+
+/* see contentFT.h for specification */
+boolean Content_isWritable(Content_T oCContent) {
+   assert(oCContent != NULL);
+   return (boolean) (oCContent->ulRefs == 1 && !oCContent->bIndexed &&
+                     oCContent->pvMapping == NULL);
+}
+
+/* see contentFT.h for specification */
+Content_T Content_ref(Content_T oCContent) {
+   assert(oCContent != NULL);
+   oCContent->ulRefs++;
+   return oCContent;
+}
+
+/* see contentFT.h for specification */
+void Content_release(Content_T oCContent) {
+   ContentStore_T oSStore;
+   Content_T *poCLink;
+   assert(oCContent != NULL);
+   assert(oCContent->ulRefs > 0);
+   if(--oCContent->ulRefs != 0)
+      return;
+   oSStore = oCContent->oSStore;
+   if(oCContent->bIndexed) {
+      poCLink = &oSStore->aoCBuckets[oCContent->ulHash &
+                                     (oSStore->ulBuckets - 1)];
+      while(*poCLink != oCContent)
+         poCLink = &(*poCLink)->oCNext;
+      *poCLink = oCContent->oCNext;
+      oSStore->ulIndexed--;
+   }
+   if(oCContent->pvMapping != NULL) {
+      (void) munmap(oCContent->pvMapping,
+                    oCContent->ulMapDelta + oCContent->ulLength);
+      free(oCContent);
+      return;
+   }
+   Arena_release(oSStore->oAArena, oCContent,
+                 sizeof(struct content) + oCContent->ulLength);
+}
+
+/* see contentFT.h for specification */
+void *Content_getBytes(Content_T oCContent) {
+   assert(oCContent != NULL);
+   if(oCContent->pvMapping != NULL)
+      return (char *) oCContent->pvMapping + oCContent->ulMapDelta;
+   return oCContent + 1;
+}
+
+/* see contentFT.h for specification */
+size_t Content_getLength(Content_T oCContent) {
+   assert(oCContent != NULL);
+   return oCContent->ulLength;
+}
+
+/* see contentFT.h for specification */
+boolean Content_visit(Content_T oCContent, unsigned long ulPass) {
+   assert(oCContent != NULL);
+   if(oCContent->ulPass == ulPass)
+      return FALSE;
+   oCContent->ulPass = ulPass;
+   return TRUE;
+}
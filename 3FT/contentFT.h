@@ -0,0 +1,100 @@
+/*--------------------------------------------------------------------*/
+/* contentFT.h                                                        */
+/*--------------------------------------------------------------------*/
+#ifndef CONTENT_INCLUDED
+#define CONTENT_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A ContentStore_T holds copies of files' contents in an arena. If it
+  deduplicates, it also indexes them by a hash of their bytes, so that
+  identical contents are stored once however many files hold them.
+*/
+typedef struct contentStore *ContentStore_T;
+
+/*
+  A Content_T is a reference-counted copy of a file's contents in a
+  ContentStore_T. Each node owning large contents holds one reference
+  to a Content_T; copies of the node, and in a deduplicating store
+  all nodes with identical contents, share it.
+*/
+typedef struct content *Content_T;
+
+/*
+  Returns a new, empty store that deduplicates contents if bDedup is
+  TRUE, or NULL if there is an allocation error.
+*/
+ContentStore_T ContentStore_new(boolean bDedup);
+
+/*
+  Frees oSStore and any contents still in it, which must no longer be
+  used. Does nothing if oSStore is NULL.
+*/
+void ContentStore_free(ContentStore_T oSStore);
+
+/*
+  Returns a Content_T holding the ulLength bytes at pvBytes, with one
+  new reference for the caller, or NULL if there is an allocation
+  error. If oSStore deduplicates and already holds identical bytes,
+  returns those; otherwise copies the bytes into oSStore.
+*/
+Content_T Content_new(ContentStore_T oSStore, const void *pvBytes,
+                      size_t ulLength);
+
+/*
+  Returns a new Content_T of ulCapacity bytes, the first ulLength of
+  which are copied from pvBytes, with one reference; or NULL if there
+  is an allocation error. It is never shared with identical contents,
+  so its bytes may be changed while Content_isWritable allows it.
+*/
+Content_T Content_newWritable(ContentStore_T oSStore,
+                              const void *pvBytes, size_t ulLength,
+                              size_t ulCapacity);
+
+/*
+  Returns TRUE if oCContent was made by Content_newWritable and holds
+  a single reference, so that its holder may change its bytes.
+*/
+boolean Content_isWritable(Content_T oCContent);
+
+/*
+  Returns a new Content_T holding the ulLength (> 0) bytes at offset
+  ulOffset of the file open on iFd, with one reference; or NULL if
+  they cannot be obtained, including if the file is shorter than
+  ulOffset + ulLength. The bytes are mapped read-only rather than
+  copied, and unmapped when the last reference is dropped, so the file
+  must not be changed meanwhile; iFd itself may be closed. If iFd
+  cannot be mapped (a pipe, say), the bytes are read into oSStore
+  instead. They are never shared with identical contents.
+*/
+Content_T Content_newMapped(ContentStore_T oSStore, int iFd,
+                            size_t ulOffset, size_t ulLength);
+
+/* Adds a reference to oCContent and returns oCContent. */
+Content_T Content_ref(Content_T oCContent);
+
+/*
+  Drops a reference to oCContent, returning its storage to its store
+  when the last reference is dropped.
+*/
+void Content_release(Content_T oCContent);
+
+/*
+  Returns the bytes held by oCContent, which are aligned for any type
+  and stay valid for as long as a reference to oCContent is held.
+  They may be shared, so must not be modified unless
+  Content_isWritable(oCContent).
+*/
+void *Content_getBytes(Content_T oCContent);
+
+/* Returns the number of bytes held by oCContent. */
+size_t Content_getLength(Content_T oCContent);
+
+/*
+  Records that oCContent has been seen during pass ulPass of a walk
+  over contents. Returns TRUE if this is the first time in that pass,
+  and FALSE otherwise, so that shared contents can be counted once.
+*/
+boolean Content_visit(Content_T oCContent, unsigned long ulPass);
+#endif
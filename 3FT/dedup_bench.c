@@ -0,0 +1,142 @@
+/*--------------------------------------------------------------------*/
+/* dedup_bench.c                                                      */
+/* Benchmark of owned and deduplicated file contents                  */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ft.h"
+
+/* Tree and contents parameters */
+enum { NUM_FILES = 100000, FILES_PER_DIR = 100, MIN_SIZE = 16,
+       MAX_SIZE = 4096, MAX_PATH_LEN = 64 };
+
+/*
+  Fills the ulLength bytes at pcBuf with random contents, as from a
+  generated or vendored source file.
+*/
+static void DedupBench_fill(char *pcBuf, size_t ulLength) {
+   size_t i;
+   assert(pcBuf != NULL);
+   for(i = 0; i < ulLength; i++)
+      pcBuf[i] = (char) ('a' + rand() % 26);
+}
+
+/* Returns the name of mode eMode. */
+static const char *DedupBench_modeName(enum contentMode eMode) {
+   switch(eMode) {
+      case FT_CONTENTS_BORROWED: return "borrowed";
+      case FT_CONTENTS_OWNED: return "owned";
+      default: return "dedup";
+   }
+}
+
+/*
+  Times building a tree whose files have contents apcContents[i] of
+  aulLens[i] bytes, then reading back every file, in mode eMode, and
+  prints the results along with the storage the tree reports.
+*/
+static void DedupBench_run(enum contentMode eMode, char **apcContents,
+                           size_t *aulLens) {
+   clock_t tStart;
+   double dInsert, dRead;
+   size_t ulLogical = 0, ulPhysical = 0;
+   size_t ulCheck = 0;
+   size_t i;
+   char acPath[MAX_PATH_LEN];
+
+   if(FT_setContentMode(eMode) != SUCCESS || FT_init() != SUCCESS)
+      exit(EXIT_FAILURE);
+
+   tStart = clock();
+   for(i = 0; i < NUM_FILES; i++) {
+      sprintf(acPath, "bench/d%05lu/f%07lu",
+              (unsigned long) (i / FILES_PER_DIR), (unsigned long) i);
+      if(FT_insertFile(acPath, apcContents[i], aulLens[i]) != SUCCESS)
+         exit(EXIT_FAILURE);
+   }
+   dInsert = (double) (clock() - tStart) / CLOCKS_PER_SEC;
+
+   tStart = clock();
+   for(i = 0; i < NUM_FILES; i++) {
+      char *pcContents;
+      sprintf(acPath, "bench/d%05lu/f%07lu",
+              (unsigned long) (i / FILES_PER_DIR), (unsigned long) i);
+      pcContents = FT_getFileContents(acPath);
+      if(pcContents == NULL)
+         exit(EXIT_FAILURE);
+      ulCheck += (unsigned char) pcContents[aulLens[i] - 1];
+   }
+   dRead = (double) (clock() - tStart) / CLOCKS_PER_SEC;
+
+   if(FT_statStorage("bench", &ulLogical, &ulPhysical) != SUCCESS)
+      exit(EXIT_FAILURE);
+   printf("%-8s insert %7.1f ns/file   read %7.1f ns/file   "
+          "logical %7.1f MB   physical %7.1f MB   (%lu)\n",
+          DedupBench_modeName(eMode),
+          dInsert * 1e9 / NUM_FILES, dRead * 1e9 / NUM_FILES,
+          (double) ulLogical / 1e6, (double) ulPhysical / 1e6,
+          (unsigned long) ulCheck);
+   (void) FT_destroy();
+}
+
+/*
+  Builds the contents of NUM_FILES files, of which the fraction given
+  by argv[1] (0.5 by default) duplicate an earlier file, and compares
+  the content modes on them. Returns 0, or EXIT_FAILURE if argv[1] is
+  not a fraction.
+*/
+int main(int argc, char *argv[]) {
+   static char *apcContents[NUM_FILES];
+   static size_t aulLens[NUM_FILES];
+   double dRatio = 0.5;
+   size_t ulDistinct = 0;
+   size_t i;
+
+   if(argc > 1) {
+      dRatio = atof(argv[1]);
+      if(dRatio < 0.0 || dRatio > 1.0) {
+         fprintf(stderr, "usage: %s [duplication ratio in 0..1]\n",
+                 argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   srand(217);
+   for(i = 0; i < NUM_FILES; i++) {
+      if(i != 0 && (double) rand() / RAND_MAX < dRatio) {
+         /* duplicate a random earlier file, in a buffer of its own */
+         size_t ulOrig = (size_t) rand() % i;
+         aulLens[i] = aulLens[ulOrig];
+         apcContents[i] = malloc(aulLens[i]);
+         if(apcContents[i] != NULL)
+            memcpy(apcContents[i], apcContents[ulOrig], aulLens[i]);
+      }
+      else {
+         aulLens[i] = MIN_SIZE
+            + (size_t) rand() % (MAX_SIZE - MIN_SIZE + 1);
+         apcContents[i] = malloc(aulLens[i]);
+         if(apcContents[i] != NULL)
+            DedupBench_fill(apcContents[i], aulLens[i]);
+         ulDistinct++;
+      }
+      if(apcContents[i] == NULL) {
+         fprintf(stderr, "out of memory\n");
+         return EXIT_FAILURE;
+      }
+   }
+   printf("corpus: %d files, %lu distinct (duplication ratio %.2f)\n",
+          NUM_FILES, (unsigned long) ulDistinct, dRatio);
+
+   DedupBench_run(FT_CONTENTS_BORROWED, apcContents, aulLens);
+   DedupBench_run(FT_CONTENTS_OWNED, apcContents, aulLens);
+   DedupBench_run(FT_CONTENTS_DEDUP, apcContents, aulLens);
+
+   for(i = 0; i < NUM_FILES; i++)
+      free(apcContents[i]);
+   return 0;
+}
@@ -0,0 +1,431 @@
+/* Implementation of a parallel export of FT nodes to disk */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "arena.h"
+#include "dynarray.h"
+#include "exportFT.h"
+
+/* The most files, and the most bytes of contents, in a batch taken
+   by a thread at once; the most directories likewise; and the size
+   of the buffer each thread reads contents into when they cannot be
+   written straight from the node */
+enum { BATCH_FILES = 256, BATCH_BYTES = 1 << 20, BATCH_DIRS = 64,
+       COPY_BUFFER = 1 << 16 };
+
+/* A directory or file to create */
+struct exportItem {
+   /* the file's node, or NULL for a directory */
+   Node_T oNFile;
+   /* the directory's depth */
+   size_t ulDepth;
+};
+
+/* A plan */
+struct export {
+   /* the arena holding the items */
+   Arena_T oAArena;
+   /* the directories and files to create, in the order added */
+   DynArray_T oDDirs;
+   DynArray_T oDFiles;
+   /* when the plan was begun */
+   struct timespec sBegun;
+};
+
+/* One phase of a plan being carried out: items to share out */
+struct exportPhase {
+   /* the items: a range of directories of one depth, or the files */
+   DynArray_T oDItems;
+   size_t ulEnd;
+   /* TRUE if the items are files */
+   boolean bFiles;
+   /* protects the fields below */
+   pthread_mutex_t sLock;
+   /* the first item not yet taken */
+   size_t ulNext;
+   /* SUCCESS, or the first error met */
+   int iStatus;
+};
+
+/*
+  Returns the '\0'-terminated path on disk of psItem, which follows it
+  in the same block.
+*/
+static char *Export_path(const struct exportItem *psItem) {
+   assert(psItem != NULL);
+   return (char *) (psItem + 1);
+}
+
+/* Returns the nanoseconds from *psFrom to *psTo. */
+static unsigned long Export_elapsed(const struct timespec *psFrom,
+                                    const struct timespec *psTo) {
+   assert(psFrom != NULL);
+   assert(psTo != NULL);
+   return (unsigned long) (psTo->tv_sec - psFrom->tv_sec) * 1000000000UL
+          + (unsigned long) psTo->tv_nsec - (unsigned long) psFrom->tv_nsec;
+}
+
+/* see exportFT.h for specification */
+Export_T Export_new(void) {
+   Export_T oXExport;
+   oXExport = malloc(sizeof(struct export));
+   if(oXExport == NULL)
+      return NULL;
+   oXExport->oAArena = Arena_new();
+   oXExport->oDDirs = DynArray_new(0);
+   oXExport->oDFiles = DynArray_new(0);
+   if(oXExport->oAArena == NULL || oXExport->oDDirs == NULL ||
+      oXExport->oDFiles == NULL) {
+      Export_free(oXExport);
+      return NULL;
+   }
+   (void) clock_gettime(CLOCK_MONOTONIC, &oXExport->sBegun);
+   return oXExport;
+}
+
+/* see exportFT.h for specification */
+void Export_free(Export_T oXExport) {
+   if(oXExport == NULL)
+      return;
+   if(oXExport->oAArena != NULL)
+      Arena_free(oXExport->oAArena);
+   if(oXExport->oDDirs != NULL)
+      DynArray_free(oXExport->oDDirs);
+   if(oXExport->oDFiles != NULL)
+      DynArray_free(oXExport->oDFiles);
+   free(oXExport);
+}
+
+/*
+  Adds an item for the ulLength characters at pcPath, with node oNFile
+  and depth ulDepth, to oDItems, allocating it from oXExport's arena.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+static int Export_add(Export_T oXExport, DynArray_T oDItems,
+                      const char *pcPath, size_t ulLength,
+                      Node_T oNFile, size_t ulDepth) {
+   struct exportItem *psItem;
+   assert(oXExport != NULL);
+   assert(oDItems != NULL);
+   assert(pcPath != NULL);
+   psItem = Arena_alloc(oXExport->oAArena,
+                        sizeof(struct exportItem) + ulLength + 1);
+   if(psItem == NULL)
+      return MEMORY_ERROR;
+   psItem->oNFile = oNFile;
+   psItem->ulDepth = ulDepth;
+   memcpy(Export_path(psItem), pcPath, ulLength);
+   Export_path(psItem)[ulLength] = '\0';
+   if(!DynArray_add(oDItems, psItem))
+      return MEMORY_ERROR;
+   return SUCCESS;
+}
+
+/* see exportFT.h for specification */
+int Export_addDir(Export_T oXExport, const char *pcPath,
+                  size_t ulLength, size_t ulDepth) {
+   assert(oXExport != NULL);
+   assert((ulDepth == 0) == (DynArray_getLength(oXExport->oDDirs) == 0));
+   return Export_add(oXExport, oXExport->oDDirs, pcPath, ulLength,
+                     NULL, ulDepth);
+}
+
+/* see exportFT.h for specification */
+int Export_addFile(Export_T oXExport, const char *pcPath,
+                   size_t ulLength, Node_T oNFile) {
+   assert(oXExport != NULL);
+   assert(oNFile != NULL);
+   return Export_add(oXExport, oXExport->oDFiles, pcPath, ulLength,
+                     oNFile, 0);
+}
+
+/* Compares the depths of directories psFirst and psSecond. */
+static int Export_compareDepths(const struct exportItem *psFirst,
+                                const struct exportItem *psSecond) {
+   assert(psFirst != NULL);
+   assert(psSecond != NULL);
+   if(psFirst->ulDepth != psSecond->ulDepth)
+      return psFirst->ulDepth < psSecond->ulDepth ? -1 : 1;
+   return 0;
+}
+
+/* Returns TRUE if the ulLength bytes at pcBytes are all zeros. */
+static boolean Export_isZero(const char *pcBytes, size_t ulLength) {
+   size_t ulIndex;
+   assert(pcBytes != NULL || ulLength == 0);
+   for(ulIndex = 0; ulIndex < ulLength; ulIndex++)
+      if(pcBytes[ulIndex] != '\0')
+         return FALSE;
+   return TRUE;
+}
+
+/*
+  Writes the ulLength bytes at pcBytes at offset ulOffset of the file
+  open on iFd, unless they are all zeros, and stores in *pbWritten
+  whether they were written. Returns SUCCESS, or MEMORY_ERROR if they
+  could not all be written.
+*/
+static int Export_writeAt(int iFd, const char *pcBytes,
+                          size_t ulLength, size_t ulOffset,
+                          boolean *pbWritten) {
+   ssize_t lWritten;
+   assert(pbWritten != NULL);
+   *pbWritten = (boolean) !Export_isZero(pcBytes, ulLength);
+   if(!*pbWritten)
+      return SUCCESS;
+   while(ulLength != 0) {
+      lWritten = pwrite(iFd, pcBytes, ulLength, (off_t) ulOffset);
+      if(lWritten <= 0)
+         return MEMORY_ERROR;
+      pcBytes += lWritten;
+      ulOffset += (size_t) lWritten;
+      ulLength -= (size_t) lWritten;
+   }
+   return SUCCESS;
+}
+
+/*
+  Writes the file of psItem, reading its contents through pcBuffer,
+  which has room for COPY_BUFFER bytes, if they are chunked. Returns
+  SUCCESS, or MEMORY_ERROR if it could not be created or written.
+*/
+static int Export_writeFile(const struct exportItem *psItem,
+                            char *pcBuffer) {
+   const char *pcContents;
+   size_t ulSize;
+   size_t ulDone;
+   size_t ulRead;
+   boolean bWritten = TRUE;
+   int iFd;
+   int iStatus = SUCCESS;
+   assert(psItem != NULL);
+   assert(pcBuffer != NULL);
+   iFd = open(Export_path(psItem), O_WRONLY | O_CREAT | O_EXCL, 0666);
+   if(iFd < 0)
+      return MEMORY_ERROR;
+   ulSize = Node_getSizeContents(psItem->oNFile);
+   pcContents = Node_getFileContents(psItem->oNFile);
+   /* a piece at a time, so that a small file takes one write, and
+      runs of zeros are skipped */
+   for(ulDone = 0; iStatus == SUCCESS && ulDone < ulSize;
+       ulDone += ulRead) {
+      if(pcContents != NULL) {
+         ulRead = ulSize - ulDone < COPY_BUFFER ?
+                  ulSize - ulDone : COPY_BUFFER;
+         iStatus = Export_writeAt(iFd, pcContents + ulDone, ulRead,
+                                  ulDone, &bWritten);
+      }
+      else {
+         ulRead = Node_readAt(psItem->oNFile, ulDone, pcBuffer,
+                              COPY_BUFFER);
+         iStatus = Export_writeAt(iFd, pcBuffer, ulRead, ulDone,
+                                  &bWritten);
+      }
+   }
+   /* skipped zeros at the end must still be part of the file */
+   if(iStatus == SUCCESS && !bWritten &&
+      ftruncate(iFd, (off_t) ulSize) != 0)
+      iStatus = MEMORY_ERROR;
+   if(close(iFd) != 0)
+      iStatus = MEMORY_ERROR;
+   return iStatus;
+}
+
+/*
+  Takes the next batch of psPhase's items, storing the range of their
+  indices in *pulFirst and *pulEnd. Returns FALSE if there were none
+  left, or an error has been met, and TRUE otherwise.
+*/
+static boolean Export_takeBatch(struct exportPhase *psPhase,
+                                size_t *pulFirst, size_t *pulEnd) {
+   struct exportItem *psItem;
+   size_t ulBytes = 0;
+   size_t ulEnd;
+   assert(psPhase != NULL);
+   assert(pulFirst != NULL);
+   assert(pulEnd != NULL);
+   pthread_mutex_lock(&psPhase->sLock);
+   ulEnd = psPhase->ulNext;
+   if(psPhase->iStatus == SUCCESS) {
+      if(!psPhase->bFiles)
+         ulEnd = psPhase->ulNext + BATCH_DIRS < psPhase->ulEnd ?
+                 psPhase->ulNext + BATCH_DIRS : psPhase->ulEnd;
+      /* many small files, or one large one */
+      else
+         while(ulEnd < psPhase->ulEnd &&
+               ulEnd - psPhase->ulNext < BATCH_FILES &&
+               ulBytes < BATCH_BYTES) {
+            psItem = DynArray_get(psPhase->oDItems, ulEnd);
+            ulBytes += Node_getSizeContents(psItem->oNFile);
+            ulEnd++;
+         }
+   }
+   *pulFirst = psPhase->ulNext;
+   *pulEnd = ulEnd;
+   psPhase->ulNext = ulEnd;
+   pthread_mutex_unlock(&psPhase->sLock);
+   return (boolean) (*pulFirst != *pulEnd);
+}
+
+/*
+  Creates the directories or writes the files of phase pvPhase, a
+  batch at a time, until there are none left or an error is met.
+*/
+static void *Export_work(void *pvPhase) {
+   struct exportPhase *psPhase = pvPhase;
+   struct exportItem *psItem;
+   char *pcBuffer = NULL;
+   size_t ulIndex;
+   size_t ulEnd;
+   int iStatus = SUCCESS;
+   assert(psPhase != NULL);
+   if(psPhase->bFiles) {
+      pcBuffer = malloc(COPY_BUFFER);
+      if(pcBuffer == NULL)
+         iStatus = MEMORY_ERROR;
+   }
+   while(iStatus == SUCCESS &&
+         Export_takeBatch(psPhase, &ulIndex, &ulEnd))
+      for(; iStatus == SUCCESS && ulIndex < ulEnd; ulIndex++) {
+         psItem = DynArray_get(psPhase->oDItems, ulIndex);
+         if(psPhase->bFiles)
+            iStatus = Export_writeFile(psItem, pcBuffer);
+         else if(mkdir(Export_path(psItem), 0777) != 0)
+            iStatus = MEMORY_ERROR;
+      }
+   free(pcBuffer);
+   if(iStatus != SUCCESS) {
+      pthread_mutex_lock(&psPhase->sLock);
+      if(psPhase->iStatus == SUCCESS)
+         psPhase->iStatus = iStatus;
+      pthread_mutex_unlock(&psPhase->sLock);
+   }
+   return NULL;
+}
+
+/*
+  Carries out the items of oDItems from index ulFirst to ulEnd, files
+  if bFiles is TRUE and directories otherwise, with up to ulThreads
+  threads, this one included. Returns SUCCESS or the first error met.
+*/
+static int Export_runPhase(DynArray_T oDItems, size_t ulFirst,
+                           size_t ulEnd, boolean bFiles,
+                           size_t ulThreads) {
+   struct exportPhase sPhase;
+   pthread_t *psThreads;
+   boolean *pbStarted;
+   size_t ulBatches;
+   size_t ulIndex;
+   assert(oDItems != NULL);
+   assert(ulThreads > 0);
+   /* there is no use for more threads than batches */
+   if(bFiles)
+      /* a batch of files may be a single large file */
+      ulBatches = ulEnd - ulFirst;
+   else
+      ulBatches = (ulEnd - ulFirst + BATCH_DIRS - 1) / BATCH_DIRS;
+   if(ulThreads > ulBatches)
+      ulThreads = ulBatches;
+   if(ulThreads == 0)
+      return SUCCESS;
+   sPhase.oDItems = oDItems;
+   sPhase.ulEnd = ulEnd;
+   sPhase.bFiles = bFiles;
+   sPhase.ulNext = ulFirst;
+   sPhase.iStatus = SUCCESS;
+   pthread_mutex_init(&sPhase.sLock, NULL);
+   psThreads = malloc(ulThreads * sizeof(pthread_t));
+   pbStarted = calloc(ulThreads, sizeof(boolean));
+   /* this thread works too; threads that cannot be started leave the
+      work to the others */
+   for(ulIndex = 1; psThreads != NULL && pbStarted != NULL &&
+       ulIndex < ulThreads; ulIndex++)
+      pbStarted[ulIndex] = (boolean)
+         (pthread_create(&psThreads[ulIndex], NULL, Export_work,
+                         &sPhase) == 0);
+   (void) Export_work(&sPhase);
+   for(ulIndex = 1; psThreads != NULL && pbStarted != NULL &&
+       ulIndex < ulThreads; ulIndex++)
+      if(pbStarted[ulIndex])
+         pthread_join(psThreads[ulIndex], NULL);
+   free(psThreads);
+   free(pbStarted);
+   pthread_mutex_destroy(&sPhase.sLock);
+   return sPhase.iStatus;
+}
+
+/* see exportFT.h for specification */
+int Export_run(Export_T oXExport, size_t ulThreads,
+               unsigned long *pulPlanNs, unsigned long *pulDirsNs,
+               unsigned long *pulFilesNs) {
+   struct timespec sStart;
+   struct timespec sDirsDone;
+   struct timespec sFilesDone;
+   struct exportItem *psItem;
+   size_t ulDirs;
+   size_t ulFirst;
+   size_t ulEnd;
+   long lProcessors;
+   int iStatus;
+   assert(oXExport != NULL);
+   assert(DynArray_getLength(oXExport->oDDirs) != 0);
+   assert(pulPlanNs != NULL);
+   assert(pulDirsNs != NULL);
+   assert(pulFilesNs != NULL);
+   (void) clock_gettime(CLOCK_MONOTONIC, &sStart);
+   *pulPlanNs = Export_elapsed(&oXExport->sBegun, &sStart);
+   *pulDirsNs = 0;
+   *pulFilesNs = 0;
+   if(ulThreads == 0) {
+      lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+      ulThreads = lProcessors > 0 ? (size_t) lProcessors : 1;
+   }
+
+   /* the first directory's errors say where the export can't go */
+   psItem = DynArray_get(oXExport->oDDirs, 0);
+   if(mkdir(Export_path(psItem), 0777) != 0) {
+      if(errno == EEXIST)
+         return ALREADY_IN_TREE;
+      if(errno == ENOENT)
+         return NO_SUCH_PATH;
+      if(errno == ENOTDIR)
+         return NOT_A_DIRECTORY;
+      return MEMORY_ERROR;
+   }
+   /* then each depth in turn */
+   DynArray_sort(oXExport->oDDirs,
+                 (int (*)(const void *, const void *))
+                 Export_compareDepths);
+   ulDirs = DynArray_getLength(oXExport->oDDirs);
+   iStatus = SUCCESS;
+   for(ulFirst = 1; iStatus == SUCCESS && ulFirst < ulDirs;
+       ulFirst = ulEnd) {
+      psItem = DynArray_get(oXExport->oDDirs, ulFirst);
+      for(ulEnd = ulFirst + 1; ulEnd < ulDirs; ulEnd++)
+         if(((struct exportItem *) DynArray_get(oXExport->oDDirs,
+                                                ulEnd))->ulDepth
+            != psItem->ulDepth)
+            break;
+      iStatus = Export_runPhase(oXExport->oDDirs, ulFirst, ulEnd, FALSE,
+                                ulThreads);
+   }
+   (void) clock_gettime(CLOCK_MONOTONIC, &sDirsDone);
+   *pulDirsNs = Export_elapsed(&sStart, &sDirsDone);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = Export_runPhase(oXExport->oDFiles, 0,
+                             DynArray_getLength(oXExport->oDFiles),
+                             TRUE, ulThreads);
+   (void) clock_gettime(CLOCK_MONOTONIC, &sFilesDone);
+   *pulFilesNs = Export_elapsed(&sDirsDone, &sFilesDone);
+   return iStatus;
+}
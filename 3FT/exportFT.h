@@ -0,0 +1,68 @@
+/*--------------------------------------------------------------------*/
+/* exportFT.h                                                         */
+/*--------------------------------------------------------------------*/
+#ifndef EXPORT_INCLUDED
+#define EXPORT_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+#include "nodeFT.h"
+
+/*
+  An Export_T is a plan for writing part of an FT out to disk: the
+  paths of the directories to create, and of the files to write with
+  the contents of their nodes. It is listed in one thread and then
+  carried out by several.
+*/
+typedef struct export *Export_T;
+
+/*
+  Returns a new, empty plan, or NULL if there is an allocation error.
+  The time until Export_run is reported as the time taken to plan.
+*/
+Export_T Export_new(void);
+
+/* Frees oXExport. Does nothing if oXExport is NULL. */
+void Export_free(Export_T oXExport);
+
+/*
+  Adds to oXExport the directory on disk at the ulLength characters
+  at pcPath, which need not be '\0'-terminated, at depth ulDepth below
+  the first directory added, which is at depth 0 and must be added
+  first. Every directory must be added after the one containing it.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Export_addDir(Export_T oXExport, const char *pcPath,
+                  size_t ulLength, size_t ulDepth);
+
+/*
+  Adds to oXExport the file on disk at the ulLength characters at
+  pcPath, holding the contents of file node oNFile, which must be in
+  a directory already added. Returns SUCCESS, or MEMORY_ERROR if
+  memory could not be allocated.
+*/
+int Export_addFile(Export_T oXExport, const char *pcPath,
+                   size_t ulLength, Node_T oNFile);
+
+/*
+  Carries out oXExport with ulThreads threads (one per processor, if
+  ulThreads is 0). First the directories are created, one depth at a
+  time so that each exists before anything inside it, with the
+  directories at each depth shared out between the threads. Then the
+  files are written, by threads each taking a batch of files at a
+  time: many small files, or a single large one. Runs of zeros (as in
+  holes) are skipped rather than written, so that they stay sparse on
+  disk. The nodes must not be changed meanwhile.
+  Stores the nanoseconds taken to plan, to create the directories and
+  to write the files in *pulPlanNs, *pulDirsNs and *pulFilesNs.
+  Returns SUCCESS, or otherwise stops early (leaving on disk whatever
+  was written) and returns:
+  * ALREADY_IN_TREE if the first directory already exists
+  * NO_SUCH_PATH if the directory to contain the first does not exist
+  * NOT_A_DIRECTORY if a prefix of the first directory is a file
+  * MEMORY_ERROR if memory could not be allocated, or a directory or
+                 file could not be written
+*/
+int Export_run(Export_T oXExport, size_t ulThreads,
+               unsigned long *pulPlanNs, unsigned long *pulDirsNs,
+               unsigned long *pulFilesNs);
+#endif
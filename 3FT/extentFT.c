@@ -0,0 +1,386 @@
+/* Implementation of file contents as a list of chunked extents */
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "dynarray.h"
+#include "extentFT.h"
+
+/* The size of a full chunk, and of the smallest chunk allocated */
+enum { CHUNK_SIZE = 4096, MIN_CHUNK = 16 };
+
+/* An extent: the part of the contents held in one chunk */
+struct extent {
+   /* the chunk's position: it holds the bytes at offsets from
+      ulIndex * CHUNK_SIZE */
+   size_t ulIndex;
+   /* the number of bytes of contents the chunk holds */
+   size_t ulLength;
+   /* the chunk, whose capacity may exceed ulLength */
+   Content_T oCChunk;
+};
+
+/* A file's contents */
+struct extents {
+   /* the extents, sorted by ulIndex */
+   DynArray_T oDExtents;
+   /* the number of bytes of contents */
+   size_t ulLength;
+};
+
+/*
+  Returns the capacity to allocate for a chunk that must hold
+  ulNeeded bytes: the next power of two, so that a growing chunk is
+  copied O(log CHUNK_SIZE) times at most.
+*/
+static size_t Extents_capacityFor(size_t ulNeeded) {
+   size_t ulCapacity = MIN_CHUNK;
+   assert(ulNeeded <= CHUNK_SIZE);
+   while(ulCapacity < ulNeeded)
+      ulCapacity *= 2;
+   return ulCapacity;
+}
+
+/*
+  Compares extent psExtent's position with *pulIndex.
+  Returns <0, 0, or >0 if psExtent's is less than, equal to, or
+  greater than *pulIndex, respectively.
+*/
+static int Extents_compareIndex(const struct extent *psExtent,
+                                const size_t *pulIndex) {
+   assert(psExtent != NULL);
+   assert(pulIndex != NULL);
+   if(psExtent->ulIndex < *pulIndex)
+      return -1;
+   return psExtent->ulIndex > *pulIndex;
+}
+
+/*
+  Returns the extent of oEExtents at position ulIndex, storing its
+  index in the list in *pulAt; or returns NULL if there is none, and
+  stores the index at which it would be inserted in *pulAt.
+*/
+static struct extent *Extents_find(Extents_T oEExtents, size_t ulIndex,
+                                   size_t *pulAt) {
+   assert(oEExtents != NULL);
+   assert(pulAt != NULL);
+   if(!DynArray_bsearch(oEExtents->oDExtents, &ulIndex, pulAt,
+            (int (*)(const void*,const void*)) Extents_compareIndex))
+      return NULL;
+   return DynArray_get(oEExtents->oDExtents, *pulAt);
+}
+
+/*
+  Inserts a new extent at position ulIndex into oEExtents' list at
+  index ulAt, with an empty chunk from oSStore of ulCapacity bytes.
+  Returns the extent, or NULL if there is an allocation error.
+*/
+static struct extent *Extents_add(Extents_T oEExtents,
+                                  ContentStore_T oSStore, size_t ulAt,
+                                  size_t ulIndex, size_t ulCapacity) {
+   struct extent *psExtent;
+   psExtent = malloc(sizeof(struct extent));
+   if(psExtent == NULL)
+      return NULL;
+   psExtent->ulIndex = ulIndex;
+   psExtent->ulLength = 0;
+   psExtent->oCChunk = Content_newWritable(oSStore, NULL, 0, ulCapacity);
+   if(psExtent->oCChunk == NULL) {
+      free(psExtent);
+      return NULL;
+   }
+   if(!DynArray_addAt(oEExtents->oDExtents, ulAt, psExtent)) {
+      Content_release(psExtent->oCChunk);
+      free(psExtent);
+      return NULL;
+   }
+   return psExtent;
+}
+
+/* Removes the extent at index ulAt of oEExtents' list. */
+static void Extents_remove(Extents_T oEExtents, size_t ulAt) {
+   struct extent *psExtent;
+   psExtent = DynArray_removeAt(oEExtents->oDExtents, ulAt);
+   Content_release(psExtent->oCChunk);
+   free(psExtent);
+}
+
+/*
+  Ensures that extent psExtent's chunk can be written to, and holds at
+  least ulNeeded bytes, by replacing it with a copy from oSStore if
+  not. Returns SUCCESS, or MEMORY_ERROR (leaving the extent as it was)
+  if memory could not be allocated.
+*/
+static int Extents_prepare(struct extent *psExtent,
+                           ContentStore_T oSStore, size_t ulNeeded) {
+   Content_T oCChunk;
+   assert(psExtent != NULL);
+   if(Content_isWritable(psExtent->oCChunk) &&
+      Content_getLength(psExtent->oCChunk) >= ulNeeded)
+      return SUCCESS;
+   if(ulNeeded < psExtent->ulLength)
+      ulNeeded = psExtent->ulLength;
+   oCChunk = Content_newWritable(oSStore,
+                                 Content_getBytes(psExtent->oCChunk),
+                                 psExtent->ulLength,
+                                 Extents_capacityFor(ulNeeded));
+   if(oCChunk == NULL)
+      return MEMORY_ERROR;
+   Content_release(psExtent->oCChunk);
+   psExtent->oCChunk = oCChunk;
+   return SUCCESS;
+}
+
+/*
+  Makes the bytes of oEExtents' contents from ulStart to ulEnd zeros
+  up to ulData, and from there on the bytes of pcData, which starts at
+  offset ulData (possibly before ulStart), in the chunks
+  holding them, without changing the length of the contents. Every
+  chunk is prepared
+  before any is changed, so that on failure the contents read as they
+  did before: only empty extents were added, and those are removed.
+  Returns SUCCESS or MEMORY_ERROR.
+*/
+static int Extents_span(Extents_T oEExtents, ContentStore_T oSStore,
+                        size_t ulStart, size_t ulEnd,
+                        const char *pcData, size_t ulData) {
+   size_t ulIndex, ulAt, ulFrom, ulTo;
+   struct extent *psExtent;
+   char *pcChunk;
+   int iStatus = SUCCESS;
+   assert(oEExtents != NULL);
+   assert(ulStart <= ulEnd && ulData <= ulEnd);
+   if(ulStart == ulEnd)
+      return SUCCESS;
+
+   for(ulIndex = ulStart / CHUNK_SIZE;
+       ulIndex <= (ulEnd - 1) / CHUNK_SIZE; ulIndex++) {
+      ulTo = ulEnd - ulIndex * CHUNK_SIZE;
+      if(ulTo > CHUNK_SIZE)
+         ulTo = CHUNK_SIZE;
+      psExtent = Extents_find(oEExtents, ulIndex, &ulAt);
+      if(psExtent == NULL) {
+         if(Extents_add(oEExtents, oSStore, ulAt, ulIndex,
+                        Extents_capacityFor(ulTo)) == NULL) {
+            iStatus = MEMORY_ERROR;
+            break;
+         }
+      }
+      else if(Extents_prepare(psExtent, oSStore, ulTo) != SUCCESS) {
+         iStatus = MEMORY_ERROR;
+         break;
+      }
+   }
+   if(iStatus != SUCCESS) {
+      /* remove the empty extents added, then give up */
+      for(ulIndex = ulStart / CHUNK_SIZE;
+          ulIndex <= (ulEnd - 1) / CHUNK_SIZE; ulIndex++) {
+         psExtent = Extents_find(oEExtents, ulIndex, &ulAt);
+         if(psExtent != NULL && psExtent->ulLength == 0)
+            Extents_remove(oEExtents, ulAt);
+      }
+      return iStatus;
+   }
+
+   for(ulIndex = ulStart / CHUNK_SIZE;
+       ulIndex <= (ulEnd - 1) / CHUNK_SIZE; ulIndex++) {
+      size_t ulBase = ulIndex * CHUNK_SIZE;
+      psExtent = Extents_find(oEExtents, ulIndex, &ulAt);
+      assert(psExtent != NULL);
+      pcChunk = Content_getBytes(psExtent->oCChunk);
+      ulFrom = ulStart > ulBase ? ulStart - ulBase : 0;
+      ulTo = ulEnd - ulBase < CHUNK_SIZE ? ulEnd - ulBase : CHUNK_SIZE;
+      /* nothing the chunk held beyond its length may show through */
+      if(psExtent->ulLength < ulFrom)
+         memset(pcChunk + psExtent->ulLength, 0,
+                ulFrom - psExtent->ulLength);
+      if(ulData > ulBase + ulFrom) {
+         size_t ulZeros = ulData - ulBase < ulTo ?
+            ulData - ulBase - ulFrom : ulTo - ulFrom;
+         memset(pcChunk + ulFrom, 0, ulZeros);
+         ulFrom += ulZeros;
+      }
+      if(ulTo > ulFrom)
+         memmove(pcChunk + ulFrom, pcData + (ulBase + ulFrom - ulData),
+                 ulTo - ulFrom);
+      if(psExtent->ulLength < ulTo)
+         psExtent->ulLength = ulTo;
+   }
+   return SUCCESS;
+}
+
+/* see extentFT.h for specification */
+Extents_T Extents_new(ContentStore_T oSStore, const void *pvBytes,
+                      size_t ulLength) {
+   Extents_T oEExtents;
+   const char *pcBytes = pvBytes;
+   size_t ulStart, ulEnd, ulAt;
+   assert(oSStore != NULL);
+   oEExtents = malloc(sizeof(struct extents));
+   if(oEExtents == NULL)
+      return NULL;
+   oEExtents->ulLength = 0;
+   oEExtents->oDExtents = DynArray_new(0);
+   if(oEExtents->oDExtents == NULL) {
+      free(oEExtents);
+      return NULL;
+   }
+   if(pcBytes != NULL)
+      for(ulStart = 0; ulStart < ulLength; ulStart = ulEnd) {
+         ulEnd = ulStart + CHUNK_SIZE < ulLength ?
+            ulStart + CHUNK_SIZE : ulLength;
+         /* chunks of zeros are left as holes */
+         for(ulAt = ulStart; ulAt < ulEnd && pcBytes[ulAt] == 0; ulAt++)
+            ;
+         if(ulAt < ulEnd &&
+            Extents_span(oEExtents, oSStore, ulStart, ulEnd, pcBytes, 0)
+            != SUCCESS) {
+            Extents_free(oEExtents);
+            return NULL;
+         }
+      }
+   oEExtents->ulLength = ulLength;
+   return oEExtents;
+}
+
+/* see extentFT.h for specification */
+Extents_T Extents_copy(Extents_T oESource) {
+   Extents_T oEExtents;
+   size_t ulAt;
+   assert(oESource != NULL);
+   oEExtents = malloc(sizeof(struct extents));
+   if(oEExtents == NULL)
+      return NULL;
+   oEExtents->ulLength = oESource->ulLength;
+   oEExtents->oDExtents =
+      DynArray_new(DynArray_getLength(oESource->oDExtents));
+   if(oEExtents->oDExtents == NULL) {
+      free(oEExtents);
+      return NULL;
+   }
+   for(ulAt = 0; ulAt < DynArray_getLength(oESource->oDExtents); ulAt++) {
+      struct extent *psExtent = malloc(sizeof(struct extent));
+      if(psExtent == NULL) {
+         /* the array holds only the extents copied so far */
+         while(ulAt-- > 0) {
+            psExtent = DynArray_get(oEExtents->oDExtents, ulAt);
+            Content_release(psExtent->oCChunk);
+            free(psExtent);
+         }
+         DynArray_free(oEExtents->oDExtents);
+         free(oEExtents);
+         return NULL;
+      }
+      *psExtent = *(struct extent *) DynArray_get(oESource->oDExtents,
+                                                   ulAt);
+      (void) Content_ref(psExtent->oCChunk);
+      (void) DynArray_set(oEExtents->oDExtents, ulAt, psExtent);
+   }
+   return oEExtents;
+}
+
+/* see extentFT.h for specification */
+void Extents_free(Extents_T oEExtents) {
+   assert(oEExtents != NULL);
+   while(DynArray_getLength(oEExtents->oDExtents) != 0)
+      Extents_remove(oEExtents,
+                     DynArray_getLength(oEExtents->oDExtents) - 1);
+   DynArray_free(oEExtents->oDExtents);
+   free(oEExtents);
+}
+
+/* see extentFT.h for specification */
+size_t Extents_getLength(Extents_T oEExtents) {
+   assert(oEExtents != NULL);
+   return oEExtents->ulLength;
+}
+
+/* see extentFT.h for specification */
+size_t Extents_read(Extents_T oEExtents, size_t ulOffset, void *pvBuf,
+                    size_t ulLength) {
+   char *pcBuf = pvBuf;
+   size_t ulDone = 0;
+   size_t ulAt;
+   assert(oEExtents != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+   if(ulOffset >= oEExtents->ulLength)
+      return 0;
+   if(ulLength > oEExtents->ulLength - ulOffset)
+      ulLength = oEExtents->ulLength - ulOffset;
+   while(ulDone < ulLength) {
+      size_t ulPos = ulOffset + ulDone;
+      size_t ulWithin = ulPos % CHUNK_SIZE;
+      size_t ulTake = CHUNK_SIZE - ulWithin;
+      size_t ulHeld = 0;
+      struct extent *psExtent;
+      if(ulTake > ulLength - ulDone)
+         ulTake = ulLength - ulDone;
+      psExtent = Extents_find(oEExtents, ulPos / CHUNK_SIZE, &ulAt);
+      if(psExtent != NULL && psExtent->ulLength > ulWithin) {
+         ulHeld = psExtent->ulLength - ulWithin;
+         if(ulHeld > ulTake)
+            ulHeld = ulTake;
+         memcpy(pcBuf + ulDone,
+                (char *) Content_getBytes(psExtent->oCChunk) + ulWithin,
+                ulHeld);
+      }
+      /* bytes no chunk holds read as zeros */
+      memset(pcBuf + ulDone + ulHeld, 0, ulTake - ulHeld);
+      ulDone += ulTake;
+   }
+   return ulLength;
+}
+
+/* see extentFT.h for specification */
+int Extents_write(Extents_T oEExtents, ContentStore_T oSStore,
+                  size_t ulOffset, const void *pvBytes, size_t ulLength) {
+   int iStatus;
+   assert(oEExtents != NULL);
+   assert(oSStore != NULL);
+   assert(pvBytes != NULL || ulLength == 0);
+   if(ulLength == 0)
+      return SUCCESS;
+   /* a gap past the end is left as a hole */
+   iStatus = Extents_span(oEExtents, oSStore, ulOffset,
+                          ulOffset + ulLength, pvBytes, ulOffset);
+   if(iStatus == SUCCESS && oEExtents->ulLength < ulOffset + ulLength)
+      oEExtents->ulLength = ulOffset + ulLength;
+   return iStatus;
+}
+
+/* see extentFT.h for specification */
+int Extents_truncate(Extents_T oEExtents, size_t ulLength) {
+   size_t ulAt;
+   struct extent *psExtent;
+   assert(oEExtents != NULL);
+   /* extending only moves the end, leaving a hole */
+   if(ulLength >= oEExtents->ulLength) {
+      oEExtents->ulLength = ulLength;
+      return SUCCESS;
+   }
+   /* drop the extents wholly past the new end, and trim the last */
+   for(ulAt = DynArray_getLength(oEExtents->oDExtents); ulAt-- > 0;) {
+      psExtent = DynArray_get(oEExtents->oDExtents, ulAt);
+      if(psExtent->ulIndex * CHUNK_SIZE >= ulLength)
+         Extents_remove(oEExtents, ulAt);
+      else {
+         if(psExtent->ulLength > ulLength - psExtent->ulIndex * CHUNK_SIZE)
+            psExtent->ulLength = ulLength - psExtent->ulIndex * CHUNK_SIZE;
+         break;
+      }
+   }
+   oEExtents->ulLength = ulLength;
+   return SUCCESS;
+}
+
+/* see extentFT.h for specification */
+size_t Extents_countStored(Extents_T oEExtents, unsigned long ulPass) {
+   size_t ulAt;
+   size_t ulStored = 0;
+   assert(oEExtents != NULL);
+   for(ulAt = 0; ulAt < DynArray_getLength(oEExtents->oDExtents); ulAt++) {
+      struct extent *psExtent = DynArray_get(oEExtents->oDExtents, ulAt);
+      if(Content_visit(psExtent->oCChunk, ulPass))
+         ulStored += Content_getLength(psExtent->oCChunk);
+   }
+   return ulStored;
+}
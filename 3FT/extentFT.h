@@ -0,0 +1,72 @@
+/*--------------------------------------------------------------------*/
+/* extentFT.h                                                         */
+/*--------------------------------------------------------------------*/
+#ifndef EXTENTS_INCLUDED
+#define EXTENTS_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+#include "contentFT.h"
+
+/*
+  An Extents_T holds a file's contents as a sorted list of extents,
+  each a fixed-size, aligned chunk of the file held in a Content_T, so
+  that reading, writing, appending or truncating touches only the
+  chunks in the range concerned. Chunks never written are holes: they
+  read as zeros and take no storage, so that sparse contents take
+  storage in proportion to the data written. Copies share chunks
+  until either copy writes to them.
+*/
+typedef struct extents *Extents_T;
+
+/*
+  Returns a new Extents_T holding a copy of the ulLength bytes at
+  pvBytes in chunks from oSStore, leaving chunks of zeros as holes, or
+  NULL if there is an allocation error. If pvBytes is NULL, the
+  contents are ulLength bytes of zeros, all in one hole.
+*/
+Extents_T Extents_new(ContentStore_T oSStore, const void *pvBytes,
+                      size_t ulLength);
+
+/*
+  Returns a new Extents_T with the same contents as oESource, sharing
+  its chunks, or NULL if there is an allocation error.
+*/
+Extents_T Extents_copy(Extents_T oESource);
+
+/* Frees oEExtents and releases its chunks. */
+void Extents_free(Extents_T oEExtents);
+
+/* Returns the number of bytes of contents in oEExtents. */
+size_t Extents_getLength(Extents_T oEExtents);
+
+/*
+  Copies up to ulLength bytes of oEExtents' contents, starting at
+  offset ulOffset, to pvBuf. Returns the number of bytes copied, which
+  is less than ulLength only if the contents end first.
+*/
+size_t Extents_read(Extents_T oEExtents, size_t ulOffset, void *pvBuf,
+                    size_t ulLength);
+
+/*
+  Writes the ulLength bytes at pvBytes into oEExtents' contents at
+  offset ulOffset, extending them if necessary; any gap between their
+  old end and ulOffset is left as a hole. New and changed chunks come
+  from oSStore. Returns SUCCESS, or MEMORY_ERROR (leaving the
+  contents unchanged) if memory could not be allocated.
+*/
+int Extents_write(Extents_T oEExtents, ContentStore_T oSStore,
+                  size_t ulOffset, const void *pvBytes, size_t ulLength);
+
+/*
+  Shortens or extends oEExtents' contents to ulLength bytes, extending
+  them with a hole. Returns SUCCESS.
+*/
+int Extents_truncate(Extents_T oEExtents, size_t ulLength);
+
+/*
+  Returns the number of bytes allocated to oEExtents' chunks that have
+  not already been visited in pass ulPass (see Content_visit), and
+  marks them visited.
+*/
+size_t Extents_countStored(Extents_T oEExtents, unsigned long ulPass);
+#endif
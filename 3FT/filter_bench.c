@@ -0,0 +1,105 @@
+/*--------------------------------------------------------------------*/
+/* filter_bench.c                                                     */
+/* Benchmark of FT_containsFile on mostly missing paths               */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ft.h"
+
+/* Tree parameters: NUM_FILES files, FILES_PER_DIR per directory, and
+   MISSING_PERCENT of the lookups for paths not in the tree */
+enum { NUM_FILES = 200000, FILES_PER_DIR = 50, NUM_LOOKUPS = 2000000,
+       MISSING_PERCENT = 60, MAX_PATH_LEN = 64 };
+
+/*
+  Writes to pcPath the path of file ulIndex, or of a missing file
+  beside it if bMissing is TRUE.
+*/
+static void FilterBench_path(char *pcPath, size_t ulIndex,
+                             boolean bMissing) {
+   assert(pcPath != NULL);
+   sprintf(pcPath, "bench/src/d%04lu/%s%07lu.c",
+           (unsigned long) (ulIndex / FILES_PER_DIR),
+           bMissing ? "cache" : "file", (unsigned long) ulIndex);
+}
+
+/*
+  Times NUM_LOOKUPS lookups of the paths in apcPaths, with
+  FT_containsFile if bContains is TRUE and with FT_stat otherwise,
+  checking each against abPresent, and returns the nanoseconds per
+  lookup.
+*/
+static double FilterBench_lookups(char **apcPaths, boolean *abPresent,
+                                  boolean bContains) {
+   clock_t tStart;
+   size_t ulSize;
+   size_t i;
+   boolean bIsFile;
+   boolean bFound;
+   tStart = clock();
+   for(i = 0; i < NUM_LOOKUPS; i++) {
+      if(bContains)
+         bFound = FT_containsFile(apcPaths[i % NUM_FILES]);
+      else
+         bFound = (boolean) (FT_stat(apcPaths[i % NUM_FILES], &bIsFile,
+                                     &ulSize) == SUCCESS);
+      if(bFound != abPresent[i % NUM_FILES])
+         exit(EXIT_FAILURE);
+   }
+   return (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e9
+      / NUM_LOOKUPS;
+}
+
+/*
+  Builds a tree of NUM_FILES files, and compares lookups of a mix of
+  its files and missing ones in a random order through the filter
+  (FT_containsFile) and without it (FT_stat). Returns 0, or
+  EXIT_FAILURE if memory could not be allocated.
+*/
+int main(void) {
+   static char *apcPaths[NUM_FILES];
+   static boolean abPresent[NUM_FILES];
+   struct filterStats sStats;
+   double dFiltered, dUnfiltered;
+   size_t i;
+
+   srand(217);
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < NUM_FILES; i++) {
+      apcPaths[i] = malloc(MAX_PATH_LEN);
+      if(apcPaths[i] == NULL) {
+         fprintf(stderr, "out of memory\n");
+         return EXIT_FAILURE;
+      }
+      FilterBench_path(apcPaths[i], i, FALSE);
+      if(FT_insertFile(apcPaths[i], NULL, 0) != SUCCESS)
+         return EXIT_FAILURE;
+   }
+   /* then some paths are swapped for missing ones, at random */
+   for(i = 0; i < NUM_FILES; i++) {
+      abPresent[i] = (boolean) (rand() % 100 >= MISSING_PERCENT);
+      if(!abPresent[i])
+         FilterBench_path(apcPaths[i], (size_t) rand() % NUM_FILES,
+                          TRUE);
+   }
+
+   dUnfiltered = FilterBench_lookups(apcPaths, abPresent, FALSE);
+   dFiltered = FilterBench_lookups(apcPaths, abPresent, TRUE);
+   FT_getFilterStats(&sStats);
+   printf("%d%% missing: stat %7.1f ns   contains %7.1f ns\n",
+          MISSING_PERCENT, dUnfiltered, dFiltered);
+   printf("filter: %lu avoided, %lu passed (%lu false positives), "
+          "%lu bypassed, %lu builds\n", sStats.ulAvoided,
+          sStats.ulPassed, sStats.ulFalsePositives, sStats.ulBypassed,
+          sStats.ulBuilds);
+
+   for(i = 0; i < NUM_FILES; i++)
+      free(apcPaths[i]);
+   (void) FT_destroy();
+   return 0;
+}
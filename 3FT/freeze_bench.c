@@ -0,0 +1,167 @@
+/*--------------------------------------------------------------------*/
+/* freeze_bench.c                                                     */
+/* Benchmark of lookups and traversals on a frozen FT                 */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ft.h"
+
+/* Tree parameters: NUM_FILES files, FANOUT entries per directory */
+enum { NUM_FILES = 200000, FANOUT = 20, NUM_LOOKUPS = 2000000,
+       MAX_PATH_LEN = 96 };
+
+/*
+  Writes to pcPath the path of file ulIndex: a directory for each
+  base-FANOUT digit of ulIndex, below a root.
+*/
+static void FreezeBench_path(char *pcPath, size_t ulIndex) {
+   size_t ulDigits = ulIndex;
+   char *pcEnd;
+   assert(pcPath != NULL);
+   pcEnd = pcPath + sprintf(pcPath, "bench");
+   do {
+      pcEnd += sprintf(pcEnd, "/module%02lu",
+                       (unsigned long) (ulDigits % FANOUT));
+      ulDigits /= FANOUT;
+   } while(ulDigits != 0);
+   sprintf(pcEnd, "/source%07lu.c", (unsigned long) ulIndex);
+}
+
+/*
+  Times NUM_LOOKUPS lookups of the paths in apcPaths, in the order
+  given by aulOrder, each of which must return iWant, and returns the
+  nanoseconds per lookup.
+*/
+static double FreezeBench_lookups(char **apcPaths, size_t *aulOrder,
+                                  int iWant) {
+   clock_t tStart;
+   size_t ulSize = 1;
+   size_t ulCheck = 0;
+   size_t i;
+   boolean bIsFile;
+   /* a miss leaves ulSize at 1, so that every lookup counts once */
+   tStart = clock();
+   for(i = 0; i < NUM_LOOKUPS; i++) {
+      if(FT_stat(apcPaths[aulOrder[i % NUM_FILES]], &bIsFile, &ulSize)
+         != iWant)
+         exit(EXIT_FAILURE);
+      ulCheck += ulSize;
+   }
+   if(ulCheck != NUM_LOOKUPS)
+      exit(EXIT_FAILURE);
+   return (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e9
+      / NUM_LOOKUPS;
+}
+
+/* Returns the seconds taken by FT_toString, which must match pcWant. */
+static double FreezeBench_toString(const char *pcWant) {
+   clock_t tStart;
+   char *pcString;
+   tStart = clock();
+   pcString = FT_toString();
+   if(pcString == NULL ||
+      (pcWant != NULL && strcmp(pcString, pcWant) != 0))
+      exit(EXIT_FAILURE);
+   free(pcString);
+   return (double) (clock() - tStart) / CLOCKS_PER_SEC;
+}
+
+/*
+  Times freezing the FT as eIndex asks, after thawing it, and prints
+  the time and the sizes of the frozen form, per path in bits.
+*/
+static void FreezeBench_freeze(enum freezeIndex eIndex,
+                               const char *pcName) {
+   struct freezeStats sStats;
+   clock_t tStart;
+   double dEntries;
+   if(FT_thaw() != SUCCESS)
+      exit(EXIT_FAILURE);
+   tStart = clock();
+   if(FT_freeze(eIndex, &sStats) != SUCCESS)
+      exit(EXIT_FAILURE);
+   dEntries = (double) sStats.ulEntries;
+   printf("freeze %-7s %7.1f ms for %lu paths: layout %6.1f, "
+          "hash %4.2f, slots %5.1f bits per path\n", pcName,
+          (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e3,
+          (unsigned long) sStats.ulEntries,
+          sStats.ulLayoutBytes * 8 / dEntries,
+          sStats.ulHashBytes * 8 / dEntries,
+          sStats.ulSlotBytes * 8 / dEntries);
+}
+
+/*
+  Builds a tree of NUM_FILES files, and compares lookups of its files
+  and of missing files next to them, in a random order, and
+  FT_toString on it before and after freezing it, with and without a
+  perfect hash index. Returns 0, or EXIT_FAILURE if memory could not
+  be allocated.
+*/
+int main(void) {
+   static char *apcPaths[NUM_FILES];
+   static char *apcMissing[NUM_FILES];
+   static size_t aulOrder[NUM_FILES];
+   double adLive[2], adFrozen[2], adHashed[2];
+   double dLive, dFrozen;
+   char *pcString;
+   size_t i, j, ulSwap;
+
+   srand(217);
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < NUM_FILES; i++) {
+      apcPaths[i] = malloc(MAX_PATH_LEN);
+      apcMissing[i] = malloc(MAX_PATH_LEN);
+      if(apcPaths[i] == NULL || apcMissing[i] == NULL) {
+         fprintf(stderr, "out of memory\n");
+         return EXIT_FAILURE;
+      }
+      FreezeBench_path(apcPaths[i], i);
+      strcpy(apcMissing[i], apcPaths[i]);
+      apcMissing[i][strlen(apcMissing[i]) - 1] = 'h';
+      if(FT_insertFile(apcPaths[i], NULL, 1) != SUCCESS)
+         return EXIT_FAILURE;
+      aulOrder[i] = i;
+   }
+   for(i = NUM_FILES - 1; i > 0; i--) {
+      j = (size_t) rand() % (i + 1);
+      ulSwap = aulOrder[i];
+      aulOrder[i] = aulOrder[j];
+      aulOrder[j] = ulSwap;
+   }
+   pcString = FT_toString();
+   if(pcString == NULL)
+      return EXIT_FAILURE;
+
+   adLive[0] = FreezeBench_lookups(apcPaths, aulOrder, SUCCESS);
+   adLive[1] = FreezeBench_lookups(apcMissing, aulOrder, NO_SUCH_PATH);
+   FreezeBench_freeze(FT_FREEZE_LAYOUT, "layout");
+   adFrozen[0] = FreezeBench_lookups(apcPaths, aulOrder, SUCCESS);
+   adFrozen[1] = FreezeBench_lookups(apcMissing, aulOrder, NO_SUCH_PATH);
+   FreezeBench_freeze(FT_FREEZE_HASHED, "hashed");
+   adHashed[0] = FreezeBench_lookups(apcPaths, aulOrder, SUCCESS);
+   adHashed[1] = FreezeBench_lookups(apcMissing, aulOrder, NO_SUCH_PATH);
+   printf("lookup   live %7.1f ns   frozen %7.1f ns   hashed %7.1f ns\n",
+          adLive[0], adFrozen[0], adHashed[0]);
+   printf("missing  live %7.1f ns   frozen %7.1f ns   hashed %7.1f ns\n",
+          adLive[1], adFrozen[1], adHashed[1]);
+   dFrozen = FreezeBench_toString(pcString);
+   if(FT_thaw() != SUCCESS)
+      return EXIT_FAILURE;
+   dLive = FreezeBench_toString(pcString);
+   printf("toString live %7.1f ms   frozen %7.1f ms\n", dLive * 1e3,
+          dFrozen * 1e3);
+
+   free(pcString);
+   for(i = 0; i < NUM_FILES; i++) {
+      free(apcPaths[i]);
+      free(apcMissing[i]);
+   }
+   (void) FT_destroy();
+   return 0;
+}
@@ -0,0 +1,444 @@
+/* Implementation of a read-only, flat layout of a node hierarchy */
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include "mphFT.h"
+#include "frozenFT.h"
+
+/* An entry of a frozen hierarchy: one node */
+struct frozenEntry {
+   /* the offset of the node's name in the name pool, and its length */
+   size_t ulName;
+   size_t ulNameLength;
+   /* the index of the node's first child, and the number of children,
+      which follow it in order of name */
+   size_t ulFirstChild;
+   size_t ulNumChildren;
+   /* the index of the node's parent (0 for the root) */
+   size_t ulParent;
+   /* TRUE if the node is a file */
+   boolean bIsFile;
+   /* the node itself */
+   Node_T oNNode;
+};
+
+/* A slot of a frozen hierarchy's index: one full path */
+struct frozenSlot {
+   /* the index of the path's entry */
+   unsigned int uiEntry;
+   /* bits of the path's hash that its slot does not depend on */
+   unsigned int uiFingerprint;
+};
+
+/* A frozen hierarchy */
+struct frozen {
+   /* the entries, in breadth-first order from the root at index 0 */
+   struct frozenEntry *psEntries;
+   size_t ulNumEntries;
+   /* every name, in the order of the entries, with no '\0's */
+   char *pcNames;
+   /* if indexed, a perfect hash function of the full paths' hashes,
+      and the slots it maps them to; else NULL */
+   Mph_T oMHash;
+   struct frozenSlot *psSlots;
+};
+
+/* Returns the fingerprint of a path whose hash is ulHash. */
+static unsigned int Frozen_fingerprint(size_t ulHash) {
+   return (unsigned int) (ulHash >> (sizeof(size_t) * 4));
+}
+
+/*
+  Adds to *pulEntries the number of nodes in the hierarchy rooted at
+  oNNode, and to *pulNames the number of characters in their names.
+*/
+static void Frozen_count(Node_T oNNode, size_t *pulEntries,
+                         size_t *pulNames) {
+   Node_T oNChild = NULL;
+   size_t ulNameLength;
+   size_t ulChild;
+   assert(oNNode != NULL);
+   assert(pulEntries != NULL);
+   assert(pulNames != NULL);
+   (void) Node_getName(oNNode, &ulNameLength);
+   (*pulEntries)++;
+   *pulNames += ulNameLength;
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++) {
+      (void) Node_getChild(oNNode, ulChild, &oNChild);
+      Frozen_count(oNChild, pulEntries, pulNames);
+   }
+}
+
+/*
+  Fills in the entry at index ulIndex of oZFrozen for node oNNode,
+  whose parent's entry is at index ulParent, copying its name to the
+  pool at offset *pulNames and advancing *pulNames past it.
+*/
+static void Frozen_setEntry(Frozen_T oZFrozen, size_t ulIndex,
+                            size_t ulParent, Node_T oNNode,
+                            size_t *pulNames) {
+   struct frozenEntry *psEntry;
+   const char *pcName;
+   assert(oZFrozen != NULL);
+   assert(oNNode != NULL);
+   assert(pulNames != NULL);
+   psEntry = &oZFrozen->psEntries[ulIndex];
+   pcName = Node_getName(oNNode, &psEntry->ulNameLength);
+   psEntry->ulName = *pulNames;
+   memcpy(oZFrozen->pcNames + *pulNames, pcName, psEntry->ulNameLength);
+   *pulNames += psEntry->ulNameLength;
+   psEntry->ulFirstChild = 0;
+   psEntry->ulNumChildren = 0;
+   psEntry->ulParent = ulParent;
+   psEntry->bIsFile = Node_getType(oNNode);
+   psEntry->oNNode = oNNode;
+}
+
+/*
+  Indexes the full paths of oZFrozen's entries with a minimal perfect
+  hash function of their hashes, found from the names alone. Returns
+  SUCCESS, also if no function could be found, in which case oZFrozen
+  is left as it was; or MEMORY_ERROR if memory could not be allocated.
+*/
+static int Frozen_index(Frozen_T oZFrozen) {
+   const struct frozenEntry *psEntry;
+   size_t *pulHashes;
+   size_t ulIndex;
+   size_t ulSlot;
+   int iStatus;
+   assert(oZFrozen != NULL);
+   if(oZFrozen->ulNumEntries == 0 || oZFrozen->ulNumEntries > UINT_MAX)
+      return SUCCESS;
+   pulHashes = malloc(oZFrozen->ulNumEntries * sizeof(size_t));
+   oZFrozen->psSlots = malloc(oZFrozen->ulNumEntries
+                              * sizeof(struct frozenSlot));
+   if(pulHashes == NULL || oZFrozen->psSlots == NULL) {
+      free(pulHashes);
+      return MEMORY_ERROR;
+   }
+   /* parents come before their children, so their hashes are known */
+   for(ulIndex = 0; ulIndex < oZFrozen->ulNumEntries; ulIndex++) {
+      psEntry = &oZFrozen->psEntries[ulIndex];
+      pulHashes[ulIndex] =
+         Path_extendHash(ulIndex == 0 ? 0 : pulHashes[psEntry->ulParent],
+                         oZFrozen->pcNames + psEntry->ulName,
+                         psEntry->ulNameLength);
+   }
+   iStatus = Mph_new(pulHashes, oZFrozen->ulNumEntries,
+                     &oZFrozen->oMHash);
+   if(iStatus == SUCCESS)
+      for(ulIndex = 0; ulIndex < oZFrozen->ulNumEntries; ulIndex++) {
+         ulSlot = Mph_lookup(oZFrozen->oMHash, pulHashes[ulIndex]);
+         oZFrozen->psSlots[ulSlot].uiEntry = (unsigned int) ulIndex;
+         oZFrozen->psSlots[ulSlot].uiFingerprint =
+            Frozen_fingerprint(pulHashes[ulIndex]);
+      }
+   free(pulHashes);
+   /* two paths with one hash: lookups descend the layout instead */
+   if(iStatus == ALREADY_IN_TREE) {
+      free(oZFrozen->psSlots);
+      oZFrozen->psSlots = NULL;
+      return SUCCESS;
+   }
+   return iStatus;
+}
+
+/* see frozenFT.h for specification */
+int Frozen_new(Node_T oNRoot, boolean bIndexed, Frozen_T *poZResult) {
+   Frozen_T oZFrozen;
+   struct frozenEntry *psEntry;
+   Node_T oNChild = NULL;
+   size_t ulEntries = 0;
+   size_t ulNames = 0;
+   size_t ulNext;
+   size_t ulIndex;
+   size_t ulChild;
+   int iStatus;
+   assert(poZResult != NULL);
+   *poZResult = NULL;
+   if(oNRoot != NULL)
+      Frozen_count(oNRoot, &ulEntries, &ulNames);
+   oZFrozen = malloc(sizeof(struct frozen));
+   if(oZFrozen == NULL)
+      return MEMORY_ERROR;
+   /* one more byte, so that an empty pool is still allocated */
+   oZFrozen->psEntries = malloc(ulEntries * sizeof(struct frozenEntry)
+                                + 1);
+   oZFrozen->pcNames = malloc(ulNames + 1);
+   oZFrozen->ulNumEntries = ulEntries;
+   oZFrozen->oMHash = NULL;
+   oZFrozen->psSlots = NULL;
+   if(oZFrozen->psEntries == NULL || oZFrozen->pcNames == NULL) {
+      Frozen_free(oZFrozen);
+      return MEMORY_ERROR;
+   }
+
+   /* the entries are their own queue: each directory's children are
+      appended as it is reached */
+   ulNames = 0;
+   if(oNRoot != NULL)
+      Frozen_setEntry(oZFrozen, 0, 0, oNRoot, &ulNames);
+   ulNext = oNRoot != NULL;
+   for(ulIndex = 0; ulIndex < ulNext; ulIndex++) {
+      psEntry = &oZFrozen->psEntries[ulIndex];
+      psEntry->ulFirstChild = ulNext;
+      psEntry->ulNumChildren = Node_getNumChildren(psEntry->oNNode);
+      for(ulChild = 0; ulChild < psEntry->ulNumChildren; ulChild++) {
+         (void) Node_getChild(psEntry->oNNode, ulChild, &oNChild);
+         Frozen_setEntry(oZFrozen, ulNext++, ulIndex, oNChild,
+                         &ulNames);
+      }
+   }
+   assert(ulNext == ulEntries);
+   if(bIndexed) {
+      iStatus = Frozen_index(oZFrozen);
+      if(iStatus != SUCCESS) {
+         Frozen_free(oZFrozen);
+         return iStatus;
+      }
+   }
+   *poZResult = oZFrozen;
+   return SUCCESS;
+}
+
+/* see frozenFT.h for specification */
+void Frozen_free(Frozen_T oZFrozen) {
+   if(oZFrozen == NULL)
+      return;
+   free(oZFrozen->psEntries);
+   free(oZFrozen->pcNames);
+   Mph_free(oZFrozen->oMHash);
+   free(oZFrozen->psSlots);
+   free(oZFrozen);
+}
+
+/* see frozenFT.h for specification */
+boolean Frozen_isIndexed(Frozen_T oZFrozen) {
+   assert(oZFrozen != NULL);
+   return oZFrozen->oMHash != NULL;
+}
+
+/* see frozenFT.h for specification */
+void Frozen_getSizes(Frozen_T oZFrozen, size_t *pulEntries,
+                     size_t *pulLayoutBytes, size_t *pulHashBytes,
+                     size_t *pulSlotBytes) {
+   size_t ulNames = 0;
+   size_t ulIndex;
+   assert(oZFrozen != NULL);
+   assert(pulEntries != NULL);
+   assert(pulLayoutBytes != NULL);
+   assert(pulHashBytes != NULL);
+   assert(pulSlotBytes != NULL);
+   for(ulIndex = 0; ulIndex < oZFrozen->ulNumEntries; ulIndex++)
+      ulNames += oZFrozen->psEntries[ulIndex].ulNameLength;
+   *pulEntries = oZFrozen->ulNumEntries;
+   *pulLayoutBytes = oZFrozen->ulNumEntries * sizeof(struct frozenEntry)
+      + ulNames;
+   *pulHashBytes = 0;
+   *pulSlotBytes = 0;
+   if(oZFrozen->oMHash != NULL) {
+      *pulHashBytes = Mph_getSize(oZFrozen->oMHash);
+      *pulSlotBytes = oZFrozen->ulNumEntries * sizeof(struct frozenSlot);
+   }
+}
+
+/*
+  Compares the name of entry psEntry of oZFrozen with the ulLength
+  characters at pcName, as siblings are ordered. Returns <0, 0, or >0
+  if the entry's name is "less than", "equal to", or "greater than"
+  pcName, respectively.
+*/
+static int Frozen_compareName(Frozen_T oZFrozen,
+                              const struct frozenEntry *psEntry,
+                              const char *pcName, size_t ulLength) {
+   int iResult;
+   assert(oZFrozen != NULL);
+   assert(psEntry != NULL);
+   assert(pcName != NULL);
+   iResult = memcmp(oZFrozen->pcNames + psEntry->ulName, pcName,
+                    psEntry->ulNameLength < ulLength ?
+                    psEntry->ulNameLength : ulLength);
+   if(iResult != 0)
+      return iResult;
+   if(psEntry->ulNameLength < ulLength)
+      return -1;
+   return psEntry->ulNameLength > ulLength;
+}
+
+/*
+  Returns TRUE if the entry at index ulIndex of oZFrozen has the
+  absolute path viewed by psView, comparing names from the entry up to
+  the root with components from the path's end, and FALSE otherwise.
+*/
+static boolean Frozen_matches(Frozen_T oZFrozen, size_t ulIndex,
+                              const PathView *psView) {
+   const struct frozenEntry *psEntry;
+   size_t ulEnd;
+   size_t ulStart;
+   assert(oZFrozen != NULL);
+   assert(psView != NULL);
+   for(ulEnd = psView->ulLength; ; ulEnd = ulStart - 1) {
+      psEntry = &oZFrozen->psEntries[ulIndex];
+      if(psEntry->ulNameLength > ulEnd)
+         return FALSE;
+      ulStart = ulEnd - psEntry->ulNameLength;
+      if(memcmp(oZFrozen->pcNames + psEntry->ulName,
+                psView->pcPath + ulStart, psEntry->ulNameLength) != 0)
+         return FALSE;
+      /* names have no '/', so each must be a whole component */
+      if(ulIndex == 0)
+         return ulStart == 0;
+      if(ulStart == 0 || psView->pcPath[ulStart - 1] != '/')
+         return FALSE;
+      ulIndex = psEntry->ulParent;
+   }
+}
+
+/* see frozenFT.h for specification */
+int Frozen_find(Frozen_T oZFrozen, const PathView *psView,
+                Node_T *poNResult) {
+   const struct frozenEntry *psEntry;
+   const struct frozenSlot *psSlot;
+   size_t ulHash;
+   size_t ulStart;
+   size_t ulEnd;
+   size_t ulLow;
+   size_t ulHigh;
+   size_t ulMid;
+   int iCompare;
+   assert(oZFrozen != NULL);
+   assert(psView != NULL);
+   assert(poNResult != NULL);
+   *poNResult = NULL;
+   if(oZFrozen->ulNumEntries == 0)
+      return NO_SUCH_PATH;
+   /* the root's name must be the first component of the path */
+   psEntry = oZFrozen->psEntries;
+   ulEnd = Path_viewComponentEnd(psView, 0);
+   if(Frozen_compareName(oZFrozen, psEntry, psView->pcPath, ulEnd))
+      return CONFLICTING_PATH;
+
+   /* the index goes straight to the one entry that can have the path,
+      and a fingerprint usually tells a miss without reading it */
+   if(oZFrozen->oMHash != NULL) {
+      ulHash = Path_hashView(psView);
+      psSlot = &oZFrozen->psSlots[Mph_lookup(oZFrozen->oMHash, ulHash)];
+      if(psSlot->uiFingerprint != Frozen_fingerprint(ulHash) ||
+         !Frozen_matches(oZFrozen, psSlot->uiEntry, psView))
+         return NO_SUCH_PATH;
+      *poNResult = oZFrozen->psEntries[psSlot->uiEntry].oNNode;
+      return SUCCESS;
+   }
+
+   for(ulStart = ulEnd + 1; ulStart < psView->ulLength;
+       ulStart = ulEnd + 1) {
+      ulEnd = Path_viewComponentEnd(psView, ulStart);
+      /* search the range of children for the next component */
+      ulLow = psEntry->ulFirstChild;
+      ulHigh = ulLow + psEntry->ulNumChildren;
+      while(ulLow < ulHigh) {
+         ulMid = ulLow + (ulHigh - ulLow) / 2;
+         iCompare = Frozen_compareName(oZFrozen,
+                                       &oZFrozen->psEntries[ulMid],
+                                       psView->pcPath + ulStart,
+                                       ulEnd - ulStart);
+         if(iCompare == 0)
+            break;
+         if(iCompare < 0)
+            ulLow = ulMid + 1;
+         else
+            ulHigh = ulMid;
+      }
+      if(ulLow >= ulHigh)
+         return NO_SUCH_PATH;
+      psEntry = &oZFrozen->psEntries[ulMid];
+   }
+   *poNResult = psEntry->oNNode;
+   return SUCCESS;
+}
+
+/*
+  Adds to *pulAcc the length of the lines of the string representation
+  for the hierarchy rooted at entry ulIndex of oZFrozen, whose
+  parent's path has length ulPrefix (0 for the root).
+*/
+static void Frozen_strlenAccumulate(Frozen_T oZFrozen, size_t ulIndex,
+                                    size_t ulPrefix, size_t *pulAcc) {
+   const struct frozenEntry *psEntry;
+   size_t ulChild;
+   assert(oZFrozen != NULL);
+   assert(pulAcc != NULL);
+   psEntry = &oZFrozen->psEntries[ulIndex];
+   /* the parent's path and a '/', or nothing for the root */
+   if(ulPrefix != 0)
+      ulPrefix++;
+   ulPrefix += psEntry->ulNameLength;
+   *pulAcc += ulPrefix + 1;
+   for(ulChild = 0; ulChild < psEntry->ulNumChildren; ulChild++)
+      Frozen_strlenAccumulate(oZFrozen, psEntry->ulFirstChild + ulChild,
+                              ulPrefix, pulAcc);
+}
+
+/*
+  Writes the string representation for the hierarchy rooted at entry
+  ulIndex of oZFrozen to pcAcc in pre-order, files before
+  directories, where the ulPrefix characters at pcPrefix are its
+  parent's path (0 for the root), and returns the end of what was
+  written.
+*/
+static char *Frozen_strcatAccumulate(Frozen_T oZFrozen, size_t ulIndex,
+                                     const char *pcPrefix,
+                                     size_t ulPrefix, char *pcAcc) {
+   const struct frozenEntry *psEntry;
+   const struct frozenEntry *psChild;
+   const char *pcPath = pcAcc;
+   size_t ulPath;
+   size_t ulChild;
+   boolean bFiles;
+   assert(oZFrozen != NULL);
+   assert(pcAcc != NULL);
+   psEntry = &oZFrozen->psEntries[ulIndex];
+   if(ulPrefix != 0) {
+      memcpy(pcAcc, pcPrefix, ulPrefix);
+      pcAcc += ulPrefix;
+      *pcAcc++ = '/';
+   }
+   memcpy(pcAcc, oZFrozen->pcNames + psEntry->ulName,
+          psEntry->ulNameLength);
+   pcAcc += psEntry->ulNameLength;
+   ulPath = (size_t) (pcAcc - pcPath);
+   *pcAcc++ = '\n';
+   /* goes through children twice: files first, then directories */
+   for(bFiles = TRUE; ; bFiles = FALSE) {
+      for(ulChild = 0; ulChild < psEntry->ulNumChildren; ulChild++) {
+         psChild = &oZFrozen->psEntries[psEntry->ulFirstChild + ulChild];
+         if(psChild->bIsFile == bFiles)
+            pcAcc = Frozen_strcatAccumulate(oZFrozen,
+                                            psEntry->ulFirstChild
+                                            + ulChild, pcPath, ulPath,
+                                            pcAcc);
+      }
+      if(!bFiles)
+         break;
+   }
+   return pcAcc;
+}
+
+/* see frozenFT.h for specification */
+char *Frozen_toString(Frozen_T oZFrozen) {
+   size_t ulTotal = 1;
+   char *pcResult;
+   char *pcEnd;
+   assert(oZFrozen != NULL);
+   if(oZFrozen->ulNumEntries != 0)
+      Frozen_strlenAccumulate(oZFrozen, 0, 0, &ulTotal);
+   pcResult = malloc(ulTotal);
+   if(pcResult == NULL)
+      return NULL;
+   pcEnd = pcResult;
+   if(oZFrozen->ulNumEntries != 0)
+      pcEnd = Frozen_strcatAccumulate(oZFrozen, 0, NULL, 0, pcResult);
+   *pcEnd = '\0';
+   return pcResult;
+}
@@ -0,0 +1,70 @@
+/*--------------------------------------------------------------------*/
+/* frozenFT.h                                                         */
+/*--------------------------------------------------------------------*/
+#ifndef FROZEN_INCLUDED
+#define FROZEN_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+#include "path.h"
+#include "nodeFT.h"
+
+/*
+  A Frozen_T is a read-only layout of a hierarchy of nodes for fast
+  lookups and traversals: one array of entries in breadth-first
+  order, in which each directory's children are a contiguous range
+  sorted by name, and one pool holding every name, siblings' names
+  side by side. Each entry refers back to its node, for its contents.
+  A layout may also be indexed: a minimal perfect hash function maps
+  each full path's hash to a slot naming its entry, so that a lookup
+  reads one slot and one chain of entries, whatever the path's depth.
+  It is only valid while the hierarchy does not change.
+*/
+typedef struct frozen *Frozen_T;
+
+/*
+  Lays out the hierarchy rooted at oNRoot (which may be NULL, for an
+  empty hierarchy), indexed if bIndexed is TRUE, and stores the layout
+  in *poZResult. Lazy copies are laid out with the children they
+  present. In the very unlikely event that two full paths have the
+  same hash, the layout is left unindexed. Returns SUCCESS, or
+  MEMORY_ERROR (setting *poZResult to NULL) if memory could not be
+  allocated.
+*/
+int Frozen_new(Node_T oNRoot, boolean bIndexed, Frozen_T *poZResult);
+
+/* Frees oZFrozen, but none of its nodes. Does nothing if NULL. */
+void Frozen_free(Frozen_T oZFrozen);
+
+/* Returns TRUE if oZFrozen is indexed, and FALSE otherwise. */
+boolean Frozen_isIndexed(Frozen_T oZFrozen);
+
+/*
+  Sets *pulEntries to the number of entries of oZFrozen,
+  *pulLayoutBytes to the bytes that its entries and names take, and
+  *pulHashBytes and *pulSlotBytes to the bytes that its index's
+  perfect hash function and slots take (0 if it is not indexed).
+*/
+void Frozen_getSizes(Frozen_T oZFrozen, size_t *pulEntries,
+                     size_t *pulLayoutBytes, size_t *pulHashBytes,
+                     size_t *pulSlotBytes);
+
+/*
+  Finds the node with the absolute path viewed by psView in oZFrozen:
+  through its index if it has one, and otherwise with one binary
+  search of a range of entries per component. Returns
+  SUCCESS and sets *poNResult to the node, or otherwise sets
+  *poNResult to NULL and returns:
+  * CONFLICTING_PATH if the root's name is not the path's first
+                     component
+  * NO_SUCH_PATH if there is no such node
+*/
+int Frozen_find(Frozen_T oZFrozen, const PathView *psView,
+                Node_T *poNResult);
+
+/*
+  Returns the string representation of oZFrozen's hierarchy, as
+  FT_toString makes it, or NULL if there is an allocation error. The
+  caller owns the string.
+*/
+char *Frozen_toString(Frozen_T oZFrozen);
+#endif
@@ -7,6 +7,13 @@
 #include <stdlib.h>
 #include "dynarray.h"
 #include "path.h"
+#include "contentFT.h"
+#include "importFT.h"
+#include "exportFT.h"
+#include "tarFT.h"
+#include "frozenFT.h"
+#include "bloomFT.h"
+#include "snapshotFT.h"
 #include "nodeFT.h"
 #include "checkerFT.h"
 #include "ft.h"
@@ -20,6 +27,57 @@ static boolean bIsInitialized;
 static Node_T oNRoot;
 /* 3. a counter of the number of nodes in the hierarchy */
 static size_t ulCount;
+/* 4. how file contents are stored, which persists across FT_destroy
+   and FT_init */
+static enum contentMode eContentMode = FT_CONTENTS_BORROWED;
+/* 5. unless in FT_CONTENTS_BORROWED mode, the store holding large
+   contents, created when first needed */
+static ContentStore_T oSContents;
+/* 6. the number of walks made by FT_statStorage */
+static unsigned long ulStoragePasses;
+/* the read-only layout of the tree while it is frozen, or NULL */
+static Frozen_T oZFrozen;
+/* the filter of the hierarchy's paths that FT_containsDir and
+   FT_containsFile consult first, or NULL while it is dropped */
+static Bloom_T oBPaths;
+/* the lookups made without the filter since it was dropped */
+static size_t ulFilterSkips;
+/* what the filter has done since FT_init */
+static struct filterStats sFilterStats;
+/* how many changes to directories leave one cold enough to pack, or
+   0 if directories are not packed; persists across FT_destroy and
+   FT_init */
+static size_t ulColdAfter;
+/* the value of Node_countChanges at the last sweep for cold
+   directories */
+static unsigned long ulLastSweep;
+/* the packing and unpacking done since FT_init */
+static unsigned long ulPacked;
+static unsigned long ulUnpacked;
+
+/* The least number of paths the filter is sized for */
+enum { MIN_FILTER = 64 };
+
+/*
+  Ensures that oSContents exists. Returns SUCCESS, or MEMORY_ERROR if
+  it could not be allocated.
+*/
+static int FT_ensureStore(void) {
+   if(oSContents == NULL)
+      oSContents =
+         ContentStore_new((boolean) (eContentMode == FT_CONTENTS_DEDUP));
+   return oSContents != NULL ? SUCCESS : MEMORY_ERROR;
+}
+
+/*
+  Returns SUCCESS if the FT can be changed, or INITIALIZATION_ERROR if
+  it is not in an initialized state or is frozen.
+*/
+static int FT_checkMutable(void) {
+   if(!bIsInitialized || oZFrozen != NULL)
+      return INITIALIZATION_ERROR;
+   return SUCCESS;
+}
 /* --------------------------------------------------------------------
   The FT_traversePath and FT_findNode functions modularize the common
   functionality of going as far as possible down an FT towards a path
@@ -27,85 +85,213 @@ static size_t ulCount;
   node if the full path was reached, respectively.
 */
 /*
-  Traverses the FT starting at the root as far as possible towards
-  absolute path oPPath. If able to traverse, returns an int SUCCESS
-  status and sets *poNFurthest to the furthest node reached (which may
-  be only a prefix of oPPath, or even NULL if the root is NULL).
-  Otherwise, sets *poNFurthest to NULL and returns with status:
-  * CONFLICTING_PATH if the root's path is not a prefix of oPPath
-  * MEMORY_ERROR if memory could not be allocated to complete request
-  * NOT_A_DIRECTORY if common node was a file
+  Unpacks oNDir (see Node_unpack), counting it, if it is packed.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated.
 */
-static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
+static int FT_unpack(Node_T oNDir) {
    int iStatus;
-   Path_T oPPrefix = NULL;
-   Node_T oNCurr;
+   assert(oNDir != NULL);
+   if(!Node_isPacked(oNDir))
+      return SUCCESS;
+   iStatus = Node_unpack(oNDir);
+   if(iStatus == SUCCESS)
+      ulUnpacked++;
+   return iStatus;
+}
+/*
+  Descends from oNStart as far as possible along the components of
+  psView that begin at offset *pulOffset, looking up each child by
+  name. Sets *poNFurthest to the furthest node reached and *pulOffset
+  to the offset of the first component not matched, which is past
+  psView's end if every remaining component was matched. The cost
+  depends only on the number of components descended, not on the
+  depth of oNStart.
+  If bMaterialize is TRUE, every lazy copy descended through is
+  materialized first, so that all the nodes on the way to the furthest
+  node are really in the hierarchy being traversed and so can be
+  changed, and every packed directory whose file is reached is
+  unpacked. Otherwise this performs no allocation, and stops at a
+  packed directory, whose files have no nodes to descend to (see
+  FT_findPacked). Returns SUCCESS, or MEMORY_ERROR if a
+  materialization or an unpacking fails.
+*/
+static int FT_descend(Node_T oNStart, const PathView *psView,
+                      size_t *pulOffset, boolean bMaterialize,
+                      Node_T *poNFurthest) {
+   Node_T oNCurr = oNStart;
    Node_T oNChild = NULL;
-   size_t ulDepth;
-   size_t i;
+   size_t ulStart;
+   size_t ulEnd;
    size_t ulChildID;
-   assert(oPPath != NULL);
+   size_t ulNew;
+   int iStatus;
+   assert(oNStart != NULL);
+   assert(psView != NULL);
+   assert(pulOffset != NULL);
+   assert(poNFurthest != NULL);
+
+   ulStart = *pulOffset;
+   while(ulStart < psView->ulLength) {
+      if(bMaterialize && Node_getShare(oNCurr) != NULL) {
+         iStatus = Node_materialize(oNCurr, &ulNew);
+         if(iStatus != SUCCESS) {
+            *poNFurthest = NULL;
+            return iStatus;
+         }
+         ulCount += ulNew;
+      }
+      if(!bMaterialize && Node_isPacked(oNCurr))
+         break;
+      ulEnd = Path_viewComponentEnd(psView, ulStart);
+      if(!Node_hasChildName(oNCurr, psView->pcPath + ulStart,
+                            ulEnd - ulStart, &ulChildID)) {
+         /* oNCurr doesn't have child with this name:
+            this is as far as we can go */
+         break;
+      }
+      /* a packed file is reached only once it has a node again */
+      iStatus = FT_unpack(oNCurr);
+      if(iStatus != SUCCESS) {
+         *poNFurthest = NULL;
+         return iStatus;
+      }
+      /* go to that child and continue with next component */
+      (void) Node_getChild(oNCurr, ulChildID, &oNChild);
+      oNCurr = oNChild;
+      ulStart = ulEnd + 1;
+   }
+   *pulOffset = ulStart;
+   *poNFurthest = oNCurr;
+   return SUCCESS;
+}
+/*
+  Returns TRUE if oNFurthest, where a descent without materialization
+  stopped short of the component of psView at offset ulOffset, is a
+  packed directory, and that component is the last and names one of
+  its files; then stores the file's identifier in *pulChildID.
+  Otherwise returns FALSE.
+*/
+static boolean FT_findPacked(const PathView *psView, size_t ulOffset,
+                             Node_T oNFurthest, size_t *pulChildID) {
+   assert(psView != NULL);
+   assert(pulChildID != NULL);
+   if(oNFurthest == NULL || ulOffset > psView->ulLength ||
+      !Node_isPacked(oNFurthest) ||
+      Path_viewComponentEnd(psView, ulOffset) != psView->ulLength)
+      return FALSE;
+   return Node_hasChildName(oNFurthest, psView->pcPath + ulOffset,
+                            psView->ulLength - ulOffset, pulChildID);
+}
+/*
+  Checks that the name of the root, which must not be NULL, is the
+  first component of the path viewed by psView, and stores in
+  *pulOffset the offset of the component after it. Returns SUCCESS,
+  or CONFLICTING_PATH if the root's name is not the first component.
+*/
+static int FT_matchRoot(const PathView *psView, size_t *pulOffset) {
+   const char *pcRootName;
+   size_t ulRootLength;
+   size_t ulEnd;
+   assert(psView != NULL);
+   assert(pulOffset != NULL);
+   assert(oNRoot != NULL);
+   ulEnd = Path_viewComponentEnd(psView, 0);
+   pcRootName = Node_getName(oNRoot, &ulRootLength);
+   if(ulRootLength != ulEnd ||
+      memcmp(pcRootName, psView->pcPath, ulEnd) != 0)
+      return CONFLICTING_PATH;
+   *pulOffset = ulEnd + 1;
+   return SUCCESS;
+}
+/*
+  Traverses the FT starting at the root as far as possible towards
+  the absolute path viewed by psView, materializing lazy copies on the
+  way if bMaterialize is TRUE (see FT_descend). If able to traverse,
+  returns an int SUCCESS status and sets *poNFurthest to the furthest
+  node reached (which may be only a prefix of the path, or even NULL
+  if the root is NULL) and *pulOffset to the offset in psView of the
+  first component below it, which is past psView's end if the whole
+  path was found.
+  Otherwise, sets *poNFurthest to NULL and returns with status:
+  * CONFLICTING_PATH if the root's path is not a prefix of the path
+  * MEMORY_ERROR if a materialization fails
+*/
+static int FT_traversePath(const PathView *psView, boolean bMaterialize,
+                           Node_T *poNFurthest, size_t *pulOffset) {
+   assert(psView != NULL);
    assert(poNFurthest != NULL);
+   assert(pulOffset != NULL);
 
+   *pulOffset = 0;
    /* root is NULL -> won't find anything */
    if(oNRoot == NULL) {
       *poNFurthest = NULL;
       return SUCCESS;
    }
-   iStatus = Path_prefix(oPPath, 1, &oPPrefix);
-   if(iStatus != SUCCESS) {
-      *poNFurthest = NULL;
-      return iStatus;
-   }
-   if(Path_comparePath(Node_getPath(oNRoot), oPPrefix)) {
-      Path_free(oPPrefix);
+   /* the root's name must be the first component of the path */
+   if(FT_matchRoot(psView, pulOffset) != SUCCESS) {
       *poNFurthest = NULL;
       return CONFLICTING_PATH;
    }
-   Path_free(oPPrefix);
-   oPPrefix = NULL;
-   oNCurr = oNRoot;
-   ulDepth = Path_getDepth(oPPath);
-   for(i = 2; i <= ulDepth; i++) {
-      iStatus = Path_prefix(oPPath, i, &oPPrefix);
+   return FT_descend(oNRoot, psView, pulOffset, bMaterialize,
+                     poNFurthest);
+}
+/*
+  Finds the node with the absolute path viewed by psView in the
+  initialized FT, as FT_findNode does, and returns as it does.
+*/
+static int FT_findView(const PathView *psView, boolean bMaterialize,
+                       Node_T *poNResult) {
+   Node_T oNFound = NULL;
+   size_t ulOffset;
+   size_t ulChildID;
+   int iStatus;
+   assert(psView != NULL);
+   assert(poNResult != NULL);
+   /* a frozen tree has a faster way, when nothing is to change */
+   if(oZFrozen != NULL && !bMaterialize)
+      return Frozen_find(oZFrozen, psView, poNResult);
+   iStatus = FT_traversePath(psView, bMaterialize, &oNFound, &ulOffset);
+   if(iStatus != SUCCESS)
+   {
+      *poNResult = NULL;
+      return iStatus;
+   }
+   /* a packed file is reached only once it has a node again */
+   if(FT_findPacked(psView, ulOffset, oNFound, &ulChildID)) {
+      iStatus = FT_unpack(oNFound);
       if(iStatus != SUCCESS) {
-         *poNFurthest = NULL;
+         *poNResult = NULL;
          return iStatus;
       }
-      if(Node_hasChild(oNCurr, oPPrefix, &ulChildID)) {
-         /* go to that child and continue with next prefix */
-         Path_free(oPPrefix);
-         oPPrefix = NULL;
-         iStatus = Node_getChild(oNCurr, ulChildID, &oNChild);
-         if(iStatus != SUCCESS) {
-            *poNFurthest = NULL;
-            return iStatus;
-         }
-         oNCurr = oNChild;
-      }
-      else {
-         /* oNCurr doesn't have child with path oPPrefix:
-            this is as far as we can go */
-         break;
-      }
+      (void) Node_getChild(oNFound, ulChildID, &oNFound);
+      ulOffset = psView->ulLength + 1;
    }
-   Path_free(oPPrefix);
-   *poNFurthest = oNCurr;
+   /* every component of the path must have been matched */
+   if(oNFound == NULL || ulOffset <= psView->ulLength) {
+      *poNResult = NULL;
+      return NO_SUCH_PATH;
+   }
+   *poNResult = oNFound;
    return SUCCESS;
 }
 /*
-  Traverses the FT to find a node with absolute path pcPath. Returns a
-  int SUCCESS status and sets *poNResult to be the node, if found.
+  Traverses the FT to find a node with the absolute path made up of
+  the ulPathLength characters at pcPath, materializing lazy copies on
+  the way if bMaterialize is TRUE (see FT_descend). Returns a int
+  SUCCESS status and sets *poNResult to be the node, if found. pcPath
+  is viewed in place, so a lookup without materialization performs no
+  allocation.
   Otherwise, sets *poNResult to NULL and returns with status:
   * INITIALIZATION_ERROR if the FT is not in an initialized state
   * BAD_PATH if pcPath does not represent a well-formatted path
   * CONFLICTING_PATH if the root's path is not a prefix of pcPath
   * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  * MEMORY_ERROR if a materialization fails
  */
-static int FT_findNode(const char *pcPath, Node_T *poNResult) {
-   Path_T oPPath = NULL;
-   Node_T oNFound = NULL;
+static int FT_findNode(const char *pcPath, size_t ulPathLength,
+                       boolean bMaterialize, Node_T *poNResult) {
+   PathView oView;
    int iStatus;
    assert(pcPath != NULL);
    assert(poNResult != NULL);
@@ -113,269 +299,1479 @@ static int FT_findNode(const char *pcPath, Node_T *poNResult) {
       *poNResult = NULL;
       return INITIALIZATION_ERROR;
    }
-   iStatus = Path_new(pcPath, &oPPath);
+   iStatus = Path_initView(&oView, pcPath, ulPathLength);
    if(iStatus != SUCCESS) {
       *poNResult = NULL;
       return iStatus;
    }
-   iStatus = FT_traversePath(oPPath, &oNFound);
-   if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
-      *poNResult = NULL;
-      return iStatus;
+   return FT_findView(&oView, bMaterialize, poNResult);
+}
+/*
+  Stores whether the path viewed by psView, towards which a descent
+  without materialization reached oNFurthest with the component at
+  offset ulOffset (past psView's end if the whole path was found) not
+  yet matched, is a file in *pbIsFile and, if so, the size of its
+  contents in *pulSize. A file in a packed directory is answered for
+  from the pack, without unpacking it. Returns SUCCESS, or
+  NO_SUCH_PATH if the path is not in the FT.
+*/
+static int FT_statReached(const PathView *psView, size_t ulOffset,
+                          Node_T oNFurthest, boolean *pbIsFile,
+                          size_t *pulSize) {
+   size_t ulChildID;
+   assert(psView != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+   if(FT_findPacked(psView, ulOffset, oNFurthest, &ulChildID)) {
+      *pbIsFile = TRUE;
+      *pulSize = Node_getPackedSize(oNFurthest, ulChildID);
+      return SUCCESS;
    }
-   if(oNFound == NULL) {
-      Path_free(oPPath);
-      *poNResult = NULL;
+   if(oNFurthest == NULL || ulOffset <= psView->ulLength)
       return NO_SUCH_PATH;
+   *pbIsFile = Node_getType(oNFurthest);
+   if(*pbIsFile)
+      *pulSize = Node_getSizeContents(oNFurthest);
+   return SUCCESS;
+}
+/*
+  Looks up the absolute path viewed by psView in the initialized FT
+  without materialization and stats it, as FT_statReached does.
+  Returns as FT_findView does.
+*/
+static int FT_statView(const PathView *psView, boolean *pbIsFile,
+                       size_t *pulSize) {
+   Node_T oNFound = NULL;
+   size_t ulOffset;
+   int iStatus;
+   assert(psView != NULL);
+   if(oZFrozen != NULL) {
+      iStatus = Frozen_find(oZFrozen, psView, &oNFound);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      ulOffset = psView->ulLength + 1;
    }
-   if(Path_comparePath(Node_getPath(oNFound), oPPath) != 0) {
-      Path_free(oPPath);
-      *poNResult = NULL;
-      return NO_SUCH_PATH;
+   else {
+      iStatus = FT_traversePath(psView, FALSE, &oNFound, &ulOffset);
+      if(iStatus != SUCCESS)
+         return iStatus;
    }
-   Path_free(oPPath);
-   *poNResult = oNFound;
-   return SUCCESS;
+   return FT_statReached(psView, ulOffset, oNFound, pbIsFile, pulSize);
 }
 
-/* see ft.h for specification */
-int FT_insertDir(const char *pcPath) {
+/*
+  Prepares oNNode, which must not be a lazy copy, to have its children
+  or contents changed: materializes every lazy copy of oNNode or of
+  any of its ancestors, top-down, so that none of them sees the
+  change. Does nothing when no node is shared. Returns SUCCESS, or
+  MEMORY_ERROR if a materialization fails.
+*/
+static int FT_unshareSpine(Node_T oNNode) {
+   size_t ulNew;
    int iStatus;
-   Path_T oPPath = NULL;
-   Node_T oNFirstNew = NULL;
-   Node_T oNCurr = NULL;
-   size_t ulDepth, ulIndex;
-   size_t ulNewNodes = 0;
-   assert(pcPath != NULL);
-   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-   /* validate pcPath and generate a Path_T for it */
-   if(!bIsInitialized)
-      return INITIALIZATION_ERROR;
-   iStatus = Path_new(pcPath, &oPPath);
-   if(iStatus != SUCCESS)
-      return iStatus;
-   /* find the closest ancestor of oPPath already in the tree */
-   iStatus= FT_traversePath(oPPath, &oNCurr);
-   if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
-      return iStatus;
+   assert(oNNode != NULL);
+   assert(Node_getShare(oNNode) == NULL);
+   if(Node_countShared() == 0)
+      return SUCCESS;
+   if(Node_getParent(oNNode) != NULL) {
+      iStatus = FT_unshareSpine(Node_getParent(oNNode));
+      if(iStatus != SUCCESS)
+         return iStatus;
    }
-   /* no ancestor node found, so if root is not NULL,
-      pcPath isn't underneath root. */
-   if(oNCurr == NULL && oNRoot != NULL) {
-      Path_free(oPPath);
-      return CONFLICTING_PATH;
+   iStatus = Node_unshare(oNNode, &ulNew);
+   ulCount += ulNew;
+   return iStatus;
+}
+/* --------------------------------------------------------------------
+  The following functions maintain the filter of paths, which lets
+  FT_containsDir and FT_containsFile answer for most missing paths
+  without parsing them twice or descending the tree. While there is a
+  filter, every path in the hierarchy must be in it; paths that are
+  gone may linger, which only costs their lookups a traversal.
+  Changes that would touch every path below a moved or lazily copied
+  directory drop the filter instead, and it is rebuilt once as many
+  lookups as there are nodes have gone without it.
+*/
+/*
+  Returns the hash of the absolute path of oNNode, which must really
+  be in the hierarchy rather than presented by a lazy copy, from the
+  names up its parent links.
+*/
+static size_t FT_hashPath(Node_T oNNode) {
+   const char *pcName;
+   size_t ulLength;
+   size_t ulHash = 0;
+   assert(oNNode != NULL);
+   if(Node_getParent(oNNode) != NULL)
+      ulHash = FT_hashPath(Node_getParent(oNNode));
+   pcName = Node_getName(oNNode, &ulLength);
+   return Path_extendHash(ulHash, pcName, ulLength);
+}
+
+/*
+  Returns the number of paths in the hierarchy rooted at oNNode,
+  including those that lazy copies present.
+*/
+static size_t FT_countPaths(Node_T oNNode) {
+   Node_T oNChild = NULL;
+   size_t ulPaths = 1;
+   size_t ulChild;
+   assert(oNNode != NULL);
+   /* packed children are all files */
+   if(Node_isPacked(oNNode))
+      return ulPaths + Node_getNumChildren(oNNode);
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++) {
+      (void) Node_getChild(oNNode, ulChild, &oNChild);
+      ulPaths += FT_countPaths(oNChild);
    }
-   ulDepth = Path_getDepth(oPPath);
-   if(oNCurr == NULL) /* new root! */
-      ulIndex = 1;
-   else {
-      ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
-      /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
-                                       Node_getPath(oNCurr))) {
-         Path_free(oPPath);
-         return ALREADY_IN_TREE;
+   return ulPaths;
+}
+
+/*
+  Adds to the filter (if bAdd is TRUE) or removes from it the paths of
+  the hierarchy rooted at oNNode, whose parent's path has hash
+  ulParentHash (0 for the root). Removal leaves in the paths that
+  lazy copies present, which are not worth a walk to take out.
+*/
+static void FT_filterTree(Node_T oNNode, size_t ulParentHash,
+                          boolean bAdd) {
+   Node_T oNChild = NULL;
+   const char *pcName;
+   size_t ulLength;
+   size_t ulHash;
+   size_t ulChild;
+   assert(oNNode != NULL);
+   assert(oBPaths != NULL);
+   pcName = Node_getName(oNNode, &ulLength);
+   ulHash = Path_extendHash(ulParentHash, pcName, ulLength);
+   if(bAdd)
+      Bloom_add(oBPaths, ulHash);
+   else
+      Bloom_remove(oBPaths, ulHash);
+   if(!bAdd && Node_getShare(oNNode) != NULL)
+      return;
+   if(Node_isPacked(oNNode)) {
+      for(ulChild = 0; ulChild < Node_getNumChildren(oNNode);
+          ulChild++) {
+         pcName = Node_getPackedName(oNNode, ulChild, &ulLength);
+         if(bAdd)
+            Bloom_add(oBPaths, Path_extendHash(ulHash, pcName, ulLength));
+         else
+            Bloom_remove(oBPaths,
+                         Path_extendHash(ulHash, pcName, ulLength));
       }
+      return;
    }
-   /* starting at oNCurr, build rest of the path one level at a time */
-   while(ulIndex <= ulDepth) {
-      Path_T oPPrefix = NULL;
-      Node_T oNNewNode = NULL;
-      /* generate a Path_T for this level */
-      iStatus = Path_prefix(oPPath, ulIndex, &oPPrefix);
-      if(iStatus != SUCCESS) {
-         Path_free(oPPath);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
-         assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-         return iStatus;
-      }
-      /* insert the new node for a directory at this level */
-      iStatus = Node_newDir(oPPrefix, oNCurr, &oNNewNode);
-      if(iStatus != SUCCESS) {
-         Path_free(oPPath);
-         Path_free(oPPrefix);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
-         assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++) {
+      (void) Node_getChild(oNNode, ulChild, &oNChild);
+      FT_filterTree(oNChild, ulHash, bAdd);
+   }
+}
+
+/* Drops the filter, to be rebuilt once lookups have gone without it
+   for a while. */
+static void FT_dropFilter(void) {
+   Bloom_free(oBPaths);
+   oBPaths = NULL;
+   ulFilterSkips = 0;
+}
+
+/*
+  Builds the filter afresh from the whole hierarchy, with room for it
+  to double. Leaves the filter dropped if memory could not be
+  allocated.
+*/
+static void FT_buildFilter(void) {
+   size_t ulPaths = 0;
+   FT_dropFilter();
+   if(oNRoot != NULL)
+      ulPaths = FT_countPaths(oNRoot);
+   oBPaths = Bloom_new(2 * ulPaths + MIN_FILTER);
+   if(oBPaths == NULL)
+      return;
+   sFilterStats.ulBuilds++;
+   if(oNRoot != NULL)
+      FT_filterTree(oNRoot, 0, TRUE);
+}
+
+/*
+  Adds to the filter, if there is one, the paths of the new hierarchy
+  rooted at oNNode, which must really be in the FT; or rebuilds it
+  larger if that overfills it.
+*/
+static void FT_filterAdded(Node_T oNNode) {
+   assert(oNNode != NULL);
+   if(oBPaths == NULL)
+      return;
+   FT_filterTree(oNNode, Node_getParent(oNNode) == NULL ? 0 :
+                 FT_hashPath(Node_getParent(oNNode)), TRUE);
+   if(Bloom_isFull(oBPaths))
+      FT_buildFilter();
+}
+
+/*
+  Removes from the filter, if there is one, the paths of the hierarchy
+  rooted at oNNode, which must really be in the FT and is about to be
+  removed.
+*/
+static void FT_filterRemoved(Node_T oNNode) {
+   assert(oNNode != NULL);
+   if(oBPaths == NULL)
+      return;
+   FT_filterTree(oNNode, Node_getParent(oNNode) == NULL ? 0 :
+                 FT_hashPath(Node_getParent(oNNode)), FALSE);
+}
+
+/*
+  Returns FALSE if the path viewed by psView is surely not in the FT,
+  by the filter, and TRUE if it may be, counting the lookup in
+  sFilterStats. A dropped filter is rebuilt here, once as many lookups
+  as there are nodes have gone without it.
+*/
+static boolean FT_filterPasses(const PathView *psView) {
+   assert(psView != NULL);
+   if(oBPaths == NULL && ulFilterSkips >= ulCount)
+      FT_buildFilter();
+   if(oBPaths == NULL) {
+      ulFilterSkips++;
+      sFilterStats.ulBypassed++;
+      return TRUE;
+   }
+   if(!Bloom_mayContain(oBPaths, Path_hashView(psView))) {
+      sFilterStats.ulAvoided++;
+      return FALSE;
+   }
+   sFilterStats.ulPassed++;
+   return TRUE;
+}
+
+/* --------------------------------------------------------------------
+  The following functions pack cold directories: those whose children
+  have not changed in the last ulColdAfter changes to any directory's
+  children. A sweep for them walks the whole hierarchy, so one is made
+  only once there have been half as many changes since the last as
+  there are nodes, which a growing tree reaches each time it doubles.
+  Nothing is packed while the tree is frozen, since the
+  frozen layout points at the files' nodes.
+*/
+/*
+  Packs every cold directory in the hierarchy rooted at oNNode that
+  Node_pack accepts. Lazy copies are passed over: the directories they
+  share are in the hierarchy themselves.
+*/
+static void FT_packCold(Node_T oNNode) {
+   Node_T oNChild = NULL;
+   size_t ulChild;
+   assert(oNNode != NULL);
+   if(Node_getType(oNNode) || Node_getShare(oNNode) != NULL ||
+      Node_isPacked(oNNode))
+      return;
+   if(Node_countChanges() - Node_getChanged(oNNode) >= ulColdAfter &&
+      Node_pack(oNNode)) {
+      ulPacked++;
+      return;
+   }
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++) {
+      (void) Node_getChild(oNNode, ulChild, &oNChild);
+      FT_packCold(oNChild);
+   }
+}
+
+/* Sweeps for cold directories, if packing is on and the hierarchy has
+   changed enough since the last sweep. */
+static void FT_sweepCold(void) {
+   size_t ulDue;
+   if(ulColdAfter == 0 || oNRoot == NULL || oZFrozen != NULL)
+      return;
+   ulDue = ulCount / 2 > ulColdAfter ? ulCount / 2 : ulColdAfter;
+   if(Node_countChanges() - ulLastSweep < ulDue)
+      return;
+   ulLastSweep = Node_countChanges();
+   FT_packCold(oNRoot);
+}
+
+/*
+  Unpacks every packed directory in the hierarchy rooted at oNNode,
+  for the walks that need a node for each file. Returns SUCCESS, or
+  MEMORY_ERROR if memory could not be allocated.
+*/
+static int FT_unpackTree(Node_T oNNode) {
+   Node_T oNChild = NULL;
+   size_t ulChild;
+   int iStatus;
+   assert(oNNode != NULL);
+   if(Node_getType(oNNode) || Node_getShare(oNNode) != NULL)
+      return SUCCESS;
+   if(Node_isPacked(oNNode))
+      return FT_unpack(oNNode);
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++) {
+      (void) Node_getChild(oNNode, ulChild, &oNChild);
+      iStatus = FT_unpackTree(oNChild);
+      if(iStatus != SUCCESS)
          return iStatus;
-      }
-      /* set up for next level */
-      Path_free(oPPrefix);
-      oNCurr = oNNewNode;
-      ulNewNodes++;
-      if(oNFirstNew == NULL)
-         oNFirstNew = oNCurr;
-      ulIndex++;
    }
-   Path_free(oPPath);
-   /* update FT state variables to reflect insertion */
-   if(oNRoot == NULL)
-      oNRoot = oNFirstNew;
-   ulCount += ulNewNodes;
-   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
 }
 
-/* see ft.h for specification*/
-int FT_insertFile(const char *pcPath, void *pvContents,
-                  size_t ulLength) {
+/*
+  Inserts a new directory (if bIsFile is FALSE) or a new file with
+  contents pvContents of size ulLength (if bIsFile is TRUE) at the
+  path viewed by psView, creating any missing ancestor directories
+  along the way. If oCContents is not NULL, the new file, which must
+  be owned, holds it instead, taking over the caller's reference to
+  it on SUCCESS. oNCurr must be the furthest node reached by
+  traversing towards that path with materialization (NULL if the
+  tree is empty), and ulOffset the offset in psView of the first
+  component below it.
+  Returns SUCCESS if the node and its ancestors were inserted, or
+  otherwise:
+  * NOT_A_DIRECTORY if oNCurr is a file that is a proper prefix of
+                    the path
+  * ALREADY_IN_TREE if the path is already in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int FT_insertNode(const PathView *psView, size_t ulOffset,
+                         Node_T oNCurr, boolean bIsFile,
+                         void *pvContents, size_t ulLength,
+                         Content_T oCContents) {
    int iStatus;
-   Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
-   Node_T oNCurr = NULL;
-   size_t ulDepth, ulIndex;
+   size_t ulEnd;
    size_t ulNewNodes = 0;
-   assert(pcPath != NULL);
-   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-   /* validate pcPath and generate a Path_T for it */
-   if(!bIsInitialized)
-      return INITIALIZATION_ERROR;
-   iStatus = Path_new(pcPath, &oPPath);
-   if(iStatus != SUCCESS)
-      return iStatus;
-   /* find the closest ancestor of oPPath already in the tree */
-   iStatus= FT_traversePath(oPPath, &oNCurr);
-   if(iStatus != SUCCESS) {
-      Path_free(oPPath);
-      return iStatus;
-   }
-   /* no ancestor node found, so if root is not NULL,
-      pcPath isn't underneath root. ensures new file would not be the
-      ft root*/
-   if((oNCurr == NULL && oNRoot != NULL) || Path_getDepth(oPPath) == 1){
-      Path_free(oPPath);
-      return CONFLICTING_PATH;
+   assert(psView != NULL);
+   assert(oCContents == NULL ||
+          (bIsFile && eContentMode != FT_CONTENTS_BORROWED));
+
+   if(ulOffset > psView->ulLength)
+      return ALREADY_IN_TREE;
+   /* files can't have children */
+   if(oNCurr != NULL && Node_getType(oNCurr))
+      return NOT_A_DIRECTORY;
+   if(oNCurr != NULL) {
+      /* the new child goes in among nodes */
+      iStatus = FT_unpack(oNCurr);
+      if(iStatus == SUCCESS)
+         iStatus = FT_unshareSpine(oNCurr);
+      if(iStatus != SUCCESS)
+         return iStatus;
    }
-   ulDepth = Path_getDepth(oPPath);
-   if(oNCurr == NULL) /* new root! */
-      ulIndex = 1;
-   else {
-      ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
-      /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
-                                       Node_getPath(oNCurr))) {
-         Path_free(oPPath);
-         return ALREADY_IN_TREE;
-      }
+   if(bIsFile && eContentMode != FT_CONTENTS_BORROWED) {
+      iStatus = FT_ensureStore();
+      if(iStatus != SUCCESS)
+         return iStatus;
    }
    /* starting at oNCurr, build rest of the path one level at a time */
-   while(ulIndex <= ulDepth) {
-      Path_T oPPrefix = NULL;
+   while(ulOffset < psView->ulLength) {
       Node_T oNNewNode = NULL;
-      /* generate a Path_T for this level */
-      iStatus = Path_prefix(oPPath, ulIndex, &oPPrefix);
+      ulEnd = Path_viewComponentEnd(psView, ulOffset);
+      if(bIsFile && ulEnd == psView->ulLength &&
+         eContentMode != FT_CONTENTS_BORROWED)
+         /* insert the new node file, with a copy of the contents */
+         iStatus = Node_newOwnedFile(psView->pcPath + ulOffset,
+                                     ulEnd - ulOffset, oNCurr,
+                                     &oNNewNode, pvContents, ulLength,
+                                     oSContents);
+      else if(bIsFile && ulEnd == psView->ulLength)
+         /* insert the new node file for this final level */
+         iStatus = Node_newFile(psView->pcPath + ulOffset,
+                                ulEnd - ulOffset, oNCurr, &oNNewNode,
+                                pvContents, ulLength);
+      else
+         /* insert the new node directory for all other levels */
+         iStatus = Node_newDir(psView->pcPath + ulOffset,
+                               ulEnd - ulOffset, oNCurr, &oNNewNode);
       if(iStatus != SUCCESS) {
-         Path_free(oPPath);
          if(oNFirstNew != NULL)
             (void) Node_free(oNFirstNew);
          assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
          return iStatus;
       }
-      if(ulIndex == ulDepth) {
-        /* insert the new node file for this final level */
-        iStatus = Node_newFile(oPPrefix, oNCurr, &oNNewNode, pvContents,
-         ulLength);
-        if(iStatus != SUCCESS) {
-            Path_free(oPPath);
-            Path_free(oPPrefix);
-            if(oNFirstNew != NULL) (void) Node_free(oNFirstNew);
-            assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-            return iStatus;
-        }
-      }
-      
-      else {
-        /* insert the new node directory for all preceding levels */
-        iStatus = Node_newDir(oPPrefix, oNCurr, &oNNewNode);
-        if(iStatus != SUCCESS) {
-            Path_free(oPPath);
-            Path_free(oPPrefix);
-            if(oNFirstNew != NULL) (void) Node_free(oNFirstNew);
-            assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-            return iStatus;
-        }
-      }
+      if(oCContents != NULL && ulEnd == psView->ulLength)
+         Node_setContent(oNNewNode, oCContents);
       /* set up for next level */
-      Path_free(oPPrefix);
       oNCurr = oNNewNode;
       ulNewNodes++;
       if(oNFirstNew == NULL)
          oNFirstNew = oNCurr;
-      ulIndex++;
+      ulOffset = ulEnd + 1;
    }
-   Path_free(oPPath);
    /* update FT state variables to reflect insertion */
    if(oNRoot == NULL)
       oNRoot = oNFirstNew;
    ulCount += ulNewNodes;
-   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   FT_filterAdded(oNFirstNew);
+   FT_sweepCold();
    return SUCCESS;
 }
 
-/* see ft.h for specification*/
-boolean FT_containsDir(const char *pcPath) {
-   int iStatus;
-   Node_T oNFound = NULL;
-   assert(pcPath != NULL);
-   iStatus = FT_findNode(pcPath, &oNFound);
-   if(iStatus == SUCCESS) {
-    if(!Node_getType(oNFound)) return TRUE; /* type is directory*/
-   }
-   return FALSE;
-}
-
-/* see ft.h for specification*/
-boolean FT_containsFile(const char *pcPath) {
+/*
+  Validates the ulPathLength characters at pcPath, finds their closest
+  ancestor in the FT, and inserts a directory or file there as
+  FT_insertNode does. Returns any error from either step, or
+  CONFLICTING_PATH if the new file would be the root.
+*/
+static int FT_insertAbsolute(const char *pcPath, size_t ulPathLength,
+                             boolean bIsFile, void *pvContents,
+                             size_t ulLength) {
    int iStatus;
-   Node_T oNFound = NULL;
+   PathView oView;
+   Node_T oNCurr = NULL;
+   size_t ulOffset;
    assert(pcPath != NULL);
-   iStatus = FT_findNode(pcPath, &oNFound);
-   if(iStatus == SUCCESS) {
-    if(Node_getType(oNFound)) return TRUE; /* ensures type is file*/
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   iStatus = FT_checkMutable();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Path_initView(&oView, pcPath, ulPathLength);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   /* ensures new file would not be the ft root */
+   if(bIsFile && oView.ulDepth == 1)
+      return CONFLICTING_PATH;
+   /* find the closest ancestor of the path already in the tree */
+   iStatus = FT_traversePath(&oView, TRUE, &oNCurr, &ulOffset);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_insertNode(&oView, ulOffset, oNCurr, bIsFile,
+                           pvContents, ulLength, NULL);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/* see ft.h for specification */
+int FT_insertDir(const char *pcPath) {
+   assert(pcPath != NULL);
+   return FT_insertDirN(pcPath, strlen(pcPath));
+}
+
+/* see ft.h for specification */
+int FT_insertDirN(const char *pcPath, size_t ulPathLength) {
+   assert(pcPath != NULL);
+   return FT_insertAbsolute(pcPath, ulPathLength, FALSE, NULL, 0);
+}
+
+/* see ft.h for specification*/
+int FT_insertFile(const char *pcPath, void *pvContents,
+                  size_t ulLength) {
+   assert(pcPath != NULL);
+   return FT_insertFileN(pcPath, strlen(pcPath), pvContents, ulLength);
+}
+
+/* see ft.h for specification*/
+int FT_insertFileN(const char *pcPath, size_t ulPathLength,
+                   void *pvContents, size_t ulLength) {
+   assert(pcPath != NULL);
+   return FT_insertAbsolute(pcPath, ulPathLength, TRUE,
+                            pvContents, ulLength);
+}
+
+/* see ft.h for specification*/
+int FT_insertFileFromFd(const char *pcPath, int iFd, size_t ulOffset,
+                        size_t ulLength) {
+   int iStatus;
+   PathView oView;
+   Content_T oCContents;
+   Node_T oNCurr = NULL;
+   size_t ulPathOffset;
+   size_t ulChildID;
+   assert(pcPath != NULL);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   if(FT_checkMutable() != SUCCESS ||
+      eContentMode == FT_CONTENTS_BORROWED)
+      return INITIALIZATION_ERROR;
+   if(ulLength == 0)
+      return FT_insertFile(pcPath, NULL, 0);
+   /* check that the file can go at pcPath before reading anything,
+      which could not be unread from a pipe */
+   iStatus = Path_initView(&oView, pcPath, strlen(pcPath));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(oView.ulDepth == 1)
+      return CONFLICTING_PATH;
+   iStatus = FT_traversePath(&oView, FALSE, &oNCurr, &ulPathOffset);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(ulPathOffset > oView.ulLength ||
+      FT_findPacked(&oView, ulPathOffset, oNCurr, &ulChildID))
+      return ALREADY_IN_TREE;
+   if(oNCurr != NULL && Node_getType(oNCurr))
+      return NOT_A_DIRECTORY;
+
+   iStatus = FT_ensureStore();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   oCContents = Content_newMapped(oSContents, iFd, ulOffset, ulLength);
+   if(oCContents == NULL)
+      return MEMORY_ERROR;
+   iStatus = FT_traversePath(&oView, TRUE, &oNCurr, &ulPathOffset);
+   if(iStatus == SUCCESS)
+      iStatus = FT_insertNode(&oView, ulPathOffset, oNCurr, TRUE, NULL,
+                              0, oCContents);
+   if(iStatus != SUCCESS)
+      Content_release(oCContents);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/* see ft.h for specification*/
+boolean FT_containsDir(const char *pcPath) {
+   assert(pcPath != NULL);
+   return FT_containsDirN(pcPath, strlen(pcPath));
+}
+
+/*
+  Returns TRUE if the FT contains a file (if bIsFile is TRUE) or a
+  directory (if bIsFile is FALSE) with the absolute path made up of
+  the ulPathLength characters at pcPath, and FALSE if not or if there
+  is an error while checking. The filter of paths is asked first, and
+  a path it rules out is not looked for.
+*/
+static boolean FT_containsNode(const char *pcPath, size_t ulPathLength,
+                               boolean bIsFile) {
+   PathView oView;
+   boolean bFoundFile;
+   size_t ulSize;
+   assert(pcPath != NULL);
+   if(!bIsInitialized ||
+      Path_initView(&oView, pcPath, ulPathLength) != SUCCESS)
+      return FALSE;
+   if(!FT_filterPasses(&oView))
+      return FALSE;
+   if(FT_statView(&oView, &bFoundFile, &ulSize) != SUCCESS) {
+      if(oBPaths != NULL)
+         sFilterStats.ulFalsePositives++;
+      return FALSE;
+   }
+   return (boolean) (bFoundFile == bIsFile);
+}
+
+/* see ft.h for specification*/
+boolean FT_containsDirN(const char *pcPath, size_t ulPathLength) {
+   assert(pcPath != NULL);
+   return FT_containsNode(pcPath, ulPathLength, FALSE);
+}
+
+/* see ft.h for specification*/
+boolean FT_containsFile(const char *pcPath) {
+   assert(pcPath != NULL);
+   return FT_containsFileN(pcPath, strlen(pcPath));
+}
+
+/* see ft.h for specification*/
+boolean FT_containsFileN(const char *pcPath, size_t ulPathLength) {
+   assert(pcPath != NULL);
+   return FT_containsNode(pcPath, ulPathLength, TRUE);
+}
+/*
+  Removes oNFound, which was found by a traversal with
+  materialization, and its whole hierarchy from the FT, and updates
+  the FT state variables. Returns SUCCESS, or MEMORY_ERROR (leaving
+  the FT unchanged) if lazy copies could not be materialized.
+*/
+static int FT_removeNode(Node_T oNFound) {
+   int iStatus;
+   assert(oNFound != NULL);
+   if(Node_getParent(oNFound) != NULL) {
+      iStatus = FT_unshareSpine(Node_getParent(oNFound));
+      if(iStatus != SUCCESS)
+         return iStatus;
    }
-   return FALSE;
+   /* open handles below must not live on in a lazy copy */
+   iStatus = Node_retirePins(oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   FT_filterRemoved(oNFound);
+   ulCount -= Node_free(oNFound);
+   if(ulCount == 0)
+      oNRoot = NULL;
+   FT_sweepCold();
+   return SUCCESS;
 }
+
 /* see ft.h for specification*/
 int FT_rmDir(const char *pcPath) {
+   assert(pcPath != NULL);
+   return FT_rmDirN(pcPath, strlen(pcPath));
+}
+
+/* see ft.h for specification*/
+int FT_rmDirN(const char *pcPath, size_t ulPathLength) {
    int iStatus;
    Node_T oNFound = NULL;
    assert(pcPath != NULL);
    assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-   iStatus = FT_findNode(pcPath, &oNFound);
+   iStatus = FT_checkMutable();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_findNode(pcPath, ulPathLength, TRUE, &oNFound);
    if(iStatus != SUCCESS)
        return iStatus;
    if(Node_getType(oNFound)) {
       return NOT_A_DIRECTORY; /* prevents removing file*/
    }
-   ulCount -= Node_free(oNFound);
-   if(ulCount == 0)
-      oNRoot = NULL;
+   iStatus = FT_removeNode(oNFound);
    assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-   return SUCCESS;
+   return iStatus;
 }
 /* see ft.h for specification*/
 int FT_rmFile(const char *pcPath) {
+   assert(pcPath != NULL);
+   return FT_rmFileN(pcPath, strlen(pcPath));
+}
+
+/* see ft.h for specification*/
+int FT_rmFileN(const char *pcPath, size_t ulPathLength) {
    int iStatus;
    Node_T oNFound = NULL;
    assert(pcPath != NULL);
    assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
-   iStatus = FT_findNode(pcPath, &oNFound);
+   iStatus = FT_checkMutable();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_findNode(pcPath, ulPathLength, TRUE, &oNFound);
    if(iStatus != SUCCESS)
        return iStatus;
    if(!Node_getType(oNFound)) {
       return NOT_A_FILE; /* prevents removing directory*/
    }
 
-   ulCount -= Node_free(oNFound);
-   if(ulCount == 0)
-      oNRoot = NULL;
-   
+   iStatus = FT_removeNode(oNFound);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+/* see ft.h for specification*/
+int FT_rename(const char *pcFrom, const char *pcTo) {
+   int iStatus;
+   PathView oFromView, oToView;
+   Node_T oNFrom = NULL;
+   Node_T oNParent = NULL;
+   Node_T oNAncestor;
+   size_t ulOffset;
+   assert(pcFrom != NULL);
+   assert(pcTo != NULL);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   iStatus = FT_checkMutable();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_findNode(pcFrom, strlen(pcFrom), TRUE, &oNFrom);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Path_initView(&oFromView, pcFrom, strlen(pcFrom));
+   assert(iStatus == SUCCESS);
+   iStatus = Path_initView(&oToView, pcTo, strlen(pcTo));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   /* the root can only be renamed, and nothing else can become it */
+   if((oNFrom == oNRoot) != (oToView.ulDepth == 1))
+      return CONFLICTING_PATH;
+   if(oNFrom == oNRoot) {
+      if(oToView.ulLength == oFromView.ulLength &&
+         !memcmp(pcTo, pcFrom, oToView.ulLength))
+         return ALREADY_IN_TREE;
+      iStatus = Node_move(oNRoot, NULL, pcTo, oToView.ulLength);
+      /* every path has changed */
+      if(iStatus == SUCCESS)
+         FT_dropFilter();
+      assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+      return iStatus;
+   }
+   /* find the new parent, which must already exist as a directory */
+   iStatus = FT_traversePath(&oToView, TRUE, &oNParent, &ulOffset);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(ulOffset > oToView.ulLength)
+      return ALREADY_IN_TREE;
+   if(Node_getType(oNParent))
+      return NOT_A_DIRECTORY;
+   if(Path_viewComponentEnd(&oToView, ulOffset) != oToView.ulLength)
+      return NO_SUCH_PATH;
+   /* neither parent may be seen through a lazy copy afterwards, which
+      also ensures that no lazy copy being moved shares an ancestor of
+      its new parent */
+   iStatus = FT_unpack(oNParent);
+   if(iStatus == SUCCESS)
+      iStatus = FT_unshareSpine(Node_getParent(oNFrom));
+   if(iStatus == SUCCESS)
+      iStatus = FT_unshareSpine(oNParent);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   /* a directory can't be moved into its own subtree */
+   for(oNAncestor = oNParent; oNAncestor != NULL;
+       oNAncestor = Node_getParent(oNAncestor))
+      if(oNAncestor == oNFrom)
+         return CONFLICTING_PATH;
+   iStatus = Node_move(oNFrom, oNParent, pcTo + ulOffset,
+                       oToView.ulLength - ulOffset);
+   /* every path below the moved node has changed */
+   if(iStatus == SUCCESS)
+      FT_dropFilter();
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+/* see ft.h for specification*/
+int FT_copyTree(const char *pcSrc, const char *pcDst) {
+   int iStatus;
+   PathView oDstView;
+   Node_T oNSrc = NULL;
+   Node_T oNParent = NULL;
+   Node_T oNAncestor;
+   Node_T oNCopy = NULL;
+   size_t ulOffset;
+   assert(pcSrc != NULL);
+   assert(pcDst != NULL);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   iStatus = FT_checkMutable();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_findNode(pcSrc, strlen(pcSrc), FALSE, &oNSrc);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Path_initView(&oDstView, pcDst, strlen(pcDst));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   /* the copy can't be a second root */
+   if(oDstView.ulDepth == 1)
+      return CONFLICTING_PATH;
+   /* find the new parent, which must already exist as a directory */
+   iStatus = FT_traversePath(&oDstView, TRUE, &oNParent, &ulOffset);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(ulOffset > oDstView.ulLength)
+      return ALREADY_IN_TREE;
+   if(Node_getType(oNParent))
+      return NOT_A_DIRECTORY;
+   if(Path_viewComponentEnd(&oDstView, ulOffset) != oDstView.ulLength)
+      return NO_SUCH_PATH;
+   iStatus = FT_unpack(oNParent);
+   if(iStatus == SUCCESS)
+      iStatus = FT_unshareSpine(oNParent);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   /* the source may have been materialized along the way, so find it
+      again; its lazy copy can't be placed inside it */
+   iStatus = FT_findNode(pcSrc, strlen(pcSrc), FALSE, &oNSrc);
+   assert(iStatus == SUCCESS);
+   if(Node_getShare(oNSrc) != NULL)
+      oNSrc = Node_getShare(oNSrc);
+   for(oNAncestor = oNParent; oNAncestor != NULL;
+       oNAncestor = Node_getParent(oNAncestor))
+      if(oNAncestor == oNSrc)
+         return CONFLICTING_PATH;
+   iStatus = Node_newCopy(pcDst + ulOffset, oDstView.ulLength - ulOffset,
+                          oNParent, oNSrc, &oNCopy);
+   /* the copy presents its source's paths without a walk, and the
+      filter would need one */
+   if(iStatus == SUCCESS) {
+      ulCount++;
+      FT_dropFilter();
+   }
    assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+/*
+  Builds the entries of scanned directory oIDir, and everything below
+  them, as children of the new directory oNDir, adding the number of
+  nodes created to *pulNew. Files hold the scanned contents, if there
+  are any; otherwise, in the owning modes, a hole of the scanned size,
+  and in FT_CONTENTS_BORROWED mode NULL with the scanned size. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated, in which
+  case the nodes created so far are left in place.
+*/
+static int FT_buildImported(Node_T oNDir, ImportDir_T oIDir,
+                            size_t *pulNew) {
+   ImportDir_T oISubdir;
+   Node_T oNChild = NULL;
+   const char *pcName;
+   size_t ulNameLength;
+   size_t ulIndex;
+   int iStatus;
+   assert(oNDir != NULL);
+   assert(oIDir != NULL);
+   assert(pulNew != NULL);
+   /* the entries are sorted, so each child is added at the end */
+   for(ulIndex = 0; ulIndex < ImportDir_getNumEntries(oIDir);
+       ulIndex++) {
+      pcName = ImportDir_getName(oIDir, ulIndex, &ulNameLength);
+      oISubdir = ImportDir_getSubdir(oIDir, ulIndex);
+      if(oISubdir != NULL)
+         iStatus = Node_newDir(pcName, ulNameLength, oNDir, &oNChild);
+      else if(eContentMode != FT_CONTENTS_BORROWED)
+         iStatus = Node_newOwnedFile(pcName, ulNameLength, oNDir,
+                                     &oNChild,
+                                     ImportDir_getContents(oIDir,
+                                                           ulIndex),
+                                     ImportDir_getSize(oIDir, ulIndex),
+                                     oSContents);
+      else
+         iStatus = Node_newFile(pcName, ulNameLength, oNDir, &oNChild,
+                                NULL, ImportDir_getSize(oIDir, ulIndex));
+      if(iStatus != SUCCESS)
+         return iStatus;
+      (*pulNew)++;
+      if(oISubdir != NULL) {
+         iStatus = FT_buildImported(oNChild, oISubdir, pulNew);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+   }
+   return SUCCESS;
+}
+
+/* see ft.h for specification*/
+int FT_importDirectory(const char *pcFsRoot, const char *pcPath,
+                       size_t ulThreads, enum importMode eMode) {
+   int iStatus;
+   PathView oView;
+   Import_T oIImport = NULL;
+   Node_T oNCurr = NULL;
+   Node_T oNFirstNew = NULL;
+   Node_T oNDir = NULL;
+   Node_T oNChild = NULL;
+   size_t ulOffset;
+   size_t ulNew = 0;
+   size_t ulChild;
+   size_t ulChildID;
+   assert(pcFsRoot != NULL);
+   assert(pcPath != NULL);
+   assert(eMode == FT_IMPORT_METADATA || eMode == FT_IMPORT_CONTENTS);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   if(FT_checkMutable() != SUCCESS ||
+      (eMode == FT_IMPORT_CONTENTS &&
+       eContentMode == FT_CONTENTS_BORROWED))
+      return INITIALIZATION_ERROR;
+   /* check that the directory can go at pcPath before scanning */
+   iStatus = Path_initView(&oView, pcPath, strlen(pcPath));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_traversePath(&oView, FALSE, &oNCurr, &ulOffset);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(ulOffset > oView.ulLength ||
+      FT_findPacked(&oView, ulOffset, oNCurr, &ulChildID))
+      return ALREADY_IN_TREE;
+   if(oNCurr != NULL && Node_getType(oNCurr))
+      return NOT_A_DIRECTORY;
+
+   iStatus = Import_scan(pcFsRoot, ulThreads,
+                         (boolean) (eMode == FT_IMPORT_CONTENTS),
+                         &oIImport);
+   if(iStatus == SUCCESS && eContentMode != FT_CONTENTS_BORROWED)
+      iStatus = FT_ensureStore();
+   if(iStatus == SUCCESS)
+      iStatus = FT_insertAbsolute(pcPath, strlen(pcPath), FALSE,
+                                  NULL, 0);
+   if(iStatus != SUCCESS) {
+      Import_free(oIImport);
+      return iStatus;
+   }
+   /* removing the first directory inserted undoes the insertion */
+   (void) FT_findNode(pcPath, Path_viewComponentEnd(&oView, ulOffset),
+                      FALSE, &oNFirstNew);
+   (void) FT_findNode(pcPath, strlen(pcPath), FALSE, &oNDir);
+   iStatus = FT_buildImported(oNDir, Import_getRoot(oIImport), &ulNew);
+   ulCount += ulNew;
+   /* the filter must hold the new nodes, even those about to go */
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNDir); ulChild++) {
+      (void) Node_getChild(oNDir, ulChild, &oNChild);
+      FT_filterAdded(oNChild);
+   }
+   if(iStatus != SUCCESS)
+      (void) FT_removeNode(oNFirstNew);
+   Import_free(oIImport);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/*
+  Adds to oXExport the children of directory oNDir, at depth ulDepth,
+  and everything below them. oNDir's path on disk is the first
+  ulLength characters of *ppcPath, a buffer of *pulCapacity characters
+  that is grown as needed to hold the paths below it. Returns SUCCESS,
+  or otherwise:
+  * BAD_PATH if a name below oNDir is "." or "..", which can't be a
+             name on disk
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int FT_planExport(Export_T oXExport, Node_T oNDir,
+                         char **ppcPath, size_t *pulCapacity,
+                         size_t ulLength, size_t ulDepth) {
+   Node_T oNChild = NULL;
+   const char *pcName;
+   char *pcGrown;
+   size_t ulNameLength;
+   size_t ulChild;
+   int iStatus;
+   assert(oXExport != NULL);
+   assert(oNDir != NULL);
+   assert(ppcPath != NULL);
+   assert(pulCapacity != NULL);
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNDir); ulChild++) {
+      (void) Node_getChild(oNDir, ulChild, &oNChild);
+      pcName = Node_getName(oNChild, &ulNameLength);
+      if((ulNameLength == 1 && pcName[0] == '.') ||
+         (ulNameLength == 2 && !memcmp(pcName, "..", 2)))
+         return BAD_PATH;
+      if(ulLength + 1 + ulNameLength > *pulCapacity) {
+         pcGrown = realloc(*ppcPath, 2 * (ulLength + 1 + ulNameLength));
+         if(pcGrown == NULL)
+            return MEMORY_ERROR;
+         *ppcPath = pcGrown;
+         *pulCapacity = 2 * (ulLength + 1 + ulNameLength);
+      }
+      (*ppcPath)[ulLength] = '/';
+      memcpy(*ppcPath + ulLength + 1, pcName, ulNameLength);
+      if(Node_getType(oNChild))
+         iStatus = Export_addFile(oXExport, *ppcPath,
+                                  ulLength + 1 + ulNameLength, oNChild);
+      else {
+         iStatus = Export_addDir(oXExport, *ppcPath,
+                                 ulLength + 1 + ulNameLength,
+                                 ulDepth);
+         if(iStatus == SUCCESS)
+            iStatus = FT_planExport(oXExport, oNChild, ppcPath,
+                                    pulCapacity,
+                                    ulLength + 1 + ulNameLength,
+                                    ulDepth + 1);
+      }
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   return SUCCESS;
+}
+
+/* see ft.h for specification*/
+int FT_exportDirectory(const char *pcPath, const char *pcFsRoot,
+                       size_t ulThreads, struct exportTimes *psTimes) {
+   int iStatus;
+   Export_T oXExport;
+   Node_T oNDir = NULL;
+   char *pcDiskPath;
+   size_t ulCapacity;
+   struct exportTimes sTimes;
+   assert(pcPath != NULL);
+   assert(pcFsRoot != NULL);
+   iStatus = FT_findNode(pcPath, strlen(pcPath), FALSE, &oNDir);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(Node_getType(oNDir))
+      return NOT_A_DIRECTORY;
+   /* lazy copies below may present directories packed elsewhere */
+   iStatus = FT_unpackTree(oNRoot);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* list everything to create, with its path on disk */
+   oXExport = Export_new();
+   ulCapacity = strlen(pcFsRoot) + 1;
+   pcDiskPath = malloc(ulCapacity);
+   if(oXExport == NULL || pcDiskPath == NULL) {
+      Export_free(oXExport);
+      free(pcDiskPath);
+      return MEMORY_ERROR;
+   }
+   strcpy(pcDiskPath, pcFsRoot);
+   iStatus = Export_addDir(oXExport, pcFsRoot, strlen(pcFsRoot), 0);
+   if(iStatus == SUCCESS)
+      iStatus = FT_planExport(oXExport, oNDir, &pcDiskPath, &ulCapacity,
+                              strlen(pcFsRoot), 1);
+   free(pcDiskPath);
+   /* then create it all */
+   if(iStatus == SUCCESS)
+      iStatus = Export_run(oXExport, ulThreads, &sTimes.ulPlanNs,
+                           &sTimes.ulDirsNs, &sTimes.ulFilesNs);
+   if(iStatus == SUCCESS && psTimes != NULL)
+      *psTimes = sTimes;
+   Export_free(oXExport);
+   return iStatus;
+}
+
+/* The size of the buffer through which contents pass to and from a
+   tar archive: smaller files are read whole */
+enum { TAR_PIECE = 1 << 16 };
+
+/*
+  Writes the contents of file node oNFile as the contents of the
+  member last started in oWWriter's archive, passing them through
+  pcBuf, a buffer of TAR_PIECE bytes, unless they are held flat.
+  Returns SUCCESS, or MEMORY_ERROR if the archive could not be
+  written.
+*/
+static int FT_writeTarContents(TarWriter_T oWWriter, Node_T oNFile,
+                               char *pcBuf) {
+   size_t ulSize;
+   size_t ulOffset;
+   size_t ulRead;
+   int iStatus;
+   assert(oWWriter != NULL);
+   assert(oNFile != NULL);
+   assert(pcBuf != NULL);
+   ulSize = Node_getSizeContents(oNFile);
+   if(Node_getFileContents(oNFile) != NULL)
+      return TarWriter_write(oWWriter, Node_getFileContents(oNFile),
+                             ulSize);
+   /* chunked contents, or NULL borrowed ones, a piece at a time */
+   for(ulOffset = 0; ulOffset < ulSize; ulOffset += ulRead) {
+      ulRead = Node_readAt(oNFile, ulOffset, pcBuf, TAR_PIECE);
+      iStatus = TarWriter_write(oWWriter, pcBuf, ulRead);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   return SUCCESS;
+}
+
+/*
+  Writes directory oNDir, and then everything below it in pre-order,
+  files before directories as in FT_toString, to oWWriter's archive.
+  The path of oNDir's parent is the first ulPrefix characters of
+  *ppcPath (0 for the root), a buffer of *pulCapacity characters that
+  is grown as needed to hold the paths below it. Contents pass through
+  pcBuf, a buffer of TAR_PIECE bytes. Returns SUCCESS, or MEMORY_ERROR
+  if memory could not be allocated or the archive could not be
+  written.
+*/
+static int FT_writeTarDir(TarWriter_T oWWriter, Node_T oNDir,
+                          char **ppcPath, size_t *pulCapacity,
+                          size_t ulPrefix, char *pcBuf) {
+   Node_T oNChild = NULL;
+   const char *pcName;
+   char *pcGrown;
+   size_t ulNameLength;
+   size_t ulLength;
+   size_t ulChild;
+   boolean bFiles;
+   int iStatus;
+   assert(oWWriter != NULL);
+   assert(oNDir != NULL);
+   assert(ppcPath != NULL);
+   assert(pulCapacity != NULL);
+   /* the root's path is its name; others' are "prefix/name" */
+   pcName = Node_getName(oNDir, &ulNameLength);
+   ulLength = ulPrefix == 0 ? 0 : ulPrefix + 1;
+   if(ulLength + ulNameLength > *pulCapacity) {
+      pcGrown = realloc(*ppcPath, 2 * (ulLength + ulNameLength));
+      if(pcGrown == NULL)
+         return MEMORY_ERROR;
+      *ppcPath = pcGrown;
+      *pulCapacity = 2 * (ulLength + ulNameLength);
+   }
+   if(ulPrefix != 0)
+      (*ppcPath)[ulPrefix] = '/';
+   memcpy(*ppcPath + ulLength, pcName, ulNameLength);
+   ulLength += ulNameLength;
+   iStatus = TarWriter_add(oWWriter, *ppcPath, ulLength, FALSE, 0);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* goes through children twice: files first, then directories */
+   for(bFiles = TRUE; ; bFiles = FALSE) {
+      for(ulChild = 0; ulChild < Node_getNumChildren(oNDir);
+          ulChild++) {
+         if(Node_isChildFile(oNDir, ulChild) != bFiles)
+            continue;
+         (void) Node_getChild(oNDir, ulChild, &oNChild);
+         if(!bFiles) {
+            iStatus = FT_writeTarDir(oWWriter, oNChild, ppcPath,
+                                     pulCapacity, ulLength, pcBuf);
+            if(iStatus != SUCCESS)
+               return iStatus;
+            continue;
+         }
+         pcName = Node_getName(oNChild, &ulNameLength);
+         if(ulLength + 1 + ulNameLength > *pulCapacity) {
+            pcGrown = realloc(*ppcPath,
+                              2 * (ulLength + 1 + ulNameLength));
+            if(pcGrown == NULL)
+               return MEMORY_ERROR;
+            *ppcPath = pcGrown;
+            *pulCapacity = 2 * (ulLength + 1 + ulNameLength);
+         }
+         (*ppcPath)[ulLength] = '/';
+         memcpy(*ppcPath + ulLength + 1, pcName, ulNameLength);
+         iStatus = TarWriter_add(oWWriter, *ppcPath,
+                                 ulLength + 1 + ulNameLength, TRUE,
+                                 Node_getSizeContents(oNChild));
+         if(iStatus == SUCCESS)
+            iStatus = FT_writeTarContents(oWWriter, oNChild, pcBuf);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+      if(!bFiles)
+         break;
+   }
+   return SUCCESS;
+}
+
+/* see ft.h for specification*/
+int FT_writeTar(int iFd) {
+   TarWriter_T oWWriter;
+   char *pcPath = NULL;
+   char *pcBuf;
+   size_t ulCapacity = 0;
+   int iStatus = SUCCESS;
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   if(oNRoot != NULL) {
+      iStatus = FT_unpackTree(oNRoot);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   oWWriter = TarWriter_new(iFd);
+   pcBuf = malloc(TAR_PIECE);
+   if(oWWriter == NULL || pcBuf == NULL) {
+      TarWriter_free(oWWriter);
+      free(pcBuf);
+      return MEMORY_ERROR;
+   }
+   if(oNRoot != NULL)
+      iStatus = FT_writeTarDir(oWWriter, oNRoot, &pcPath, &ulCapacity,
+                               0, pcBuf);
+   if(iStatus == SUCCESS)
+      iStatus = TarWriter_finish(oWWriter);
+   free(pcPath);
+   free(pcBuf);
+   TarWriter_free(oWWriter);
+   return iStatus;
+}
+
+/*
+  Finds the child of directory oNParent (or the root, if oNParent is
+  NULL) named by the ulNameLength characters at pcName, which must be
+  a directory, or creates it and adds it to oDNew. Stores the
+  directory in *poNResult. Returns SUCCESS, or otherwise:
+  * CONFLICTING_PATH if pcName is not the root's name
+  * NOT_A_DIRECTORY if the child is a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int FT_readTarDir(Node_T oNParent, const char *pcName,
+                         size_t ulNameLength, DynArray_T oDNew,
+                         Node_T *poNResult) {
+   const char *pcRootName;
+   size_t ulRootLength;
+   size_t ulChildID;
+   size_t ulNew;
+   int iStatus;
+   assert(pcName != NULL);
+   assert(oDNew != NULL);
+   assert(poNResult != NULL);
+   if(oNParent == NULL && oNRoot != NULL) {
+      pcRootName = Node_getName(oNRoot, &ulRootLength);
+      if(ulRootLength != ulNameLength ||
+         memcmp(pcRootName, pcName, ulNameLength) != 0)
+         return CONFLICTING_PATH;
+      *poNResult = oNRoot;
+      return SUCCESS;
+   }
+   if(oNParent != NULL) {
+      if(Node_getShare(oNParent) != NULL) {
+         iStatus = Node_materialize(oNParent, &ulNew);
+         if(iStatus != SUCCESS)
+            return iStatus;
+         ulCount += ulNew;
+      }
+      if(Node_hasChildName(oNParent, pcName, ulNameLength,
+                           &ulChildID)) {
+         /* packed children are all files */
+         if(Node_isPacked(oNParent))
+            return NOT_A_DIRECTORY;
+         (void) Node_getChild(oNParent, ulChildID, poNResult);
+         return Node_getType(*poNResult) ? NOT_A_DIRECTORY : SUCCESS;
+      }
+      iStatus = FT_unshareSpine(oNParent);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   iStatus = Node_newDir(pcName, ulNameLength, oNParent, poNResult);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(DynArray_add(oDNew, *poNResult) == 0) {
+      (void) Node_free(*poNResult);
+      return MEMORY_ERROR;
+   }
+   ulCount++;
+   if(oNRoot == NULL)
+      oNRoot = *poNResult;
+   return SUCCESS;
+}
+
+/*
+  Creates a file named by the ulNameLength characters at pcName in
+  directory oNParent, holding the ulSize bytes that follow in
+  oRReader's archive, and adds it to oDNew. Contents pass through
+  pcBuf, a buffer of TAR_PIECE bytes: smaller contents are stored
+  whole, and larger ones a piece at a time, with pieces of zeros left
+  as holes. Returns SUCCESS, or otherwise:
+  * ALREADY_IN_TREE if oNParent already has a child named pcName
+  * BAD_PATH if the archive is malformed
+  * MEMORY_ERROR if memory could not be allocated or the archive could
+                 not be read
+*/
+static int FT_readTarFile(TarReader_T oRReader, Node_T oNParent,
+                          const char *pcName, size_t ulNameLength,
+                          size_t ulSize, DynArray_T oDNew,
+                          char *pcBuf) {
+   Node_T oNFile = NULL;
+   size_t ulChildID;
+   size_t ulOffset;
+   size_t ulPiece;
+   size_t ulIndex;
+   size_t ulNew;
+   int iStatus;
+   assert(oRReader != NULL);
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+   assert(oDNew != NULL);
+   assert(pcBuf != NULL);
+   if(Node_getShare(oNParent) != NULL) {
+      iStatus = Node_materialize(oNParent, &ulNew);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      ulCount += ulNew;
+   }
+   if(Node_hasChildName(oNParent, pcName, ulNameLength, &ulChildID))
+      return ALREADY_IN_TREE;
+   iStatus = FT_unshareSpine(oNParent);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   if(ulSize <= TAR_PIECE) {
+      iStatus = TarReader_read(oRReader, pcBuf, ulSize);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      iStatus = Node_newOwnedFile(pcName, ulNameLength, oNParent,
+                                  &oNFile, pcBuf, ulSize, oSContents);
+   }
+   else
+      /* a hole, filled in below */
+      iStatus = Node_newOwnedFile(pcName, ulNameLength, oNParent,
+                                  &oNFile, NULL, ulSize, oSContents);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(DynArray_add(oDNew, oNFile) == 0) {
+      (void) Node_free(oNFile);
+      return MEMORY_ERROR;
+   }
+   ulCount++;
+   for(ulOffset = 0; ulSize > TAR_PIECE && ulOffset < ulSize;
+       ulOffset += ulPiece) {
+      ulPiece = ulSize - ulOffset < TAR_PIECE ? ulSize - ulOffset
+                                              : TAR_PIECE;
+      iStatus = TarReader_read(oRReader, pcBuf, ulPiece);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      for(ulIndex = 0; ulIndex < ulPiece && pcBuf[ulIndex] == '\0';
+          ulIndex++)
+         ;
+      if(ulIndex < ulPiece) {
+         iStatus = Node_writeAt(oNFile, ulOffset, pcBuf, ulPiece,
+                                oSContents);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+   }
+   return SUCCESS;
+}
+
+/*
+  Adds the member of oRReader's archive whose path is viewed by
+  psView, a directory or (if bIsFile is TRUE) a file of ulSize bytes,
+  to the FT. oDChain holds the directories on the path of the last
+  member added, from the root down; those it shares with psView's
+  path are reused without searching, and the rest are replaced by the
+  directories on psView's path, found or created. Every node created
+  is added to oDNew. Returns SUCCESS, or otherwise the statuses
+  described for FT_readTar.
+*/
+static int FT_readTarMember(TarReader_T oRReader, const PathView *psView,
+                            boolean bIsFile, size_t ulSize,
+                            DynArray_T oDChain, DynArray_T oDNew,
+                            char *pcBuf) {
+   Node_T oNDir = NULL;
+   Node_T oNParent = NULL;
+   const char *pcName;
+   size_t ulNameLength;
+   size_t ulStart = 0;
+   size_t ulEnd;
+   size_t ulDepth;
+   int iStatus;
+   assert(oRReader != NULL);
+   assert(psView != NULL);
+   assert(oDChain != NULL);
+   assert(oDNew != NULL);
+   if(bIsFile && psView->ulDepth == 1)
+      return CONFLICTING_PATH;
+   for(ulDepth = 0; ulDepth < psView->ulDepth; ulDepth++) {
+      ulEnd = Path_viewComponentEnd(psView, ulStart);
+      if(bIsFile && ulEnd == psView->ulLength)
+         return FT_readTarFile(oRReader, oNParent,
+                               psView->pcPath + ulStart,
+                               ulEnd - ulStart, ulSize, oDNew, pcBuf);
+      /* keep the directories shared with the last member's path */
+      if(ulDepth < DynArray_getLength(oDChain)) {
+         oNDir = DynArray_get(oDChain, ulDepth);
+         pcName = Node_getName(oNDir, &ulNameLength);
+         if(ulNameLength != ulEnd - ulStart ||
+            memcmp(pcName, psView->pcPath + ulStart, ulNameLength)) {
+            while(DynArray_getLength(oDChain) > ulDepth)
+               (void) DynArray_removeAt(oDChain,
+                                        DynArray_getLength(oDChain) - 1);
+            oNDir = NULL;
+         }
+      }
+      else
+         oNDir = NULL;
+      if(oNDir == NULL) {
+         iStatus = FT_readTarDir(oNParent, psView->pcPath + ulStart,
+                                 ulEnd - ulStart, oDNew, &oNDir);
+         /* a directory member can't replace a file */
+         if(iStatus == NOT_A_DIRECTORY && ulEnd == psView->ulLength)
+            return ALREADY_IN_TREE;
+         if(iStatus != SUCCESS)
+            return iStatus;
+         if(DynArray_add(oDChain, oNDir) == 0)
+            return MEMORY_ERROR;
+      }
+      oNParent = oNDir;
+      ulStart = ulEnd + 1;
+   }
+   /* a directory already in the FT is simply kept */
+   return SUCCESS;
+}
+
+/* see ft.h for specification*/
+int FT_readTar(int iFd) {
+   TarReader_T oRReader;
+   DynArray_T oDChain;
+   DynArray_T oDNew;
+   PathView oView;
+   const char *pcPath;
+   char *pcBuf;
+   size_t ulLength;
+   size_t ulSize;
+   boolean bIsFile;
+   int iStatus;
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   if(FT_checkMutable() != SUCCESS ||
+      eContentMode == FT_CONTENTS_BORROWED)
+      return INITIALIZATION_ERROR;
+   iStatus = FT_ensureStore();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   oRReader = TarReader_new(iFd);
+   oDChain = DynArray_new(0);
+   oDNew = DynArray_new(0);
+   pcBuf = malloc(TAR_PIECE);
+   if(oRReader == NULL || oDChain == NULL || oDNew == NULL ||
+      pcBuf == NULL)
+      iStatus = MEMORY_ERROR;
+
+   /* members are added in archive order, each beside the last */
+   while(iStatus == SUCCESS) {
+      iStatus = TarReader_next(oRReader, &pcPath, &ulLength, &bIsFile,
+                               &ulSize);
+      if(iStatus == NO_SUCH_PATH) {
+         iStatus = SUCCESS;
+         break;
+      }
+      if(iStatus == SUCCESS)
+         iStatus = Path_initView(&oView, pcPath, ulLength);
+      if(iStatus == SUCCESS)
+         iStatus = FT_readTarMember(oRReader, &oView, bIsFile, ulSize,
+                                    oDChain, oDNew, pcBuf);
+   }
+
+   /* on error, the nodes created are freed, children first */
+   while(iStatus != SUCCESS && oDNew != NULL &&
+         DynArray_getLength(oDNew) != 0) {
+      ulCount -= Node_free(DynArray_removeAt(oDNew,
+                                             DynArray_getLength(oDNew)
+                                             - 1));
+      if(ulCount == 0)
+         oNRoot = NULL;
+   }
+   /* members went in all over the tree, so the filter is built anew */
+   if(iStatus == SUCCESS && oBPaths != NULL)
+      FT_buildFilter();
+   TarReader_free(oRReader);
+   if(oDChain != NULL)
+      DynArray_free(oDChain);
+   if(oDNew != NULL)
+      DynArray_free(oDNew);
+   free(pcBuf);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/* see ft.h for specification*/
+int FT_freeze(enum freezeIndex eIndex, struct freezeStats *psStats) {
+   Frozen_T oZNew;
+   int iStatus;
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   if(oZFrozen == NULL ||
+      (eIndex == FT_FREEZE_HASHED && !Frozen_isIndexed(oZFrozen))) {
+      if(oZFrozen == NULL && oNRoot != NULL) {
+         iStatus = FT_unpackTree(oNRoot);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+      iStatus = Frozen_new(oNRoot, eIndex == FT_FREEZE_HASHED, &oZNew);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      Frozen_free(oZFrozen);
+      oZFrozen = oZNew;
+   }
+   if(psStats != NULL)
+      Frozen_getSizes(oZFrozen, &psStats->ulEntries,
+                      &psStats->ulLayoutBytes, &psStats->ulHashBytes,
+                      &psStats->ulSlotBytes);
+   return SUCCESS;
+}
+
+/* see ft.h for specification*/
+int FT_thaw(void) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   /* the nodes were kept, so there is nothing to restore */
+   Frozen_free(oZFrozen);
+   oZFrozen = NULL;
+   return SUCCESS;
+}
+
+/* see ft.h for specification*/
+void FT_getFilterStats(struct filterStats *psStats) {
+   assert(psStats != NULL);
+   *psStats = sFilterStats;
+}
+
+/* see ft.h for specification*/
+void FT_setPacking(size_t ulNewColdAfter) {
+   ulColdAfter = ulNewColdAfter;
+   if(ulColdAfter == 0 || !bIsInitialized || oZFrozen != NULL ||
+      oNRoot == NULL)
+      return;
+   ulLastSweep = Node_countChanges();
+   FT_packCold(oNRoot);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+}
+
+/* see ft.h for specification*/
+void FT_getPackStats(struct packStats *psStats) {
+   assert(psStats != NULL);
+   Node_getPackSizes(&psStats->ulDirs, &psStats->ulFiles,
+                     &psStats->ulBytes, &psStats->ulNodeBytes);
+   psStats->ulPacked = ulPacked;
+   psStats->ulUnpacked = ulUnpacked;
+}
+
+/* see ft.h for specification*/
+int FT_setContentMode(enum contentMode eMode) {
+   assert(eMode == FT_CONTENTS_BORROWED || eMode == FT_CONTENTS_OWNED ||
+          eMode == FT_CONTENTS_DEDUP);
+   if(bIsInitialized)
+      return INITIALIZATION_ERROR;
+   eContentMode = eMode;
    return SUCCESS;
 }
 /* see ft.h for specification*/
@@ -386,6 +1782,13 @@ int FT_init(void) {
    bIsInitialized = TRUE;
    oNRoot = NULL;
    ulCount = 0;
+   /* the filter starts empty, to be kept up to date from the first
+      insertion */
+   memset(&sFilterStats, 0, sizeof(sFilterStats));
+   FT_buildFilter();
+   ulPacked = 0;
+   ulUnpacked = 0;
+   ulLastSweep = Node_countChanges();
    assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
 }
@@ -394,35 +1797,68 @@ int FT_destroy(void) {
    assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    if(!bIsInitialized)
       return INITIALIZATION_ERROR;
+   Frozen_free(oZFrozen);
+   oZFrozen = NULL;
+   FT_dropFilter();
    if(oNRoot) {
       ulCount -= Node_free(oNRoot);
       oNRoot = NULL;
    }
+   /* every owned file is gone, so all of their contents can go too */
+   ContentStore_free(oSContents);
+   oSContents = NULL;
    bIsInitialized = FALSE;
    assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
 }
 /* see ft.h for specification*/
-void *FT_getFileContents(const char *pcPath) {
+void *FT_getFileContents(const char *pcPath) {
+   assert(pcPath != NULL);
+   return FT_getFileContentsN(pcPath, strlen(pcPath));
+}
+
+/* see ft.h for specification*/
+void *FT_getFileContentsN(const char *pcPath, size_t ulPathLength) {
     int iStatus;
     Node_T oNFound = NULL;
     assert(pcPath != NULL);
     
-    if(!FT_containsFile(pcPath)) return NULL;
-    iStatus = FT_findNode(pcPath, &oNFound);
-    if(iStatus != SUCCESS) return NULL;
+    iStatus = FT_findNode(pcPath, ulPathLength, FALSE, &oNFound);
+    if(iStatus != SUCCESS || !Node_getType(oNFound)) return NULL;
+    /* chunked contents must be gathered up to be returned */
+    if(Node_flatten(oNFound, oSContents) != SUCCESS) return NULL;
     return Node_getFileContents(oNFound);
 }
 /* see ft.h for specification*/
 void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
                              size_t ulNewLength) {
+   assert(pcPath != NULL);
+   return FT_replaceFileContentsN(pcPath, strlen(pcPath),
+                                 pvNewContents, ulNewLength);
+}
+
+/* see ft.h for specification*/
+void *FT_replaceFileContentsN(const char *pcPath, size_t ulPathLength,
+                              void *pvNewContents, size_t ulNewLength) {
     int iStatus;
     Node_T oNFound = NULL;
     void* oldContents;
     assert(pcPath != NULL);
-    if(FT_containsFile(pcPath)) {
-        iStatus = FT_findNode(pcPath, &oNFound);
-        if(iStatus != SUCCESS) return NULL;
+    if(FT_checkMutable() != SUCCESS) return NULL;
+    iStatus = FT_findNode(pcPath, ulPathLength, TRUE, &oNFound);
+    if(iStatus == SUCCESS && Node_getType(oNFound)) {
+        /* lazy copies of the file's directory keep the old contents */
+        if(FT_unshareSpine(Node_getParent(oNFound)) != SUCCESS)
+           return NULL;
+        if(eContentMode != FT_CONTENTS_BORROWED) {
+           /* the old contents are released, so return the new copy */
+           if(FT_ensureStore() != SUCCESS ||
+              Node_replaceOwnedContents(oNFound, pvNewContents,
+                                        ulNewLength, oSContents)
+              != SUCCESS)
+              return NULL;
+           return Node_getFileContents(oNFound);
+        }
         oldContents = Node_getFileContents(oNFound); 
         iStatus = Node_setFileContents(oNFound, pvNewContents);
         if(iStatus != SUCCESS) {
@@ -436,105 +1872,749 @@ void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
 }
 /* see ft.h for specification*/
 int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize) {
+   assert(pcPath != NULL);
+   return FT_statN(pcPath, strlen(pcPath), pbIsFile, pulSize);
+}
+
+/* see ft.h for specification*/
+int FT_statN(const char *pcPath, size_t ulPathLength,
+             boolean *pbIsFile, size_t *pulSize) {
+    PathView oView;
     int iStatus;
-    Node_T oNFound = NULL;
     assert(pcPath != NULL);
     assert(pbIsFile!=NULL);
     assert(pulSize!=NULL);
-    
-    iStatus = FT_findNode(pcPath, &oNFound);
-    if (iStatus == SUCCESS) {
-        if (Node_getType(oNFound)) {
-            *pbIsFile = TRUE;
-            *pulSize = Node_getSizeContents(oNFound);
-        }
-        else {
-            *pbIsFile = FALSE;
-        }
-    }
-    return iStatus;
+
+    if (!bIsInitialized)
+        return INITIALIZATION_ERROR;
+    iStatus = Path_initView(&oView, pcPath, ulPathLength);
+    if (iStatus != SUCCESS)
+        return iStatus;
+    return FT_statView(&oView, pbIsFile, pulSize);
 }
-/* --------------------------------------------------------------------
-  The following auxiliary functions are used for generating the
-  string representation of the FT.
+
+/* The number of lookups whose walks FT_statMany interleaves */
+enum { FT_LOOKUP_GROUP = 32 };
+
+/* A lookup of FT_statMany, as far as it has gone */
+struct lookup {
+   /* the path looked up */
+   PathView sView;
+   /* the furthest node reached, and the offset in sView of the first
+      component below it, as FT_descend leaves them */
+   Node_T oNCurr;
+   size_t ulOffset;
+   /* the search for that component among oNCurr's children */
+   struct nodeSearch sSearch;
+   /* TRUE once the lookup has gone as far as it can */
+   boolean bDone;
+};
+
+/*
+  Starts psLookup's search for the component of its path at its
+  offset, or marks it done if there is none, or if its node is a
+  packed directory, whose files have no nodes to descend to.
 */
+static void FT_startLookup(struct lookup *psLookup) {
+   size_t ulEnd;
+   assert(psLookup != NULL);
+   if(psLookup->ulOffset >= psLookup->sView.ulLength) {
+      psLookup->bDone = TRUE;
+      return;
+   }
+   ulEnd = Path_viewComponentEnd(&psLookup->sView, psLookup->ulOffset);
+   Node_startSearch(&psLookup->sSearch, psLookup->oNCurr,
+                    psLookup->sView.pcPath + psLookup->ulOffset,
+                    ulEnd - psLookup->ulOffset);
+}
+
 /*
-  Performs a pre-order traversal of the tree rooted at n,
-  inserting each payload to DynArray_T d beginning at index i.
-  Returns the next unused index in d after the insertion(s).
-  Ensures files are placed before directories.
+  Makes the next step of psLookup, which is not done: a step of its
+  search, or, once that has ended, the descent to the child found and
+  the start of the search below it.
 */
-static size_t FT_preOrderTraversal(Node_T n, DynArray_T d, size_t i) {
-   size_t c;
-   assert(d != NULL);
-   if(n != NULL) {
-      (void) DynArray_set(d, i, n);
-      i++;
-      /* goes through array and orders files first*/
-      for(c = 0; c < Node_getNumChildren(n); c++) {
-         int iStatus;
-         Node_T oNChild = NULL;
-         iStatus = Node_getChild(n,c, &oNChild);
-         assert(iStatus == SUCCESS);
-         if(Node_getType(oNChild))
-            i = FT_preOrderTraversal(oNChild, d, i);
+static void FT_stepLookup(struct lookup *psLookup) {
+   size_t ulChildID;
+   assert(psLookup != NULL);
+   assert(!psLookup->bDone);
+   if(Node_stepSearch(&psLookup->sSearch))
+      return;
+   if(!Node_endSearch(&psLookup->sSearch, &ulChildID) ||
+      Node_isPacked(psLookup->oNCurr)) {
+      psLookup->bDone = TRUE;
+      return;
+   }
+   (void) Node_getChild(psLookup->oNCurr, ulChildID, &psLookup->oNCurr);
+   psLookup->ulOffset =
+      Path_viewComponentEnd(&psLookup->sView, psLookup->ulOffset) + 1;
+   FT_startLookup(psLookup);
+}
+
+/*
+  Stats the ulPaths paths at apcPaths into asResults, as FT_statMany
+  does, with their walks interleaved: each round makes one step of
+  every lookup not yet done, so that the memory each step prefetches
+  for the next has the rest of the round to arrive in.
+*/
+static void FT_statGroup(const char *apcPaths[], size_t ulPaths,
+                         struct statResult asResults[]) {
+   struct lookup asLookups[FT_LOOKUP_GROUP];
+   struct lookup *psLookup;
+   struct statResult *psResult;
+   boolean bMoving;
+   size_t i;
+   assert(apcPaths != NULL);
+   assert(asResults != NULL);
+   assert(ulPaths <= FT_LOOKUP_GROUP);
+#ifdef __GNUC__
+   /* the paths themselves are read first, all at once */
+   for(i = 0; i < ulPaths; i++)
+      __builtin_prefetch(apcPaths[i]);
+#endif
+   for(i = 0; i < ulPaths; i++) {
+      psLookup = &asLookups[i];
+      psResult = &asResults[i];
+      psResult->bIsFile = FALSE;
+      psResult->ulSize = 0;
+      psLookup->bDone = TRUE;
+      psLookup->oNCurr = oNRoot;
+      assert(apcPaths[i] != NULL);
+      psResult->iStatus = Path_initView(&psLookup->sView, apcPaths[i],
+                                        strlen(apcPaths[i]));
+      if(psResult->iStatus != SUCCESS)
+         continue;
+      /* a frozen tree has a faster way of its own */
+      if(oZFrozen != NULL) {
+         psResult->iStatus = FT_statView(&psLookup->sView,
+                                         &psResult->bIsFile,
+                                         &psResult->ulSize);
+         continue;
       }
-      /* then goes through array and orders directories*/
-      for(c = 0; c < Node_getNumChildren(n); c++) {
-         int iStatus;
-         Node_T oNChild = NULL;
-         iStatus = Node_getChild(n,c, &oNChild);
-         assert(iStatus == SUCCESS);
-         if(!Node_getType(oNChild))
-            i = FT_preOrderTraversal(oNChild, d, i);
+      if(oNRoot == NULL) {
+         psResult->iStatus = NO_SUCH_PATH;
+         continue;
+      }
+      psResult->iStatus = FT_matchRoot(&psLookup->sView,
+                                       &psLookup->ulOffset);
+      if(psResult->iStatus != SUCCESS)
+         continue;
+      psLookup->bDone = FALSE;
+      FT_startLookup(psLookup);
+   }
+
+   do {
+      bMoving = FALSE;
+      for(i = 0; i < ulPaths; i++)
+         if(!asLookups[i].bDone) {
+            FT_stepLookup(&asLookups[i]);
+            bMoving = TRUE;
+         }
+   } while(bMoving);
+
+   for(i = 0; i < ulPaths; i++)
+      if(asResults[i].iStatus == SUCCESS && oZFrozen == NULL)
+         asResults[i].iStatus =
+            FT_statReached(&asLookups[i].sView, asLookups[i].ulOffset,
+                           asLookups[i].oNCurr, &asResults[i].bIsFile,
+                           &asResults[i].ulSize);
+}
+
+/* The most levels of the previous path that FT_statSorted keeps */
+enum { FT_SPINE_MAX = 64 };
+
+/*
+  Stats the ulPaths paths at apcPaths into asResults, as FT_statMany
+  does, in order: the nodes the walk of each path passes through are
+  kept as a spine, and the walk of the next starts from the deepest
+  of them on the prefix the two paths share, rather than the root.
+  Neither the FT nor the spine changes in between, so the nodes kept
+  stay valid.
+*/
+static void FT_statSorted(const char *apcPaths[], size_t ulPaths,
+                          struct statResult asResults[]) {
+   /* aoNSpine[i] is the node that the first i+1 components of the
+      previous path lead to, and aulEnds[i] the offset just past that
+      component; ulReached of them are filled in */
+   Node_T aoNSpine[FT_SPINE_MAX];
+   size_t aulEnds[FT_SPINE_MAX];
+   size_t ulReached = 0;
+   PathView sPrev;
+   PathView sView;
+   Node_T oNCurr;
+   struct statResult *psResult;
+   size_t ulLevel;
+   size_t ulOffset;
+   size_t ulEnd;
+   size_t ulChildID;
+   size_t i;
+   assert(apcPaths != NULL || ulPaths == 0);
+   assert(asResults != NULL || ulPaths == 0);
+
+   for(i = 0; i < ulPaths; i++) {
+      psResult = &asResults[i];
+      psResult->bIsFile = FALSE;
+      psResult->ulSize = 0;
+      assert(apcPaths[i] != NULL);
+      psResult->iStatus = Path_initView(&sView, apcPaths[i],
+                                        strlen(apcPaths[i]));
+      if(psResult->iStatus != SUCCESS)
+         continue;
+      /* a frozen tree has a faster way of its own */
+      if(oZFrozen != NULL || oNRoot == NULL) {
+         psResult->iStatus = FT_statView(&sView, &psResult->bIsFile,
+                                         &psResult->ulSize);
+         continue;
       }
+
+      /* back up to the deepest level kept that this path shares */
+      ulLevel = 0;
+      if(ulReached != 0) {
+         ulLevel = Path_getSharedViewDepth(&sPrev, &sView, &ulEnd);
+         if(ulLevel > ulReached)
+            ulLevel = ulReached;
+      }
+      if(ulLevel == 0) {
+         ulReached = 0;
+         psResult->iStatus = FT_matchRoot(&sView, &ulOffset);
+         if(psResult->iStatus != SUCCESS)
+            continue;
+         aoNSpine[0] = oNRoot;
+         aulEnds[0] = ulOffset - 1;
+         ulLevel = 1;
+      }
+      oNCurr = aoNSpine[ulLevel - 1];
+      ulOffset = aulEnds[ulLevel - 1] + 1;
+
+      /* descend from there as FT_descend does, extending the spine */
+      while(ulOffset < sView.ulLength && !Node_isPacked(oNCurr)) {
+         ulEnd = Path_viewComponentEnd(&sView, ulOffset);
+         if(!Node_hasChildName(oNCurr, sView.pcPath + ulOffset,
+                               ulEnd - ulOffset, &ulChildID))
+            break;
+         (void) Node_getChild(oNCurr, ulChildID, &oNCurr);
+         if(ulLevel < FT_SPINE_MAX) {
+            aoNSpine[ulLevel] = oNCurr;
+            aulEnds[ulLevel] = ulEnd;
+         }
+         ulLevel++;
+         ulOffset = ulEnd + 1;
+      }
+      ulReached = ulLevel < FT_SPINE_MAX ? ulLevel : FT_SPINE_MAX;
+      sPrev = sView;
+      psResult->iStatus = FT_statReached(&sView, ulOffset, oNCurr,
+                                         &psResult->bIsFile,
+                                         &psResult->ulSize);
+   }
+}
+
+/* see ft.h for specification*/
+int FT_statMany(const char *apcPaths[], size_t ulPaths,
+                enum pathOrder eOrder, struct statResult asResults[]) {
+   size_t ulFirst;
+   assert(apcPaths != NULL || ulPaths == 0);
+   assert(asResults != NULL || ulPaths == 0);
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   if(eOrder == FT_PATHS_SORTED) {
+      FT_statSorted(apcPaths, ulPaths, asResults);
+      return SUCCESS;
+   }
+   for(ulFirst = 0; ulFirst < ulPaths; ulFirst += FT_LOOKUP_GROUP)
+      FT_statGroup(apcPaths + ulFirst,
+                   ulPaths - ulFirst < FT_LOOKUP_GROUP ?
+                   ulPaths - ulFirst : FT_LOOKUP_GROUP,
+                   asResults + ulFirst);
+   return SUCCESS;
+}
+
+/*
+  Adds the sizes of the contents of the files in the hierarchy rooted
+  at oNNode to *pulLogical, and the bytes the FT stores for them to
+  *pulPhysical, counting each block of contents not yet visited in the
+  current pass once.
+*/
+static void FT_accumulateStorage(Node_T oNNode, size_t *pulLogical,
+                                 size_t *pulPhysical) {
+   size_t ulChild;
+   Node_T oNChild = NULL;
+   assert(oNNode != NULL);
+   if(Node_getType(oNNode)) {
+      *pulLogical += Node_getSizeContents(oNNode);
+      *pulPhysical += Node_countStored(oNNode, ulStoragePasses);
+      return;
+   }
+   /* packed files borrow their contents, so the FT stores none */
+   if(Node_isPacked(oNNode)) {
+      for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++)
+         *pulLogical += Node_getPackedSize(oNNode, ulChild);
+      return;
+   }
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++) {
+      (void) Node_getChild(oNNode, ulChild, &oNChild);
+      FT_accumulateStorage(oNChild, pulLogical, pulPhysical);
+   }
+}
+
+/* see ft.h for specification*/
+int FT_statStorage(const char *pcPath, size_t *pulLogical,
+                   size_t *pulPhysical) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   assert(pcPath != NULL);
+   assert(pulLogical != NULL);
+   assert(pulPhysical != NULL);
+
+   iStatus = FT_findNode(pcPath, strlen(pcPath), FALSE, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   *pulLogical = 0;
+   *pulPhysical = 0;
+   ulStoragePasses++;
+   FT_accumulateStorage(oNFound, pulLogical, pulPhysical);
+   return SUCCESS;
+}
+
+/* see ft.h for specification*/
+int FT_readAt(const char *pcPath, size_t ulOffset, void *pvBuf,
+              size_t ulLength, size_t *pulRead) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   assert(pcPath != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+   assert(pulRead != NULL);
+   iStatus = FT_findNode(pcPath, strlen(pcPath), FALSE, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!Node_getType(oNFound))
+      return NOT_A_FILE;
+   *pulRead = Node_readAt(oNFound, ulOffset, pvBuf, ulLength);
+   return SUCCESS;
+}
+
+/*
+  Finds the file with absolute path pcPath so that its owned contents
+  can be changed: materializes and unshares its ancestors, so that the
+  change is seen at pcPath alone, and ensures that oSContents exists.
+  Sets *poNResult to the file and returns SUCCESS, or otherwise
+  returns the status described for FT_writeAt.
+*/
+static int FT_findOwnedFile(const char *pcPath, Node_T *poNResult) {
+   int iStatus;
+   assert(pcPath != NULL);
+   assert(poNResult != NULL);
+   if(FT_checkMutable() != SUCCESS ||
+      eContentMode == FT_CONTENTS_BORROWED)
+      return INITIALIZATION_ERROR;
+   iStatus = FT_findNode(pcPath, strlen(pcPath), TRUE, poNResult);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!Node_getType(*poNResult))
+      return NOT_A_FILE;
+   iStatus = FT_unshareSpine(Node_getParent(*poNResult));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return FT_ensureStore();
+}
+
+/* see ft.h for specification*/
+int FT_writeAt(const char *pcPath, size_t ulOffset,
+               const void *pvBytes, size_t ulLength) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   assert(pvBytes != NULL || ulLength == 0);
+   iStatus = FT_findOwnedFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Node_writeAt(oNFound, ulOffset, pvBytes, ulLength,
+                          oSContents);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/* see ft.h for specification*/
+int FT_append(const char *pcPath, const void *pvBytes,
+              size_t ulLength) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   assert(pvBytes != NULL || ulLength == 0);
+   iStatus = FT_findOwnedFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Node_writeAt(oNFound, Node_getSizeContents(oNFound),
+                          pvBytes, ulLength, oSContents);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/* see ft.h for specification*/
+int FT_truncate(const char *pcPath, size_t ulLength) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   iStatus = FT_findOwnedFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Node_truncate(oNFound, ulLength, oSContents);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+/* --------------------------------------------------------------------
+  Directory handles let clients resolve relative paths from a
+  directory without re-descending from the root. A handle pins its
+  node, so that removing the directory leaves the handle stale rather
+  than dangling.
+*/
+struct dirHandle {
+   /* the directory this handle was opened on */
+   Node_T oNDir;
+};
+
+/*
+  Resolves the relative path pcRelPath from the directory of oHDir,
+  materializing lazy copies on the way if bMaterialize is TRUE (see
+  FT_descend). On SUCCESS, initializes *psView to view pcRelPath,
+  sets *poNFurthest to the furthest node reached and *pulOffset to
+  the offset in *psView of the first component below it, and returns
+  whether that node is pcRelPath itself in *pbFound. Otherwise
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if oHDir's directory has been removed
+  * BAD_PATH if pcRelPath does not represent a well-formatted path
+  * MEMORY_ERROR if a materialization fails
+*/
+static int FT_resolveAt(DirHandle_T oHDir, const char *pcRelPath,
+                        boolean bMaterialize, PathView *psView,
+                        Node_T *poNFurthest, size_t *pulOffset,
+                        boolean *pbFound) {
+   int iStatus;
+   assert(oHDir != NULL);
+   assert(pcRelPath != NULL);
+   assert(psView != NULL);
+   assert(poNFurthest != NULL);
+   assert(pulOffset != NULL);
+   assert(pbFound != NULL);
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   if(Node_isRemoved(oHDir->oNDir))
+      return NO_SUCH_PATH;
+   iStatus = Path_initView(psView, pcRelPath, strlen(pcRelPath));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   *pulOffset = 0;
+   iStatus = FT_descend(oHDir->oNDir, psView, pulOffset, bMaterialize,
+                        poNFurthest);
+   *pbFound = (boolean) (*pulOffset > psView->ulLength);
+   return iStatus;
+}
+
+/*
+  Inserts a directory or file at pcRelPath relative to oHDir, as
+  FT_insertNode does; see FT_insertDirAt and FT_insertFileAt.
+*/
+static int FT_insertAt(DirHandle_T oHDir, const char *pcRelPath,
+                       boolean bIsFile, void *pvContents,
+                       size_t ulLength) {
+   int iStatus;
+   PathView oView;
+   Node_T oNCurr = NULL;
+   size_t ulOffset;
+   boolean bFound;
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   iStatus = FT_checkMutable();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_resolveAt(oHDir, pcRelPath, TRUE, &oView, &oNCurr,
+                          &ulOffset, &bFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_insertNode(&oView, ulOffset, oNCurr, bIsFile,
+                           pvContents, ulLength, NULL);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/* see ft.h for specification */
+int FT_openDir(const char *pcPath, DirHandle_T *poHResult) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   DirHandle_T oHNew;
+   assert(pcPath != NULL);
+   assert(poHResult != NULL);
+   *poHResult = NULL;
+   iStatus = FT_findNode(pcPath, strlen(pcPath), TRUE, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(Node_getType(oNFound))
+      return NOT_A_DIRECTORY;
+   oHNew = malloc(sizeof(struct dirHandle));
+   if(oHNew == NULL)
+      return MEMORY_ERROR;
+   oHNew->oNDir = oNFound;
+   Node_pin(oNFound);
+   *poHResult = oHNew;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+void FT_closeDir(DirHandle_T oHDir) {
+   if(oHDir == NULL)
+      return;
+   Node_unpin(oHDir->oNDir);
+   free(oHDir);
+}
+
+/* see ft.h for specification */
+int FT_insertDirAt(DirHandle_T oHDir, const char *pcRelPath) {
+   assert(oHDir != NULL);
+   assert(pcRelPath != NULL);
+   return FT_insertAt(oHDir, pcRelPath, FALSE, NULL, 0);
+}
+
+/* see ft.h for specification */
+int FT_insertFileAt(DirHandle_T oHDir, const char *pcRelPath,
+                    void *pvContents, size_t ulLength) {
+   assert(oHDir != NULL);
+   assert(pcRelPath != NULL);
+   return FT_insertAt(oHDir, pcRelPath, TRUE, pvContents, ulLength);
+}
+
+/* see ft.h for specification */
+int FT_statAt(DirHandle_T oHDir, const char *pcRelPath,
+              boolean *pbIsFile, size_t *pulSize) {
+   int iStatus;
+   PathView oView;
+   Node_T oNFound = NULL;
+   size_t ulOffset;
+   boolean bFound;
+   assert(oHDir != NULL);
+   assert(pcRelPath != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+   iStatus = FT_resolveAt(oHDir, pcRelPath, FALSE, &oView,
+                          &oNFound, &ulOffset, &bFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return FT_statReached(&oView, ulOffset, oNFound, pbIsFile, pulSize);
+}
+
+/* see ft.h for specification */
+int FT_rmAt(DirHandle_T oHDir, const char *pcRelPath) {
+   int iStatus;
+   PathView oView;
+   Node_T oNFound = NULL;
+   size_t ulOffset;
+   boolean bFound;
+   assert(oHDir != NULL);
+   assert(pcRelPath != NULL);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   iStatus = FT_checkMutable();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_resolveAt(oHDir, pcRelPath, TRUE, &oView,
+                          &oNFound, &ulOffset, &bFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!bFound)
+      return NO_SUCH_PATH;
+   iStatus = FT_removeNode(oNFound);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
+/* see ft.h for specification */
+int FT_snapshot(Snapshot_T *poSResult) {
+   int iStatus;
+   assert(poSResult != NULL);
+   *poSResult = NULL;
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   if(oNRoot != NULL) {
+      iStatus = FT_unpackTree(oNRoot);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   return Snapshot_new(oNRoot, poSResult);
+}
+
+/* see ft.h for specification */
+void FT_freeSnapshot(Snapshot_T oSSnapshot) {
+   Snapshot_free(oSSnapshot);
+}
+
+/*
+  Returns TRUE if oSSnapshot holds a file (if bIsFile is TRUE) or a
+  directory (if bIsFile is FALSE) with absolute path pcPath, and FALSE
+  if not or if there is an error while checking.
+*/
+static boolean FT_snapshotContains(Snapshot_T oSSnapshot,
+                                   const char *pcPath, boolean bIsFile) {
+   PathView oView;
+   size_t ulNode;
+   assert(oSSnapshot != NULL);
+   assert(pcPath != NULL);
+   if(Path_initView(&oView, pcPath, strlen(pcPath)) != SUCCESS ||
+      Snapshot_find(oSSnapshot, &oView, &ulNode) != SUCCESS)
+      return FALSE;
+   return Snapshot_isFile(oSSnapshot, ulNode) == bIsFile;
+}
+
+/* see ft.h for specification */
+boolean FT_snapshotContainsDir(Snapshot_T oSSnapshot,
+                               const char *pcPath) {
+   return FT_snapshotContains(oSSnapshot, pcPath, FALSE);
+}
+
+/* see ft.h for specification */
+boolean FT_snapshotContainsFile(Snapshot_T oSSnapshot,
+                                const char *pcPath) {
+   return FT_snapshotContains(oSSnapshot, pcPath, TRUE);
+}
+
+/* see ft.h for specification */
+int FT_snapshotStat(Snapshot_T oSSnapshot, const char *pcPath,
+                    boolean *pbIsFile, size_t *pulSize) {
+   int iStatus;
+   PathView oView;
+   size_t ulNode;
+   assert(oSSnapshot != NULL);
+   assert(pcPath != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+   iStatus = Path_initView(&oView, pcPath, strlen(pcPath));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Snapshot_find(oSSnapshot, &oView, &ulNode);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(Snapshot_isFile(oSSnapshot, ulNode)) {
+      *pbIsFile = TRUE;
+      *pulSize = Snapshot_getFileSize(oSSnapshot, ulNode);
    }
-   return i;
+   else
+      *pbIsFile = FALSE;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+char *FT_snapshotToString(Snapshot_T oSSnapshot) {
+   assert(oSSnapshot != NULL);
+   return Snapshot_toString(oSSnapshot);
 }
+
+/* see ft.h for specification */
+void FT_getSnapshotStats(Snapshot_T oSSnapshot,
+                         struct snapshotStats *psStats) {
+   assert(oSSnapshot != NULL);
+   assert(psStats != NULL);
+   Snapshot_getStats(oSSnapshot, psStats);
+}
+/* --------------------------------------------------------------------
+  The following auxiliary functions are used for generating the
+  string representation of the FT.
+*/
 /*
-  Alternate version of strlen that uses pulAcc as an in-out parameter
-  to accumulate a string length, rather than returning the length of
-  oNNode's path, and also always adds one addition byte to the sum.
+  Adds to *pulAcc the length of the lines of the string representation
+  for the tree rooted at n, whose parent's path has length ulPrefix
+  (0 for the root). Each node's path is written on its own line, and
+  is measured from the names along the way rather than from n's
+  parent links, since n may be presented by a lazy copy elsewhere.
 */
-static void FT_strlenAccumulate(Node_T oNNode, size_t *pulAcc) {
+static void FT_strlenAccumulate(Node_T n, size_t ulPrefix,
+                                size_t *pulAcc) {
+   size_t ulNameLength;
+   size_t c;
+   assert(n != NULL);
    assert(pulAcc != NULL);
-   if(oNNode != NULL)
-      *pulAcc += (Path_getStrLength(Node_getPath(oNNode)) + 1);
+   (void) Node_getName(n, &ulNameLength);
+   /* the parent's path and a '/', or nothing for the root */
+   if(ulPrefix != 0)
+      ulPrefix++;
+   ulPrefix += ulNameLength;
+   *pulAcc += ulPrefix + 1;
+   if(Node_isPacked(n)) {
+      for(c = 0; c < Node_getNumChildren(n); c++) {
+         (void) Node_getPackedName(n, c, &ulNameLength);
+         *pulAcc += ulPrefix + 1 + ulNameLength + 1;
+      }
+      return;
+   }
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      Node_T oNChild = NULL;
+      (void) Node_getChild(n, c, &oNChild);
+      FT_strlenAccumulate(oNChild, ulPrefix, pulAcc);
+   }
 }
 /*
-  Alternate version of strcat that inverts the typical argument
-  order, appending oNNode's path onto pcAcc, and also always adds one
-  newline at the end of the concatenated string.
+  Writes the string representation for the tree rooted at n to pcAcc
+  in pre-order, files before directories, where the ulPrefix
+  characters at pcPrefix are its parent's path (0 for the root), and
+  returns the end of what was written. Each line's path is reused as
+  the prefix of its children's lines.
 */
-static void FT_strcatAccumulate(Node_T oNNode, char *pcAcc) {
+static char *FT_strcatAccumulate(Node_T n, const char *pcPrefix,
+                                 size_t ulPrefix, char *pcAcc) {
+   const char *pcName;
+   const char *pcPath = pcAcc;
+   size_t ulNameLength;
+   size_t ulPath;
+   size_t c;
+   boolean bFiles;
+   assert(n != NULL);
    assert(pcAcc != NULL);
-   if(oNNode != NULL) {
-      strcat(pcAcc, Path_getPathname(Node_getPath(oNNode)));
-      strcat(pcAcc, "\n");
+   pcName = Node_getName(n, &ulNameLength);
+   if(ulPrefix != 0) {
+      memcpy(pcAcc, pcPrefix, ulPrefix);
+      pcAcc += ulPrefix;
+      *pcAcc++ = '/';
+   }
+   memcpy(pcAcc, pcName, ulNameLength);
+   pcAcc += ulNameLength;
+   ulPath = (size_t) (pcAcc - pcPath);
+   *pcAcc++ = '\n';
+   /* packed children are all files, already in order */
+   if(Node_isPacked(n)) {
+      for(c = 0; c < Node_getNumChildren(n); c++) {
+         pcName = Node_getPackedName(n, c, &ulNameLength);
+         memcpy(pcAcc, pcPath, ulPath);
+         pcAcc += ulPath;
+         *pcAcc++ = '/';
+         memcpy(pcAcc, pcName, ulNameLength);
+         pcAcc += ulNameLength;
+         *pcAcc++ = '\n';
+      }
+      return pcAcc;
    }
+   /* goes through children twice: files first, then directories */
+   for(bFiles = TRUE; ; bFiles = FALSE) {
+      for(c = 0; c < Node_getNumChildren(n); c++) {
+         Node_T oNChild = NULL;
+         if(Node_isChildFile(n, c) != bFiles)
+            continue;
+         (void) Node_getChild(n, c, &oNChild);
+         pcAcc = FT_strcatAccumulate(oNChild, pcPath, ulPath, pcAcc);
+      }
+      if(!bFiles)
+         break;
+   }
+   return pcAcc;
 }
 /*--------------------------------------------------------------------*/
 char *FT_toString(void) {
-   DynArray_T nodes;
-
    size_t totalStrlen = 1;
    char *result = NULL;
+   char *end;
    if(!bIsInitialized)
       return NULL;
-   nodes = DynArray_new(ulCount);
+   if(oZFrozen != NULL)
+      return Frozen_toString(oZFrozen);
 
-   (void) FT_preOrderTraversal(oNRoot, nodes, 0);
-
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strlenAccumulate,
-                (void*) &totalStrlen);
+   if(oNRoot != NULL)
+      FT_strlenAccumulate(oNRoot, 0, &totalStrlen);
    result = malloc(totalStrlen);
-   if(result == NULL) {
-      DynArray_free(nodes);
+   if(result == NULL)
       return NULL;
-   }
-   *result = '\0';
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strcatAccumulate,
-                (void *) result);
-   DynArray_free(nodes);
+   end = result;
+   if(oNRoot != NULL)
+      end = FT_strcatAccumulate(oNRoot, NULL, 0, result);
+   *end = '\0';
    return result;
 }
\ No newline at end of file
@@ -58,10 +58,36 @@ int FT_rmDir(const char *pcPath);
    * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file
    * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
    * MEMORY_ERROR if memory could not be allocated to complete request
+   In the owning modes (see FT_setContentMode), pvContents may be NULL
+   with ulLength non-zero: the file then holds ulLength zeros, as a
+   hole that takes no storage until written with FT_writeAt.
 */
 int FT_insertFile(const char *pcPath, void *pvContents,
                   size_t ulLength);
 
+/*
+  Inserts a new file into the FT with absolute path pcPath, as
+  FT_insertFile does, whose contents are the ulLength bytes at offset
+  ulOffset of the file open on iFd. In the owning modes only, the
+  bytes are mapped into memory rather than read and copied, so they
+  never pass through a client buffer; pages are loaded only as they
+  are read. iFd may be a regular file, or a memfd (see memfd_create)
+  holding anonymous contents; if it cannot be mapped, as for a pipe,
+  the bytes are read into the FT's storage instead (consuming them,
+  and the ulOffset bytes before them, from a pipe). The mapping is
+  released when the file is removed or its contents replaced, or the
+  FT is destroyed, and the underlying file must not be changed until
+  then, but iFd may be closed at once. Changing the file with
+  FT_writeAt and the like copies its contents. Nothing is mapped or
+  read unless the file can be inserted at pcPath.
+  Returns SUCCESS, or the statuses described for FT_insertFile, or:
+  * INITIALIZATION_ERROR if the FT is in FT_CONTENTS_BORROWED mode
+  * MEMORY_ERROR if the bytes could not be mapped or read, including
+                 if iFd's file is shorter than ulOffset + ulLength
+*/
+int FT_insertFileFromFd(const char *pcPath, int iFd, size_t ulOffset,
+                        size_t ulLength);
+
 /*
   Returns TRUE if the FT contains a file with absolute path
   pcPath and FALSE if not or if there is an error while checking.
@@ -81,6 +107,50 @@ boolean FT_containsFile(const char *pcPath);
 */
 int FT_rmFile(const char *pcPath);
 
+/*
+  Moves the file or directory hierarchy at absolute path pcFrom to
+  absolute path pcTo, whose parent directory must already exist. The
+  root can be renamed to another single-component path. Only the moved
+  node is relinked, so the cost depends on the depths of the two paths
+  and not on the size of the hierarchy; open directory handles within
+  it follow it to its new location.
+  Returns SUCCESS if moved. Otherwise, leaves the FT unchanged and
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcFrom or pcTo does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcFrom
+                     or pcTo, if exactly one of pcFrom and pcTo has
+                     depth 1, or if pcTo is inside pcFrom
+  * NO_SUCH_PATH if pcFrom, or pcTo's parent, does not exist in the FT
+  * NOT_A_DIRECTORY if a proper prefix of pcTo exists as a file
+  * ALREADY_IN_TREE if pcTo already exists in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rename(const char *pcFrom, const char *pcTo);
+
+/*
+  Copies the file or directory hierarchy at absolute path pcSrc to the
+  new absolute path pcDst, whose parent directory must already exist.
+  File copies have the same contents pointers as their originals (in
+  the owning modes, until either is replaced, for contents over 64
+  bytes). A directory copy shares the source hierarchy until either
+  side is changed, and nodes are then copied one level at a time along
+  the path being changed, so the copy itself costs O(depth) and memory
+  grows only as the two hierarchies diverge.
+  Returns SUCCESS if copied. Otherwise, leaves the FT unchanged and
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcSrc or pcDst does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcSrc
+                     or pcDst, if pcDst has depth 1, or if pcDst is
+                     inside pcSrc
+  * NO_SUCH_PATH if pcSrc, or pcDst's parent, does not exist in the FT
+  * NOT_A_DIRECTORY if a proper prefix of pcDst exists as a file
+  * ALREADY_IN_TREE if pcDst already exists in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_copyTree(const char *pcSrc, const char *pcDst);
+
 /*
   Returns the contents of the file with absolute path pcPath.
   Returns NULL if unable to complete the request for any reason.
@@ -95,6 +165,8 @@ void *FT_getFileContents(const char *pcPath);
   the parameter pvNewContents of size ulNewLength bytes.
   Returns the old contents if successful. (Note: contents may be NULL.)
   Returns NULL if unable to complete the request for any reason.
+  In the owning modes the old contents are released instead, and
+  the FT's copy of the new contents is returned if successful.
 */
 void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
                              size_t ulNewLength);
@@ -117,6 +189,324 @@ void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
 */
 int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize);
 
+/* The ways in which the FT can store file contents */
+enum contentMode {
+   /* the FT stores only the clients' pointers to the contents, and
+      clients must keep the contents alive; this is the default */
+   FT_CONTENTS_BORROWED,
+   /* the FT stores its own copies of the contents, inline in the file
+      node if they are at most 64 bytes and in an arena otherwise, and
+      releases them when the file is removed or replaced or the FT is
+      destroyed; clients may reuse their buffers at once, and
+      FT_getFileContents returns the FT's copy (NULL if empty), which
+      clients must not modify */
+   FT_CONTENTS_OWNED,
+   /* as FT_CONTENTS_OWNED, except that contents over 64 bytes are
+      hashed, and all files with identical contents share one copy */
+   FT_CONTENTS_DEDUP
+};
+
+/*
+  Chooses how file contents are stored from the next FT_init on, and
+  for every FT after it until this is called again. Returns
+  INITIALIZATION_ERROR (leaving the mode unchanged) if the FT is
+  already initialized, and SUCCESS otherwise.
+*/
+int FT_setContentMode(enum contentMode eMode);
+
+/* What FT_importDirectory records of each file */
+enum importMode {
+   /* only its size: in the owning modes, the file holds a hole of
+      that many zeros, and in FT_CONTENTS_BORROWED mode NULL contents
+      of that size */
+   FT_IMPORT_METADATA,
+   /* its contents too, copied as FT_insertFile copies them (owning
+      modes only) */
+   FT_IMPORT_CONTENTS
+};
+
+/*
+  Inserts a new directory into the FT with absolute path pcPath, as
+  FT_insertDir does, holding a copy of the directory hierarchy on
+  disk rooted at directory pcFsRoot, as eMode describes. Only
+  directories and regular files are copied: symbolic links are not
+  followed, and other kinds of file are left out.
+  The disk is scanned by ulThreads threads (one per processor, if
+  ulThreads is 0), each filling a local copy of the directories it
+  scans, and a thread with no directories left to scan takes some from
+  another thread. Only once the whole hierarchy has been scanned is it
+  added to the FT, one directory at a time, with no further system
+  calls or path lookups; the FT must not be used by other threads
+  meanwhile.
+  Returns SUCCESS, or otherwise leaves the FT unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state, or
+                         eMode is FT_IMPORT_CONTENTS in
+                         FT_CONTENTS_BORROWED mode
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+  * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file, or
+                    pcFsRoot is not a directory
+  * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
+  * NO_SUCH_PATH if pcFsRoot does not exist
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 or a directory or file below pcFsRoot could not be
+                 read
+*/
+int FT_importDirectory(const char *pcFsRoot, const char *pcPath,
+                       size_t ulThreads, enum importMode eMode);
+
+/* The time FT_exportDirectory took over each phase */
+struct exportTimes {
+   /* nanoseconds taken to list what to create */
+   unsigned long ulPlanNs;
+   /* nanoseconds taken to create the directories */
+   unsigned long ulDirsNs;
+   /* nanoseconds taken to write the files */
+   unsigned long ulFilesNs;
+};
+
+/*
+  Writes the FT directory hierarchy at absolute path pcPath out to
+  disk, as a new directory pcFsRoot holding a copy of everything below
+  pcPath. The hierarchy is first listed; then the directories are
+  created with ulThreads threads (one per processor, if ulThreads is
+  0), one depth at a time so that each exists before anything inside
+  it; then the files are written by the threads, each taking a batch
+  of files at a time (many small files, or a single large one), so
+  that most files cost one open, write and close and no locking.
+  Holes, and other runs of zeros, are left as holes on disk. If
+  psTimes is not NULL, the time spent in each phase is stored in it.
+  The FT must not be used by other threads meanwhile.
+  Returns SUCCESS, or otherwise returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path, or a
+             name below it is "." or ".."
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT, or
+                 the directory to contain pcFsRoot does not exist
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file, or a prefix of
+                    pcFsRoot is a file
+  * ALREADY_IN_TREE if pcFsRoot already exists
+  * MEMORY_ERROR if memory could not be allocated, or a directory or
+                 file could not be written, in which case whatever
+                 was written before the error is left on disk
+*/
+int FT_exportDirectory(const char *pcPath, const char *pcFsRoot,
+                       size_t ulThreads, struct exportTimes *psTimes);
+
+/*
+  Writes the whole FT to file descriptor iFd as a tar archive (see
+  tarFT.h), streaming it in pre-order, files before directories as in
+  FT_toString, through buffers of fixed size: each file's contents are
+  written straight from its node, or a piece at a time if they are in
+  chunks. An empty FT makes an empty archive.
+  Returns SUCCESS, or otherwise returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated, or the archive could
+                 not be written, in which case part of it may have been
+*/
+int FT_writeTar(int iFd);
+
+/*
+  Adds the directories and regular files of the tar archive read from
+  file descriptor iFd to the FT, with copies of their contents, as
+  FT_insertDir and FT_insertFile would; directories already in the FT
+  are kept. The archive is streamed through buffers of fixed size, and
+  each member is added beside the one before it, so that an archive
+  in pre-order (as FT_writeTar makes) is built without looking up any
+  path from the root. Larger files are stored a piece at a time, with
+  pieces of zeros left as holes.
+  Returns SUCCESS, or otherwise leaves the FT unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state, or
+                         is in FT_CONTENTS_BORROWED mode
+  * BAD_PATH if the archive is malformed, or a member's path does not
+             represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of a
+                     member's path, or a file would be the root
+  * NOT_A_DIRECTORY if a proper prefix of a member's path exists as a
+                    file
+  * ALREADY_IN_TREE if a file's path is already in the FT, or a
+                    directory's path is there as a file
+  * MEMORY_ERROR if memory could not be allocated, or the archive could
+                 not be read
+*/
+int FT_readTar(int iFd);
+
+/* How FT_freeze looks up paths in the frozen FT */
+enum freezeIndex {
+   /* by one binary search of a directory's children per component */
+   FT_FREEZE_LAYOUT,
+   /* as well, through a minimal perfect hash function of every full
+      path, built as the FT is frozen: a lookup reads one slot, whose
+      fingerprint of the path's hash tells most misses at once, and
+      then compares names up one chain of entries */
+   FT_FREEZE_HASHED
+};
+
+/* The sizes of the frozen form of the FT */
+struct freezeStats {
+   /* the number of directories and files */
+   size_t ulEntries;
+   /* bytes taken by the layout's entries and names */
+   size_t ulLayoutBytes;
+   /* bytes taken by the perfect hash function, and by the slots it
+      maps the paths to; 0 if there is no such index */
+   size_t ulHashBytes;
+   size_t ulSlotBytes;
+};
+
+/*
+  Freezes the FT for read-mostly use: lays it out once more, as one
+  array of entries in breadth-first order, with each directory's
+  children a contiguous range sorted by name, and every name in one
+  pool, indexed as eIndex asks. Until FT_thaw or FT_destroy, lookups
+  by path (FT_contains*, FT_stat, FT_getFileContents, FT_readAt and
+  the like) search that layout, and FT_toString walks it, rather than
+  following pointers from node to node; and every function that would
+  change the FT's hierarchy or contents changes nothing and returns
+  INITIALIZATION_ERROR (or NULL). If the FT is already frozen, it is
+  laid out again only if eIndex asks for an index it lacks. If psStats
+  is not NULL, the sizes of the frozen form are stored in it.
+  Returns SUCCESS, or otherwise returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated, in which case the
+                 FT is as it was
+*/
+int FT_freeze(enum freezeIndex eIndex, struct freezeStats *psStats);
+
+/*
+  Thaws a frozen FT, making it changeable again; the hierarchy is kept
+  throughout, so this only frees the frozen layout. Does nothing if
+  the FT is not frozen. Returns SUCCESS, or INITIALIZATION_ERROR if
+  the FT is not in an initialized state.
+*/
+int FT_thaw(void);
+
+/*
+  What the filter of paths has done since FT_init. FT_containsDir and
+  FT_containsFile ask a counting Bloom filter of every path in the FT
+  before looking a path up, so that most missing paths are answered
+  without a traversal. The filter is kept up to date as paths are
+  inserted and removed, and rebuilt as it fills up or after
+  FT_readTar; FT_rename and FT_copyTree drop it instead, and it is
+  rebuilt once as many lookups as there are nodes have gone without
+  it.
+*/
+struct filterStats {
+   /* lookups answered by the filter alone, as surely missing */
+   unsigned long ulAvoided;
+   /* lookups the filter let through */
+   unsigned long ulPassed;
+   /* of those, lookups of missing paths: the filter's false
+      positives */
+   unsigned long ulFalsePositives;
+   /* lookups made while the filter was dropped */
+   unsigned long ulBypassed;
+   /* the number of times the filter was built */
+   unsigned long ulBuilds;
+};
+
+/* Stores in *psStats what the filter of paths has done since FT_init. */
+void FT_getFilterStats(struct filterStats *psStats);
+
+/*
+  Sets how cold a directory must be for the FT to pack it: once
+  ulColdAfter changes have been made to directories' children since
+  its own last changed, a directory of at least 8 children, all of
+  them files with borrowed contents (see FT_setContentMode), gives up
+  their nodes for one front-coded block of their names, contents
+  pointers and sizes. FT_containsDir, FT_containsFile, FT_stat and
+  FT_toString answer from the block; anything else that reaches one
+  of its files, or adds to the directory, unpacks it first. 0, the
+  default, stops packing, leaving packed directories packed until
+  they are next unpacked. Persists across FT_destroy and FT_init.
+  Unless 0, the FT is swept for cold directories at once, if it is
+  initialized and not frozen, and then again each time it has
+  changed half as many times as it has nodes.
+*/
+void FT_setPacking(size_t ulColdAfter);
+
+/* What packing has saved and done */
+struct packStats {
+   /* the packed directories, and the files in them */
+   size_t ulDirs;
+   size_t ulFiles;
+   /* the bytes their packs take, and the bytes the files would take
+      as nodes with their names */
+   size_t ulBytes;
+   size_t ulNodeBytes;
+   /* the directories packed, and unpacked, since FT_init */
+   unsigned long ulPacked;
+   unsigned long ulUnpacked;
+};
+
+/* Stores in *psStats how much packing saves now and what it has done
+   since FT_init. */
+void FT_getPackStats(struct packStats *psStats);
+
+/*
+  Copies up to ulLength bytes of the contents of the file with
+  absolute path pcPath, starting at offset ulOffset, to pvBuf, and
+  sets *pulRead to the number of bytes copied, which is less than
+  ulLength only if the contents end first. Returns SUCCESS, or
+  otherwise leaves *pulRead unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+*/
+int FT_readAt(const char *pcPath, size_t ulOffset, void *pvBuf,
+              size_t ulLength, size_t *pulRead);
+
+/*
+  The following functions change the contents of the file with
+  absolute path pcPath in place, in the owning modes. Contents over 64
+  bytes are split into chunks of 4096 bytes when first changed, after
+  which each change costs in proportion to the chunks it touches, not
+  to the size of the file; FT_getFileContents gathers them up again.
+
+  FT_writeAt writes the ulLength bytes at pvBytes at offset ulOffset,
+  extending the contents if necessary, with zeros between their old
+  end and ulOffset. FT_append writes them at the end of the contents.
+  FT_truncate shortens or extends (with zeros) the contents to
+  ulLength bytes. Chunks of zeros added by extending, or never
+  written, are holes: FT_readAt returns zeros for them, and they take
+  no storage, so that a large, mostly empty file takes storage in
+  proportion to the data written to it (but FT_getFileContents
+  gathers up all of its bytes, holes included). Each returns SUCCESS,
+  or otherwise leaves the contents unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state, or
+                         is in FT_CONTENTS_BORROWED mode
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_writeAt(const char *pcPath, size_t ulOffset,
+               const void *pvBytes, size_t ulLength);
+int FT_append(const char *pcPath, const void *pvBytes,
+              size_t ulLength);
+int FT_truncate(const char *pcPath, size_t ulLength);
+
+/*
+  Reports how much storage the files at or below absolute path pcPath
+  use: sets *pulLogical to the total size of their contents, and
+  *pulPhysical to the number of bytes of contents the FT stores for
+  them, in which contents shared between files (copies, or identical
+  files in FT_CONTENTS_DEDUP mode) are counted once. *pulPhysical is 0
+  in FT_CONTENTS_BORROWED mode, where the FT stores no contents.
+  Returns SUCCESS, or otherwise leaves *pulLogical and *pulPhysical
+  unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+*/
+int FT_statStorage(const char *pcPath, size_t *pulLogical,
+                   size_t *pulPhysical);
+
 /*
   Sets the FT data structure to an initialized state.
   The data structure is initially empty.
@@ -147,4 +537,168 @@ int FT_destroy(void);
 */
 char *FT_toString(void);
 
+/*
+  The following functions behave exactly like their counterparts
+  above, except that the absolute path is given as the ulPathLength
+  characters at pcPath, which need not be '\0'-terminated. This lets
+  clients pass slices of a larger buffer without copying them. Those
+  characters must not include a '\0': such a path is a BAD_PATH.
+*/
+int FT_insertDirN(const char *pcPath, size_t ulPathLength);
+boolean FT_containsDirN(const char *pcPath, size_t ulPathLength);
+int FT_rmDirN(const char *pcPath, size_t ulPathLength);
+int FT_insertFileN(const char *pcPath, size_t ulPathLength,
+                   void *pvContents, size_t ulLength);
+boolean FT_containsFileN(const char *pcPath, size_t ulPathLength);
+int FT_rmFileN(const char *pcPath, size_t ulPathLength);
+void *FT_getFileContentsN(const char *pcPath, size_t ulPathLength);
+void *FT_replaceFileContentsN(const char *pcPath, size_t ulPathLength,
+                              void *pvNewContents, size_t ulNewLength);
+int FT_statN(const char *pcPath, size_t ulPathLength,
+             boolean *pbIsFile, size_t *pulSize);
+
+/* How the paths given to FT_statMany are ordered */
+enum pathOrder {
+   /* in any order */
+   FT_PATHS_UNSORTED,
+   /* so that paths sharing a prefix tend to be next to each other,
+      as when sorted; results are the same in any order, but only
+      this order makes them faster to find */
+   FT_PATHS_SORTED
+};
+
+/* What FT_statMany found for one path */
+struct statResult {
+   /* what FT_stat would return for the path */
+   int iStatus;
+   /* when iStatus is SUCCESS, whether the path is a file, and if so
+      the size of its contents; otherwise FALSE and 0 */
+   boolean bIsFile;
+   size_t ulSize;
+};
+
+/*
+  Stats each of the ulPaths absolute paths in apcPaths as FT_stat
+  would, storing what it found for apcPaths[i] in asResults[i].
+  With eOrder FT_PATHS_UNSORTED, up to 32 lookups at a time have
+  their walks down the hierarchy interleaved a step at a time, each
+  step prefetching the memory the next reads, so that one lookup's
+  wait for memory is spent on the others. On a hierarchy too large
+  for the caches this takes less time than as many calls of FT_stat;
+  on one that fits, the interleaving costs more than it saves.
+  With eOrder FT_PATHS_SORTED, each lookup instead starts from the
+  deepest directory its path shares with the previous path, which
+  was kept from that path's walk, so that a run of paths in one
+  directory costs one walk down to it and a search of it per path.
+  Returns SUCCESS, or INITIALIZATION_ERROR (storing nothing) if the
+  FT is not in an initialized state.
+*/
+int FT_statMany(const char *apcPaths[], size_t ulPaths,
+                enum pathOrder eOrder, struct statResult asResults[]);
+
+/*
+  A DirHandle_T refers to a directory in the FT, from which relative
+  paths can be resolved at a cost that depends only on their own
+  depth. A handle whose directory is removed (including by FT_destroy)
+  becomes stale: every function below except FT_closeDir then returns
+  NO_SUCH_PATH for it.
+*/
+typedef struct dirHandle *DirHandle_T;
+
+/*
+  Opens a handle on the directory with absolute path pcPath, storing
+  it in *poHResult. Returns SUCCESS if the handle is opened, or
+  otherwise sets *poHResult to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  The client owns the handle and must release it with FT_closeDir.
+*/
+int FT_openDir(const char *pcPath, DirHandle_T *poHResult);
+
+/* Releases oHDir, which may be stale. Does nothing if oHDir is NULL. */
+void FT_closeDir(DirHandle_T oHDir);
+
+/*
+  The following functions behave like FT_insertDir, FT_insertFile and
+  FT_stat, except that pcRelPath is a path relative to the directory
+  of oHDir, and that they return NO_SUCH_PATH if oHDir is stale.
+*/
+int FT_insertDirAt(DirHandle_T oHDir, const char *pcRelPath);
+int FT_insertFileAt(DirHandle_T oHDir, const char *pcRelPath,
+                    void *pvContents, size_t ulLength);
+int FT_statAt(DirHandle_T oHDir, const char *pcRelPath,
+              boolean *pbIsFile, size_t *pulSize);
+
+/*
+  Removes the file or directory hierarchy at pcRelPath relative to the
+  directory of oHDir. Handles opened on removed directories become
+  stale. Returns SUCCESS if found and removed. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcRelPath does not represent a well-formatted path
+  * NO_SUCH_PATH if pcRelPath does not exist below oHDir's directory,
+                 or oHDir is stale
+*/
+int FT_rmAt(DirHandle_T oHDir, const char *pcRelPath);
+
+/*
+  A Snapshot_T is a read-only copy of the FT's hierarchy as it was
+  when taken, in a succinct form for keeping many of them around: the
+  shape takes about two bits per node (each directory's children
+  counted in unary, in breadth-first order), each node one more bit
+  for whether it is a file, and the names are front-coded, most kept
+  as the length of the prefix they share with their previous sibling
+  and the rest. Files' sizes are kept, but not their contents. A
+  snapshot does not depend on the FT once taken: the FT may change or
+  be destroyed, and the snapshot stays as it was.
+*/
+typedef struct snapshot *Snapshot_T;
+
+/* The sizes of a snapshot */
+struct snapshotStats {
+   /* the number of directories and files */
+   size_t ulNodes;
+   /* bytes taken by the shape and the file bits, with their indexes */
+   size_t ulShapeBytes;
+   /* bytes taken by the front-coded names, with their offsets */
+   size_t ulNameBytes;
+   /* bytes taken by the files' sizes, with their offsets */
+   size_t ulSizeBytes;
+};
+
+/*
+  Takes a snapshot of the FT, storing it in *poSResult. Returns
+  SUCCESS, or otherwise sets *poSResult to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  The client owns the snapshot and must release it with
+  FT_freeSnapshot.
+*/
+int FT_snapshot(Snapshot_T *poSResult);
+
+/* Releases oSSnapshot. Does nothing if oSSnapshot is NULL. */
+void FT_freeSnapshot(Snapshot_T oSSnapshot);
+
+/*
+  The following functions behave like FT_containsDir,
+  FT_containsFile, FT_stat and FT_toString, on the hierarchy of
+  oSSnapshot rather than the FT's; they do not need the FT to be
+  initialized. FT_snapshotStat may also return MEMORY_ERROR if it
+  cannot allocate space to decode a long name.
+*/
+boolean FT_snapshotContainsDir(Snapshot_T oSSnapshot,
+                               const char *pcPath);
+boolean FT_snapshotContainsFile(Snapshot_T oSSnapshot,
+                                const char *pcPath);
+int FT_snapshotStat(Snapshot_T oSSnapshot, const char *pcPath,
+                    boolean *pbIsFile, size_t *pulSize);
+char *FT_snapshotToString(Snapshot_T oSSnapshot);
+
+/* Stores the sizes of oSSnapshot's parts in *psStats. */
+void FT_getSnapshotStats(Snapshot_T oSSnapshot,
+                         struct snapshotStats *psStats);
+
 #endif
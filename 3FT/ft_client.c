@@ -8,6 +8,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "ft.h"
 
 /* Tests the FT implementation with an assortment of checks.
@@ -16,9 +19,23 @@
 int main(void) {
   enum {ARRLEN = 1000};
   char* temp;
+  char* temp2;
   boolean bIsFile;
-  size_t l;
+  size_t l, ulPhysical, i;
+  int iFd;
+  int aiPipe[2];
   char arr[ARRLEN];
+  char buf[ARRLEN];
+  DirHandle_T oHDir, oHSub;
+  struct exportTimes sTimes;
+  struct freezeStats sFreeze;
+  struct filterStats sFilter;
+  Snapshot_T oSSnap;
+  struct snapshotStats sSnap;
+  struct packStats sPack;
+  struct statResult asStats[48];
+  const char *apcStats[48];
+  struct stat sStat;
   arr[0] = '\0';
 
   /* Before the data structure is initialized:
@@ -235,11 +252,893 @@ int main(void) {
   fprintf(stderr, "Checkpoint 4.5:\n%s\n", temp);
   free(temp);
 
+  /* length-delimited variants take paths that are slices of a larger
+     buffer, so nothing past the given length may be examined */
+  strcpy(arr, "1root/z/frameXYZ");
+  assert(FT_insertDirN(arr, strlen("1root/z")) == SUCCESS);
+  assert(FT_containsDir("1root/z") == TRUE);
+  assert(FT_containsDirN(arr, strlen("1root/z/frame")) == FALSE);
+  assert(FT_insertFileN(arr, strlen("1root/z/frame"), "data",
+                        strlen("data")+1) == SUCCESS);
+  assert(FT_containsFile("1root/z/frame") == TRUE);
+  assert(FT_containsFileN(arr, strlen("1root/z/frame")) == TRUE);
+  assert(FT_containsFileN(arr, strlen("1root/z/fram")) == FALSE);
+  assert(FT_insertDirN(arr, strlen("1root/")) == BAD_PATH);
+  assert(FT_insertDirN(arr, 0) == BAD_PATH);
+  /* a '\0' within the length is no part of any name */
+  assert(FT_insertDirN("1root/b\0c", 9) == BAD_PATH);
+  assert(FT_containsDirN("1root/z\0", 8) == FALSE);
+  assert(FT_statN("1root/z\0/frame", 14, &bIsFile, &l) == BAD_PATH);
+  assert(FT_statN(arr, strlen("1root/z/frame"), &bIsFile, &l) ==
+         SUCCESS);
+  assert(bIsFile == TRUE);
+  assert(l == strlen("data")+1);
+  assert(!strcmp(FT_getFileContentsN(arr, strlen("1root/z/frame")),
+                 "data"));
+  assert(!strcmp(FT_replaceFileContentsN(arr, strlen("1root/z/frame"),
+                                         "more", strlen("more")+1),
+                 "data"));
+  assert(FT_rmDirN(arr, strlen("1root/z/frame")) == NOT_A_DIRECTORY);
+  assert(FT_rmFileN(arr, strlen("1root/z/frame")) == SUCCESS);
+  assert(FT_rmDirN(arr, strlen("1root/z")) == SUCCESS);
+  assert(FT_containsDir("1root/z") == FALSE);
+
+  /* handles resolve relative paths from their directory, and become
+     stale once that directory is removed */
+  assert(FT_openDir("1root/y/CHILD1FILE", &oHDir) == NOT_A_DIRECTORY);
+  assert(oHDir == NULL);
+  assert(FT_openDir("1root/y/nope", &oHDir) == NO_SUCH_PATH);
+  assert(FT_openDir("1root/y", &oHDir) == SUCCESS);
+  assert(FT_insertDirAt(oHDir, "w/v") == SUCCESS);
+  assert(FT_containsDir("1root/y/w/v") == TRUE);
+  assert(FT_insertDirAt(oHDir, "w") == ALREADY_IN_TREE);
+  assert(FT_insertFileAt(oHDir, "w/v/f", "rel", strlen("rel")+1)
+         == SUCCESS);
+  assert(FT_containsFile("1root/y/w/v/f") == TRUE);
+  assert(FT_insertFileAt(oHDir, "w/v/f/g", NULL, 0)
+         == NOT_A_DIRECTORY);
+  assert(FT_insertDirAt(oHDir, "/w") == BAD_PATH);
+  assert(FT_statAt(oHDir, "w/v/f", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE);
+  assert(l == strlen("rel")+1);
+  assert(FT_statAt(oHDir, "CHILD2DIR", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == FALSE);
+  assert(FT_statAt(oHDir, "w/u", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_openDir("1root/y/w", &oHSub) == SUCCESS);
+  assert(FT_rmAt(oHSub, "v/f") == SUCCESS);
+  assert(FT_containsFile("1root/y/w/v/f") == FALSE);
+  assert(FT_rmAt(oHSub, "v/f") == NO_SUCH_PATH);
+  assert(FT_rmAt(oHDir, "w") == SUCCESS);
+  assert(FT_containsDir("1root/y/w") == FALSE);
+  assert(FT_statAt(oHSub, "v", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_insertDirAt(oHSub, "v") == NO_SUCH_PATH);
+  FT_closeDir(oHSub);
+  assert(FT_statAt(oHDir, "CHILD2DIR/CHILD4DIR", &bIsFile, &l)
+         == SUCCESS);
+
+  /* renames relink whole hierarchies, and handles follow them */
+  assert(FT_openDir("1root/y/CHILD2DIR", &oHSub) == SUCCESS);
+  assert(FT_rename("1root/y/CHILD2DIR", "1root/m") == SUCCESS);
+  assert(FT_containsDir("1root/y/CHILD2DIR") == FALSE);
+  assert(FT_containsDir("1root/m/CHILD4DIR") == TRUE);
+  assert(FT_statAt(oHSub, "CHILD4DIR", &bIsFile, &l) == SUCCESS);
+  assert(FT_statAt(oHDir, "CHILD2DIR", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_rename("1root/y/CHILD1FILE", "1root/m/moved") == SUCCESS);
+  assert(FT_containsFile("1root/m/moved") == TRUE);
+  assert(FT_containsFile("1root/y/CHILD1FILE") == FALSE);
+  assert(FT_rename("1root/y/CHILD3DIR", "1root/y/A") == SUCCESS);
+  assert(FT_rename("1root/y/A", "1root/y/Z") == SUCCESS);
+  assert(FT_containsDir("1root/y/Z") == TRUE);
+  assert(FT_rename("1root/m", "1root/m/CHILD4DIR/in") ==
+         CONFLICTING_PATH);
+  assert(FT_rename("1root/m", "1root/x") == ALREADY_IN_TREE);
+  assert(FT_rename("1root/m", "1root/q/r") == NO_SUCH_PATH);
+  assert(FT_rename("1root/m", "1root/m/moved/r") == NOT_A_DIRECTORY);
+  assert(FT_rename("1root/nope", "1root/r") == NO_SUCH_PATH);
+  assert(FT_rename("1root/m", "2root") == CONFLICTING_PATH);
+  assert(FT_rename("1root/m", "2root/m") == CONFLICTING_PATH);
+  assert(FT_rename("1root/m", "1root//x") == BAD_PATH);
+  assert(FT_rename("1root", "0root") == SUCCESS);
+  assert(FT_containsDir("0root/m/CHILD4DIR") == TRUE);
+  assert(FT_statAt(oHSub, "CHILD4DIR", &bIsFile, &l) == SUCCESS);
+  assert(FT_rename("0root", "0root") == ALREADY_IN_TREE);
+  assert(FT_rename("0root", "1root") == SUCCESS);
+  FT_closeDir(oHSub);
+
+  /* copies share their source until either side changes */
+  assert(FT_copyTree("1root/m", "1root/t") == SUCCESS);
+  assert(FT_containsDir("1root/t/CHILD4DIR") == TRUE);
+  assert(FT_containsFile("1root/t/moved") == TRUE);
+  assert(FT_getFileContents("1root/t/moved") ==
+         FT_getFileContents("1root/m/moved"));
+  assert(FT_copyTree("1root/m", "1root/t") == ALREADY_IN_TREE);
+  assert(FT_copyTree("1root/m", "1root/m/CHILD4DIR/in") ==
+         CONFLICTING_PATH);
+  assert(FT_copyTree("1root/m", "1root/q/r") == NO_SUCH_PATH);
+  assert(FT_copyTree("1root/m", "1root/m/moved/r") == NOT_A_DIRECTORY);
+  assert(FT_copyTree("1root/nope", "1root/r") == NO_SUCH_PATH);
+  assert(FT_copyTree("1root/m", "1root2") == CONFLICTING_PATH);
+  assert(FT_copyTree("1root/t", "1root/u") == SUCCESS);
+  assert(FT_insertDir("1root/t/CHILD4DIR/new") == SUCCESS);
+  assert(FT_containsDir("1root/m/CHILD4DIR/new") == FALSE);
+  assert(FT_containsDir("1root/u/CHILD4DIR/new") == FALSE);
+  assert(FT_replaceFileContents("1root/m/moved", "m", 2) == NULL);
+  assert(FT_getFileContents("1root/t/moved") == NULL);
+  assert(FT_rmDir("1root/m") == SUCCESS);
+  assert(FT_containsDir("1root/u/CHILD4DIR") == TRUE);
+  assert(FT_rmFile("1root/u/moved") == SUCCESS);
+  assert(FT_containsFile("1root/t/moved") == TRUE);
+  assert(FT_copyTree("1root/t/moved", "1root/u/moved") == SUCCESS);
+  assert(FT_stat("1root/u/moved", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE);
+  /* a handle below a removed directory goes stale, even when lazy
+     copies of the directory take over its children */
+  assert(FT_insertDir("1root/r/a/b/c") == SUCCESS);
+  assert(FT_openDir("1root/r/a/b", &oHSub) == SUCCESS);
+  assert(FT_copyTree("1root/r/a", "1root/r/c") == SUCCESS);
+  assert(FT_copyTree("1root/r/a", "1root/r/c2") == SUCCESS);
+  assert(FT_rmDir("1root/r/a") == SUCCESS);
+  assert(FT_insertDirAt(oHSub, "x") == NO_SUCH_PATH);
+  assert(FT_statAt(oHSub, "c", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_containsDir("1root/r/c/b/c") == TRUE);
+  assert(FT_containsDir("1root/r/c/b/x") == FALSE);
+  assert(FT_insertDir("1root/r/c2/b/y") == SUCCESS);
+  assert(FT_containsDir("1root/r/c/b/y") == FALSE);
+  FT_closeDir(oHSub);
+
   assert(FT_destroy() == SUCCESS);
+  assert(FT_statAt(oHDir, "CHILD2DIR", &bIsFile, &l)
+         == INITIALIZATION_ERROR);
+  FT_closeDir(oHDir);
   assert(FT_destroy() == INITIALIZATION_ERROR);
   assert(FT_containsDir("1root") == FALSE);
   assert(FT_containsFile("1root") == FALSE);
   assert((temp = FT_toString()) == NULL);
 
+  /* In owned mode the FT keeps its own copies of file contents, so
+     the client's buffers can be reused or freed at once */
+  assert(FT_init() == SUCCESS);
+  assert(FT_setContentMode(FT_CONTENTS_OWNED) == INITIALIZATION_ERROR);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_setContentMode(FT_CONTENTS_OWNED) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  strcpy(arr, "small");
+  assert(FT_insertFile("1root/small", arr, 6) == SUCCESS);
+  memset(arr, 'L', ARRLEN);
+  assert(FT_insertFile("1root/large", arr, ARRLEN) == SUCCESS);
+  assert(FT_insertFile("1root/empty", NULL, 0) == SUCCESS);
+  arr[0] = 'x';
+  assert(strcmp(FT_getFileContents("1root/small"), "small") == 0);
+  assert(FT_getFileContents("1root/small") != arr);
+  assert(((char *) FT_getFileContents("1root/large"))[0] == 'L');
+  assert(FT_getFileContents("1root/empty") == NULL);
+  assert(FT_stat("1root/large", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE);
+  assert(l == ARRLEN);
+  /* replacing returns the FT's copy of the new contents */
+  temp = FT_replaceFileContents("1root/small", arr, ARRLEN);
+  assert(temp != NULL && temp != arr && temp[0] == 'x');
+  temp = FT_replaceFileContents("1root/large", "tiny", 5);
+  assert(temp != NULL && strcmp(temp, "tiny") == 0);
+  assert(FT_replaceFileContents("1root/empty", NULL, 0) == NULL);
+  assert(FT_stat("1root/small", &bIsFile, &l) == SUCCESS);
+  assert(l == ARRLEN);
+  /* copies keep their contents when the original is replaced */
+  assert(FT_copyTree("1root/small", "1root/small2") == SUCCESS);
+  assert(FT_getFileContents("1root/small2") ==
+         FT_getFileContents("1root/small"));
+  assert(FT_replaceFileContents("1root/small", "s", 2) != NULL);
+  assert(((char *) FT_getFileContents("1root/small2"))[0] == 'x');
+  assert(FT_rmFile("1root/small") == SUCCESS);
+  assert(((char *) FT_getFileContents("1root/small2"))[1] == 'L');
+  assert(FT_statStorage("1root", &l, &ulPhysical) == SUCCESS);
+  assert(l == ARRLEN + 5 && ulPhysical == ARRLEN + 5);
+  assert(FT_destroy() == SUCCESS);
+
+  /* In dedup mode identical large contents are stored once */
+  assert(FT_setContentMode(FT_CONTENTS_DEDUP) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  memset(arr, 'D', ARRLEN);
+  assert(FT_insertFile("1root/a", arr, ARRLEN) == SUCCESS);
+  assert(FT_insertFile("1root/b/c", arr, ARRLEN) == SUCCESS);
+  assert(FT_insertFile("1root/b/d", arr, ARRLEN - 1) == SUCCESS);
+  assert(FT_insertFile("1root/b/e", "short", 6) == SUCCESS);
+  assert(FT_getFileContents("1root/a") ==
+         FT_getFileContents("1root/b/c"));
+  assert(FT_getFileContents("1root/a") !=
+         FT_getFileContents("1root/b/d"));
+  assert(FT_statStorage("1root", &l, &ulPhysical) == SUCCESS);
+  assert(l == 3 * ARRLEN + 5 && ulPhysical == 2 * ARRLEN + 5);
+  assert(FT_statStorage("1root/b/c", &l, &ulPhysical) == SUCCESS);
+  assert(l == ARRLEN && ulPhysical == ARRLEN);
+  assert(FT_statStorage("1root/x", &l, &ulPhysical) == NO_SUCH_PATH);
+  /* replacing one copy leaves the other intact */
+  arr[0] = 'E';
+  assert(FT_replaceFileContents("1root/a", arr, ARRLEN) != NULL);
+  assert(((char *) FT_getFileContents("1root/b/c"))[0] == 'D');
+  assert(FT_rmDir("1root/b") == SUCCESS);
+  assert(((char *) FT_getFileContents("1root/a"))[0] == 'E');
+  assert(FT_statStorage("1root", &l, &ulPhysical) == SUCCESS);
+  assert(l == ARRLEN && ulPhysical == ARRLEN);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_setContentMode(FT_CONTENTS_BORROWED) == SUCCESS);
+
+  /* Ranged reads work in any mode, but files can only be changed in
+     place when the FT owns their contents */
+  assert(FT_readAt("1root/f", 0, buf, 1, &l) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertFile("1root/f", "abc", 3) == SUCCESS);
+  assert(FT_readAt("1root/f", 1, buf, 5, &l) == SUCCESS);
+  assert(l == 2 && memcmp(buf, "bc", 2) == 0);
+  assert(FT_readAt("1root/f", 3, buf, 5, &l) == SUCCESS && l == 0);
+  assert(FT_readAt("1root", 0, buf, 5, &l) == NOT_A_FILE);
+  assert(FT_writeAt("1root/f", 0, "x", 1) == INITIALIZATION_ERROR);
+  assert(FT_append("1root/f", "x", 1) == INITIALIZATION_ERROR);
+  assert(FT_truncate("1root/f", 0) == INITIALIZATION_ERROR);
+  assert(FT_destroy() == SUCCESS);
+
+  assert(FT_setContentMode(FT_CONTENTS_OWNED) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  /* small files are changed inline */
+  assert(FT_insertFile("1root/s", "abcd", 4) == SUCCESS);
+  assert(FT_writeAt("1root/s", 2, "ZZZ", 3) == SUCCESS);
+  assert(memcmp(FT_getFileContents("1root/s"), "abZZZ", 5) == 0);
+  assert(FT_truncate("1root/s", 1) == SUCCESS);
+  assert(FT_append("1root/s", "b", 1) == SUCCESS);
+  assert(FT_stat("1root/s", &bIsFile, &l) == SUCCESS && l == 2);
+  assert(memcmp(FT_getFileContents("1root/s"), "ab", 2) == 0);
+  /* a log built by appending spans several chunks */
+  assert(FT_insertFile("1root/log", NULL, 0) == SUCCESS);
+  for(i = 0; i < ARRLEN; i++) {
+    sprintf(buf, "line %04d\n", (int) i);
+    assert(FT_append("1root/log", buf, 10) == SUCCESS);
+  }
+  assert(FT_stat("1root/log", &bIsFile, &l) == SUCCESS);
+  assert(l == 10 * ARRLEN);
+  assert(FT_readAt("1root/log", 4090, buf, 20, &l) == SUCCESS);
+  assert(l == 20 && memcmp(buf, "line 0409\nline 0410\n", 20) == 0);
+  assert(FT_writeAt("1root/log", 4095, "XY", 2) == SUCCESS);
+  assert(FT_readAt("1root/log", 4094, buf, 4, &l) == SUCCESS);
+  assert(memcmp(buf, " XY0", 4) == 0);
+  /* a copy shares the chunks until either is written */
+  assert(FT_copyTree("1root/log", "1root/log2") == SUCCESS);
+  assert(FT_writeAt("1root/log2", 0, "L", 1) == SUCCESS);
+  assert(FT_readAt("1root/log", 0, buf, 1, &l) == SUCCESS);
+  assert(buf[0] == 'l');
+  /* truncating and writing past the end fill the gap with zeros */
+  assert(FT_truncate("1root/log", 4097) == SUCCESS);
+  assert(FT_writeAt("1root/log", 9000, "end", 3) == SUCCESS);
+  assert(FT_stat("1root/log", &bIsFile, &l) == SUCCESS && l == 9003);
+  assert(FT_readAt("1root/log", 4096, buf, 3, &l) == SUCCESS);
+  assert(l == 3 && buf[0] == 'Y' && buf[1] == '\0' && buf[2] == '\0');
+  temp = FT_getFileContents("1root/log");
+  assert(temp != NULL && temp[4095] == 'X' && temp[8999] == '\0');
+  assert(memcmp(temp + 9000, "end", 3) == 0);
+  assert(FT_append("1root/log", "!", 1) == SUCCESS);
+  assert(FT_readAt("1root/log2", 10 * ARRLEN - 10, buf, 20, &l)
+         == SUCCESS);
+  assert(l == 10 && memcmp(buf, "line 0999\n", 10) == 0);
+  assert(FT_writeAt("1root", 0, "x", 1) == NOT_A_FILE);
+  assert(FT_truncate("1root/nope", 0) == NO_SUCH_PATH);
+  /* a large image that is mostly zeros takes storage only for the
+     data written to it */
+  assert(FT_insertFile("1root/img", NULL, (size_t) 1 << 31) == SUCCESS);
+  assert(FT_stat("1root/img", &bIsFile, &l) == SUCCESS);
+  assert(l == (size_t) 1 << 31);
+  assert(FT_writeAt("1root/img", (size_t) 1 << 30, "data", 4) == SUCCESS);
+  assert(FT_readAt("1root/img", ((size_t) 1 << 30) - 2, buf, 6, &l)
+         == SUCCESS);
+  assert(l == 6 && memcmp(buf, "\0\0data", 6) == 0);
+  assert(FT_truncate("1root/img", ((size_t) 1 << 30) + 2) == SUCCESS);
+  assert(FT_truncate("1root/img", (size_t) 1 << 31) == SUCCESS);
+  assert(FT_readAt("1root/img", ((size_t) 1 << 30) + 1, buf, 3, &l)
+         == SUCCESS);
+  assert(l == 3 && memcmp(buf, "a\0\0", 3) == 0);
+  assert(FT_append("1root/img", "tail", 4) == SUCCESS);
+  assert(FT_statStorage("1root/img", &l, &ulPhysical) == SUCCESS);
+  assert(l == ((size_t) 1 << 31) + 4 && ulPhysical < 100);
+  /* contents can be mapped straight from a file: here, this one */
+  iFd = open("ft_client.c", O_RDONLY);
+  assert(iFd >= 0);
+  assert(FT_insertFileFromFd("1root/src", iFd, 4096, 8) == SUCCESS);
+  assert(FT_insertFileFromFd("1root/hdr", iFd, 2, 70) == SUCCESS);
+  assert(FT_insertFileFromFd("1root/empty", iFd, 0, 0) == SUCCESS);
+  assert(FT_insertFileFromFd("1root/big", iFd, 0, (size_t) 1 << 30)
+         == MEMORY_ERROR);
+  assert(FT_insertFileFromFd("1root/bad", -1, 0, 8) == MEMORY_ERROR);
+  assert(FT_insertFileFromFd("1root/src", iFd, 0, 8) == ALREADY_IN_TREE);
+  assert(FT_insertFileFromFd("1root//x", iFd, 0, 8) == BAD_PATH);
+  assert(close(iFd) == 0);
+  /* nothing is consumed from a pipe for a file that cannot go in */
+  assert(pipe(aiPipe) == 0);
+  assert(write(aiPipe[1], "0123456789", 10) == 10);
+  assert(FT_insertFileFromFd("1root/src", aiPipe[0], 0, 4)
+         == ALREADY_IN_TREE);
+  assert(FT_insertFileFromFd("1root/src/x", aiPipe[0], 0, 4)
+         == NOT_A_DIRECTORY);
+  assert(FT_insertFileFromFd("2root/x", aiPipe[0], 0, 4)
+         == CONFLICTING_PATH);
+  assert(FT_insertFileFromFd("1root/pipe/in", aiPipe[0], 0, 4)
+         == SUCCESS);
+  assert(FT_readAt("1root/pipe/in", 0, buf, 4, &l) == SUCCESS);
+  assert(l == 4 && memcmp(buf, "0123", 4) == 0);
+  assert(close(aiPipe[0]) == 0 && close(aiPipe[1]) == 0);
+  assert(FT_containsFile("1root/big") == FALSE);
+  temp = FT_getFileContents("1root/hdr");
+  assert(temp != NULL && memcmp(temp, "-----", 5) == 0);
+  assert(FT_stat("1root/hdr", &bIsFile, &l) == SUCCESS && l == 70);
+  assert(FT_readAt("1root/src", 0, buf, 8, &l) == SUCCESS && l == 8);
+  assert(FT_copyTree("1root/hdr", "1root/hdr2") == SUCCESS);
+  assert(FT_append("1root/hdr", "*/", 2) == SUCCESS);
+  assert(FT_readAt("1root/hdr", 68, buf, 4, &l) == SUCCESS);
+  assert(l == 4 && memcmp(buf, "*/*/", 4) == 0);
+  assert(FT_rmFile("1root/hdr2") == SUCCESS);
+  assert(FT_replaceFileContents("1root/src", "x", 1) != NULL);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_setContentMode(FT_CONTENTS_BORROWED) == SUCCESS);
+
+  /* a hierarchy on disk can be imported whole */
+  assert(mkdir("ft_import.tmp", 0700) == 0);
+  assert(mkdir("ft_import.tmp/sub", 0700) == 0);
+  assert(mkdir("ft_import.tmp/sub/deep", 0700) == 0);
+  for(i = 0; i < 3; i++) {
+    sprintf(arr, i == 0 ? "ft_import.tmp/a" : i == 1 ?
+            "ft_import.tmp/sub/b" : "ft_import.tmp/sub/deep/c");
+    iFd = open(arr, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    assert(iFd >= 0);
+    assert(write(iFd, arr, strlen(arr)) == (long) strlen(arr));
+    assert(close(iFd) == 0);
+  }
+  assert(FT_init() == SUCCESS);
+  assert(FT_importDirectory("ft_import.tmp", "1root/imp", 4,
+                            FT_IMPORT_METADATA) == SUCCESS);
+  assert(FT_containsDir("1root/imp/sub/deep") == TRUE);
+  assert(FT_stat("1root/imp/sub/b", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE && l == strlen("ft_import.tmp/sub/b"));
+  assert(FT_importDirectory("ft_import.tmp", "1root/imp", 4,
+                            FT_IMPORT_METADATA) == ALREADY_IN_TREE);
+  assert(FT_importDirectory("ft_import.tmp", "1root/imp/a/x", 4,
+                            FT_IMPORT_METADATA) == NOT_A_DIRECTORY);
+  assert(FT_importDirectory("ft_import.tmp", "2root/imp", 4,
+                            FT_IMPORT_METADATA) == CONFLICTING_PATH);
+  assert(FT_importDirectory("ft_import.tmp", "1root/two", 4,
+                            FT_IMPORT_CONTENTS) == INITIALIZATION_ERROR);
+  assert(FT_importDirectory("ft_import.tmp/nope", "1root/two", 4,
+                            FT_IMPORT_METADATA) == NO_SUCH_PATH);
+  assert(FT_importDirectory("ft_import.tmp/a", "1root/two", 4,
+                            FT_IMPORT_METADATA) == NOT_A_DIRECTORY);
+  assert(FT_containsDir("1root/two") == FALSE);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_setContentMode(FT_CONTENTS_OWNED) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_importDirectory("ft_import.tmp", "imp", 0,
+                            FT_IMPORT_CONTENTS) == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(strcmp(temp, "imp\nimp/a\nimp/sub\nimp/sub/b\n"
+                "imp/sub/deep\nimp/sub/deep/c\n") == 0);
+  free(temp);
+  assert(FT_readAt("imp/sub/deep/c", 0, buf, ARRLEN, &l) == SUCCESS);
+  assert(l == strlen("ft_import.tmp/sub/deep/c"));
+  assert(memcmp(buf, "ft_import.tmp/sub/deep/c", l) == 0);
+  /* and written back out, holes and all */
+  assert(FT_insertFile("imp/sub/hole", NULL, 100000) == SUCCESS);
+  assert(FT_writeAt("imp/sub/hole", 70000, "end", 3) == SUCCESS);
+  assert(FT_exportDirectory("imp", "ft_export.tmp", 2, &sTimes)
+         == SUCCESS);
+  assert(FT_exportDirectory("imp", "ft_export.tmp", 2, NULL)
+         == ALREADY_IN_TREE);
+  assert(FT_exportDirectory("imp/a", "ft_export2.tmp", 2, NULL)
+         == NOT_A_DIRECTORY);
+  assert(FT_exportDirectory("imp", "ft_export.tmp/a/x", 2, NULL)
+         == NOT_A_DIRECTORY);
+  assert(FT_exportDirectory("imp", "ft_nope.tmp/x", 2, NULL)
+         == NO_SUCH_PATH);
+  iFd = open("ft_export.tmp/sub/deep/c", O_RDONLY);
+  assert(iFd >= 0);
+  assert(read(iFd, buf, ARRLEN) == (long) strlen(arr));
+  assert(memcmp(buf, arr, strlen(arr)) == 0);
+  assert(close(iFd) == 0);
+  assert(stat("ft_export.tmp/sub/hole", &sStat) == 0);
+  assert(sStat.st_size == 100000);
+  iFd = open("ft_export.tmp/sub/hole", O_RDONLY);
+  assert(iFd >= 0);
+  assert(read(iFd, buf, ARRLEN) == ARRLEN && buf[ARRLEN - 1] == '\0');
+  assert(lseek(iFd, 70000, SEEK_SET) == 70000);
+  assert(read(iFd, buf, 4) == 4 && memcmp(buf, "end", 4) == 0);
+  assert(close(iFd) == 0);
+
+  /* a round trip through a tar archive, with a path too long for
+     ustar, and then archives that can't be read in */
+  memset(buf, 'x', 150);
+  strcpy(buf + 150, "/long");
+  temp = malloc(strlen("imp/") + strlen(buf) + 1);
+  assert(temp != NULL);
+  sprintf(temp, "imp/%s", buf);
+  assert(FT_insertFile(temp, "abc", 3) == SUCCESS);
+  free(temp);
+  iFd = open("ft_tar.tmp", O_RDWR | O_CREAT | O_TRUNC, 0600);
+  assert(iFd >= 0);
+  assert(FT_writeTar(iFd) == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_writeTar(iFd) == INITIALIZATION_ERROR);
+  assert(FT_readTar(iFd) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(lseek(iFd, 0, SEEK_SET) == 0);
+  assert(FT_readTar(iFd) == SUCCESS);
+  assert((temp2 = FT_toString()) != NULL && strcmp(temp2, temp) == 0);
+  free(temp2);
+  assert(FT_readAt("imp/sub/hole", 69999, buf + 200, 5, &l) == SUCCESS);
+  assert(l == 5 && memcmp(buf + 200, "\0end", 5) == 0);
+  assert(FT_readAt("imp/sub/deep/c", 0, buf + 200, ARRLEN - 200, &l)
+         == SUCCESS);
+  assert(l == strlen(arr) && memcmp(buf + 200, arr, l) == 0);
+  /* reading it in again finds its files already there */
+  assert(lseek(iFd, 0, SEEK_SET) == 0);
+  assert(FT_readTar(iFd) == ALREADY_IN_TREE);
+  assert((temp2 = FT_toString()) != NULL && strcmp(temp2, temp) == 0);
+  free(temp2);
+  free(temp);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("other") == SUCCESS);
+  assert(lseek(iFd, 0, SEEK_SET) == 0);
+  assert(FT_readTar(iFd) == CONFLICTING_PATH);
+  assert((temp2 = FT_toString()) != NULL && strcmp(temp2, "other\n") == 0);
+  free(temp2);
+  /* an empty FT makes an empty archive */
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(close(iFd) == 0);
+  iFd = open("ft_tar.tmp", O_RDWR | O_TRUNC);
+  assert(iFd >= 0);
+  assert(FT_writeTar(iFd) == SUCCESS);
+  assert(lseek(iFd, 0, SEEK_CUR) == 1024);
+  assert(lseek(iFd, 0, SEEK_SET) == 0);
+  assert(FT_readTar(iFd) == SUCCESS);
+  assert((temp2 = FT_toString()) != NULL && strcmp(temp2, "") == 0);
+  free(temp2);
+  /* and a block that isn't a header is malformed */
+  memset(buf, 'x', 512);
+  assert(close(iFd) == 0);
+  iFd = open("ft_tar.tmp", O_RDWR | O_TRUNC);
+  assert(iFd >= 0);
+  assert(write(iFd, buf, 512) == 512);
+  assert(lseek(iFd, 0, SEEK_SET) == 0);
+  assert(FT_readTar(iFd) == BAD_PATH);
+  assert(close(iFd) == 0);
+  assert(unlink("ft_tar.tmp") == 0);
+  assert(FT_destroy() == SUCCESS);
+  assert(unlink("ft_export.tmp/sub/deep/c") == 0);
+  assert(rmdir("ft_export.tmp/sub/deep") == 0);
+  assert(unlink("ft_export.tmp/sub/b") == 0);
+  assert(unlink("ft_export.tmp/sub/hole") == 0);
+  assert(rmdir("ft_export.tmp/sub") == 0);
+  assert(unlink("ft_export.tmp/a") == 0);
+  assert(rmdir("ft_export.tmp") == 0);
+  assert(unlink("ft_import.tmp/sub/deep/c") == 0);
+  assert(rmdir("ft_import.tmp/sub/deep") == 0);
+  assert(unlink("ft_import.tmp/sub/b") == 0);
+  assert(rmdir("ft_import.tmp/sub") == 0);
+  assert(unlink("ft_import.tmp/a") == 0);
+  assert(rmdir("ft_import.tmp") == 0);
+  assert(FT_setContentMode(FT_CONTENTS_BORROWED) == SUCCESS);
+
+  /* A frozen FT answers lookups from its flat layout, including
+     paths in lazy copies, and refuses changes until thawed */
+  assert(FT_freeze(FT_FREEZE_LAYOUT, NULL) == INITIALIZATION_ERROR);
+  assert(FT_thaw() == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_freeze(FT_FREEZE_LAYOUT, NULL) == SUCCESS);
+  assert(FT_containsDir("a") == FALSE);
+  assert((temp = FT_toString()) != NULL && strcmp(temp, "") == 0);
+  free(temp);
+  assert(FT_insertDir("a") == INITIALIZATION_ERROR);
+  assert(FT_thaw() == SUCCESS);
+  assert(FT_insertFile("a/b/c", "xyz", 3) == SUCCESS);
+  assert(FT_insertFile("a/b/bb", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("a/d/e") == SUCCESS);
+  assert(FT_copyTree("a/b", "a/d/copy") == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(FT_freeze(FT_FREEZE_LAYOUT, NULL) == SUCCESS);
+  assert(FT_freeze(FT_FREEZE_LAYOUT, NULL) == SUCCESS);
+  assert((temp2 = FT_toString()) != NULL && strcmp(temp, temp2) == 0);
+  free(temp2);
+  assert(FT_containsFile("a/b/c") == TRUE);
+  assert(FT_containsDir("a/b/c") == FALSE);
+  assert(FT_containsFile("a/d/copy/c") == TRUE);
+  assert(FT_containsDir("a/d/e") == TRUE);
+  assert(FT_containsDir("a/d/e/f") == FALSE);
+  assert(FT_containsDir("b") == FALSE);
+  assert(FT_stat("a/b/c/x", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_stat("z/b", &bIsFile, &l) == CONFLICTING_PATH);
+  assert(FT_stat("a//b", &bIsFile, &l) == BAD_PATH);
+  assert(FT_stat("a/d/copy/c", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE && l == 3);
+  assert(memcmp(FT_getFileContents("a/d/copy/c"), "xyz", 3) == 0);
+  assert(FT_insertDir("a/x") == INITIALIZATION_ERROR);
+  assert(FT_insertFile("a/x", NULL, 0) == INITIALIZATION_ERROR);
+  assert(FT_rmFile("a/b/c") == INITIALIZATION_ERROR);
+  assert(FT_rmDir("a/d") == INITIALIZATION_ERROR);
+  assert(FT_rename("a/b", "a/z") == INITIALIZATION_ERROR);
+  assert(FT_copyTree("a/b", "a/z") == INITIALIZATION_ERROR);
+  assert(FT_replaceFileContents("a/b/c", "q", 1) == NULL);
+  assert(FT_openDir("a/d/copy", &oHDir) == SUCCESS);
+  assert(FT_statAt(oHDir, "c", &bIsFile, &l) == SUCCESS);
+  assert(FT_insertDirAt(oHDir, "n") == INITIALIZATION_ERROR);
+  assert(FT_rmAt(oHDir, "c") == INITIALIZATION_ERROR);
+  assert((temp2 = FT_toString()) != NULL && strcmp(temp, temp2) == 0);
+  free(temp2);
+  free(temp);
+  assert(FT_thaw() == SUCCESS);
+  assert(FT_thaw() == SUCCESS);
+  assert(FT_insertDirAt(oHDir, "n") == SUCCESS);
+  assert(FT_containsDir("a/d/copy/n") == TRUE);
+  assert(FT_containsDir("a/b/n") == FALSE);
+  FT_closeDir(oHDir);
+  assert(FT_freeze(FT_FREEZE_LAYOUT, &sFreeze) == SUCCESS);
+  assert(FT_containsDir("a/d/copy/n") == TRUE);
+  assert(sFreeze.ulEntries == 10 && sFreeze.ulLayoutBytes > 0);
+  assert(sFreeze.ulHashBytes == 0 && sFreeze.ulSlotBytes == 0);
+
+  /* A hashed freeze looks every full path up in one step, and still
+     tells a missing path even when its names are all in the tree */
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(FT_freeze(FT_FREEZE_HASHED, &sFreeze) == SUCCESS);
+  assert(sFreeze.ulEntries == 10);
+  assert(sFreeze.ulHashBytes > 0 && sFreeze.ulSlotBytes > 0);
+  assert(FT_freeze(FT_FREEZE_LAYOUT, &sFreeze) == SUCCESS);
+  assert(sFreeze.ulHashBytes > 0);
+  assert(FT_containsDir("a") == TRUE);
+  assert(FT_containsDir("a/d/copy/n") == TRUE);
+  assert(FT_containsFile("a/d/copy/c") == TRUE);
+  assert(FT_containsFile("a/d/copy/bb") == TRUE);
+  assert(FT_containsDir("a/d/copy/c") == FALSE);
+  assert(FT_containsFile("a/b/cc") == FALSE);
+  assert(FT_containsDir("a/b/n") == FALSE);
+  assert(FT_containsDir("a/copy") == FALSE);
+  assert(FT_containsFile("a/d/b/c") == FALSE);
+  assert(FT_containsDir("a/e") == FALSE);
+  assert(FT_stat("a/b/c/x", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_stat("b/c", &bIsFile, &l) == CONFLICTING_PATH);
+  assert(FT_stat("a/b/c", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE && l == 3);
+  assert(FT_stat("a/d", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == FALSE);
+  assert((temp2 = FT_toString()) != NULL && strcmp(temp, temp2) == 0);
+  free(temp2);
+  free(temp);
+  assert(FT_insertDir("a/x") == INITIALIZATION_ERROR);
+  assert(FT_thaw() == SUCCESS);
+  assert(FT_containsDir("a/d/copy/n") == TRUE);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("a") == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+
+  /* The filter of paths rules out most missing paths at once, and
+     follows insertions, removals, renames and copies */
+  assert(FT_init() == SUCCESS);
+  for(i = 0; i < 100; i++) {
+    sprintf(arr, "r/d%lu/f%lu", (unsigned long) (i % 10),
+            (unsigned long) i);
+    assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+  }
+  for(i = 0; i < 100; i++) {
+    sprintf(arr, "r/d%lu/f%lu", (unsigned long) (i % 10),
+            (unsigned long) i);
+    assert(FT_containsFile(arr) == TRUE);
+    assert(FT_containsDir(arr) == FALSE);
+    sprintf(arr, "r/d%lu/g%lu", (unsigned long) (i % 10),
+            (unsigned long) i);
+    assert(FT_containsFile(arr) == FALSE);
+  }
+  FT_getFilterStats(&sFilter);
+  assert(sFilter.ulBypassed == 0 && sFilter.ulBuilds >= 1);
+  assert(sFilter.ulAvoided + sFilter.ulPassed == 300);
+  assert(sFilter.ulPassed == 200 + sFilter.ulFalsePositives);
+  assert(sFilter.ulAvoided >= 90);
+  assert(FT_rmFile("r/d2/f2") == SUCCESS);
+  assert(FT_containsFile("r/d2/f2") == FALSE);
+  assert(FT_containsFile("r/d2/f12") == TRUE);
+  assert(FT_rmDir("r/d3") == SUCCESS);
+  assert(FT_containsDir("r/d3") == FALSE);
+  assert(FT_containsFile("r/d3/f13") == FALSE);
+  assert(FT_insertFile("r/d3/f13", NULL, 0) == SUCCESS);
+  assert(FT_containsFile("r/d3/f13") == TRUE);
+  assert(FT_rename("r/d1", "r/e1") == SUCCESS);
+  assert(FT_containsFile("r/e1/f11") == TRUE);
+  assert(FT_containsFile("r/d1/f11") == FALSE);
+  assert(FT_copyTree("r/e1", "r/c1") == SUCCESS);
+  assert(FT_containsFile("r/c1/f21") == TRUE);
+  FT_getFilterStats(&sFilter);
+  assert(sFilter.ulBypassed == 3);
+  /* once lookups have gone without it for long enough, it is back */
+  l = sFilter.ulBuilds;
+  for(i = 0; i < 200; i++)
+    assert(FT_containsDir("r/e1") == TRUE);
+  assert(FT_containsFile("r/c1/f31") == TRUE);
+  assert(FT_containsFile("r/c1/f32") == FALSE);
+  FT_getFilterStats(&sFilter);
+  assert(sFilter.ulBuilds == l + 1 && sFilter.ulBypassed < 200);
+  assert(FT_freeze(FT_FREEZE_HASHED, NULL) == SUCCESS);
+  assert(FT_containsFile("r/e1/f41") == TRUE);
+  assert(FT_containsFile("r/e1/f42") == FALSE);
+  assert(FT_destroy() == SUCCESS);
+
+  /* A snapshot keeps the hierarchy and sizes as they were, apart from
+     the FT, whose names it front-codes across buckets of siblings */
+  assert(FT_snapshot(&oSSnap) == INITIALIZATION_ERROR);
+  assert(oSSnap == NULL);
+  assert(FT_init() == SUCCESS);
+  assert(FT_snapshot(&oSSnap) == SUCCESS);
+  assert(FT_snapshotContainsDir(oSSnap, "s") == FALSE);
+  assert((temp = FT_snapshotToString(oSSnap)) != NULL);
+  assert(strcmp(temp, "") == 0);
+  free(temp);
+  FT_freeSnapshot(oSSnap);
+  strcpy(buf, "s/dir0/");
+  memset(buf + 7, 'n', 300);
+  strcpy(buf + 307, "/x");
+  for(i = 0; i < 100; i++) {
+    sprintf(arr, "s/dir%lu/file_%03lu", (unsigned long) (i % 7),
+            (unsigned long) i);
+    assert(FT_insertFile(arr, buf, i) == SUCCESS);
+  }
+  assert(FT_insertFile(buf, NULL, 7) == SUCCESS);
+  assert(FT_insertDir("s/empty") == SUCCESS);
+  assert(FT_copyTree("s/dir3", "s/dir3copy") == SUCCESS);
+  assert(FT_snapshot(&oSSnap) == SUCCESS);
+  FT_getSnapshotStats(oSSnap, &sSnap);
+  assert(sSnap.ulNodes == 1 + 7 + 100 + 2 + 1 + 1 + 14);
+  assert(sSnap.ulShapeBytes > 0 && sSnap.ulNameBytes > 0);
+  assert(sSnap.ulSizeBytes > 0);
+  assert((temp = FT_toString()) != NULL);
+  assert((temp2 = FT_snapshotToString(oSSnap)) != NULL);
+  assert(strcmp(temp, temp2) == 0);
+  free(temp2);
+  assert(FT_rmDir("s/dir3") == SUCCESS);
+  assert(FT_insertFile("s/new", NULL, 0) == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+  for(i = 0; i < 100; i++) {
+    sprintf(arr, "s/dir%lu/file_%03lu", (unsigned long) (i % 7),
+            (unsigned long) i);
+    assert(FT_snapshotContainsFile(oSSnap, arr) == TRUE);
+    assert(FT_snapshotContainsDir(oSSnap, arr) == FALSE);
+    assert(FT_snapshotStat(oSSnap, arr, &bIsFile, &l) == SUCCESS);
+    assert(bIsFile == TRUE && l == i);
+    sprintf(arr, "s/dir%lu/file_%03lu", (unsigned long) ((i + 1) % 7),
+            (unsigned long) i);
+    assert(FT_snapshotContainsFile(oSSnap, arr) == FALSE);
+  }
+  assert(FT_snapshotStat(oSSnap, buf, &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE && l == 7);
+  assert(FT_snapshotContainsDir(oSSnap, "s/dir3copy") == TRUE);
+  assert(FT_snapshotContainsFile(oSSnap, "s/dir3copy/file_094") == TRUE);
+  assert(FT_snapshotContainsDir(oSSnap, "s/dir3") == TRUE);
+  assert(FT_snapshotContainsDir(oSSnap, "s/empty") == TRUE);
+  assert(FT_snapshotContainsFile(oSSnap, "s/new") == FALSE);
+  assert(FT_snapshotContainsDir(oSSnap, "s/dir") == FALSE);
+  assert(FT_snapshotContainsDir(oSSnap, "s/dir70") == FALSE);
+  assert(FT_snapshotContainsDir(oSSnap, "s/a") == FALSE);
+  assert(FT_snapshotContainsDir(oSSnap, "s/z") == FALSE);
+  assert(FT_snapshotStat(oSSnap, "t/dir0", &bIsFile, &l)
+         == CONFLICTING_PATH);
+  assert(FT_snapshotStat(oSSnap, "s//dir0", &bIsFile, &l) == BAD_PATH);
+  assert(FT_snapshotStat(oSSnap, "s/dir1/x", &bIsFile, &l)
+         == NO_SUCH_PATH);
+  assert(FT_snapshotStat(oSSnap, "s/dir1", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == FALSE);
+  assert((temp2 = FT_snapshotToString(oSSnap)) != NULL);
+  assert(strcmp(temp, temp2) == 0);
+  free(temp2);
+  free(temp);
+  FT_freeSnapshot(oSSnap);
+  FT_freeSnapshot(NULL);
+
+  /* A cold directory of files is packed: lookups and the string
+     representation read the pack, and anything else unpacks it */
+  assert(FT_init() == SUCCESS);
+  for(i = 0; i < 40; i++) {
+    sprintf(arr, "p/cold/part-%06lu.parquet", (unsigned long) i);
+    assert(FT_insertFile(arr, buf, i) == SUCCESS);
+  }
+  for(i = 0; i < 9; i++) {
+    sprintf(arr, "p/warm/part-%06lu.parquet", (unsigned long) i);
+    assert(FT_insertFile(arr, buf, i) == SUCCESS);
+  }
+  assert((temp = FT_toString()) != NULL);
+  FT_setPacking(5);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 1 && sPack.ulFiles == 40);
+  assert(sPack.ulPacked == 1 && sPack.ulUnpacked == 0);
+  assert(sPack.ulBytes < sPack.ulNodeBytes);
+  assert((temp2 = FT_toString()) != NULL);
+  assert(strcmp(temp, temp2) == 0);
+  free(temp2);
+  for(i = 0; i < 40; i++) {
+    sprintf(arr, "p/cold/part-%06lu.parquet", (unsigned long) i);
+    assert(FT_containsFile(arr) == TRUE);
+    assert(FT_containsDir(arr) == FALSE);
+    assert(FT_stat(arr, &bIsFile, &l) == SUCCESS);
+    assert(bIsFile == TRUE && l == i);
+  }
+  assert(FT_containsFile("p/cold/part-000040.parquet") == FALSE);
+  assert(FT_containsFile("p/cold/part-00001.parquet") == FALSE);
+  assert(FT_stat("p/cold/part-000001.parquet/x", &bIsFile, &l)
+         == NO_SUCH_PATH);
+  assert(FT_stat("p/cold", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == FALSE);
+  assert(FT_copyTree("p/cold", "p/copy") == SUCCESS);
+  assert(FT_stat("p/copy/part-000003.parquet", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE && l == 3);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulUnpacked == 0);
+  /* reaching a file's contents unpacks its directory */
+  assert(FT_getFileContents("p/cold/part-000002.parquet") == buf);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 0 && sPack.ulFiles == 0 && sPack.ulBytes == 0);
+  assert(sPack.ulUnpacked == 1);
+  /* and it is packed again once cold again; adding to it unpacks it */
+  for(i = 9; i < 18; i++) {
+    sprintf(arr, "p/warm/part-%06lu.parquet", (unsigned long) i);
+    assert(FT_insertFile(arr, buf, i) == SUCCESS);
+  }
+  FT_setPacking(5);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 1 && sPack.ulPacked == 2);
+  assert(FT_insertFile("p/cold/part-000100.parquet", buf, 100)
+         == SUCCESS);
+  assert(FT_containsFile("p/cold/part-000100.parquet") == TRUE);
+  assert(FT_containsFile("p/copy/part-000100.parquet") == FALSE);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 0 && sPack.ulUnpacked == 2);
+  /* freezing and snapshots need every file's node; the copy, now
+     materialized, is packed too */
+  for(i = 18; i < 27; i++) {
+    sprintf(arr, "p/warm/part-%06lu.parquet", (unsigned long) i);
+    assert(FT_insertFile(arr, buf, i) == SUCCESS);
+  }
+  FT_setPacking(5);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 2 && sPack.ulFiles == 81);
+  assert(FT_freeze(FT_FREEZE_LAYOUT, NULL) == SUCCESS);
+  assert(FT_containsFile("p/cold/part-000100.parquet") == TRUE);
+  assert(FT_thaw() == SUCCESS);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 0 && sPack.ulUnpacked == 4);
+  /* a packed directory is removed whole, and its lazy copy keeps its
+     files */
+  for(i = 27; i < 36; i++) {
+    sprintf(arr, "p/warm/part-%06lu.parquet", (unsigned long) i);
+    assert(FT_insertFile(arr, buf, i) == SUCCESS);
+  }
+  FT_setPacking(5);
+  assert(FT_rmDir("p/copy") == SUCCESS);
+  assert(FT_copyTree("p/cold", "p/copy") == SUCCESS);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 1 && sPack.ulFiles == 41);
+  assert(FT_rmDir("p/cold") == SUCCESS);
+  assert(FT_containsDir("p/cold") == FALSE);
+  assert(FT_stat("p/copy/part-000100.parquet", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE && l == 100);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 1 && sPack.ulUnpacked == 4);
+  assert(FT_rmDir("p/copy") == SUCCESS);
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs == 0 && sPack.ulFiles == 0);
+  free(temp);
+  FT_setPacking(0);
+  assert(FT_destroy() == SUCCESS);
+
+  /* batched stats agree with FT_stat, for every kind of path */
+  assert(FT_statMany(apcStats, 0, FT_PATHS_UNSORTED, asStats)
+         == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  apcStats[0] = "m";
+  assert(FT_statMany(apcStats, 1, FT_PATHS_UNSORTED, asStats)
+         == SUCCESS);
+  assert(asStats[0].iStatus == NO_SUCH_PATH);
+  assert(FT_statMany(apcStats, 1, FT_PATHS_SORTED, asStats) == SUCCESS);
+  assert(asStats[0].iStatus == NO_SUCH_PATH);
+  temp = malloc(48 * 32);
+  assert(temp != NULL);
+  for(i = 0; i < 30; i++) {
+    sprintf(arr, "m/d%lu/f%lu", (unsigned long) (i % 3),
+            (unsigned long) i);
+    assert(FT_insertFile(arr, buf, i) == SUCCESS);
+  }
+  assert(FT_insertDir("m/d1/sub/deeper") == SUCCESS);
+  assert(FT_copyTree("m/d1", "m/lazy") == SUCCESS);
+  /* paths grouped by directory, as sorting groups them, resume their
+     walks from the previous path's, however far that went */
+  for(i = 0; i < 36; i++) {
+    sprintf(temp + 32 * i, "m/d%lu/f%lu", (unsigned long) (i / 12),
+            (unsigned long) (i / 12 + i % 12 * 3));
+    apcStats[i] = temp + 32 * i;
+  }
+  apcStats[36] = "m/d1/sub/deeper";
+  apcStats[37] = "m/d1/sub";
+  apcStats[38] = "m/d1/sub/deeper/x";
+  apcStats[39] = "m/d1/f1/x";
+  apcStats[40] = "m/d1/f13";
+  apcStats[41] = "m/lazy/f1";
+  apcStats[42] = "m/lazy/sub/deeper";
+  apcStats[43] = "m//d0";
+  apcStats[44] = "m/d0";
+  apcStats[45] = "x";
+  apcStats[46] = "m";
+  apcStats[47] = "m/d0";
+  assert(FT_statMany(apcStats, 48, FT_PATHS_SORTED, asStats) == SUCCESS);
+  for(i = 0; i < 48; i++) {
+    size_t ulSize = 0;
+    bIsFile = FALSE;
+    assert(FT_stat(apcStats[i], &bIsFile, &ulSize)
+           == asStats[i].iStatus);
+    assert(asStats[i].bIsFile == bIsFile);
+    assert(asStats[i].ulSize == ulSize);
+  }
+  assert(asStats[0].iStatus == SUCCESS && asStats[0].ulSize == 0);
+  assert(asStats[13].iStatus == SUCCESS && asStats[13].ulSize == 4);
+  assert(asStats[35].iStatus == NO_SUCH_PATH);
+  assert(asStats[36].iStatus == SUCCESS && !asStats[36].bIsFile);
+  assert(asStats[38].iStatus == NO_SUCH_PATH);
+  assert(asStats[39].iStatus == NO_SUCH_PATH);
+  assert(asStats[40].iStatus == SUCCESS && asStats[40].ulSize == 13);
+  assert(asStats[42].iStatus == SUCCESS);
+  assert(asStats[43].iStatus == BAD_PATH);
+  assert(asStats[45].iStatus == CONFLICTING_PATH);
+  assert(asStats[47].iStatus == SUCCESS && !asStats[47].bIsFile);
+  for(i = 0; i < 48; i++) {
+    sprintf(temp + 32 * i, "m/%s%lu/f%lu",
+            i % 4 == 3 ? "lazy" : "d", (unsigned long) (i % 3),
+            (unsigned long) i);
+    apcStats[i] = temp + 32 * i;
+  }
+  strcpy(temp + 32 * 3, "m/lazy/sub/deeper");
+  apcStats[5] = "m/d2/f5/under";
+  apcStats[6] = "m/d0";
+  apcStats[7] = "m";
+  apcStats[8] = "x/d0/f0";
+  apcStats[9] = "m//d0";
+  apcStats[10] = "m/lazy/f1";
+  apcStats[11] = "m/d1/f";
+  for(l = 0; l < 4; l++) {
+    assert(FT_statMany(apcStats, 48, l % 2 ? FT_PATHS_SORTED
+                       : FT_PATHS_UNSORTED, asStats) == SUCCESS);
+    for(i = 0; i < 48; i++) {
+      size_t ulSize = 0;
+      bIsFile = FALSE;
+      assert(FT_stat(apcStats[i], &bIsFile, &ulSize)
+             == asStats[i].iStatus);
+      assert(asStats[i].bIsFile == bIsFile);
+      assert(asStats[i].ulSize == ulSize);
+    }
+    assert(asStats[6].iStatus == SUCCESS && !asStats[6].bIsFile);
+    assert(asStats[8].iStatus == CONFLICTING_PATH);
+    assert(asStats[9].iStatus == BAD_PATH);
+    assert(asStats[10].iStatus == SUCCESS && asStats[10].ulSize == 1);
+    /* then again, with the files of d0 packed */
+    if(l == 1)
+      FT_setPacking(1);
+  }
+  FT_getPackStats(&sPack);
+  assert(sPack.ulDirs != 0 && sPack.ulUnpacked == 0);
+  FT_setPacking(0);
+  assert(FT_freeze(FT_FREEZE_LAYOUT, NULL) == SUCCESS);
+  for(l = 0; l < 2; l++) {
+    assert(FT_statMany(apcStats + 4, 8, l ? FT_PATHS_SORTED
+                       : FT_PATHS_UNSORTED, asStats) == SUCCESS);
+    assert(asStats[2].iStatus == SUCCESS && !asStats[2].bIsFile);
+    assert(asStats[6].iStatus == SUCCESS && asStats[6].ulSize == 1);
+  }
+  assert(FT_thaw() == SUCCESS);
+  free(temp);
+  assert(FT_destroy() == SUCCESS);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,559 @@
+/* Implementation of a parallel scan of a directory hierarchy on disk */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "arena.h"
+#include "importFT.h"
+
+/* An entry of a scanned directory */
+struct importEntry {
+   /* the entry's '\0'-terminated name */
+   char *pcName;
+   /* the number of characters in pcName */
+   size_t ulNameLength;
+   /* the size of the file, or 0 for a directory */
+   size_t ulSize;
+   /* the file's contents, if they were read; otherwise NULL */
+   void *pvContents;
+   /* the scanned directory, or NULL for a file */
+   ImportDir_T oIDir;
+   /* the entry read before this one from the same directory */
+   struct importEntry *psPrev;
+};
+
+/* A scanned directory */
+struct importDir {
+   /* the entries, sorted by name */
+   struct importEntry **ppsEntries;
+   /* the number of entries */
+   size_t ulEntries;
+};
+
+/* A finished scan */
+struct import {
+   /* the directory scanned from */
+   ImportDir_T oIRoot;
+   /* the arenas holding everything scanned, one per thread */
+   Arena_T *poAArenas;
+   /* the number of arenas */
+   size_t ulArenas;
+};
+
+/* A directory waiting to be scanned */
+struct importTask {
+   /* where to put what is scanned */
+   ImportDir_T oIDir;
+   /* the directory's path on disk, which the task owns */
+   char *pcPath;
+};
+
+/* One thread of a scan in progress */
+struct importWorker {
+   /* the scan the thread belongs to */
+   struct importScan *psScan;
+   /* the arena that this thread alone allocates from */
+   Arena_T oAArena;
+   /* protects the queue below */
+   pthread_mutex_t sLock;
+   /* the thread's queue: a circular buffer of ulCapacity tasks, of
+      which ulCount, from index ulFirst, are waiting. The thread takes
+      its newest task, so that it scans depth-first, and others take
+      its oldest, which are likeliest to head large hierarchies. */
+   struct importTask *psTasks;
+   size_t ulCapacity;
+   size_t ulFirst;
+   size_t ulCount;
+   /* the thread, if one was started for this worker */
+   pthread_t sThread;
+   boolean bStarted;
+};
+
+/* A scan in progress */
+struct importScan {
+   /* the workers */
+   struct importWorker *psWorkers;
+   /* the number of workers */
+   size_t ulWorkers;
+   /* TRUE if files' contents are to be read */
+   boolean bContents;
+   /* protects the counters and status below */
+   pthread_mutex_t sLock;
+   /* signalled when a task is queued or the last task is finished */
+   pthread_cond_t sChanged;
+   /* the number of tasks queued, and of tasks queued or running */
+   size_t ulQueued;
+   size_t ulPending;
+   /* SUCCESS, or the first error met */
+   int iStatus;
+};
+
+/*
+  Compares the names of the entries at ppsFirst and ppsSecond, which
+  hold no '\0' before their ends, in the order used for nodes' names.
+*/
+static int Import_compareEntries(const void *ppsFirst,
+                                 const void *ppsSecond) {
+   return strcmp((*(struct importEntry * const *) ppsFirst)->pcName,
+                 (*(struct importEntry * const *) ppsSecond)->pcName);
+}
+
+/* Records iStatus as psScan's result, unless an error came first. */
+static void Import_fail(struct importScan *psScan, int iStatus) {
+   assert(psScan != NULL);
+   pthread_mutex_lock(&psScan->sLock);
+   if(psScan->iStatus == SUCCESS)
+      psScan->iStatus = iStatus;
+   pthread_mutex_unlock(&psScan->sLock);
+}
+
+/*
+  Queues the directory at pcPath, which the queue takes over, to be
+  scanned into oIDir, on psWorker's queue. Returns SUCCESS, or
+  MEMORY_ERROR (freeing pcPath) if the queue could not grow.
+*/
+static int Import_push(struct importWorker *psWorker, ImportDir_T oIDir,
+                       char *pcPath) {
+   struct importScan *psScan;
+   struct importTask *psGrown;
+   size_t ulIndex;
+   assert(psWorker != NULL);
+   assert(oIDir != NULL);
+   assert(pcPath != NULL);
+   psScan = psWorker->psScan;
+   /* count the task first, so that no thread finishes meanwhile */
+   pthread_mutex_lock(&psScan->sLock);
+   psScan->ulQueued++;
+   psScan->ulPending++;
+   pthread_mutex_unlock(&psScan->sLock);
+
+   pthread_mutex_lock(&psWorker->sLock);
+   if(psWorker->ulCount == psWorker->ulCapacity) {
+      psGrown = malloc(2 * psWorker->ulCapacity *
+                       sizeof(struct importTask));
+      if(psGrown == NULL) {
+         pthread_mutex_unlock(&psWorker->sLock);
+         free(pcPath);
+         pthread_mutex_lock(&psScan->sLock);
+         psScan->ulQueued--;
+         psScan->ulPending--;
+         if(psScan->iStatus == SUCCESS)
+            psScan->iStatus = MEMORY_ERROR;
+         pthread_cond_broadcast(&psScan->sChanged);
+         pthread_mutex_unlock(&psScan->sLock);
+         return MEMORY_ERROR;
+      }
+      for(ulIndex = 0; ulIndex < psWorker->ulCount; ulIndex++)
+         psGrown[ulIndex] = psWorker->psTasks[(psWorker->ulFirst + ulIndex)
+                                              % psWorker->ulCapacity];
+      free(psWorker->psTasks);
+      psWorker->psTasks = psGrown;
+      psWorker->ulFirst = 0;
+      psWorker->ulCapacity *= 2;
+   }
+   ulIndex = (psWorker->ulFirst + psWorker->ulCount) %
+             psWorker->ulCapacity;
+   psWorker->psTasks[ulIndex].oIDir = oIDir;
+   psWorker->psTasks[ulIndex].pcPath = pcPath;
+   psWorker->ulCount++;
+   pthread_mutex_unlock(&psWorker->sLock);
+   pthread_cond_signal(&psScan->sChanged);
+   return SUCCESS;
+}
+
+/*
+  Takes a task from psVictim's queue into *psTask: the newest if
+  bOwn is TRUE, and the oldest otherwise. Returns TRUE if there was
+  one, and FALSE otherwise.
+*/
+static boolean Import_takeFrom(struct importWorker *psVictim,
+                               boolean bOwn,
+                               struct importTask *psTask) {
+   size_t ulIndex;
+   assert(psVictim != NULL);
+   assert(psTask != NULL);
+   pthread_mutex_lock(&psVictim->sLock);
+   if(psVictim->ulCount == 0) {
+      pthread_mutex_unlock(&psVictim->sLock);
+      return FALSE;
+   }
+   if(bOwn)
+      ulIndex = (psVictim->ulFirst + psVictim->ulCount - 1) %
+                psVictim->ulCapacity;
+   else {
+      ulIndex = psVictim->ulFirst;
+      psVictim->ulFirst = (psVictim->ulFirst + 1) %
+                          psVictim->ulCapacity;
+   }
+   *psTask = psVictim->psTasks[ulIndex];
+   psVictim->ulCount--;
+   pthread_mutex_unlock(&psVictim->sLock);
+   return TRUE;
+}
+
+/*
+  Reads the ulSize bytes of file pcName in the directory open on
+  iDirFd into a block from oAArena, and stores it in *ppvResult.
+  Returns SUCCESS, or MEMORY_ERROR if the block could not be allocated
+  or the bytes could not all be read.
+*/
+static int Import_readFile(int iDirFd, const char *pcName,
+                           size_t ulSize, Arena_T oAArena,
+                           void **ppvResult) {
+   char *pcBytes;
+   size_t ulDone = 0;
+   ssize_t lRead;
+   int iFd;
+   assert(pcName != NULL);
+   assert(ppvResult != NULL);
+   pcBytes = Arena_alloc(oAArena, ulSize);
+   if(pcBytes == NULL)
+      return MEMORY_ERROR;
+   iFd = openat(iDirFd, pcName, O_RDONLY);
+   if(iFd < 0)
+      return MEMORY_ERROR;
+   while(ulDone < ulSize) {
+      lRead = read(iFd, pcBytes + ulDone, ulSize - ulDone);
+      if(lRead <= 0)
+         break;
+      ulDone += (size_t) lRead;
+   }
+   (void) close(iFd);
+   if(ulDone < ulSize)
+      return MEMORY_ERROR;
+   *ppvResult = pcBytes;
+   return SUCCESS;
+}
+
+/*
+  Scans the directory of psTask into its ImportDir_T, allocating from
+  psWorker's arena, and queues each subdirectory on psWorker's queue.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated or
+  the directory or a file in it could not be read.
+*/
+static int Import_scanDir(struct importWorker *psWorker,
+                          const struct importTask *psTask) {
+   DIR *psDir;
+   struct dirent *psDirEntry;
+   struct stat sStat;
+   struct importEntry *psEntry;
+   struct importEntry *psLast = NULL;
+   ImportDir_T oIDir;
+   Arena_T oAArena;
+   size_t ulPathLength;
+   size_t ulNameLength;
+   size_t ulIndex;
+   char *pcSubPath;
+   int iDirFd;
+   int iStatus = SUCCESS;
+   assert(psWorker != NULL);
+   assert(psTask != NULL);
+   oIDir = psTask->oIDir;
+   oAArena = psWorker->oAArena;
+   psDir = opendir(psTask->pcPath);
+   if(psDir == NULL)
+      return MEMORY_ERROR;
+   iDirFd = dirfd(psDir);
+   ulPathLength = strlen(psTask->pcPath);
+   for(;;) {
+      errno = 0;
+      psDirEntry = readdir(psDir);
+      if(psDirEntry == NULL) {
+         if(errno != 0)
+            iStatus = MEMORY_ERROR;
+         break;
+      }
+      if(!strcmp(psDirEntry->d_name, ".") ||
+         !strcmp(psDirEntry->d_name, ".."))
+         continue;
+      if(fstatat(iDirFd, psDirEntry->d_name, &sStat,
+                 AT_SYMLINK_NOFOLLOW) != 0) {
+         /* an entry removed since it was listed is just left out */
+         if(errno == ENOENT)
+            continue;
+         iStatus = MEMORY_ERROR;
+         break;
+      }
+      if(!S_ISDIR(sStat.st_mode) && !S_ISREG(sStat.st_mode))
+         continue;
+      ulNameLength = strlen(psDirEntry->d_name);
+      psEntry = Arena_alloc(oAArena, sizeof(struct importEntry) +
+                            ulNameLength + 1);
+      if(psEntry == NULL) {
+         iStatus = MEMORY_ERROR;
+         break;
+      }
+      psEntry->pcName = (char *) (psEntry + 1);
+      memcpy(psEntry->pcName, psDirEntry->d_name, ulNameLength + 1);
+      psEntry->ulNameLength = ulNameLength;
+      psEntry->ulSize = 0;
+      psEntry->pvContents = NULL;
+      psEntry->oIDir = NULL;
+      if(S_ISDIR(sStat.st_mode)) {
+         psEntry->oIDir = Arena_alloc(oAArena, sizeof(struct importDir));
+         pcSubPath = malloc(ulPathLength + ulNameLength + 2);
+         if(psEntry->oIDir == NULL || pcSubPath == NULL) {
+            free(pcSubPath);
+            iStatus = MEMORY_ERROR;
+            break;
+         }
+         psEntry->oIDir->ppsEntries = NULL;
+         psEntry->oIDir->ulEntries = 0;
+         memcpy(pcSubPath, psTask->pcPath, ulPathLength);
+         pcSubPath[ulPathLength] = '/';
+         memcpy(pcSubPath + ulPathLength + 1, psEntry->pcName,
+                ulNameLength + 1);
+         iStatus = Import_push(psWorker, psEntry->oIDir, pcSubPath);
+      }
+      else {
+         psEntry->ulSize = (size_t) sStat.st_size;
+         if(psWorker->psScan->bContents && psEntry->ulSize != 0)
+            iStatus = Import_readFile(iDirFd, psEntry->pcName,
+                                      psEntry->ulSize, oAArena,
+                                      &psEntry->pvContents);
+      }
+      if(iStatus != SUCCESS)
+         break;
+      psEntry->psPrev = psLast;
+      psLast = psEntry;
+      oIDir->ulEntries++;
+   }
+   (void) closedir(psDir);
+   if(iStatus != SUCCESS || oIDir->ulEntries == 0)
+      return iStatus;
+
+   /* gather the entries up and sort them as the nodes will be */
+   oIDir->ppsEntries = Arena_alloc(oAArena, oIDir->ulEntries *
+                                   sizeof(struct importEntry *));
+   if(oIDir->ppsEntries == NULL)
+      return MEMORY_ERROR;
+   ulIndex = oIDir->ulEntries;
+   for(psEntry = psLast; psEntry != NULL; psEntry = psEntry->psPrev)
+      oIDir->ppsEntries[--ulIndex] = psEntry;
+   qsort(oIDir->ppsEntries, oIDir->ulEntries,
+         sizeof(struct importEntry *), Import_compareEntries);
+   return SUCCESS;
+}
+
+/*
+  Runs worker pvWorker until every directory of its scan has been
+  scanned: takes tasks from its own queue, or when that is empty from
+  the other workers' queues, and waits when there are none to take.
+  Once an error has been met, the remaining tasks are taken but not
+  run.
+*/
+static void *Import_work(void *pvWorker) {
+   struct importWorker *psWorker = pvWorker;
+   struct importScan *psScan;
+   struct importTask sTask;
+   size_t ulVictim;
+   boolean bTaken;
+   int iStatus;
+   assert(psWorker != NULL);
+   psScan = psWorker->psScan;
+   for(;;) {
+      bTaken = Import_takeFrom(psWorker, TRUE, &sTask);
+      for(ulVictim = 0; !bTaken && ulVictim < psScan->ulWorkers;
+          ulVictim++)
+         if(&psScan->psWorkers[ulVictim] != psWorker)
+            bTaken = Import_takeFrom(&psScan->psWorkers[ulVictim],
+                                     FALSE, &sTask);
+      pthread_mutex_lock(&psScan->sLock);
+      if(!bTaken) {
+         /* nothing to take: wait for more, or for the end */
+         while(psScan->ulQueued == 0 && psScan->ulPending != 0)
+            pthread_cond_wait(&psScan->sChanged, &psScan->sLock);
+         if(psScan->ulPending == 0) {
+            pthread_mutex_unlock(&psScan->sLock);
+            return NULL;
+         }
+         pthread_mutex_unlock(&psScan->sLock);
+         continue;
+      }
+      psScan->ulQueued--;
+      iStatus = psScan->iStatus;
+      pthread_mutex_unlock(&psScan->sLock);
+
+      if(iStatus == SUCCESS) {
+         iStatus = Import_scanDir(psWorker, &sTask);
+         if(iStatus != SUCCESS)
+            Import_fail(psScan, iStatus);
+      }
+      free(sTask.pcPath);
+      pthread_mutex_lock(&psScan->sLock);
+      if(--psScan->ulPending == 0)
+         pthread_cond_broadcast(&psScan->sChanged);
+      pthread_mutex_unlock(&psScan->sLock);
+   }
+}
+
+/* see importFT.h for specification */
+int Import_scan(const char *pcFsRoot, size_t ulThreads,
+                boolean bContents, Import_T *poIResult) {
+   struct importScan sScan;
+   struct importWorker *psWorker;
+   struct stat sStat;
+   Import_T oIImport;
+   char *pcPath;
+   size_t ulIndex;
+   long lProcessors;
+   int iStatus = SUCCESS;
+   assert(pcFsRoot != NULL);
+   assert(poIResult != NULL);
+   *poIResult = NULL;
+   if(stat(pcFsRoot, &sStat) != 0)
+      return NO_SUCH_PATH;
+   if(!S_ISDIR(sStat.st_mode))
+      return NOT_A_DIRECTORY;
+   if(ulThreads == 0) {
+      lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+      ulThreads = lProcessors > 0 ? (size_t) lProcessors : 1;
+   }
+
+   /* the finished scan keeps the workers' arenas */
+   oIImport = malloc(sizeof(struct import));
+   if(oIImport == NULL)
+      return MEMORY_ERROR;
+   oIImport->poAArenas = calloc(ulThreads, sizeof(Arena_T));
+   oIImport->ulArenas = ulThreads;
+   sScan.psWorkers = calloc(ulThreads, sizeof(struct importWorker));
+   if(oIImport->poAArenas == NULL || sScan.psWorkers == NULL) {
+      free(sScan.psWorkers);
+      oIImport->ulArenas = 0;
+      Import_free(oIImport);
+      return MEMORY_ERROR;
+   }
+   sScan.ulWorkers = ulThreads;
+   sScan.bContents = bContents;
+   sScan.ulQueued = 0;
+   sScan.ulPending = 0;
+   sScan.iStatus = SUCCESS;
+   pthread_mutex_init(&sScan.sLock, NULL);
+   pthread_cond_init(&sScan.sChanged, NULL);
+   for(ulIndex = 0; ulIndex < ulThreads; ulIndex++) {
+      psWorker = &sScan.psWorkers[ulIndex];
+      psWorker->psScan = &sScan;
+      psWorker->oAArena = Arena_new();
+      oIImport->poAArenas[ulIndex] = psWorker->oAArena;
+      psWorker->ulCapacity = 16;
+      psWorker->psTasks = malloc(psWorker->ulCapacity *
+                                 sizeof(struct importTask));
+      psWorker->ulFirst = 0;
+      psWorker->ulCount = 0;
+      psWorker->bStarted = FALSE;
+      pthread_mutex_init(&psWorker->sLock, NULL);
+      if(psWorker->oAArena == NULL || psWorker->psTasks == NULL)
+         iStatus = MEMORY_ERROR;
+   }
+
+   /* seed the first worker's queue with the root */
+   if(iStatus == SUCCESS) {
+      oIImport->oIRoot = Arena_alloc(sScan.psWorkers[0].oAArena,
+                                     sizeof(struct importDir));
+      pcPath = malloc(strlen(pcFsRoot) + 1);
+      if(oIImport->oIRoot == NULL || pcPath == NULL) {
+         free(pcPath);
+         iStatus = MEMORY_ERROR;
+      }
+      else {
+         oIImport->oIRoot->ppsEntries = NULL;
+         oIImport->oIRoot->ulEntries = 0;
+         strcpy(pcPath, pcFsRoot);
+         iStatus = Import_push(&sScan.psWorkers[0], oIImport->oIRoot,
+                               pcPath);
+      }
+   }
+   if(iStatus == SUCCESS) {
+      /* this thread is the first worker; any threads that cannot be
+         started leave the work to the others */
+      for(ulIndex = 1; ulIndex < ulThreads; ulIndex++) {
+         psWorker = &sScan.psWorkers[ulIndex];
+         psWorker->bStarted = (boolean)
+            (pthread_create(&psWorker->sThread, NULL, Import_work,
+                            psWorker) == 0);
+      }
+      (void) Import_work(&sScan.psWorkers[0]);
+      for(ulIndex = 1; ulIndex < ulThreads; ulIndex++)
+         if(sScan.psWorkers[ulIndex].bStarted)
+            pthread_join(sScan.psWorkers[ulIndex].sThread, NULL);
+      iStatus = sScan.iStatus;
+   }
+
+   for(ulIndex = 0; ulIndex < ulThreads; ulIndex++) {
+      psWorker = &sScan.psWorkers[ulIndex];
+      assert(psWorker->ulCount == 0);
+      free(psWorker->psTasks);
+      pthread_mutex_destroy(&psWorker->sLock);
+   }
+   pthread_cond_destroy(&sScan.sChanged);
+   pthread_mutex_destroy(&sScan.sLock);
+   free(sScan.psWorkers);
+   if(iStatus != SUCCESS) {
+      Import_free(oIImport);
+      return iStatus;
+   }
+   *poIResult = oIImport;
+   return SUCCESS;
+}
+
+/* see importFT.h for specification */
+void Import_free(Import_T oIImport) {
+   size_t ulIndex;
+   if(oIImport == NULL)
+      return;
+   for(ulIndex = 0; ulIndex < oIImport->ulArenas; ulIndex++)
+      if(oIImport->poAArenas[ulIndex] != NULL)
+         Arena_free(oIImport->poAArenas[ulIndex]);
+   free(oIImport->poAArenas);
+   free(oIImport);
+}
+
+/* see importFT.h for specification */
+ImportDir_T Import_getRoot(Import_T oIImport) {
+   assert(oIImport != NULL);
+   return oIImport->oIRoot;
+}
+
+/* see importFT.h for specification */
+size_t ImportDir_getNumEntries(ImportDir_T oIDir) {
+   assert(oIDir != NULL);
+   return oIDir->ulEntries;
+}
+
+/* see importFT.h for specification */
+const char *ImportDir_getName(ImportDir_T oIDir, size_t ulIndex,
+                              size_t *pulLength) {
+   assert(oIDir != NULL);
+   assert(ulIndex < oIDir->ulEntries);
+   assert(pulLength != NULL);
+   *pulLength = oIDir->ppsEntries[ulIndex]->ulNameLength;
+   return oIDir->ppsEntries[ulIndex]->pcName;
+}
+
+/* see importFT.h for specification */
+ImportDir_T ImportDir_getSubdir(ImportDir_T oIDir, size_t ulIndex) {
+   assert(oIDir != NULL);
+   assert(ulIndex < oIDir->ulEntries);
+   return oIDir->ppsEntries[ulIndex]->oIDir;
+}
+
+/* see importFT.h for specification */
+size_t ImportDir_getSize(ImportDir_T oIDir, size_t ulIndex) {
+   assert(oIDir != NULL);
+   assert(ulIndex < oIDir->ulEntries);
+   return oIDir->ppsEntries[ulIndex]->ulSize;
+}
+
+/* see importFT.h for specification */
+const void *ImportDir_getContents(ImportDir_T oIDir, size_t ulIndex) {
+   assert(oIDir != NULL);
+   assert(ulIndex < oIDir->ulEntries);
+   return oIDir->ppsEntries[ulIndex]->pvContents;
+}
@@ -0,0 +1,74 @@
+/*--------------------------------------------------------------------*/
+/* importFT.h                                                         */
+/*--------------------------------------------------------------------*/
+#ifndef IMPORT_INCLUDED
+#define IMPORT_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  An Import_T is a scan of a directory hierarchy on disk: the names,
+  types and sizes (and optionally the contents) of everything in it,
+  held in memory so that the hierarchy can be built into an FT in bulk
+  without any further system calls.
+*/
+typedef struct import *Import_T;
+
+/*
+  An ImportDir_T is one directory of an Import_T. Its entries, its
+  files and subdirectories, are sorted by name as the children of a
+  node are.
+*/
+typedef struct importDir *ImportDir_T;
+
+/*
+  Scans the directory hierarchy on disk rooted at directory pcFsRoot
+  with ulThreads threads (or one per processor, if ulThreads is 0)
+  and stores the scan in *poIResult. Each thread scans directories
+  from a queue of its own, into memory of its own, and a thread whose
+  queue runs dry takes directories from the others', so that no
+  thread idles while any directory is waiting to be scanned. Only
+  directories and regular files are scanned: symbolic links are not
+  followed, and other kinds of file are left out. If bContents is
+  TRUE, the contents of each file are read too.
+  Returns SUCCESS, or otherwise sets *poIResult to NULL and returns:
+  * NO_SUCH_PATH if pcFsRoot does not exist
+  * NOT_A_DIRECTORY if pcFsRoot is not a directory
+  * MEMORY_ERROR if memory could not be allocated, or a directory or
+                 file below pcFsRoot could not be read
+*/
+int Import_scan(const char *pcFsRoot, size_t ulThreads,
+                boolean bContents, Import_T *poIResult);
+
+/* Frees oIImport and everything scanned into it. */
+void Import_free(Import_T oIImport);
+
+/* Returns the directory that oIImport scanned from. */
+ImportDir_T Import_getRoot(Import_T oIImport);
+
+/* Returns the number of entries in oIDir. */
+size_t ImportDir_getNumEntries(ImportDir_T oIDir);
+
+/*
+  Returns the '\0'-terminated name of oIDir's entry ulIndex, and
+  stores its length in *pulLength.
+*/
+const char *ImportDir_getName(ImportDir_T oIDir, size_t ulIndex,
+                              size_t *pulLength);
+
+/*
+  Returns the directory that is oIDir's entry ulIndex, or NULL if that
+  entry is a file.
+*/
+ImportDir_T ImportDir_getSubdir(ImportDir_T oIDir, size_t ulIndex);
+
+/* Returns the size of the file that is oIDir's entry ulIndex. */
+size_t ImportDir_getSize(ImportDir_T oIDir, size_t ulIndex);
+
+/*
+  Returns the contents of the file that is oIDir's entry ulIndex, or
+  NULL if they were not read or it is empty. They stay valid until
+  the Import_T holding oIDir is freed.
+*/
+const void *ImportDir_getContents(ImportDir_T oIDir, size_t ulIndex);
+#endif
@@ -0,0 +1,197 @@
+/*--------------------------------------------------------------------*/
+/* lookup_bench.c                                                     */
+/* Benchmark of the time and cache misses of lookups by path, one by  */
+/* one and batched, in a random and in sorted order                   */
+/*--------------------------------------------------------------------*/
+
+/* for syscall, to open a hardware counter */
+#define _GNU_SOURCE
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "ft.h"
+
+/* Tree parameters: NUM_FILES files, FILES_PER_DIR per directory and
+   DIRS_PER_TOP directories per top-level directory */
+enum { NUM_FILES = 409600, FILES_PER_DIR = 256, DIRS_PER_TOP = 40,
+       NUM_LOOKUPS = 4000000, MAX_PATH_LEN = 64, MAX_BATCH = 256 };
+
+/* Returns a scrambling of ulValue, so that siblings' names do not
+   share long prefixes. */
+static unsigned long LookupBench_scramble(size_t ulValue) {
+   unsigned long ulHash = (unsigned long) ulValue * 2654435761UL;
+   return (ulHash ^ (ulHash >> 15)) & 0xFFFFFFFFUL;
+}
+
+/* Writes to pcPath the path of file ulIndex. */
+static void LookupBench_path(char *pcPath, size_t ulIndex) {
+   size_t ulDir = ulIndex / FILES_PER_DIR;
+   assert(pcPath != NULL);
+   sprintf(pcPath, "data/top%02lu/%08lx/%08lx.dat",
+           (unsigned long) (ulDir / DIRS_PER_TOP),
+           LookupBench_scramble(ulDir), LookupBench_scramble(ulIndex));
+}
+
+/*
+  Opens a counter of the cache misses of this process in user mode,
+  and returns its descriptor, or -1 if the platform or the kernel
+  does not offer one.
+*/
+static int LookupBench_openCounter(void) {
+#ifdef __linux__
+   struct perf_event_attr sAttr;
+   memset(&sAttr, 0, sizeof(sAttr));
+   sAttr.size = sizeof(sAttr);
+   sAttr.type = PERF_TYPE_HARDWARE;
+   sAttr.config = PERF_COUNT_HW_CACHE_MISSES;
+   sAttr.exclude_kernel = 1;
+   sAttr.exclude_hv = 1;
+   return (int) syscall(__NR_perf_event_open, &sAttr, 0, -1, -1, 0);
+#else
+   return -1;
+#endif
+}
+
+/* Returns the count of counter iCounter, or 0 if it is -1. */
+static uint64_t LookupBench_readCounter(int iCounter) {
+   uint64_t ulCount = 0;
+#ifdef __linux__
+   if(iCounter >= 0 &&
+      read(iCounter, &ulCount, sizeof(ulCount)) != sizeof(ulCount))
+      ulCount = 0;
+#endif
+   return ulCount;
+}
+
+/* Compares the paths that pvFirst and pvSecond point to, for qsort. */
+static int LookupBench_compare(const void *pvFirst, const void *pvSecond) {
+   return strcmp(*(const char *const *) pvFirst,
+                 *(const char *const *) pvSecond);
+}
+
+/*
+  Times NUM_LOOKUPS stats of the paths in apcPaths, by FT_statMany in
+  batches of ulBatch, told that they are in order eOrder, if ulBatch
+  is not 0 and by FT_stat otherwise, checking each size, and prints
+  the nanoseconds and, if iCounter is not -1, the cache misses per
+  lookup. Returns FALSE if a lookup is wrong.
+*/
+static boolean LookupBench_run(const char **apcPaths, size_t ulBatch,
+                               enum pathOrder eOrder, int iCounter) {
+   static struct statResult asResults[MAX_BATCH];
+   clock_t tStart;
+   double dTime;
+   uint64_t ulMisses;
+   size_t ulSize = 0;
+   size_t i, j;
+   boolean bIsFile;
+   assert(ulBatch <= MAX_BATCH);
+   assert(NUM_FILES % MAX_BATCH == 0 && NUM_LOOKUPS % MAX_BATCH == 0);
+   ulMisses = LookupBench_readCounter(iCounter);
+   tStart = clock();
+   if(ulBatch == 0) {
+      for(i = 0; i < NUM_LOOKUPS; i++)
+         if(FT_stat(apcPaths[i % NUM_FILES], &bIsFile, &ulSize)
+            != SUCCESS || ulSize != strlen(apcPaths[i % NUM_FILES]))
+            return FALSE;
+   }
+   else
+      for(i = 0; i < NUM_LOOKUPS; i += ulBatch) {
+         if(FT_statMany(apcPaths + i % NUM_FILES, ulBatch, eOrder,
+                        asResults) != SUCCESS)
+            return FALSE;
+         for(j = 0; j < ulBatch; j++)
+            if(asResults[j].iStatus != SUCCESS || asResults[j].ulSize
+               != strlen(apcPaths[(i + j) % NUM_FILES]))
+               return FALSE;
+      }
+   dTime = (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e9
+      / NUM_LOOKUPS;
+   ulMisses = LookupBench_readCounter(iCounter) - ulMisses;
+   if(ulBatch == 0)
+      printf("FT_stat:                    %7.1f ns", dTime);
+   else
+      printf("FT_statMany by %3lu%s: %7.1f ns", (unsigned long) ulBatch,
+             eOrder == FT_PATHS_SORTED ? ", sorted" : "        ", dTime);
+   if(iCounter >= 0)
+      printf("   %6.2f cache misses", (double) ulMisses / NUM_LOOKUPS);
+   printf(" per lookup\n");
+   return TRUE;
+}
+
+/*
+  Builds a tree of NUM_FILES files and stats them in a random order,
+  one by one and in batches of several sizes, and then in sorted
+  order, one by one and in batches with and without the sorted mode,
+  reporting the nanoseconds and, where a hardware counter is
+  available, the cache misses per lookup. Returns 0, or EXIT_FAILURE
+  if memory could not be allocated or a lookup is wrong.
+*/
+int main(void) {
+   static const size_t aulBatches[] = { 0, 32, 64, 256 };
+   static char *apcPaths[NUM_FILES];
+   int iCounter;
+   char *pcSwap;
+   size_t i, j;
+
+   srand(217);
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < NUM_FILES; i++) {
+      apcPaths[i] = malloc(MAX_PATH_LEN);
+      if(apcPaths[i] == NULL) {
+         fprintf(stderr, "out of memory\n");
+         return EXIT_FAILURE;
+      }
+      LookupBench_path(apcPaths[i], i);
+      /* each file's size is its path's length, for checking */
+      if(FT_insertFile(apcPaths[i], apcPaths[i], strlen(apcPaths[i]))
+         != SUCCESS)
+         return EXIT_FAILURE;
+   }
+   for(i = NUM_FILES - 1; i > 0; i--) {
+      j = (size_t) rand() % (i + 1);
+      pcSwap = apcPaths[i];
+      apcPaths[i] = apcPaths[j];
+      apcPaths[j] = pcSwap;
+   }
+
+   iCounter = LookupBench_openCounter();
+   printf("%lu files, %lu per directory, %lu lookups\n",
+          (unsigned long) NUM_FILES, (unsigned long) FILES_PER_DIR,
+          (unsigned long) NUM_LOOKUPS);
+   if(iCounter < 0)
+      printf("cache misses unavailable (no hardware counter)\n");
+   for(i = 0; i < sizeof(aulBatches) / sizeof(aulBatches[0]); i++)
+      if(!LookupBench_run((const char **) apcPaths, aulBatches[i],
+                          FT_PATHS_UNSORTED, iCounter))
+         return EXIT_FAILURE;
+
+   printf("sorted:\n");
+   qsort(apcPaths, NUM_FILES, sizeof(apcPaths[0]), LookupBench_compare);
+   if(!LookupBench_run((const char **) apcPaths, 0, FT_PATHS_UNSORTED,
+                       iCounter) ||
+      !LookupBench_run((const char **) apcPaths, MAX_BATCH,
+                       FT_PATHS_UNSORTED, iCounter) ||
+      !LookupBench_run((const char **) apcPaths, MAX_BATCH,
+                       FT_PATHS_SORTED, iCounter))
+      return EXIT_FAILURE;
+
+#ifdef __linux__
+   if(iCounter >= 0)
+      (void) close(iCounter);
+#endif
+   for(i = 0; i < NUM_FILES; i++)
+      free(apcPaths[i]);
+   (void) FT_destroy();
+   return 0;
+}
@@ -0,0 +1,262 @@
+/* Implementation of a minimal perfect hash function, found bucket by
+   bucket from the largest, each with a pilot searched for in turn */
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include "mphFT.h"
+
+/* Parameters of the search: about BUCKET_SIZE hashes per bucket, a
+   bucket's pilots tried up to PILOT_TRIES times the number of hashes,
+   and up to NUM_SEEDS seeds tried before giving up */
+enum { BUCKET_SIZE = 4, PILOT_TRIES = 64, NUM_SEEDS = 8 };
+
+/* Odd multipliers for the mixing of hashes */
+#define MPH_MUL1 ((size_t) 0xBF58476D1CE4E5B9UL)
+#define MPH_MUL2 ((size_t) 0x94D049BB133111EBUL)
+
+/* A minimal perfect hash function */
+struct mph {
+   /* the number of hashes, and so of slots */
+   size_t ulCount;
+   /* the number of buckets */
+   size_t ulBuckets;
+   /* the seed that all of the buckets' pilots work for */
+   size_t ulSeed;
+   /* each bucket's pilot */
+   unsigned int *auiPilots;
+};
+
+/* Returns ulHash with its bits mixed, so that neighbouring hashes give
+   unrelated results. */
+static size_t Mph_mix(size_t ulHash) {
+   ulHash ^= ulHash >> (sizeof(size_t) * 4);
+   ulHash *= MPH_MUL1;
+   ulHash ^= ulHash >> (sizeof(size_t) * 4);
+   ulHash *= MPH_MUL2;
+   ulHash ^= ulHash >> (sizeof(size_t) * 4);
+   return ulHash;
+}
+
+/* Returns the bucket of ulHash in oMHash. */
+static size_t Mph_bucket(Mph_T oMHash, size_t ulHash) {
+   assert(oMHash != NULL);
+   return Mph_mix(ulHash ^ oMHash->ulSeed) % oMHash->ulBuckets;
+}
+
+/* Returns the slot of ulHash in oMHash when its bucket's pilot is
+   uiPilot. */
+static size_t Mph_slot(Mph_T oMHash, size_t ulHash,
+                       unsigned int uiPilot) {
+   assert(oMHash != NULL);
+   return Mph_mix(ulHash ^ Mph_mix((size_t) uiPilot + oMHash->ulSeed))
+      % oMHash->ulCount;
+}
+
+/*
+  Searches for a pilot for the ulSize hashes at pulHashes that moves
+  each to a slot not yet marked in pcTaken, and marks them, using
+  pulSlots for the ulSize slots tried. Returns TRUE and sets *puiPilot
+  to the pilot if one is found, or FALSE (marking nothing) if not.
+*/
+static boolean Mph_findPilot(Mph_T oMHash, const size_t *pulHashes,
+                             size_t ulSize, char *pcTaken,
+                             size_t *pulSlots, unsigned int *puiPilot) {
+   unsigned int uiPilot;
+   size_t ulTries;
+   size_t i;
+   assert(oMHash != NULL);
+   assert(pcTaken != NULL);
+   assert(pulSlots != NULL);
+   assert(puiPilot != NULL);
+   ulTries = PILOT_TRIES * oMHash->ulCount;
+   if(ulTries > UINT_MAX)
+      ulTries = UINT_MAX;
+   for(uiPilot = 0; uiPilot < ulTries; uiPilot++) {
+      /* hashes of the bucket must not share a slot either */
+      for(i = 0; i < ulSize; i++) {
+         pulSlots[i] = Mph_slot(oMHash, pulHashes[i], uiPilot);
+         if(pcTaken[pulSlots[i]])
+            break;
+         pcTaken[pulSlots[i]] = 1;
+      }
+      if(i == ulSize) {
+         *puiPilot = uiPilot;
+         return TRUE;
+      }
+      while(i > 0)
+         pcTaken[pulSlots[--i]] = 0;
+   }
+   return FALSE;
+}
+
+/*
+  Tries to find a pilot for each of oMHash's buckets with its current
+  seed, where the hashes of bucket b are at pulSorted[pulStarts[b]]
+  up to pulSorted[pulStarts[b + 1]], and pulOrder lists the buckets
+  from the largest. Uses pcTaken (as many chars as hashes) and
+  pulSlots (as many as the largest bucket's hashes) for its search.
+  Returns TRUE if every bucket got one, and FALSE otherwise.
+*/
+static boolean Mph_place(Mph_T oMHash, const size_t *pulSorted,
+                         const size_t *pulStarts, const size_t *pulOrder,
+                         char *pcTaken, size_t *pulSlots) {
+   size_t ulBucket;
+   size_t i;
+   assert(oMHash != NULL);
+   for(i = 0; i < oMHash->ulCount; i++)
+      pcTaken[i] = 0;
+   for(i = 0; i < oMHash->ulBuckets; i++) {
+      ulBucket = pulOrder[i];
+      if(!Mph_findPilot(oMHash, pulSorted + pulStarts[ulBucket],
+                        pulStarts[ulBucket + 1] - pulStarts[ulBucket],
+                        pcTaken, pulSlots,
+                        &oMHash->auiPilots[ulBucket]))
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+  Groups the ulCount hashes at pulHashes by oMHash's buckets for its
+  current seed into pulSorted, setting pulStarts[b] to where bucket b
+  starts (and pulStarts[ulBuckets] to ulCount), and lists the buckets
+  from the largest in pulOrder, using pulSizes (one more than the
+  number of hashes) to count them. Sets *pulMaxSize to the number of
+  hashes in the largest bucket. Returns FALSE if two hashes are equal,
+  and TRUE otherwise.
+*/
+static boolean Mph_group(Mph_T oMHash, const size_t *pulHashes,
+                         size_t *pulSorted, size_t *pulStarts,
+                         size_t *pulOrder, size_t *pulSizes,
+                         size_t *pulMaxSize) {
+   size_t ulBucket;
+   size_t ulSize;
+   size_t ulNext;
+   size_t i;
+   size_t j;
+   assert(oMHash != NULL);
+   assert(pulMaxSize != NULL);
+
+   /* a counting sort of the hashes by bucket */
+   for(i = 0; i <= oMHash->ulBuckets; i++)
+      pulStarts[i] = 0;
+   for(i = 0; i < oMHash->ulCount; i++)
+      pulStarts[Mph_bucket(oMHash, pulHashes[i]) + 1]++;
+   for(i = 0; i < oMHash->ulBuckets; i++)
+      pulStarts[i + 1] += pulStarts[i];
+   for(i = 0; i < oMHash->ulCount; i++) {
+      /* each bucket's start moves on to its next free place */
+      ulBucket = Mph_bucket(oMHash, pulHashes[i]);
+      pulSorted[pulStarts[ulBucket]++] = pulHashes[i];
+   }
+   for(i = oMHash->ulBuckets; i > 0; i--)
+      pulStarts[i] = pulStarts[i - 1];
+   pulStarts[0] = 0;
+
+   /* equal hashes always share a bucket */
+   *pulMaxSize = 0;
+   for(ulBucket = 0; ulBucket < oMHash->ulBuckets; ulBucket++) {
+      for(i = pulStarts[ulBucket]; i < pulStarts[ulBucket + 1]; i++)
+         for(j = i + 1; j < pulStarts[ulBucket + 1]; j++)
+            if(pulSorted[i] == pulSorted[j])
+               return FALSE;
+      ulSize = pulStarts[ulBucket + 1] - pulStarts[ulBucket];
+      if(ulSize > *pulMaxSize)
+         *pulMaxSize = ulSize;
+   }
+
+   /* a counting sort of the buckets by size, largest first */
+   for(i = 0; i <= *pulMaxSize; i++)
+      pulSizes[i] = 0;
+   for(ulBucket = 0; ulBucket < oMHash->ulBuckets; ulBucket++)
+      pulSizes[pulStarts[ulBucket + 1] - pulStarts[ulBucket]]++;
+   ulNext = 0;
+   for(i = *pulMaxSize + 1; i > 0; i--) {
+      ulSize = pulSizes[i - 1];
+      pulSizes[i - 1] = ulNext;
+      ulNext += ulSize;
+   }
+   for(ulBucket = 0; ulBucket < oMHash->ulBuckets; ulBucket++)
+      pulOrder[pulSizes[pulStarts[ulBucket + 1]
+                        - pulStarts[ulBucket]]++] = ulBucket;
+   return TRUE;
+}
+
+/* see mphFT.h for specification */
+int Mph_new(const size_t *pulHashes, size_t ulCount, Mph_T *poMResult) {
+   Mph_T oMHash;
+   size_t *pulSorted;
+   size_t *pulStarts;
+   size_t *pulOrder;
+   size_t *pulSizes;
+   size_t ulMaxSize = 0;
+   char *pcTaken;
+   int iStatus = ALREADY_IN_TREE;
+   size_t ulSeed;
+   assert(pulHashes != NULL);
+   assert(ulCount > 0);
+   assert(poMResult != NULL);
+   *poMResult = NULL;
+   oMHash = malloc(sizeof(struct mph));
+   if(oMHash == NULL)
+      return MEMORY_ERROR;
+   oMHash->ulCount = ulCount;
+   oMHash->ulBuckets = ulCount / BUCKET_SIZE + 1;
+   oMHash->ulSeed = 0;
+   oMHash->auiPilots = malloc(oMHash->ulBuckets * sizeof(unsigned int));
+   pulSorted = malloc(ulCount * sizeof(size_t));
+   pulStarts = malloc((oMHash->ulBuckets + 1) * sizeof(size_t));
+   pulOrder = malloc(oMHash->ulBuckets * sizeof(size_t));
+   pulSizes = malloc((ulCount + 1) * sizeof(size_t));
+   pcTaken = malloc(ulCount);
+   if(oMHash->auiPilots == NULL || pulSorted == NULL ||
+      pulStarts == NULL || pulOrder == NULL || pulSizes == NULL ||
+      pcTaken == NULL)
+      iStatus = MEMORY_ERROR;
+
+   /* a seed rarely fails, but then another is tried */
+   for(ulSeed = 0; iStatus == ALREADY_IN_TREE && ulSeed < NUM_SEEDS;
+       ulSeed++) {
+      oMHash->ulSeed = ulSeed * MPH_MUL2;
+      if(!Mph_group(oMHash, pulHashes, pulSorted, pulStarts, pulOrder,
+                    pulSizes, &ulMaxSize))
+         break;
+      /* pulSizes is free again, and has room for the slots tried */
+      if(Mph_place(oMHash, pulSorted, pulStarts, pulOrder, pcTaken,
+                   pulSizes))
+         iStatus = SUCCESS;
+   }
+
+   free(pulSorted);
+   free(pulStarts);
+   free(pulOrder);
+   free(pulSizes);
+   free(pcTaken);
+   if(iStatus != SUCCESS) {
+      Mph_free(oMHash);
+      return iStatus;
+   }
+   *poMResult = oMHash;
+   return SUCCESS;
+}
+
+/* see mphFT.h for specification */
+void Mph_free(Mph_T oMHash) {
+   if(oMHash == NULL)
+      return;
+   free(oMHash->auiPilots);
+   free(oMHash);
+}
+
+/* see mphFT.h for specification */
+size_t Mph_lookup(Mph_T oMHash, size_t ulHash) {
+   assert(oMHash != NULL);
+   return Mph_slot(oMHash, ulHash,
+                   oMHash->auiPilots[Mph_bucket(oMHash, ulHash)]);
+}
+
+/* see mphFT.h for specification */
+size_t Mph_getSize(Mph_T oMHash) {
+   assert(oMHash != NULL);
+   return oMHash->ulBuckets * sizeof(unsigned int);
+}
@@ -0,0 +1,42 @@
+/*--------------------------------------------------------------------*/
+/* mphFT.h                                                            */
+/*--------------------------------------------------------------------*/
+#ifndef MPH_INCLUDED
+#define MPH_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  An Mph_T is a minimal perfect hash function over a fixed set of n
+  distinct hashes: it maps each of them to its own slot in 0..n-1,
+  with one small array read. Hashes are first spread over about n/4
+  buckets; each bucket then stores a "pilot" that moves all its hashes
+  to slots no other bucket uses. A hash not in the set is mapped to
+  some slot too, so callers must check what they find there.
+*/
+typedef struct mph *Mph_T;
+
+/*
+  Builds a minimal perfect hash function for the ulCount hashes at
+  pulHashes, and stores it in *poMResult. Returns SUCCESS, or
+  otherwise sets *poMResult to NULL and returns:
+  * MEMORY_ERROR if memory could not be allocated
+  * ALREADY_IN_TREE if two of the hashes are equal, so that no such
+                    function exists, or (very rarely) if none was
+                    found anyway
+*/
+int Mph_new(const size_t *pulHashes, size_t ulCount, Mph_T *poMResult);
+
+/* Frees oMHash. Does nothing if NULL. */
+void Mph_free(Mph_T oMHash);
+
+/*
+  Returns the slot of ulHash in oMHash: a different one in 0..n-1 for
+  each of the n hashes it was built for, and one of those for any
+  other hash.
+*/
+size_t Mph_lookup(Mph_T oMHash, size_t ulHash);
+
+/* Returns the number of bytes that oMHash's pilots take. */
+size_t Mph_getSize(Mph_T oMHash);
+#endif
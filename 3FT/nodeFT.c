@@ -2,26 +2,132 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
-#include "dynarray.h"
+#include "contentFT.h"
+#include "extentFT.h"
+#include "packFT.h"
 #include "nodeFT.h"
 #include "checkerFT.h"
-/* A node in a FT */
+/* A node in a FT. The fields that a lookup by path reads come first,
+   so that on a 64-bit machine they share one 64-byte cache line. */
 struct node {
-   /* the object corresponding to the node's absolute path */
-   Path_T oPPath;
-   /* this node's parent */
-   Node_T oNParent;
-   /* the object containing links to this node's children */
-   DynArray_T oDChildren;
+   /* the node's name: the last component of its absolute path, which
+      is derived from its ancestors' names rather than stored. It is
+      kept in the node's own allocation, after any inline contents,
+      until the node is renamed to a longer name */
+   char *pcName;
+   /* the number of characters in pcName, which has no '\0' */
+   size_t ulNameLength;
+   /* this node's children's entries (see struct childArray), once it
+      has had two at once; until then NULL, with the only child (if
+      any) in oNOnly, so that a chain of single-child directories
+      costs one allocation per level */
+   struct childArray *psChildren;
+   Node_T oNOnly;
+   /* for a lazy copy of a directory, the directory whose children it
+      presents as its own until it is materialized; otherwise NULL */
+   Node_T oNShare;
+   /* for a packed directory, its files, which then have no nodes of
+      their own (see Node_pack); otherwise NULL */
+   Pack_T oPPacked;
    /* boolean to differentiate between file (True) vs 
    directory (False) */
    boolean ftType;
-   /* pointer to file contents: (null) if directory */
-   void* fileContents;
    /* size of contents*/
    size_t sizeContents;
+   /* pointer to file contents: (null) if directory */
+   void* fileContents;
+   /* this node's parent */
+   Node_T oNParent;
+   /* number of outstanding pins (e.g., open directory handles) */
+   size_t ulPins;
+   /* TRUE if the node has been removed from the tree while pinned */
+   boolean bRemoved;
+   /* the first of the lazy copies sharing this node's children */
+   Node_T oNReferrers;
+   /* the next of the lazy copies sharing the same node as this one */
+   Node_T oNNextReferrer;
+   /* TRUE if the node owns a copy of its file contents, FALSE if it
+      borrows the client's */
+   boolean bOwned;
+   /* the number of bytes of owned contents that fit inline, directly
+      after the struct node in the same allocation */
+   size_t ulInline;
+   /* the owned contents, if they are neither inline nor chunked;
+      otherwise NULL */
+   Content_T oCContents;
+   /* the owned contents, if they have been changed in place since
+      they were last too large to be inline; otherwise NULL */
+   Extents_T oEExtents;
+   /* the value of ulChanges when the node's children last changed */
+   unsigned long ulChanged;
+};
+
+/*
+  A directory's children, once it has had two at once: this header,
+  then room for ulCapacity entries in the same allocation, the first
+  ulLength of them in use and in order of name. A search by name reads
+  the entries' keys and only the nodes of children whose keys match,
+  rather than every node it passes.
+*/
+struct childArray {
+   size_t ulLength;
+   size_t ulCapacity;
+};
+
+/* A child's entry in its parent's children array */
+struct childEntry {
+   /* the start of the child's name, as Node_key makes it, with the
+      lowest bit set if the child is a file */
+   size_t ulKey;
+   /* the child itself */
+   Node_T oNChild;
 };
 
+/* The largest contents that an owned file node stores inline; the
+   fewest files that a directory is packed for; the entries a new
+   children array has room for, which with the header fill 64 bytes;
+   the characters of a name that its key holds */
+enum { NODE_INLINE_MAX = 64, NODE_PACK_MIN = 8, NODE_ARRAY_MIN = 3,
+       NODE_KEY_CHARS = sizeof(size_t) - 1 };
+
+/* the number of lazy copies in existence, across all trees */
+static size_t ulShared;
+
+/* the number of pinned nodes in existence, across all trees */
+static size_t ulPinned;
+
+/* the number of changes to directories' children, across all trees,
+   which dates each directory's last change */
+static unsigned long ulChanges;
+
+/* the packed directories in existence, the files in them, the bytes
+   their packs take and the total length of those files' names */
+static size_t ulPackedDirs;
+static size_t ulPackedFiles;
+static size_t ulPackedBytes;
+static size_t ulPackedNames;
+
+/*
+  Returns the node whose children oNNode presents: oNNode itself, or
+  the directory it shares if it is a lazy copy.
+*/
+static Node_T Node_children(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return oNNode->oNShare != NULL ? oNNode->oNShare : oNNode;
+}
+
+/* Unlinks lazy copy oNLazy from its shared directory's referrers. */
+static void Node_unlinkReferrer(Node_T oNLazy) {
+   Node_T *poNLink;
+   assert(oNLazy != NULL);
+   assert(oNLazy->oNShare != NULL);
+   poNLink = &oNLazy->oNShare->oNReferrers;
+   while(*poNLink != oNLazy)
+      poNLink = &(*poNLink)->oNNextReferrer;
+   *poNLink = oNLazy->oNNextReferrer;
+   oNLazy->oNNextReferrer = NULL;
+}
+
 /* see nodeFT.h for specification*/
 boolean Node_getType(Node_T oNNode) {
    assert(oNNode!=NULL);
@@ -40,247 +146,875 @@ size_t Node_getSizeContents(Node_T oNNode) {
 /* see nodeFT.h for specification*/
 int Node_setFileContents(Node_T oNNode, void *pvNewContents) {
    assert(oNNode!=NULL);
+   assert(!oNNode->bOwned);
    oNNode->fileContents = pvNewContents;
    return SUCCESS;
 }
 /* see nodeFT.h for specification*/
 int Node_setSizeContents(Node_T oNNode, size_t ulNewLength) {
    assert(oNNode!=NULL);
+   assert(!oNNode->bOwned);
    oNNode->sizeContents = ulNewLength;
    return SUCCESS;
 }
+/* Returns the entries of children array psArray. */
+static struct childEntry *Node_entries(struct childArray *psArray) {
+   assert(psArray != NULL);
+   return (struct childEntry *) (psArray + 1);
+}
+
+/*
+  Returns the key of the name of ulLength characters at pcName: its
+  first NODE_KEY_CHARS characters, from the highest byte down and
+  padded with zeros, above a zero lowest byte. Keys that differ order
+  as their names do; names with the same key must be compared whole.
+*/
+static size_t Node_key(const char *pcName, size_t ulLength) {
+   size_t ulKey = 0;
+   size_t ulChar;
+   assert(pcName != NULL);
+   for(ulChar = 0; ulChar < NODE_KEY_CHARS; ulChar++) {
+      ulKey <<= 8;
+      if(ulChar < ulLength)
+         ulKey |= (unsigned char) pcName[ulChar];
+   }
+   return ulKey << 8;
+}
+
+/* Returns the number of children that directory oNDir holds itself. */
+static size_t Node_countOwn(Node_T oNDir) {
+   assert(oNDir != NULL);
+   if(oNDir->oPPacked != NULL)
+      return Pack_getCount(oNDir->oPPacked);
+   if(oNDir->psChildren != NULL)
+      return oNDir->psChildren->ulLength;
+   return oNDir->oNOnly != NULL;
+}
+
+/* Returns the child at index ulIndex of those oNDir holds itself,
+   which must not be packed. */
+static Node_T Node_ownChild(Node_T oNDir, size_t ulIndex) {
+   assert(oNDir != NULL);
+   assert(oNDir->oPPacked == NULL);
+   assert(ulIndex < Node_countOwn(oNDir));
+   if(oNDir->psChildren != NULL)
+      return Node_entries(oNDir->psChildren)[ulIndex].oNChild;
+   return oNDir->oNOnly;
+}
+
+/* Makes psEntry the entry of oNChild, keyed by its current name. */
+static void Node_setEntry(struct childEntry *psEntry, Node_T oNChild) {
+   assert(psEntry != NULL);
+   assert(oNChild != NULL);
+   psEntry->ulKey = Node_key(oNChild->pcName, oNChild->ulNameLength)
+      | (oNChild->ftType ? 1 : 0);
+   psEntry->oNChild = oNChild;
+}
+
 /*
-  Links new child oNChild into oNParent's children array at index
-  ulIndex. Returns SUCCESS if the new child was added successfully,
-  or  MEMORY_ERROR if allocation fails adding oNChild to the array.
+  Links new child oNChild into oNParent's children at index ulIndex,
+  giving oNParent a children array when it gets a second child.
+  Returns SUCCESS if the new child was added successfully, or
+  MEMORY_ERROR if allocation fails adding oNChild to the array.
 */
 static int Node_addChild(Node_T oNParent, Node_T oNChild,
                          size_t ulIndex) {
+   struct childArray *psArray;
+   struct childEntry *psEntry;
+   size_t ulCapacity;
    assert(oNParent != NULL);
    assert(oNChild != NULL);
-   if(DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
-      return SUCCESS;
+   assert(oNParent->oNShare == NULL);
+   assert(oNParent->oPPacked == NULL);
+   oNParent->ulChanged = ++ulChanges;
+   psArray = oNParent->psChildren;
+   if(psArray == NULL) {
+      if(oNParent->oNOnly == NULL) {
+         oNParent->oNOnly = oNChild;
+         return SUCCESS;
+      }
+      psArray = malloc(sizeof(struct childArray)
+                       + NODE_ARRAY_MIN * sizeof(struct childEntry));
+      if(psArray == NULL)
+         return MEMORY_ERROR;
+      psArray->ulLength = 1;
+      psArray->ulCapacity = NODE_ARRAY_MIN;
+      Node_setEntry(Node_entries(psArray), oNParent->oNOnly);
+      oNParent->psChildren = psArray;
+      oNParent->oNOnly = NULL;
+   }
+   else if(psArray->ulLength == psArray->ulCapacity) {
+      /* grow so that the whole allocation stays a multiple of 64
+         bytes */
+      ulCapacity = 2 * psArray->ulCapacity + 1;
+      psArray = realloc(psArray, sizeof(struct childArray)
+                        + ulCapacity * sizeof(struct childEntry));
+      if(psArray == NULL)
+         return MEMORY_ERROR;
+      psArray->ulCapacity = ulCapacity;
+      oNParent->psChildren = psArray;
+   }
+   assert(ulIndex <= psArray->ulLength);
+   psEntry = Node_entries(psArray) + ulIndex;
+   memmove(psEntry + 1, psEntry,
+           (psArray->ulLength - ulIndex) * sizeof(struct childEntry));
+   Node_setEntry(psEntry, oNChild);
+   psArray->ulLength++;
+   return SUCCESS;
+}
+
+/*
+  Unlinks the child at index ulIndex from oNParent's children. An
+  array, once made, is kept, so that the child can always be linked
+  back in.
+*/
+static void Node_removeChild(Node_T oNParent, size_t ulIndex) {
+   struct childEntry *psEntry;
+   assert(oNParent != NULL);
+   assert(ulIndex < Node_countOwn(oNParent));
+   oNParent->ulChanged = ++ulChanges;
+   if(oNParent->psChildren != NULL) {
+      psEntry = Node_entries(oNParent->psChildren) + ulIndex;
+      oNParent->psChildren->ulLength--;
+      memmove(psEntry, psEntry + 1,
+              (oNParent->psChildren->ulLength - ulIndex)
+              * sizeof(struct childEntry));
+   }
    else
-      return MEMORY_ERROR;
+      oNParent->oNOnly = NULL;
 }
+
+/* Frees the children array of oNDir, whose children are all gone. */
+static void Node_freeChildren(Node_T oNDir) {
+   assert(oNDir != NULL);
+   assert(Node_countOwn(oNDir) == 0);
+   free(oNDir->psChildren);
+   oNDir->psChildren = NULL;
+}
+
+/* A name that need not be '\0'-terminated, used as a search key */
+struct nodeKey {
+   /* the characters of the name */
+   const char *pcPath;
+   /* the number of characters in the name */
+   size_t ulLength;
+};
+
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
+  Compares oNFirst's name with the name psSecond. Since siblings'
+  paths differ only in their names, this orders siblings exactly as
+  their paths do.
   Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
-  "greater than" pcSecond, respectively.
+  "greater than" psSecond, respectively.
 */
-static int Node_compareString(const Node_T oNFirst,
-                                 const char *pcSecond) {
+static int Node_compareName(const Node_T oNFirst,
+                            const struct nodeKey *psSecond) {
+   int iResult;
    assert(oNFirst != NULL);
-   assert(pcSecond != NULL);
-   return Path_compareString(oNFirst->oPPath, pcSecond);
+   assert(psSecond != NULL);
+   iResult = memcmp(oNFirst->pcName, psSecond->pcPath,
+                    oNFirst->ulNameLength < psSecond->ulLength ?
+                    oNFirst->ulNameLength : psSecond->ulLength);
+   if(iResult != 0)
+      return iResult;
+   if(oNFirst->ulNameLength < psSecond->ulLength)
+      return -1;
+   return oNFirst->ulNameLength > psSecond->ulLength;
 }
 
 /*
-  Compares oNFirst and oNSecond lexicographically based on their paths.
-  Returns <0, 0, or >0 if onFirst is "less than", "equal to", or
-  "greater than" oNSecond, respectively.
+  Returns a newly allocated copy of the ulLength characters at pcName,
+  or NULL if there is an allocation error.
 */
-static int Node_compare(Node_T oNFirst, Node_T oNSecond) {
-   assert(oNFirst != NULL);
-   assert(oNSecond != NULL);
-   return Path_comparePath(oNFirst->oPPath, oNSecond->oPPath);
+static char *Node_copyName(const char *pcName, size_t ulLength) {
+   char *pcCopy;
+   assert(pcName != NULL);
+   pcCopy = malloc(ulLength);
+   if(pcCopy != NULL)
+      memcpy(pcCopy, pcName, ulLength);
+   return pcCopy;
 }
 
-/* see nodeFT.h for specification*/
-int Node_newFile(Path_T oPPath, Node_T oNParent, Node_T *poNResult, 
-                           void *pvNewContents, size_t ulNewLength) {
+/* Returns the inline storage of oNNode. */
+static void *Node_inline(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return oNNode + 1;
+}
+
+/* Returns the storage for oNNode's name in its own allocation. */
+static char *Node_inlineName(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return (char *) (oNNode + 1) + oNNode->ulInline;
+}
+
+/* Releases owned file oNNode's contents, unless they are inline. */
+static void Node_releaseContents(Node_T oNNode) {
+   assert(oNNode != NULL);
+   if(oNNode->oCContents != NULL)
+      Content_release(oNNode->oCContents);
+   if(oNNode->oEExtents != NULL)
+      Extents_free(oNNode->oEExtents);
+   oNNode->oCContents = NULL;
+   oNNode->oEExtents = NULL;
+   oNNode->fileContents = NULL;
+}
+
+/*
+  Makes owned file oNNode hold the ulLength bytes at pvBytes: in
+  oCContents, if it is not NULL, by taking over the caller's reference
+  to it; otherwise by copying them inline, where they must fit. Any
+  contents oNNode held before are released.
+*/
+static void Node_adoptContents(Node_T oNNode, Content_T oCContents,
+                               const void *pvBytes, size_t ulLength) {
+   assert(oNNode != NULL);
+   assert(oNNode->bOwned);
+   assert(oCContents != NULL || ulLength <= oNNode->ulInline);
+   if(oCContents == NULL && ulLength != 0)
+      /* the bytes may already be inline */
+      memmove(Node_inline(oNNode), pvBytes, ulLength);
+   Node_releaseContents(oNNode);
+   oNNode->oCContents = oCContents;
+   if(oCContents != NULL)
+      oNNode->fileContents = Content_getBytes(oCContents);
+   else
+      oNNode->fileContents = ulLength != 0 ? Node_inline(oNNode) : NULL;
+   oNNode->sizeContents = ulLength;
+}
+
+/*
+  Creates a new file (if bIsFile is TRUE) or directory node named by
+  the ulNameLength characters at pcName as a child of oNParent, as
+  described for Node_newFile and Node_newDir, with room for ulInline
+  bytes of inline contents after it. If oNShare is not NULL, the new
+  directory is a lazy copy of oNShare, which must be a directory that
+  is not itself a lazy copy.
+*/
+static int Node_new(const char *pcName, size_t ulNameLength,
+                    Node_T oNParent, boolean bIsFile,
+                    void *pvNewContents, size_t ulNewLength,
+                    size_t ulInline, Node_T oNShare,
+                    Node_T *poNResult) {
    struct node *psNew;
-   Path_T oPParentPath = NULL;
-   Path_T oPNewPath = NULL;
-   size_t ulParentDepth;
-   size_t ulIndex;
+   size_t ulIndex = 0;
    int iStatus;
-   assert(oPPath != NULL);
+   assert(pcName != NULL);
+   assert(ulNameLength != 0);
+   assert(memchr(pcName, '/', ulNameLength) == NULL);
+   assert(poNResult != NULL);
    assert(oNParent == NULL || CheckerFT_Node_isValid(oNParent));
-   /* allocate space for a new node */
-   psNew = malloc(sizeof(struct node));
-   if(psNew == NULL) {
-      *poNResult = NULL;
-      return MEMORY_ERROR;
-   }
-   /* set the new node's path */
-   iStatus = Path_dup(oPPath, &oPNewPath);
-   if(iStatus != SUCCESS) {
-      free(psNew);
-      *poNResult = NULL;
-      return iStatus;
-   }
-   psNew->oPPath = oPNewPath;
-   /* validate and set the new node's parent */
+   *poNResult = NULL;
    if(oNParent != NULL) {
-      size_t ulSharedDepth;
-      oPParentPath = oNParent->oPPath;
-      ulParentDepth = Path_getDepth(oPParentPath);
-      ulSharedDepth = Path_getSharedPrefixDepth(psNew->oPPath,
-                                                oPParentPath);
-      /* parent must be an ancestor of child */
-      if(ulSharedDepth < ulParentDepth) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return CONFLICTING_PATH;
-      }
-      /* parent must be exactly one level up from child */
-      if(Path_getDepth(psNew->oPPath) != ulParentDepth + 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return NO_SUCH_PATH;
-      }
-      /* parent must not already have child with this path */
-      if(Node_hasChild(oNParent, oPPath, &ulIndex)) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
+      /* files can't have children */
+      if(Node_getType(oNParent))
+         return NOT_A_DIRECTORY;
+      /* parent must not already have child with this name */
+      if(Node_hasChildName(oNParent, pcName, ulNameLength, &ulIndex))
          return ALREADY_IN_TREE;
-      }
+      /* a packed parent takes its files back as nodes first */
+      iStatus = Node_unpack(oNParent);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   /* allocate space for a new node, its inline contents and its name,
+      all at once */
+   psNew = malloc(sizeof(struct node) + ulInline + ulNameLength);
+   if(psNew == NULL)
+      return MEMORY_ERROR;
+   psNew->ulInline = ulInline;
+   psNew->pcName = Node_inlineName(psNew);
+   memcpy(psNew->pcName, pcName, ulNameLength);
+   psNew->ulNameLength = ulNameLength;
+   psNew->oNParent = oNParent;
+   psNew->ulPins = 0;
+   psNew->bRemoved = FALSE;
+   psNew->oNShare = NULL;
+   psNew->oNReferrers = NULL;
+   psNew->oNNextReferrer = NULL;
+   psNew->bOwned = FALSE;
+   psNew->oCContents = NULL;
+   psNew->oEExtents = NULL;
+   psNew->oPPacked = NULL;
+   psNew->ulChanged = ulChanges;
+   psNew->ftType = bIsFile;
+   /* a directory starts with no children, and so no array */
+   psNew->psChildren = NULL;
+   psNew->oNOnly = NULL;
+   if(bIsFile || oNShare != NULL) {
+      /* points to file contents pvNewContents with size of
+      ulNewLength bytes*/
+      psNew->fileContents = pvNewContents;
+      psNew->sizeContents = ulNewLength;
    }
    else {
-      /* new node must be root */
-      /* can only create one "level" at a time */
-      if(Path_getDepth(psNew->oPPath) != 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return NO_SUCH_PATH;
-      }
+      /* sets "file" contents to NULL and sizeContents to 0*/
+      psNew->fileContents = NULL;
+      psNew->sizeContents = 0;
    }
-   psNew->oNParent = oNParent;
    /* Link into parent's children list */
-   if(oNParent != NULL && !Node_getType(oNParent)) {
+   if(oNParent != NULL) {
       iStatus = Node_addChild(oNParent, psNew, ulIndex);
       if(iStatus != SUCCESS) {
-         Path_free(psNew->oPPath);
          free(psNew);
-         *poNResult = NULL;
          return iStatus;
       }
    }
-   /*check is parent is file and return NOT_A_DIRECTORY*/
-   else if (oNParent != NULL && Node_getType(oNParent)){
-      Path_free(psNew->oPPath);
-      free(psNew);
-      *poNResult = NULL;
-      return NOT_A_DIRECTORY;
+   /* a lazy copy joins its shared directory's referrers */
+   if(oNShare != NULL) {
+      assert(!oNShare->ftType && oNShare->oNShare == NULL);
+      psNew->oNShare = oNShare;
+      psNew->oNNextReferrer = oNShare->oNReferrers;
+      oNShare->oNReferrers = psNew;
+      ulShared++;
    }
-
-   /* points to file contents pvNewContents with size of 
-   ulNewLength bytes*/ 
-   psNew->fileContents = pvNewContents;
-   psNew->sizeContents = ulNewLength;
-   /*update ftType to true*/
-   psNew->ftType = TRUE;
    *poNResult = psNew;
    assert(oNParent == NULL || CheckerFT_Node_isValid(oNParent));
    assert(CheckerFT_Node_isValid(*poNResult));
    return SUCCESS;
 }
+
 /* see nodeFT.h for specification*/
-int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
-   struct node *psNew;
-   Path_T oPParentPath = NULL;
-   Path_T oPNewPath = NULL;
-   size_t ulParentDepth;
-   size_t ulIndex;
+int Node_newFile(const char *pcName, size_t ulNameLength,
+                 Node_T oNParent, Node_T *poNResult,
+                 void *pvNewContents, size_t ulNewLength) {
+   return Node_new(pcName, ulNameLength, oNParent, TRUE,
+                   pvNewContents, ulNewLength, 0, NULL, poNResult);
+}
+
+/*
+  Creates owned file oNSource's copy, named and placed as by
+  Node_newDir, storing it in *poNResult: the copy holds ulLength bytes
+  at pvBytes, in oCContents if it is not NULL, or otherwise inline.
+  Takes over the caller's reference to oCContents whatever the result.
+*/
+static int Node_newOwned(const char *pcName, size_t ulNameLength,
+                         Node_T oNParent, Content_T oCContents,
+                         const void *pvBytes, size_t ulLength,
+                         Node_T *poNResult) {
+   size_t ulInline = 0;
    int iStatus;
-   assert(oPPath != NULL);
-   assert(oNParent == NULL || CheckerFT_Node_isValid(oNParent));
-   /* allocate space for a new node */
-   psNew = malloc(sizeof(struct node));
-   if(psNew == NULL) {
-      *poNResult = NULL;
-      return MEMORY_ERROR;
-   }
-   /* set the new node's path */
-   iStatus = Path_dup(oPPath, &oPNewPath);
+   /* round the inline room up so that replacements can reuse it */
+   if(oCContents == NULL)
+      ulInline = (ulLength + 15) & ~(size_t) 15;
+   iStatus = Node_new(pcName, ulNameLength, oNParent, TRUE, NULL, 0,
+                      ulInline, NULL, poNResult);
    if(iStatus != SUCCESS) {
-      free(psNew);
-      *poNResult = NULL;
+      if(oCContents != NULL)
+         Content_release(oCContents);
       return iStatus;
    }
-   psNew->oPPath = oPNewPath;
-   /* validate and set the new node's parent */
-   if(oNParent != NULL) {
-      size_t ulSharedDepth;
-      oPParentPath = oNParent->oPPath;
-      ulParentDepth = Path_getDepth(oPParentPath);
-      ulSharedDepth = Path_getSharedPrefixDepth(psNew->oPPath,
-                                                oPParentPath);
-      /* parent must be an ancestor of child */
-      if(ulSharedDepth < ulParentDepth) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return CONFLICTING_PATH;
-      }
-      /* parent must be exactly one level up from child */
-      if(Path_getDepth(psNew->oPPath) != ulParentDepth + 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
+   (*poNResult)->bOwned = TRUE;
+   Node_adoptContents(*poNResult, oCContents, pvBytes, ulLength);
+   return SUCCESS;
+}
+
+/* see nodeFT.h for specification*/
+int Node_newOwnedFile(const char *pcName, size_t ulNameLength,
+                      Node_T oNParent, Node_T *poNResult,
+                      const void *pvNewContents, size_t ulNewLength,
+                      ContentStore_T oSStore) {
+   Content_T oCContents = NULL;
+   Extents_T oEExtents;
+   int iStatus;
+   assert(oSStore != NULL);
+   assert(poNResult != NULL);
+   if(pvNewContents == NULL && ulNewLength != 0) {
+      /* zeros with nothing to copy: a file that is all hole */
+      oEExtents = Extents_new(oSStore, NULL, ulNewLength);
+      if(oEExtents == NULL) {
          *poNResult = NULL;
-         return NO_SUCH_PATH;
+         return MEMORY_ERROR;
       }
-      /* parent must not already have child with this path */
-      if(Node_hasChild(oNParent, oPPath, &ulIndex)) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return ALREADY_IN_TREE;
+      iStatus = Node_newOwned(pcName, ulNameLength, oNParent, NULL,
+                              NULL, 0, poNResult);
+      if(iStatus != SUCCESS) {
+         Extents_free(oEExtents);
+         return iStatus;
       }
+      (*poNResult)->oEExtents = oEExtents;
+      (*poNResult)->sizeContents = ulNewLength;
+      return SUCCESS;
    }
-   else {
-      /* new node must be root */
-      /* can only create one "level" at a time */
-      if(Path_getDepth(psNew->oPPath) != 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
+   if(ulNewLength > NODE_INLINE_MAX) {
+      oCContents = Content_new(oSStore, pvNewContents, ulNewLength);
+      if(oCContents == NULL) {
          *poNResult = NULL;
-         return NO_SUCH_PATH;
+         return MEMORY_ERROR;
       }
    }
-   psNew->oNParent = oNParent;
-   /* initialize the new node's dynarray */
-   psNew->oDChildren = DynArray_new(0);
-   if(psNew->oDChildren == NULL) {
-      Path_free(psNew->oPPath);
-      free(psNew);
-      *poNResult = NULL;
-      return MEMORY_ERROR;
+   return Node_newOwned(pcName, ulNameLength, oNParent, oCContents,
+                        pvNewContents, ulNewLength, poNResult);
+}
+
+/* see nodeFT.h for specification*/
+int Node_replaceOwnedContents(Node_T oNNode, const void *pvNewContents,
+                              size_t ulNewLength,
+                              ContentStore_T oSStore) {
+   Content_T oCContents = NULL;
+   assert(oNNode != NULL);
+   assert(oNNode->bOwned);
+   assert(pvNewContents != NULL || ulNewLength == 0);
+   assert(oSStore != NULL);
+   if(ulNewLength > oNNode->ulInline) {
+      oCContents = Content_new(oSStore, pvNewContents, ulNewLength);
+      if(oCContents == NULL)
+         return MEMORY_ERROR;
    }
-   /* Link into parent's children list */
-   if(oNParent != NULL && !Node_getType(oNParent)) {
-      iStatus = Node_addChild(oNParent, psNew, ulIndex);
+   Node_adoptContents(oNNode, oCContents, pvNewContents, ulNewLength);
+   return SUCCESS;
+}
+
+/* see nodeFT.h for specification*/
+void Node_setContent(Node_T oNNode, Content_T oCContents) {
+   assert(oNNode != NULL);
+   assert(oNNode->bOwned);
+   assert(oCContents != NULL);
+   Node_adoptContents(oNNode, oCContents, NULL,
+                      Content_getLength(oCContents));
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_ownsContents(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return oNNode->bOwned;
+}
+
+/* see nodeFT.h for specification*/
+size_t Node_countStored(Node_T oNNode, unsigned long ulPass) {
+   assert(oNNode != NULL);
+   if(!oNNode->bOwned)
+      return 0;
+   if(oNNode->oEExtents != NULL)
+      return Extents_countStored(oNNode->oEExtents, ulPass);
+   if(oNNode->oCContents != NULL)
+      return Content_visit(oNNode->oCContents, ulPass) ?
+         Content_getLength(oNNode->oCContents) : 0;
+   return oNNode->sizeContents;
+}
+
+/* see nodeFT.h for specification*/
+size_t Node_readAt(Node_T oNNode, size_t ulOffset, void *pvBuf,
+                   size_t ulLength) {
+   assert(oNNode != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+   if(oNNode->oEExtents != NULL)
+      return Extents_read(oNNode->oEExtents, ulOffset, pvBuf, ulLength);
+   if(ulOffset >= oNNode->sizeContents)
+      return 0;
+   if(ulLength > oNNode->sizeContents - ulOffset)
+      ulLength = oNNode->sizeContents - ulOffset;
+   /* borrowed contents may be NULL whatever their size */
+   if(oNNode->fileContents == NULL)
+      memset(pvBuf, 0, ulLength);
+   else
+      memcpy(pvBuf, (char *) oNNode->fileContents + ulOffset, ulLength);
+   return ulLength;
+}
+
+/*
+  Stores in *poEResult owned file oNNode's contents as extents: its
+  own, if they are already chunked, or otherwise a new chunked copy
+  from oSStore, which the caller must install or free. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+static int Node_getExtents(Node_T oNNode, ContentStore_T oSStore,
+                           Extents_T *poEResult) {
+   assert(oNNode != NULL);
+   assert(poEResult != NULL);
+   *poEResult = oNNode->oEExtents;
+   if(*poEResult == NULL)
+      *poEResult = Extents_new(oSStore, oNNode->fileContents,
+                               oNNode->sizeContents);
+   return *poEResult != NULL ? SUCCESS : MEMORY_ERROR;
+}
+
+/*
+  Makes owned file oNNode hold oEExtents, the result of
+  Node_getExtents, if iStatus is SUCCESS, and otherwise frees
+  oEExtents if it is not oNNode's own. Returns iStatus.
+*/
+static int Node_setExtents(Node_T oNNode, Extents_T oEExtents,
+                           int iStatus) {
+   assert(oNNode != NULL);
+   assert(oEExtents != NULL);
+   if(oEExtents != oNNode->oEExtents) {
       if(iStatus != SUCCESS) {
-         Path_free(psNew->oPPath);
-         free(psNew);
+         Extents_free(oEExtents);
+         return iStatus;
+      }
+      /* release the old contents only now, since the new bytes may
+         have come from them */
+      Node_releaseContents(oNNode);
+      oNNode->oEExtents = oEExtents;
+   }
+   oNNode->sizeContents = Extents_getLength(oEExtents);
+   return iStatus;
+}
+
+/* see nodeFT.h for specification*/
+int Node_writeAt(Node_T oNNode, size_t ulOffset, const void *pvBytes,
+                 size_t ulLength, ContentStore_T oSStore) {
+   Extents_T oEExtents;
+   char *pcInline;
+   int iStatus;
+   assert(oNNode != NULL);
+   assert(oNNode->bOwned);
+   assert(pvBytes != NULL || ulLength == 0);
+   assert(oSStore != NULL);
+   if(ulLength == 0)
+      return SUCCESS;
+   if(oNNode->oEExtents == NULL && oNNode->oCContents == NULL &&
+      ulOffset + ulLength <= oNNode->ulInline) {
+      /* change the inline bytes in place */
+      pcInline = Node_inline(oNNode);
+      if(ulOffset > oNNode->sizeContents)
+         memset(pcInline + oNNode->sizeContents, 0,
+                ulOffset - oNNode->sizeContents);
+      memmove(pcInline + ulOffset, pvBytes, ulLength);
+      if(oNNode->sizeContents < ulOffset + ulLength)
+         oNNode->sizeContents = ulOffset + ulLength;
+      oNNode->fileContents = pcInline;
+      return SUCCESS;
+   }
+   iStatus = Node_getExtents(oNNode, oSStore, &oEExtents);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return Node_setExtents(oNNode, oEExtents,
+                          Extents_write(oEExtents, oSStore, ulOffset,
+                                        pvBytes, ulLength));
+}
+
+/* see nodeFT.h for specification*/
+int Node_truncate(Node_T oNNode, size_t ulLength,
+                  ContentStore_T oSStore) {
+   Extents_T oEExtents;
+   int iStatus;
+   assert(oNNode != NULL);
+   assert(oNNode->bOwned);
+   assert(oSStore != NULL);
+   if(oNNode->oEExtents == NULL && oNNode->oCContents == NULL &&
+      ulLength <= oNNode->ulInline) {
+      if(ulLength > oNNode->sizeContents)
+         memset((char *) Node_inline(oNNode) + oNNode->sizeContents, 0,
+                ulLength - oNNode->sizeContents);
+      oNNode->sizeContents = ulLength;
+      oNNode->fileContents = ulLength != 0 ? Node_inline(oNNode) : NULL;
+      return SUCCESS;
+   }
+   iStatus = Node_getExtents(oNNode, oSStore, &oEExtents);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return Node_setExtents(oNNode, oEExtents,
+                          Extents_truncate(oEExtents, ulLength));
+}
+
+/* see nodeFT.h for specification*/
+int Node_flatten(Node_T oNNode, ContentStore_T oSStore) {
+   Extents_T oEExtents;
+   Content_T oCContents = NULL;
+   size_t ulLength;
+   assert(oNNode != NULL);
+   oEExtents = oNNode->oEExtents;
+   if(oEExtents == NULL)
+      return SUCCESS;
+   assert(oSStore != NULL);
+   ulLength = Extents_getLength(oEExtents);
+   if(ulLength > oNNode->ulInline) {
+      oCContents = Content_newWritable(oSStore, NULL, 0, ulLength);
+      if(oCContents == NULL)
+         return MEMORY_ERROR;
+      (void) Extents_read(oEExtents, 0, Content_getBytes(oCContents),
+                          ulLength);
+   }
+   else
+      (void) Extents_read(oEExtents, 0, Node_inline(oNNode), ulLength);
+   oNNode->oEExtents = NULL;
+   Extents_free(oEExtents);
+   oNNode->oCContents = oCContents;
+   if(oCContents != NULL)
+      oNNode->fileContents = Content_getBytes(oCContents);
+   else
+      oNNode->fileContents = ulLength != 0 ? Node_inline(oNNode) : NULL;
+   return SUCCESS;
+}
+
+/* see nodeFT.h for specification*/
+int Node_newDir(const char *pcName, size_t ulNameLength,
+                Node_T oNParent, Node_T *poNResult) {
+   return Node_new(pcName, ulNameLength, oNParent, FALSE,
+                   NULL, 0, 0, NULL, poNResult);
+}
+
+/* see nodeFT.h for specification*/
+int Node_newCopy(const char *pcName, size_t ulNameLength,
+                 Node_T oNParent, Node_T oNSource, Node_T *poNResult) {
+   assert(oNSource != NULL);
+   if(oNSource->oEExtents != NULL) {
+      /* chunks are shared until either file writes to them */
+      Extents_T oEExtents = Extents_copy(oNSource->oEExtents);
+      int iStatus;
+      if(oEExtents == NULL) {
          *poNResult = NULL;
+         return MEMORY_ERROR;
+      }
+      iStatus = Node_newOwned(pcName, ulNameLength, oNParent, NULL,
+                              NULL, 0, poNResult);
+      if(iStatus != SUCCESS) {
+         Extents_free(oEExtents);
          return iStatus;
       }
+      (*poNResult)->oEExtents = oEExtents;
+      (*poNResult)->sizeContents = Extents_getLength(oEExtents);
+      return SUCCESS;
    }
-   /*check is parent is file and return NOT_A_DIRECTORY*/
-   else if (oNParent != NULL && Node_getType(oNParent)){
-      Path_free(psNew->oPPath);
-      free(psNew);
-      *poNResult = NULL;
-      return NOT_A_DIRECTORY;
+   if(oNSource->bOwned)
+      /* large contents are shared, small ones copied inline */
+      return Node_newOwned(pcName, ulNameLength, oNParent,
+                           oNSource->oCContents != NULL ?
+                           Content_ref(oNSource->oCContents) : NULL,
+                           oNSource->fileContents,
+                           oNSource->sizeContents, poNResult);
+   if(oNSource->ftType)
+      return Node_new(pcName, ulNameLength, oNParent, TRUE,
+                      oNSource->fileContents, oNSource->sizeContents,
+                      0, NULL, poNResult);
+   return Node_new(pcName, ulNameLength, oNParent, FALSE, NULL, 0,
+                   0, Node_children(oNSource), poNResult);
+}
+
+/* see nodeFT.h for specification*/
+Node_T Node_getShare(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return oNNode->oNShare;
+}
+
+/* see nodeFT.h for specification*/
+size_t Node_countShared(void) {
+   return ulShared;
+}
+
+/* see nodeFT.h for specification*/
+int Node_materialize(Node_T oNNode, size_t *pulNew) {
+   Node_T oNShare;
+   size_t ulChild, ulNumChildren;
+   int iStatus;
+   assert(oNNode != NULL);
+   assert(pulNew != NULL);
+   *pulNew = 0;
+   oNShare = oNNode->oNShare;
+   if(oNShare == NULL)
+      return SUCCESS;
+   /* the copies are made from nodes */
+   iStatus = Node_unpack(oNShare);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulNumChildren = Node_countOwn(oNShare);
+   /* become an ordinary directory, then copy each shared child in
+      order; directories among them become lazy copies in turn */
+   Node_unlinkReferrer(oNNode);
+   oNNode->oNShare = NULL;
+   ulShared--;
+   for(ulChild = 0; ulChild < ulNumChildren; ulChild++) {
+      Node_T oNChild = Node_ownChild(oNShare, ulChild);
+      Node_T oNCopy = NULL;
+      iStatus = Node_newCopy(oNChild->pcName, oNChild->ulNameLength,
+                             oNNode, oNChild, &oNCopy);
+      if(iStatus != SUCCESS) {
+         /* undo, and go back to sharing */
+         while(Node_countOwn(oNNode) != 0)
+            (void) Node_free(Node_ownChild(oNNode, 0));
+         Node_freeChildren(oNNode);
+         oNNode->oNShare = oNShare;
+         oNNode->oNNextReferrer = oNShare->oNReferrers;
+         oNShare->oNReferrers = oNNode;
+         ulShared++;
+         *pulNew = 0;
+         return iStatus;
+      }
    }
-   /* sets "file" contents to NULL and sizeContents to 0*/
-   psNew->fileContents = NULL;
-   psNew->sizeContents = 0;
-   /*update ftType to false*/
-   psNew->ftType = FALSE;
-   *poNResult = psNew;
-   assert(oNParent == NULL || CheckerFT_Node_isValid(oNParent));
-   assert(CheckerFT_Node_isValid(*poNResult));
+   *pulNew = ulNumChildren;
    return SUCCESS;
 }
 
+/* see nodeFT.h for specification*/
+int Node_unshare(Node_T oNNode, size_t *pulNew) {
+   size_t ulNew;
+   int iStatus;
+   assert(oNNode != NULL);
+   assert(pulNew != NULL);
+   *pulNew = 0;
+   while(oNNode->oNReferrers != NULL) {
+      iStatus = Node_materialize(oNNode->oNReferrers, &ulNew);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      *pulNew += ulNew;
+   }
+   return SUCCESS;
+}
+
+/*
+  Frees packed directory oNDir's pack, leaving it with no children, and
+  returns the number of files that were in it.
+*/
+static size_t Node_dropPack(Node_T oNDir) {
+   Pack_T oPPack;
+   size_t ulCount;
+   assert(oNDir != NULL);
+   assert(oNDir->oPPacked != NULL);
+   oPPack = oNDir->oPPacked;
+   ulCount = Pack_getCount(oPPack);
+   ulPackedDirs--;
+   ulPackedFiles -= ulCount;
+   ulPackedBytes -= Pack_getSize(oPPack);
+   ulPackedNames -= Pack_getNameLength(oPPack);
+   Pack_free(oPPack);
+   oNDir->oPPacked = NULL;
+   return ulCount;
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_pack(Node_T oNDir) {
+   Pack_T oPPack;
+   Node_T oNChild;
+   size_t ulChild, ulNumChildren;
+   assert(oNDir != NULL);
+   if(oNDir->ftType || oNDir->oNShare != NULL || oNDir->oPPacked != NULL)
+      return FALSE;
+   ulNumChildren = Node_countOwn(oNDir);
+   if(ulNumChildren < NODE_PACK_MIN)
+      return FALSE;
+   /* only files whose nodes hold nothing but their name and the
+      client's pointer */
+   for(ulChild = 0; ulChild < ulNumChildren; ulChild++) {
+      oNChild = Node_ownChild(oNDir, ulChild);
+      if(!oNChild->ftType || oNChild->bOwned || oNChild->ulPins != 0)
+         return FALSE;
+   }
+   oPPack = Pack_new(ulNumChildren);
+   if(oPPack == NULL)
+      return FALSE;
+   for(ulChild = 0; ulChild < ulNumChildren; ulChild++) {
+      oNChild = Node_ownChild(oNDir, ulChild);
+      if(Pack_add(oPPack, oNChild->pcName, oNChild->ulNameLength,
+                  oNChild->fileContents, oNChild->sizeContents)
+         != SUCCESS) {
+         Pack_free(oPPack);
+         return FALSE;
+      }
+   }
+   Pack_trim(oPPack);
+   /* the files' nodes go all at once, without unlinking each */
+   for(ulChild = 0; ulChild < ulNumChildren; ulChild++) {
+      oNChild = Node_ownChild(oNDir, ulChild);
+      if(oNChild->pcName != Node_inlineName(oNChild))
+         free(oNChild->pcName);
+      free(oNChild);
+   }
+   free(oNDir->psChildren);
+   oNDir->psChildren = NULL;
+   oNDir->oNOnly = NULL;
+   oNDir->oPPacked = oPPack;
+   ulPackedDirs++;
+   ulPackedFiles += ulNumChildren;
+   ulPackedBytes += Pack_getSize(oPPack);
+   ulPackedNames += Pack_getNameLength(oPPack);
+   return TRUE;
+}
+
+/* see nodeFT.h for specification*/
+int Node_unpack(Node_T oNNode) {
+   Node_T oNDir;
+   Node_T oNFile;
+   Pack_T oPPack;
+   const char *pcName;
+   void *pvContents;
+   size_t ulChild, ulNumChildren, ulLength, ulSize;
+   unsigned long ulBefore;
+   int iStatus;
+   assert(oNNode != NULL);
+   oNDir = Node_children(oNNode);
+   oPPack = oNDir->oPPacked;
+   if(oPPack == NULL)
+      return SUCCESS;
+   /* become an ordinary directory, then make a node for each file in
+      order */
+   ulNumChildren = Pack_getCount(oPPack);
+   oNDir->oPPacked = NULL;
+   ulBefore = ulChanges;
+   for(ulChild = 0; ulChild < ulNumChildren; ulChild++) {
+      pcName = Pack_getEntry(oPPack, ulChild, &ulLength, &pvContents,
+                             &ulSize);
+      iStatus = Node_new(pcName, ulLength, oNDir, TRUE, pvContents,
+                         ulSize, 0, NULL, &oNFile);
+      if(iStatus != SUCCESS) {
+         /* undo, and stay packed */
+         while(Node_countOwn(oNDir) != 0)
+            (void) Node_free(Node_ownChild(oNDir, 0));
+         Node_freeChildren(oNDir);
+         oNDir->oPPacked = oPPack;
+         return iStatus;
+      }
+   }
+   /* the files were there already: unpacking is one change, not one
+      per file, so that it does not age every other directory */
+   ulChanges = ulBefore + 1;
+   oNDir->ulChanged = ulChanges;
+   oNDir->oPPacked = oPPack;
+   (void) Node_dropPack(oNDir);
+   return SUCCESS;
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_isPacked(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return !oNNode->ftType && Node_children(oNNode)->oPPacked != NULL;
+}
+
+/* see nodeFT.h for specification*/
+const char *Node_getPackedName(Node_T oNDir, size_t ulChildID,
+                               size_t *pulLength) {
+   void *pvContents;
+   size_t ulSize;
+   assert(Node_isPacked(oNDir));
+   assert(pulLength != NULL);
+   return Pack_getEntry(Node_children(oNDir)->oPPacked, ulChildID,
+                        pulLength, &pvContents, &ulSize);
+}
+
+/* see nodeFT.h for specification*/
+size_t Node_getPackedSize(Node_T oNDir, size_t ulChildID) {
+   void *pvContents;
+   size_t ulLength, ulSize;
+   assert(Node_isPacked(oNDir));
+   (void) Pack_getEntry(Node_children(oNDir)->oPPacked, ulChildID,
+                        &ulLength, &pvContents, &ulSize);
+   return ulSize;
+}
+
+/* see nodeFT.h for specification*/
+unsigned long Node_countChanges(void) {
+   return ulChanges;
+}
+
+/* see nodeFT.h for specification*/
+unsigned long Node_getChanged(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return oNNode->ulChanged;
+}
+
+/* see nodeFT.h for specification*/
+void Node_getPackSizes(size_t *pulDirs, size_t *pulFiles,
+                       size_t *pulBytes, size_t *pulNodeBytes) {
+   assert(pulDirs != NULL);
+   assert(pulFiles != NULL);
+   assert(pulBytes != NULL);
+   assert(pulNodeBytes != NULL);
+   *pulDirs = ulPackedDirs;
+   *pulFiles = ulPackedFiles;
+   *pulBytes = ulPackedBytes;
+   *pulNodeBytes = ulPackedFiles * sizeof(struct node) + ulPackedNames;
+}
+
 /* see nodeFT.h for specification*/
 size_t Node_free(Node_T oNNode) {
    size_t ulIndex;
@@ -289,54 +1023,616 @@ size_t Node_free(Node_T oNNode) {
    assert(CheckerFT_Node_isValid(oNNode));
    /* remove from parent's list */
    if(oNNode->oNParent != NULL) {
-      if(DynArray_bsearch(
-            oNNode->oNParent->oDChildren,
-            oNNode, &ulIndex,
-            (int (*)(const void *, const void *)) Node_compare)
-        )
-         (void) DynArray_removeAt(oNNode->oNParent->oDChildren,
-                                  ulIndex);
-   }
-   /* recursively remove children if directory */
-   if(!Node_getType(oNNode)) {
-      while(DynArray_getLength(oNNode->oDChildren) != 0) {
-         ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
+      if(Node_hasChildName(oNNode->oNParent, oNNode->pcName,
+                           oNNode->ulNameLength, &ulIndex))
+         Node_removeChild(oNNode->oNParent, ulIndex);
+   }
+   if(oNNode->oNShare != NULL) {
+      /* a lazy copy owns no children */
+      Node_unlinkReferrer(oNNode);
+      oNNode->oNShare = NULL;
+      ulShared--;
+   }
+   else if(oNNode->oNReferrers != NULL) {
+      /* lazy copies still present these children, so hand them over
+         to the first copy, and make the others share that copy */
+      Node_T oNHeir = oNNode->oNReferrers;
+      Node_T oNOther;
+      size_t ulChild;
+      oNNode->oNReferrers = oNHeir->oNNextReferrer;
+      oNHeir->oNNextReferrer = NULL;
+      oNHeir->oNShare = NULL;
+      oNHeir->psChildren = oNNode->psChildren;
+      oNHeir->oNOnly = oNNode->oNOnly;
+      oNHeir->oPPacked = oNNode->oPPacked;
+      oNNode->psChildren = NULL;
+      oNNode->oNOnly = NULL;
+      oNNode->oPPacked = NULL;
+      ulShared--;
+      if(oNHeir->oPPacked == NULL)
+         for(ulChild = 0; ulChild < Node_countOwn(oNHeir); ulChild++)
+            Node_ownChild(oNHeir, ulChild)->oNParent = oNHeir;
+      for(oNOther = oNNode->oNReferrers; oNOther != NULL;
+          oNOther = oNOther->oNNextReferrer)
+         oNOther->oNShare = oNHeir;
+      oNHeir->oNReferrers = oNNode->oNReferrers;
+      oNNode->oNReferrers = NULL;
+   }
+   else if(oNNode->bOwned)
+      /* release owned contents that are not inline */
+      Node_releaseContents(oNNode);
+   else if(oNNode->oPPacked != NULL)
+      /* packed files go with their pack */
+      ulCount += Node_dropPack(oNNode);
+   else if(!Node_getType(oNNode)) {
+      /* recursively remove children if directory */
+      while(Node_countOwn(oNNode) != 0) {
+         ulCount += Node_free(Node_ownChild(oNNode, 0));
       }
-      DynArray_free(oNNode->oDChildren);
+      Node_freeChildren(oNNode);
    }
 
-   /* remove path */
-   Path_free(oNNode->oPPath);
-   /* finally, free the struct node */
-   free(oNNode);
+   /* remove name, unless it is in the node's own allocation */
+   if(oNNode->pcName != Node_inlineName(oNNode))
+      free(oNNode->pcName);
+   oNNode->pcName = NULL;
+   /* finally, free the struct node, unless it is pinned: then it
+      lingers as a removed node until Node_unpin releases it */
+   if(oNNode->ulPins != 0) {
+      oNNode->oNParent = NULL;
+      oNNode->bRemoved = TRUE;
+   }
+   else
+      free(oNNode);
    ulCount++;
    return ulCount;
 }
 
 /* see nodeFT.h for specification*/
-Path_T Node_getPath(Node_T oNNode) {
+int Node_move(Node_T oNNode, Node_T oNNewParent, const char *pcName,
+              size_t ulNameLength) {
+   char *pcNewName;
+   char *pcOldName;
+   size_t ulOldLength;
+   size_t ulOldIndex = 0;
+   size_t ulNewIndex = 0;
+   assert(oNNode != NULL);
+   assert(pcName != NULL);
+   assert(ulNameLength != 0);
+   assert(memchr(pcName, '/', ulNameLength) == NULL);
+   assert((oNNode->oNParent == NULL) == (oNNewParent == NULL));
+   assert(oNNewParent == NULL || !Node_getType(oNNewParent));
+   assert(oNNewParent == NULL || oNNewParent->oNShare == NULL);
+   assert(oNNewParent == NULL || oNNewParent->oPPacked == NULL);
+
+   if(oNNewParent != NULL &&
+      Node_hasChildName(oNNewParent, pcName, ulNameLength, &ulNewIndex))
+      return ALREADY_IN_TREE;
+   pcNewName = Node_copyName(pcName, ulNameLength);
+   if(pcNewName == NULL)
+      return MEMORY_ERROR;
+   pcOldName = oNNode->pcName;
+   ulOldLength = oNNode->ulNameLength;
+   if(oNNewParent != NULL)
+      (void) Node_hasChildName(oNNode->oNParent, pcOldName, ulOldLength,
+                               &ulOldIndex);
+   /* the new name goes in first, since the node's new entry is keyed
+      by it */
+   oNNode->pcName = pcNewName;
+   oNNode->ulNameLength = ulNameLength;
+   if(oNNewParent != NULL) {
+      if(oNNewParent == oNNode->oNParent) {
+         /* the array never shrinks, so re-adding after the removal
+            cannot fail */
+         Node_removeChild(oNNewParent, ulOldIndex);
+         if(ulNewIndex > ulOldIndex)
+            ulNewIndex--;
+         (void) Node_addChild(oNNewParent, oNNode, ulNewIndex);
+      }
+      else {
+         /* link into the new parent first, so that a failure leaves
+            the node where it was */
+         if(Node_addChild(oNNewParent, oNNode, ulNewIndex) != SUCCESS) {
+            oNNode->pcName = pcOldName;
+            oNNode->ulNameLength = ulOldLength;
+            free(pcNewName);
+            return MEMORY_ERROR;
+         }
+         Node_removeChild(oNNode->oNParent, ulOldIndex);
+      }
+   }
+   if(pcOldName != Node_inlineName(oNNode))
+      free(pcOldName);
+   oNNode->oNParent = oNNewParent;
+   assert(CheckerFT_Node_isValid(oNNode));
+   return SUCCESS;
+}
+
+/* see nodeFT.h for specification*/
+void Node_pin(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(!oNNode->bRemoved);
+   if(oNNode->ulPins++ == 0)
+      ulPinned++;
+}
+
+/* see nodeFT.h for specification*/
+void Node_unpin(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->ulPins > 0);
+   oNNode->ulPins--;
+   if(oNNode->ulPins != 0)
+      return;
+   ulPinned--;
+   if(oNNode->bRemoved)
+      free(oNNode);
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_isRemoved(Node_T oNNode) {
+   assert(oNNode != NULL);
+   return oNNode->bRemoved;
+}
+
+/*
+  Puts oNFresh, a node allocated for a name of oNPinned's length and
+  no inline contents, in the place of pinned directory oNPinned, which
+  has a parent: oNFresh takes over its name, children, sharing and
+  parent, and oNPinned is left removed, as Node_free leaves it.
+*/
+static void Node_replacePinned(Node_T oNPinned, Node_T oNFresh) {
+   Node_T oNParent;
+   Node_T oNOther;
+   Node_T *poNLink;
+   size_t ulIndex = 0;
+   size_t ulChild;
+   assert(oNPinned != NULL);
+   assert(oNFresh != NULL);
+   assert(oNPinned->ulPins != 0 && !oNPinned->ftType);
+   assert(oNPinned->oNParent != NULL);
+
+   *oNFresh = *oNPinned;
+   oNFresh->ulInline = 0;
+   oNFresh->ulPins = 0;
+   if(oNPinned->pcName == Node_inlineName(oNPinned)) {
+      oNFresh->pcName = Node_inlineName(oNFresh);
+      memcpy(oNFresh->pcName, oNPinned->pcName, oNPinned->ulNameLength);
+   }
+
+   /* relink everything that pointed to oNPinned */
+   oNParent = oNPinned->oNParent;
+   (void) Node_hasChildName(oNParent, oNPinned->pcName,
+                            oNPinned->ulNameLength, &ulIndex);
+   if(oNParent->psChildren != NULL)
+      Node_entries(oNParent->psChildren)[ulIndex].oNChild = oNFresh;
+   else
+      oNParent->oNOnly = oNFresh;
+   if(oNFresh->oNShare != NULL) {
+      poNLink = &oNFresh->oNShare->oNReferrers;
+      while(*poNLink != oNPinned)
+         poNLink = &(*poNLink)->oNNextReferrer;
+      *poNLink = oNFresh;
+   }
+   else if(oNFresh->oPPacked == NULL)
+      for(ulChild = 0; ulChild < Node_countOwn(oNFresh); ulChild++)
+         Node_ownChild(oNFresh, ulChild)->oNParent = oNFresh;
+   for(oNOther = oNFresh->oNReferrers; oNOther != NULL;
+       oNOther = oNOther->oNNextReferrer)
+      oNOther->oNShare = oNFresh;
+
+   oNPinned->psChildren = NULL;
+   oNPinned->oNOnly = NULL;
+   oNPinned->oNShare = NULL;
+   oNPinned->oPPacked = NULL;
+   oNPinned->oNReferrers = NULL;
+   oNPinned->oNNextReferrer = NULL;
+   oNPinned->oNParent = NULL;
+   oNPinned->pcName = NULL;
+   oNPinned->bRemoved = TRUE;
+}
+
+/*
+  Counts the pinned directories below oNNode that Node_free would hand
+  over to a lazy copy, bShared being TRUE if oNNode's own children
+  would be handed over, and stores them, parents first, at aoNPinned
+  if it is not NULL.
+*/
+static size_t Node_findHandedPins(Node_T oNNode, boolean bShared,
+                                  Node_T *aoNPinned) {
+   Node_T oNChild;
+   size_t ulFound = 0;
+   size_t ulChild;
+   assert(oNNode != NULL);
+   if(oNNode->ftType || oNNode->oNShare != NULL ||
+      oNNode->oPPacked != NULL)
+      return 0;
+   bShared = (boolean) (bShared || oNNode->oNReferrers != NULL);
+   for(ulChild = 0; ulChild < Node_countOwn(oNNode); ulChild++) {
+      oNChild = Node_ownChild(oNNode, ulChild);
+      if(bShared && oNChild->ulPins != 0) {
+         if(aoNPinned != NULL)
+            aoNPinned[ulFound] = oNChild;
+         ulFound++;
+      }
+      ulFound += Node_findHandedPins(oNChild, bShared,
+                                     aoNPinned != NULL ?
+                                     aoNPinned + ulFound : NULL);
+   }
+   return ulFound;
+}
+
+/* see nodeFT.h for specification*/
+int Node_retirePins(Node_T oNNode) {
+   Node_T *aoNNodes;
+   size_t ulFound;
+   size_t i;
+   assert(oNNode != NULL);
+   if(ulPinned == 0)
+      return SUCCESS;
+   ulFound = Node_findHandedPins(oNNode, FALSE, NULL);
+   if(ulFound == 0)
+      return SUCCESS;
+
+   /* the pinned nodes, then their fresh nodes, all allocated before
+      any is replaced, so that failing changes nothing */
+   aoNNodes = calloc(2 * ulFound, sizeof(Node_T));
+   if(aoNNodes == NULL)
+      return MEMORY_ERROR;
+   (void) Node_findHandedPins(oNNode, FALSE, aoNNodes);
+   for(i = 0; i < ulFound; i++) {
+      aoNNodes[ulFound + i] = malloc(sizeof(struct node)
+                                     + aoNNodes[i]->ulNameLength);
+      if(aoNNodes[ulFound + i] == NULL) {
+         while(i-- > 0)
+            free(aoNNodes[ulFound + i]);
+         free(aoNNodes);
+         return MEMORY_ERROR;
+      }
+   }
+   /* parents come first, so each pinned node's parent is in place */
+   for(i = 0; i < ulFound; i++)
+      Node_replacePinned(aoNNodes[i], aoNNodes[ulFound + i]);
+   free(aoNNodes);
+   return SUCCESS;
+}
+
+/* see nodeFT.h for specification*/
+const char *Node_getName(Node_T oNNode, size_t *pulLength) {
+   assert(oNNode != NULL);
+   assert(pulLength != NULL);
+   *pulLength = oNNode->ulNameLength;
+   return oNNode->pcName;
+}
+
+/* see nodeFT.h for specification*/
+size_t Node_getDepth(Node_T oNNode) {
+   size_t ulDepth = 0;
+   assert(oNNode != NULL);
+   for(; oNNode != NULL; oNNode = oNNode->oNParent)
+      ulDepth++;
+   return ulDepth;
+}
+
+/* see nodeFT.h for specification*/
+size_t Node_getPathLength(Node_T oNNode) {
+   size_t ulLength;
    assert(oNNode != NULL);
-   return oNNode->oPPath;
+   /* one name per level, with a '/' before each but the root's */
+   ulLength = oNNode->ulNameLength;
+   for(oNNode = oNNode->oNParent; oNNode != NULL;
+       oNNode = oNNode->oNParent)
+      ulLength += oNNode->ulNameLength + 1;
+   return ulLength;
 }
 
 /* see nodeFT.h for specification*/
-boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
-                         size_t *pulChildID) {
+void Node_writePath(Node_T oNNode, char *pcBuf) {
+   size_t ulEnd;
+   assert(oNNode != NULL);
+   assert(pcBuf != NULL);
+   /* fill in the names from the last component back to the root */
+   ulEnd = Node_getPathLength(oNNode);
+   pcBuf[ulEnd] = '\0';
+   for(;;) {
+      ulEnd -= oNNode->ulNameLength;
+      memcpy(pcBuf + ulEnd, oNNode->pcName, oNNode->ulNameLength);
+      oNNode = oNNode->oNParent;
+      if(oNNode == NULL)
+         break;
+      pcBuf[--ulEnd] = '/';
+   }
+   assert(ulEnd == 0);
+}
+
+/* see nodeFT.h for specification*/
+int Node_getPath(Node_T oNNode, Path_T *poPResult) {
+   char *pcPath;
+   int iStatus;
+   assert(oNNode != NULL);
+   assert(poPResult != NULL);
+   pcPath = malloc(Node_getPathLength(oNNode) + 1);
+   if(pcPath == NULL) {
+      *poPResult = NULL;
+      return MEMORY_ERROR;
+   }
+   Node_writePath(oNNode, pcPath);
+   iStatus = Path_new(pcPath, poPResult);
+   free(pcPath);
+   return iStatus;
+}
+
+/*
+  Searches the entries of children array psArray for the name psKey,
+  as described for Node_hasChildName: by key, then by the whole names
+  of the children whose keys match.
+*/
+static boolean Node_searchEntries(struct childArray *psArray,
+                                  const struct nodeKey *psKey,
+                                  size_t *pulChildID) {
+   struct childEntry *psEntries;
+   size_t ulKey, ulFound;
+   size_t ulLow = 0;
+   size_t ulHigh;
+   size_t ulMid;
+   int iCompare;
+   assert(psArray != NULL);
+   assert(psKey != NULL);
+   assert(pulChildID != NULL);
+   psEntries = Node_entries(psArray);
+   ulKey = Node_key(psKey->pcPath, psKey->ulLength);
+   ulHigh = psArray->ulLength;
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      /* without the file bit */
+      ulFound = psEntries[ulMid].ulKey & ~(size_t) 0xFF;
+      if(ulFound != ulKey)
+         iCompare = ulFound < ulKey ? -1 : 1;
+      else
+         iCompare = Node_compareName(psEntries[ulMid].oNChild, psKey);
+      if(iCompare == 0) {
+         *pulChildID = ulMid;
+         return TRUE;
+      }
+      if(iCompare < 0)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   *pulChildID = ulLow;
+   return FALSE;
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_hasChildName(Node_T oNParent, const char *pcName,
+                          size_t ulLength, size_t *pulChildID) {
+   struct nodeKey sKey;
+   Node_T oNDir;
+   int iCompare;
    assert(oNParent != NULL);
-   assert(oPPath != NULL);
+   assert(pcName != NULL);
    assert(pulChildID != NULL);
    if (oNParent->ftType) return FALSE;
-   /* *pulChildID is the index into oNParent->oDChildren */
-   return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) Node_compareString);
+   sKey.pcPath = pcName;
+   sKey.ulLength = ulLength;
+   /* *pulChildID is the index into the presented children */
+   oNDir = Node_children(oNParent);
+   if(oNDir->oPPacked != NULL)
+      return Pack_find(oNDir->oPPacked, pcName, ulLength, pulChildID);
+   if(oNDir->psChildren != NULL)
+      return Node_searchEntries(oNDir->psChildren, &sKey, pulChildID);
+   /* no array: at most one child to compare with */
+   if(oNDir->oNOnly == NULL) {
+      *pulChildID = 0;
+      return FALSE;
+   }
+   iCompare = Node_compareName(oNDir->oNOnly, &sKey);
+   *pulChildID = iCompare < 0;
+   return iCompare == 0;
+}
+
+/* The stages of a search (see struct nodeSearch): its next step reads
+   the directory, the header of its children array, the entry in the
+   middle of the range left, or the child whose name must be compared
+   whole; or it has ended */
+enum { NODE_SEARCH_ENTER, NODE_SEARCH_ARRAY, NODE_SEARCH_PROBE,
+       NODE_SEARCH_COMPARE, NODE_SEARCH_DONE };
+
+/* The most entries whose range a search probes all in one step, as
+   many as fit in a 64-byte line */
+enum { NODE_SEARCH_NEAR = 64 / sizeof(struct childEntry) };
+
+/* Asks the processor to start loading the cache line at pvAddress,
+   where the compiler offers a way to. */
+static void Node_prefetchLine(const void *pvAddress) {
+#ifdef __GNUC__
+   __builtin_prefetch(pvAddress);
+#else
+   (void) pvAddress;
+#endif
+}
+
+/* Prefetches the fields of oNNode that a lookup reads, which may
+   straddle two lines, since nodes are not aligned to lines. */
+static void Node_prefetchNode(Node_T oNNode) {
+   Node_prefetchLine(oNNode);
+   Node_prefetchLine((const char *) oNNode + 63);
+}
+
+/* Prefetches those fields of oNNode, and its name, where it usually
+   is: inline, with no inline contents before it. */
+static void Node_prefetchNamed(Node_T oNNode) {
+   Node_prefetchNode(oNNode);
+   Node_prefetchLine(oNNode + 1);
+}
+
+/*
+  Ends *psSearch if no entries are left in its range, and returns
+  FALSE; otherwise makes its next step probe the middle entry, which
+  it prefetches, and returns TRUE. A range of at most
+  NODE_SEARCH_NEAR entries spans at most two lines, which are both
+  prefetched, for the next step to finish the search in.
+*/
+static boolean Node_nextProbe(struct nodeSearch *psSearch) {
+   struct childEntry *psEntries;
+   assert(psSearch != NULL);
+   if(psSearch->ulLow >= psSearch->ulHigh) {
+      psSearch->iStage = NODE_SEARCH_DONE;
+      return FALSE;
+   }
+   psSearch->iStage = NODE_SEARCH_PROBE;
+   psEntries = Node_entries(psSearch->oNDir->psChildren);
+   if(psSearch->ulHigh - psSearch->ulLow <= NODE_SEARCH_NEAR) {
+      Node_prefetchLine(psEntries + psSearch->ulLow);
+      Node_prefetchLine(psEntries + psSearch->ulHigh - 1);
+   }
+   else
+      Node_prefetchLine(psEntries + psSearch->ulLow
+                        + (psSearch->ulHigh - psSearch->ulLow) / 2);
+   return TRUE;
+}
+
+/* see nodeFT.h for specification*/
+void Node_startSearch(struct nodeSearch *psSearch, Node_T oNParent,
+                      const char *pcName, size_t ulLength) {
+   assert(psSearch != NULL);
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+   psSearch->oNDir = oNParent;
+   psSearch->pcName = pcName;
+   psSearch->ulLength = ulLength;
+   psSearch->ulLow = 0;
+   psSearch->ulHigh = 0;
+   psSearch->iStage = NODE_SEARCH_ENTER;
+   psSearch->bFound = FALSE;
+   Node_prefetchNode(oNParent);
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_stepSearch(struct nodeSearch *psSearch) {
+   struct childEntry *psEntry;
+   struct nodeKey sKey;
+   Node_T oNDir;
+   size_t ulMid;
+   int iCompare;
+   boolean bNear;
+   assert(psSearch != NULL);
+   oNDir = psSearch->oNDir;
+   ulMid = psSearch->ulLow + (psSearch->ulHigh - psSearch->ulLow) / 2;
+   switch(psSearch->iStage) {
+      case NODE_SEARCH_ENTER:
+         if(oNDir->ftType || (oNDir->oNShare == NULL &&
+                              oNDir->oPPacked == NULL &&
+                              Node_countOwn(oNDir) == 0)) {
+            psSearch->iStage = NODE_SEARCH_DONE;
+            return FALSE;
+         }
+         /* a lazy copy's children are those of the directory it
+            shares, which is not lazy itself */
+         if(oNDir->oNShare != NULL) {
+            psSearch->oNDir = oNDir->oNShare;
+            Node_prefetchNode(psSearch->oNDir);
+            return TRUE;
+         }
+         if(oNDir->oPPacked != NULL) {
+            psSearch->bFound = Pack_find(oNDir->oPPacked,
+                                         psSearch->pcName,
+                                         psSearch->ulLength,
+                                         &psSearch->ulLow);
+            psSearch->iStage = NODE_SEARCH_DONE;
+            return FALSE;
+         }
+         if(oNDir->psChildren != NULL) {
+            Node_prefetchLine(oNDir->psChildren);
+            psSearch->iStage = NODE_SEARCH_ARRAY;
+            return TRUE;
+         }
+         /* no array: the only child is compared with */
+         psSearch->ulHigh = 1;
+         Node_prefetchNamed(oNDir->oNOnly);
+         psSearch->iStage = NODE_SEARCH_COMPARE;
+         return TRUE;
+
+      case NODE_SEARCH_ARRAY:
+         psSearch->ulKey = Node_key(psSearch->pcName, psSearch->ulLength);
+         psSearch->ulHigh = oNDir->psChildren->ulLength;
+         return Node_nextProbe(psSearch);
+
+      case NODE_SEARCH_PROBE:
+         /* a range that was near enough is all prefetched */
+         bNear = psSearch->ulHigh - psSearch->ulLow <= NODE_SEARCH_NEAR;
+         for(;;) {
+            psEntry = Node_entries(oNDir->psChildren) + ulMid;
+            /* without the file bit */
+            if((psEntry->ulKey & ~(size_t) 0xFF) == psSearch->ulKey) {
+               Node_prefetchNamed(psEntry->oNChild);
+               psSearch->iStage = NODE_SEARCH_COMPARE;
+               return TRUE;
+            }
+            if((psEntry->ulKey & ~(size_t) 0xFF) < psSearch->ulKey)
+               psSearch->ulLow = ulMid + 1;
+            else
+               psSearch->ulHigh = ulMid;
+            if(!bNear || psSearch->ulLow >= psSearch->ulHigh)
+               return Node_nextProbe(psSearch);
+            ulMid = psSearch->ulLow
+               + (psSearch->ulHigh - psSearch->ulLow) / 2;
+         }
+
+      case NODE_SEARCH_COMPARE:
+         sKey.pcPath = psSearch->pcName;
+         sKey.ulLength = psSearch->ulLength;
+         iCompare = Node_compareName(Node_ownChild(oNDir, ulMid), &sKey);
+         if(iCompare == 0) {
+            psSearch->ulLow = ulMid;
+            psSearch->bFound = TRUE;
+            psSearch->iStage = NODE_SEARCH_DONE;
+            return FALSE;
+         }
+         if(iCompare < 0)
+            psSearch->ulLow = ulMid + 1;
+         else
+            psSearch->ulHigh = ulMid;
+         /* the only child, if there is no array, was the last */
+         if(oNDir->psChildren == NULL) {
+            psSearch->iStage = NODE_SEARCH_DONE;
+            return FALSE;
+         }
+         return Node_nextProbe(psSearch);
+
+      default:
+         return FALSE;
+   }
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_endSearch(const struct nodeSearch *psSearch,
+                       size_t *pulChildID) {
+   assert(psSearch != NULL);
+   assert(psSearch->iStage == NODE_SEARCH_DONE);
+   assert(pulChildID != NULL);
+   *pulChildID = psSearch->ulLow;
+   return psSearch->bFound;
 }
 
 /* see nodeFT.h for specification*/
 size_t Node_getNumChildren(Node_T oNParent) {
    assert(oNParent != NULL);
    if (oNParent->ftType) return 0;
-   return DynArray_getLength(oNParent->oDChildren);
+   return Node_countOwn(Node_children(oNParent));
+}
+
+/* see nodeFT.h for specification*/
+boolean Node_isChildFile(Node_T oNParent, size_t ulChildID) {
+   Node_T oNDir;
+   assert(oNParent != NULL);
+   assert(ulChildID < Node_getNumChildren(oNParent));
+   oNDir = Node_children(oNParent);
+   /* packed children are all files */
+   if(oNDir->oPPacked != NULL)
+      return TRUE;
+   if(oNDir->psChildren != NULL)
+      return (Node_entries(oNDir->psChildren)[ulChildID].ulKey & 1) != 0;
+   return oNDir->oNOnly->ftType;
 }
 
 /* see nodeFT.h for specification*/
@@ -345,15 +1641,18 @@ int Node_getChild(Node_T oNParent, size_t ulChildID,
    assert(oNParent != NULL);
    assert(poNResult != NULL);
    if (oNParent->ftType) return NOT_A_DIRECTORY;
-   /* ulChildID is the index into oNParent->oDChildren */
+   /* ulChildID is the index into the presented children */
    if(ulChildID >= Node_getNumChildren(oNParent)) {
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
-   else {
-      *poNResult = DynArray_get(oNParent->oDChildren, ulChildID);
-      return SUCCESS;
+   /* a packed directory's files become nodes when one is asked for */
+   if(Node_unpack(oNParent) != SUCCESS) {
+      *poNResult = NULL;
+      return MEMORY_ERROR;
    }
+   *poNResult = Node_ownChild(Node_children(oNParent), ulChildID);
+   return SUCCESS;
 }
 
 /* see nodeFT.h for specification*/
@@ -366,9 +1665,9 @@ Node_T Node_getParent(Node_T oNNode) {
 char *Node_toString(Node_T oNNode) {
    char *copyPath;
    assert(oNNode != NULL);
-   copyPath = malloc(Path_getStrLength(Node_getPath(oNNode))+1);
+   copyPath = malloc(Node_getPathLength(oNNode)+1);
    if(copyPath == NULL)
       return NULL;
-   else
-      return strcpy(copyPath, Path_getPathname(Node_getPath(oNNode)));
+   Node_writePath(oNNode, copyPath);
+   return copyPath;
 }
\ No newline at end of file
@@ -7,12 +7,14 @@
 #include <stddef.h>
 #include "a4def.h"
 #include "path.h"
+#include "contentFT.h"
 
 /* A Node_T is a node in a Directory Tree */
 typedef struct node *Node_T;
 /* Returns the boolean type of oNNode: file(TRUE), directory (FALSE)*/
 boolean Node_getType(Node_T oNNode);
-/* Returns a pointer to the file contents of oNNode*/
+/* Returns a pointer to the file contents of oNNode, or NULL if they
+   are chunked (see Node_flatten)*/
 void *Node_getFileContents(Node_T oNNode);
 /* Returns the size of contents of oNNode */
 size_t Node_getSizeContents(Node_T oNNode);
@@ -24,57 +26,309 @@ int SUCCESS*/
 int Node_setSizeContents(Node_T oNNode, size_t ulNewLength);
 
 /*
-  Creates a new node for directory in the Directory Tree, with path   
-  oPPath and parent oNParent. Returns an int SUCCESS status and sets 
-  *poNResult to be the new node if successful. Otherwise, sets 
+  Creates a new node for directory in the Directory Tree, named by the
+  ulNameLength characters at pcName (the last component of its path,
+  which need not be '\0'-terminated), with parent oNParent or as the
+  root if oNParent is NULL. Returns an int SUCCESS status and sets
+  *poNResult to be the new node if successful. Otherwise, sets
   *poNResult to NULL and returns status:
   * MEMORY_ERROR if memory could not be allocated to complete request
-  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-  * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-  * ALREADY_IN_TREE if oNParent already has a child with this path
-*/
-int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult);
-/*
-  Creates a new node for file in the Directory Tree, with path oPPath,
-  parent oNParent, contents pvNewContents with size ulNewLength. 
-  Returns an int SUCCESS status and sets *poNResult to be the new node
-  if successful. Otherwise, sets *poNResult to NULL and returns status:
+  * NOT_A_DIRECTORY if oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child with this name
+*/
+int Node_newDir(const char *pcName, size_t ulNameLength,
+                Node_T oNParent, Node_T *poNResult);
+/*
+  Creates a new node for file in the Directory Tree, named and placed
+  as by Node_newDir, with contents pvNewContents with size
+  ulNewLength. Returns an int SUCCESS status and sets *poNResult to be
+  the new node if successful. Otherwise, sets *poNResult to NULL and
+  returns status:
   * MEMORY_ERROR if memory could not be allocated to complete request
-  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-  * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-  * ALREADY_IN_TREE if oNParent already has a child with this path
+  * NOT_A_DIRECTORY if oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child with this name
+*/
+int Node_newFile(const char *pcName, size_t ulNameLength,
+                 Node_T oNParent, Node_T *poNResult,
+                 void *pvNewContents, size_t ulNewLength);
+/*
+  Creates a new file node like Node_newFile, except that the node owns
+  a copy of the ulNewLength bytes at pvNewContents rather than
+  borrowing them: contents of up to 64 bytes are stored inline in the
+  node's own allocation, and larger ones in oSStore (shared with any
+  identical contents, if it deduplicates). The copy is released when
+  the node is freed. If pvNewContents is NULL, the contents are
+  ulNewLength zeros, held as a hole that takes no storage (see
+  extentFT.h). Returns the same statuses as Node_newFile.
+*/
+int Node_newOwnedFile(const char *pcName, size_t ulNameLength,
+                      Node_T oNParent, Node_T *poNResult,
+                      const void *pvNewContents, size_t ulNewLength,
+                      ContentStore_T oSStore);
+/*
+  Replaces the contents of oNNode, which must have been created by
+  Node_newOwnedFile or copied from such a node, with a copy of the
+  ulNewLength bytes at pvNewContents, stored as Node_newOwnedFile
+  stores them, and releases the old contents. Returns SUCCESS, or
+  MEMORY_ERROR (leaving oNNode unchanged) if memory could not be
+  allocated.
+*/
+int Node_replaceOwnedContents(Node_T oNNode, const void *pvNewContents,
+                              size_t ulNewLength,
+                              ContentStore_T oSStore);
+/*
+  Makes owned file oNNode hold the contents of oCContents, taking over
+  the caller's reference to it, and releases its old contents.
+*/
+void Node_setContent(Node_T oNNode, Content_T oCContents);
+/* Returns TRUE if oNNode is a file that owns its contents. */
+boolean Node_ownsContents(Node_T oNNode);
+/*
+  Returns the number of bytes of storage holding file oNNode's owned
+  contents, not counting any Content_T already visited in pass ulPass
+  (see Content_visit), or 0 if oNNode does not own its contents.
+*/
+size_t Node_countStored(Node_T oNNode, unsigned long ulPass);
+/*
+  Copies up to ulLength bytes of file oNNode's contents, starting at
+  offset ulOffset, to pvBuf. Returns the number of bytes copied, which
+  is less than ulLength only if the contents end first. NULL borrowed
+  contents read as zeros. Changes nothing, so may be called from
+  several threads at once while the tree is not being changed.
+*/
+size_t Node_readAt(Node_T oNNode, size_t ulOffset, void *pvBuf,
+                   size_t ulLength);
+/*
+  Writes the ulLength bytes at pvBytes into owned file oNNode's
+  contents at offset ulOffset, extending them if necessary, with zeros
+  between their old end and ulOffset (a hole, unless they are inline).
+  Contents that do not fit inline are first split into chunks in
+  oSStore (see extentFT.h), after which each write costs in proportion
+  to the chunks it touches. Returns
+  SUCCESS, or MEMORY_ERROR (leaving the contents unchanged) if memory
+  could not be allocated.
+*/
+int Node_writeAt(Node_T oNNode, size_t ulOffset, const void *pvBytes,
+                 size_t ulLength, ContentStore_T oSStore);
+/*
+  Shortens or extends owned file oNNode's contents to ulLength bytes,
+  extending them with zeros as Node_writeAt would. Returns SUCCESS,
+  or MEMORY_ERROR (leaving the contents unchanged) if memory could not
+  be allocated.
+*/
+int Node_truncate(Node_T oNNode, size_t ulLength,
+                  ContentStore_T oSStore);
+/*
+  Gathers owned file oNNode's contents, if they are chunked, back into
+  one block from oSStore (or inline), so that Node_getFileContents can
+  return them. Returns SUCCESS, or MEMORY_ERROR (leaving them chunked)
+  if memory could not be allocated.
+*/
+int Node_flatten(Node_T oNNode, ContentStore_T oSStore);
+/*
+  Creates a new node named and placed as by Node_newDir that is a copy
+  of oNSource. A file copy is an ordinary file with the same contents;
+  a copy of an owned file owns its contents too, sharing large ones
+  with oNSource until either is replaced.
+  A directory copy is lazy: it presents the children of oNSource (or
+  of the directory oNSource shares, if it is lazy itself) through
+  Node_getNumChildren, Node_getChild and Node_hasChildName without
+  copying them, so this costs the same for any size of hierarchy.
+  Returns the same statuses as Node_newDir.
+*/
+int Node_newCopy(const char *pcName, size_t ulNameLength,
+                 Node_T oNParent, Node_T oNSource, Node_T *poNResult);
+/*
+  Returns the directory whose children lazy copy oNNode presents, or
+  NULL if oNNode is not a lazy copy. Children may only be added to,
+  removed from or moved into directories that are not lazy copies.
+*/
+Node_T Node_getShare(Node_T oNNode);
+/*
+  Returns the number of lazy copies in existence. When it is 0, no
+  node can be shared and Node_unshare need not be called.
+*/
+size_t Node_countShared(void);
+/*
+  Gives lazy copy oNNode children of its own: a copy (as made by
+  Node_newCopy) of each child of the directory it shares, so that it
+  costs one node per child, and directories one level down are still
+  shared. Stores the number of nodes created in *pulNew. Does nothing
+  if oNNode is not a lazy copy. Returns SUCCESS, or MEMORY_ERROR
+  (leaving oNNode lazy) if memory could not be allocated.
+*/
+int Node_materialize(Node_T oNNode, size_t *pulNew);
+/*
+  Materializes every lazy copy of oNNode, so that changes to oNNode's
+  children are not seen through any other node, and stores the number
+  of nodes created in *pulNew. Returns SUCCESS, or MEMORY_ERROR if
+  memory could not be allocated (after which some copies may still
+  share oNNode).
+*/
+int Node_unshare(Node_T oNNode, size_t *pulNew);
+/*
+  Packs directory oNDir: replaces the nodes of its files with one
+  front-coded block (see packFT.h) holding each file's name, contents
+  pointer and size, which Node_hasChildName, Node_getNumChildren,
+  Node_getPackedName and Node_getPackedSize read in place. oNDir is
+  packed only if it is not a lazy copy and has at least 8 children,
+  all of them files with borrowed contents and no pins. Returns TRUE
+  if oNDir was packed, or FALSE (changing nothing) if it was not
+  eligible or memory could not be allocated.
+*/
+boolean Node_pack(Node_T oNDir);
+/*
+  Gives the files of the directory whose children oNNode presents
+  nodes again, if it is packed; Node_getChild and the creation of a
+  child do so as needed. Returns SUCCESS, or MEMORY_ERROR (leaving it
+  packed) if memory could not be allocated.
+*/
+int Node_unpack(Node_T oNNode);
+/* Returns TRUE if oNNode is a directory whose children are packed. */
+boolean Node_isPacked(Node_T oNNode);
+/*
+  Returns the name, which is not '\0'-terminated and is valid until
+  the directory is next read or changed, of child ulChildID of packed
+  directory oNDir, and stores its length in *pulLength. Packed
+  children are all files.
 */
-int Node_newFile(Path_T oPPath, Node_T oNParent, Node_T *poNResult, 
-                          void *pvNewContents, size_t ulNewLength);
+const char *Node_getPackedName(Node_T oNDir, size_t ulChildID,
+                               size_t *pulLength);
+/* Returns the size of the contents of child ulChildID of packed
+   directory oNDir. */
+size_t Node_getPackedSize(Node_T oNDir, size_t ulChildID);
+/*
+  Returns the number of changes made so far to directories' children,
+  across all trees: a clock that Node_getChanged readings are on.
+  Unpacking a directory is one change, however many files it holds.
+*/
+unsigned long Node_countChanges(void);
+/* Returns the value of Node_countChanges when directory oNNode's
+   children last changed, or when it was created. */
+unsigned long Node_getChanged(Node_T oNNode);
+/*
+  Stores the number of packed directories in existence, across all
+  trees, in *pulDirs, the number of files in them in *pulFiles, the
+  bytes their packs take in *pulBytes, and the bytes those files
+  would take as nodes in *pulNodeBytes.
+*/
+void Node_getPackSizes(size_t *pulDirs, size_t *pulFiles,
+                       size_t *pulBytes, size_t *pulNodeBytes);
 /*
   Destroys and frees all memory allocated for the subtree rooted at
   oNNode, i.e., deletes this node and all its descendents. Returns the
-  number of nodes deleted.
+  number of nodes deleted. If oNNode has lazy copies, its children are
+  handed over to one of them instead and only oNNode is deleted.
 */
 size_t Node_free(Node_T oNNode);
-/* Returns the path object representing oNNode's absolute path. */
-Path_T Node_getPath(Node_T oNNode);
 /*
-  Returns TRUE if oNParent has a child with path oPPath. Returns
+  Moves oNNode, with its whole subtree, to be the child of directory
+  oNNewParent named by the ulNameLength characters at pcName. If
+  oNNode is the root, oNNewParent must be NULL and the root is just
+  renamed. oNNewParent must not be in oNNode's subtree. Only
+  oNNode itself is changed, so the cost does not depend on the size
+  of the subtree. Returns SUCCESS, or otherwise changes nothing and
+  returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * ALREADY_IN_TREE if oNNewParent already has a child with this name
+*/
+int Node_move(Node_T oNNode, Node_T oNNewParent, const char *pcName,
+              size_t ulNameLength);
+/*
+  Returns oNNode's name, the last component of its absolute path,
+  which is not '\0'-terminated, and stores its length in *pulLength.
+*/
+const char *Node_getName(Node_T oNNode, size_t *pulLength);
+/*
+  Returns the depth of oNNode's absolute path, found by following
+  parent links.
+*/
+size_t Node_getDepth(Node_T oNNode);
+/* Returns the length of oNNode's absolute path, as by strlen. */
+size_t Node_getPathLength(Node_T oNNode);
+/*
+  Writes oNNode's '\0'-terminated absolute path into pcBuf, which must
+  have room for Node_getPathLength(oNNode) + 1 characters.
+*/
+void Node_writePath(Node_T oNNode, char *pcBuf);
+/*
+  Derives the path object representing oNNode's absolute path from
+  the names of oNNode and its ancestors, and stores it in *poPResult.
+  The caller owns the result and must Path_free it. Returns SUCCESS,
+  or sets *poPResult to NULL and returns MEMORY_ERROR if memory could
+  not be allocated.
+*/
+int Node_getPath(Node_T oNNode, Path_T *poPResult);
+/*
+  Returns TRUE if oNParent has a child whose name is the ulLength
+  characters at pcName, which need not be '\0'-terminated. Returns
   FALSE if it does not.
   If oNParent has such a child, stores in *pulChildID the child's
   identifier (as used in Node_getChild). If oNParent does not have
   such a child, stores in *pulChildID the identifier that such a
-  child _would_ have if inserted.
+  child _would_ have if inserted. The cost of the search does not
+  depend on the depth of oNParent.
+*/
+boolean Node_hasChildName(Node_T oNParent, const char *pcName,
+                          size_t ulLength, size_t *pulChildID);
+/*
+  A search for a child by name, as Node_hasChildName makes it, taken
+  a step at a time: each step reads only what the step before it
+  prefetched, so that a caller interleaving the steps of several
+  searches has the memory each one waits for loaded in the meantime.
+  Like a PathView, it is meant to be declared as a local variable; its
+  fields are for nodeFT.c alone.
 */
-boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
-                         size_t *pulChildID);
+struct nodeSearch {
+   /* the directory whose children are searched */
+   Node_T oNDir;
+   /* the name searched for, and its key */
+   const char *pcName;
+   size_t ulLength;
+   size_t ulKey;
+   /* the range of children the name may be among */
+   size_t ulLow;
+   size_t ulHigh;
+   /* what the next step does */
+   int iStage;
+   /* once the search has ended, whether the child was found */
+   boolean bFound;
+};
+/*
+  Starts *psSearch for the child of oNParent named by the ulLength
+  characters at pcName, which must stay valid and unchanged, as must
+  oNParent's children, until the search has ended. Prefetches what
+  the first step reads.
+*/
+void Node_startSearch(struct nodeSearch *psSearch, Node_T oNParent,
+                      const char *pcName, size_t ulLength);
+/*
+  Makes the next step of *psSearch, prefetching what the step after it
+  reads. Returns TRUE if the search goes on, or FALSE once it has
+  ended.
+*/
+boolean Node_stepSearch(struct nodeSearch *psSearch);
+/*
+  Returns the result of *psSearch, which has ended, as Node_hasChildName
+  would return it, storing in *pulChildID what it would.
+*/
+boolean Node_endSearch(const struct nodeSearch *psSearch,
+                       size_t *pulChildID);
 /* Returns the number of children that oNParent has. */
 size_t Node_getNumChildren(Node_T oNParent);
+/*
+  Returns TRUE if child ulChildID of directory oNParent is a file and
+  FALSE if it is a directory, from oNParent's own record of its
+  children, without reading the child's node or unpacking oNParent.
+*/
+boolean Node_isChildFile(Node_T oNParent, size_t ulChildID);
 /*
   Returns an int SUCCESS status and sets *poNResult to be the child
   node of oNParent with identifier ulChildID, if one exists.
   Otherwise, sets *poNResult to NULL and returns status:
   * NO_SUCH_PATH if ulChildID is not a valid child for oNParent
+  * MEMORY_ERROR if oNParent is packed and memory could not be
+    allocated to unpack it
 */
 int Node_getChild(Node_T oNParent, size_t ulChildID,
                   Node_T *poNResult);
@@ -84,6 +338,35 @@ int Node_getChild(Node_T oNParent, size_t ulChildID,
 */
 Node_T Node_getParent(Node_T oNNode);
 
+/*
+  Pins oNNode, which must not have been removed. A pinned node that
+  is removed from the tree by Node_free is detached and emptied, but
+  its struct stays allocated (so that holders of the pin can detect
+  the removal with Node_isRemoved) until it is no longer pinned.
+*/
+void Node_pin(Node_T oNNode);
+/*
+  Releases one pin on oNNode, freeing it if it has been removed and
+  this was its last pin.
+*/
+void Node_unpin(Node_T oNNode);
+/*
+  Returns TRUE if oNNode has been removed from the tree while pinned,
+  in which case no other Node_ function may be applied to it except
+  Node_unpin. Returns FALSE otherwise.
+*/
+boolean Node_isRemoved(Node_T oNNode);
+/*
+  Prepares oNNode's hierarchy for its removal by Node_free, which
+  hands the children of a directory with lazy copies over to one of
+  the copies: each pinned directory below oNNode that would be handed
+  over is given a fresh node in its place, and is itself removed, as
+  Node_free would remove it. Holders of the pins thus see the removal,
+  and the copy none of their changes. Returns SUCCESS, or MEMORY_ERROR
+  (leaving the hierarchy unchanged) if memory could not be allocated.
+*/
+int Node_retirePins(Node_T oNNode);
+
 /*
   Returns a string representation for oNNode, or NULL if
   there is an allocation error.
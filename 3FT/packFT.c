@@ -0,0 +1,290 @@
+/* Implementation of a front-coded block of a directory's files */
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "packFT.h"
+
+/* A restart point every PACK_RESTART entries; a number takes at most
+   NUMBER_MAX bytes */
+enum { PACK_RESTART = 16, NUMBER_MAX = sizeof(size_t) * 2 };
+
+/* A pack */
+struct pack {
+   /* the entries, one after another: the name as described in
+      packFT.h, then the size of the contents, then the pointer to
+      them, all numbers seven bits a byte */
+   unsigned char *pucEntries;
+   size_t ulLength;
+   size_t ulCapacity;
+   /* the offset of each restart point's entry */
+   size_t *pulRestarts;
+   /* the number of entries, and the total length of their names */
+   size_t ulCount;
+   size_t ulNames;
+   /* while filling, the name of the last entry appended */
+   const char *pcLast;
+   size_t ulLastLength;
+   /* room for the longest name, into which names are decoded */
+   char *pcName;
+   size_t ulMaxName;
+};
+
+/* Writes ulValue at pucPos, seven bits a byte from the lowest with
+   the top bit set on all but the last, and returns the end. */
+static unsigned char *Pack_putNumber(unsigned char *pucPos,
+                                     size_t ulValue) {
+   assert(pucPos != NULL);
+   for(; ulValue >= 0x80; ulValue >>= 7)
+      *pucPos++ = (unsigned char) (ulValue | 0x80);
+   *pucPos++ = (unsigned char) ulValue;
+   return pucPos;
+}
+
+/* Reads a number written by Pack_putNumber at *ppucPos, and moves
+   *ppucPos past it. */
+static size_t Pack_getNumber(const unsigned char **ppucPos) {
+   size_t ulValue = 0;
+   size_t ulShift = 0;
+   const unsigned char *pucPos;
+   assert(ppucPos != NULL);
+   for(pucPos = *ppucPos; (*pucPos & 0x80) != 0; pucPos++) {
+      ulValue |= (size_t) (*pucPos & 0x7F) << ulShift;
+      ulShift += 7;
+   }
+   ulValue |= (size_t) *pucPos << ulShift;
+   *ppucPos = pucPos + 1;
+   return ulValue;
+}
+
+/* see packFT.h for specification */
+Pack_T Pack_new(size_t ulCount) {
+   Pack_T oPPack;
+   oPPack = calloc(1, sizeof(struct pack));
+   if(oPPack == NULL)
+      return NULL;
+   oPPack->pulRestarts = malloc((ulCount / PACK_RESTART + 1)
+                                * sizeof(size_t));
+   if(oPPack->pulRestarts == NULL) {
+      free(oPPack);
+      return NULL;
+   }
+   return oPPack;
+}
+
+/* see packFT.h for specification */
+void Pack_free(Pack_T oPPack) {
+   if(oPPack == NULL)
+      return;
+   free(oPPack->pucEntries);
+   free(oPPack->pulRestarts);
+   free(oPPack->pcName);
+   free(oPPack);
+}
+
+/*
+  Compares the ulFirst characters at pcFirst with the ulSecond
+  characters at pcSecond, as siblings are ordered: returns <0, 0, or
+  >0 if the first is "less than", "equal to", or "greater than" the
+  second.
+*/
+static int Pack_compare(const char *pcFirst, size_t ulFirst,
+                        const char *pcSecond, size_t ulSecond) {
+   int iResult;
+   iResult = memcmp(pcFirst, pcSecond,
+                    ulFirst < ulSecond ? ulFirst : ulSecond);
+   if(iResult != 0)
+      return iResult;
+   if(ulFirst < ulSecond)
+      return -1;
+   return ulFirst > ulSecond;
+}
+
+/* see packFT.h for specification */
+int Pack_add(Pack_T oPPack, const char *pcName, size_t ulLength,
+             void *pvContents, size_t ulSize) {
+   unsigned char *pucPos;
+   size_t ulShared = 0;
+   size_t ulNeeded;
+   assert(oPPack != NULL);
+   assert(pcName != NULL);
+   if(oPPack->ulCount % PACK_RESTART != 0)
+      while(ulShared < ulLength && ulShared < oPPack->ulLastLength &&
+            pcName[ulShared] == oPPack->pcLast[ulShared])
+         ulShared++;
+   assert(oPPack->pcLast == NULL ||
+          Pack_compare(oPPack->pcLast, oPPack->ulLastLength, pcName,
+                       ulLength) < 0);
+   /* make all the room first, so that a failure changes nothing */
+   ulNeeded = oPPack->ulLength + 4 * NUMBER_MAX + ulLength - ulShared;
+   if(ulNeeded > oPPack->ulCapacity) {
+      pucPos = realloc(oPPack->pucEntries, 2 * ulNeeded);
+      if(pucPos == NULL)
+         return MEMORY_ERROR;
+      oPPack->pucEntries = pucPos;
+      oPPack->ulCapacity = 2 * ulNeeded;
+   }
+   if(ulLength > oPPack->ulMaxName) {
+      char *pcGrown = realloc(oPPack->pcName, ulLength);
+      if(pcGrown == NULL)
+         return MEMORY_ERROR;
+      oPPack->pcName = pcGrown;
+      oPPack->ulMaxName = ulLength;
+   }
+
+   pucPos = oPPack->pucEntries + oPPack->ulLength;
+   if(oPPack->ulCount % PACK_RESTART == 0)
+      oPPack->pulRestarts[oPPack->ulCount / PACK_RESTART] =
+         oPPack->ulLength;
+   else
+      pucPos = Pack_putNumber(pucPos, ulShared);
+   pucPos = Pack_putNumber(pucPos, ulLength - ulShared);
+   memcpy(pucPos, pcName + ulShared, ulLength - ulShared);
+   pucPos += ulLength - ulShared;
+   pucPos = Pack_putNumber(pucPos, ulSize);
+   pucPos = Pack_putNumber(pucPos, (size_t) pvContents);
+   oPPack->ulLength = (size_t) (pucPos - oPPack->pucEntries);
+   oPPack->pcLast = pcName;
+   oPPack->ulLastLength = ulLength;
+   oPPack->ulCount++;
+   oPPack->ulNames += ulLength;
+   return SUCCESS;
+}
+
+/* see packFT.h for specification */
+void Pack_trim(Pack_T oPPack) {
+   unsigned char *pucTrimmed;
+   assert(oPPack != NULL);
+   oPPack->pcLast = NULL;
+   pucTrimmed = realloc(oPPack->pucEntries, oPPack->ulLength + 1);
+   if(pucTrimmed == NULL)
+      return;
+   oPPack->pucEntries = pucTrimmed;
+   oPPack->ulCapacity = oPPack->ulLength + 1;
+}
+
+/* see packFT.h for specification */
+size_t Pack_getCount(Pack_T oPPack) {
+   assert(oPPack != NULL);
+   return oPPack->ulCount;
+}
+
+/*
+  Decodes the entry at *ppucPos, the entry ulIndex of oPPack, into
+  its name buffer, which holds the name of the entry before unless
+  ulIndex is a restart point, and returns the name's length. Moves
+  *ppucPos past the name, and, if ppvContents is not NULL, past the
+  rest of the entry, storing its contents and size in *ppvContents
+  and *pulSize.
+*/
+static size_t Pack_decode(Pack_T oPPack, const unsigned char **ppucPos,
+                          size_t ulIndex, void **ppvContents,
+                          size_t *pulSize) {
+   size_t ulShared = 0;
+   size_t ulRest;
+   assert(oPPack != NULL);
+   assert(ppucPos != NULL);
+   if(ulIndex % PACK_RESTART != 0)
+      ulShared = Pack_getNumber(ppucPos);
+   ulRest = Pack_getNumber(ppucPos);
+   memcpy(oPPack->pcName + ulShared, *ppucPos, ulRest);
+   *ppucPos += ulRest;
+   if(ppvContents != NULL) {
+      assert(pulSize != NULL);
+      *pulSize = Pack_getNumber(ppucPos);
+      *ppvContents = (void *) Pack_getNumber(ppucPos);
+   }
+   else {
+      (void) Pack_getNumber(ppucPos);
+      (void) Pack_getNumber(ppucPos);
+   }
+   return ulShared + ulRest;
+}
+
+/* see packFT.h for specification */
+boolean Pack_find(Pack_T oPPack, const char *pcName, size_t ulLength,
+                  size_t *pulIndex) {
+   const unsigned char *pucPos;
+   size_t ulLow = 0;
+   size_t ulHigh;
+   size_t ulMid;
+   size_t ulIndex;
+   size_t ulEnd;
+   size_t ulFound;
+   int iCompare;
+   assert(oPPack != NULL);
+   assert(pcName != NULL);
+   assert(pulIndex != NULL);
+   /* the last restart point whose name, which is whole, is not past
+      pcName */
+   ulHigh = (oPPack->ulCount + PACK_RESTART - 1) / PACK_RESTART;
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      pucPos = oPPack->pucEntries + oPPack->pulRestarts[ulMid];
+      ulFound = Pack_getNumber(&pucPos);
+      iCompare = Pack_compare((const char *) pucPos, ulFound, pcName,
+                              ulLength);
+      if(iCompare == 0) {
+         *pulIndex = ulMid * PACK_RESTART;
+         return TRUE;
+      }
+      if(iCompare < 0)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   if(ulLow == 0) {
+      *pulIndex = 0;
+      return FALSE;
+   }
+   /* then the names after it, up to the next restart point */
+   ulIndex = (ulLow - 1) * PACK_RESTART;
+   ulEnd = ulIndex + PACK_RESTART;
+   if(ulEnd > oPPack->ulCount)
+      ulEnd = oPPack->ulCount;
+   pucPos = oPPack->pucEntries + oPPack->pulRestarts[ulLow - 1];
+   for(; ulIndex < ulEnd; ulIndex++) {
+      ulFound = Pack_decode(oPPack, &pucPos, ulIndex, NULL, NULL);
+      iCompare = Pack_compare(oPPack->pcName, ulFound, pcName, ulLength);
+      if(iCompare >= 0) {
+         *pulIndex = ulIndex;
+         return iCompare == 0;
+      }
+   }
+   *pulIndex = ulEnd;
+   return FALSE;
+}
+
+/* see packFT.h for specification */
+const char *Pack_getEntry(Pack_T oPPack, size_t ulIndex,
+                          size_t *pulLength, void **ppvContents,
+                          size_t *pulSize) {
+   const unsigned char *pucPos;
+   size_t ulEntry;
+   assert(oPPack != NULL);
+   assert(ulIndex < oPPack->ulCount);
+   assert(pulLength != NULL);
+   assert(ppvContents != NULL);
+   assert(pulSize != NULL);
+   /* from the restart point before it */
+   pucPos = oPPack->pucEntries
+      + oPPack->pulRestarts[ulIndex / PACK_RESTART];
+   for(ulEntry = ulIndex - ulIndex % PACK_RESTART; ulEntry <= ulIndex;
+       ulEntry++)
+      *pulLength = Pack_decode(oPPack, &pucPos, ulEntry, ppvContents,
+                               pulSize);
+   return oPPack->pcName;
+}
+
+/* see packFT.h for specification */
+size_t Pack_getNameLength(Pack_T oPPack) {
+   assert(oPPack != NULL);
+   return oPPack->ulNames;
+}
+
+/* see packFT.h for specification */
+size_t Pack_getSize(Pack_T oPPack) {
+   assert(oPPack != NULL);
+   return sizeof(struct pack) + oPPack->ulCapacity
+      + (oPPack->ulCount / PACK_RESTART + 1) * sizeof(size_t)
+      + oPPack->ulMaxName;
+}
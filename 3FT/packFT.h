@@ -0,0 +1,71 @@
+/*--------------------------------------------------------------------*/
+/* packFT.h                                                           */
+/*--------------------------------------------------------------------*/
+#ifndef PACK_INCLUDED
+#define PACK_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A Pack_T holds a directory's files in one block, in order of name,
+  instead of one node each: for each, its name, the client's pointer
+  to its contents and their size. Names are front-coded: every 16th
+  name, a restart point, is whole, and each other name is the length
+  of the prefix it shares with the one before and the rest, so that
+  siblings such as "part-000001.parquet" and "part-000002.parquet"
+  take a few bytes each. A name is found by a binary search of the
+  restart points and a scan of the names after one.
+*/
+typedef struct pack *Pack_T;
+
+/*
+  Returns a new, empty pack with room for the offsets of ulCount
+  entries, or NULL if there is an allocation error.
+*/
+Pack_T Pack_new(size_t ulCount);
+
+/* Frees oPPack. Does nothing if NULL. */
+void Pack_free(Pack_T oPPack);
+
+/*
+  Appends to oPPack a file named by the ulLength characters at pcName,
+  which must come after the name of the file appended before it and
+  stay valid until the next call, with ulSize bytes of contents at
+  pvContents. Returns SUCCESS, or MEMORY_ERROR (leaving oPPack as it
+  was) if memory could not be allocated.
+*/
+int Pack_add(Pack_T oPPack, const char *pcName, size_t ulLength,
+             void *pvContents, size_t ulSize);
+
+/* Gives back to the allocator what oPPack does not use, once it is
+   filled. */
+void Pack_trim(Pack_T oPPack);
+
+/* Returns the number of files in oPPack. */
+size_t Pack_getCount(Pack_T oPPack);
+
+/*
+  Returns TRUE and stores in *pulIndex the index of the file in oPPack
+  named by the ulLength characters at pcName, if there is one, and
+  otherwise returns FALSE and stores in *pulIndex the index such a
+  file would have.
+*/
+boolean Pack_find(Pack_T oPPack, const char *pcName, size_t ulLength,
+                  size_t *pulIndex);
+
+/*
+  Decodes file ulIndex of oPPack: returns its name, which is valid
+  until the next call on oPPack, storing its length in *pulLength,
+  and stores its contents and their size in *ppvContents and
+  *pulSize.
+*/
+const char *Pack_getEntry(Pack_T oPPack, size_t ulIndex,
+                          size_t *pulLength, void **ppvContents,
+                          size_t *pulSize);
+
+/* Returns the total length of the names of the files in oPPack. */
+size_t Pack_getNameLength(Pack_T oPPack);
+
+/* Returns the number of bytes that oPPack takes. */
+size_t Pack_getSize(Pack_T oPPack);
+#endif
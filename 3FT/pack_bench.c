@@ -0,0 +1,119 @@
+/*--------------------------------------------------------------------*/
+/* pack_bench.c                                                       */
+/* Benchmark of the memory and lookups of packed directories          */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ft.h"
+
+/* Tree parameters: NUM_FILES files, FILES_PER_DIR per directory */
+enum { NUM_FILES = 200000, FILES_PER_DIR = 1000, NUM_LOOKUPS = 2000000,
+       MAX_PATH_LEN = 64 };
+
+/* Writes to pcPath the path of file ulIndex. */
+static void PackBench_path(char *pcPath, size_t ulIndex) {
+   assert(pcPath != NULL);
+   sprintf(pcPath, "lake/table%03lu/part-%06lu.parquet",
+           (unsigned long) (ulIndex / FILES_PER_DIR),
+           (unsigned long) ulIndex);
+}
+
+/*
+  Times NUM_LOOKUPS stats of the paths in apcPaths, checking each
+  size, and returns the nanoseconds per lookup.
+*/
+static double PackBench_lookups(char **apcPaths) {
+   clock_t tStart;
+   size_t ulSize = 0;
+   size_t i;
+   boolean bIsFile;
+   tStart = clock();
+   for(i = 0; i < NUM_LOOKUPS; i++)
+      if(FT_stat(apcPaths[i % NUM_FILES], &bIsFile, &ulSize) != SUCCESS ||
+         ulSize != strlen(apcPaths[i % NUM_FILES]))
+         exit(EXIT_FAILURE);
+   return (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e9
+      / NUM_LOOKUPS;
+}
+
+/*
+  Builds a tree of NUM_FILES files in directories of FILES_PER_DIR,
+  stats them in a random order, packs every directory and stats them
+  again, and reports the bytes the files take as nodes and packed.
+  Returns 0, or EXIT_FAILURE if memory could not be allocated or a
+  lookup is wrong.
+*/
+int main(void) {
+   static char *apcPaths[NUM_FILES];
+   struct packStats sStats;
+   clock_t tStart;
+   double dNodes, dPacked, dPack;
+   char *pcBefore;
+   char *pcAfter;
+   char *pcSwap;
+   size_t i, j;
+
+   srand(217);
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < NUM_FILES; i++) {
+      apcPaths[i] = malloc(MAX_PATH_LEN);
+      if(apcPaths[i] == NULL) {
+         fprintf(stderr, "out of memory\n");
+         return EXIT_FAILURE;
+      }
+      PackBench_path(apcPaths[i], i);
+      /* each file's size is its path's length, for checking */
+      if(FT_insertFile(apcPaths[i], apcPaths[i], strlen(apcPaths[i]))
+         != SUCCESS)
+         return EXIT_FAILURE;
+   }
+   /* one more change, so that the last directory filled is cold too */
+   if(FT_insertDir("lake/staging") != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = NUM_FILES - 1; i > 0; i--) {
+      j = (size_t) rand() % (i + 1);
+      pcSwap = apcPaths[i];
+      apcPaths[i] = apcPaths[j];
+      apcPaths[j] = pcSwap;
+   }
+
+   dNodes = PackBench_lookups(apcPaths);
+   pcBefore = FT_toString();
+   tStart = clock();
+   FT_setPacking(1);
+   dPack = (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e3;
+   FT_getPackStats(&sStats);
+   pcAfter = FT_toString();
+   if(pcBefore == NULL || pcAfter == NULL ||
+      strcmp(pcBefore, pcAfter) != 0 ||
+      sStats.ulFiles != NUM_FILES)
+      return EXIT_FAILURE;
+   free(pcBefore);
+   free(pcAfter);
+   dPacked = PackBench_lookups(apcPaths);
+   FT_getPackStats(&sStats);
+   if(sStats.ulUnpacked != 0)
+      return EXIT_FAILURE;
+
+   printf("%lu files in %lu directories, packed in %.1f ms\n",
+          (unsigned long) sStats.ulFiles, (unsigned long) sStats.ulDirs,
+          dPack);
+   printf("as nodes: %9lu bytes (%5.1f per file)\n",
+          (unsigned long) sStats.ulNodeBytes,
+          (double) sStats.ulNodeBytes / sStats.ulFiles);
+   printf("packed:   %9lu bytes (%5.1f per file)\n",
+          (unsigned long) sStats.ulBytes,
+          (double) sStats.ulBytes / sStats.ulFiles);
+   printf("stat: nodes %7.1f ns   packed %7.1f ns\n", dNodes, dPacked);
+
+   for(i = 0; i < NUM_FILES; i++)
+      free(apcPaths[i]);
+   (void) FT_destroy();
+   return 0;
+}
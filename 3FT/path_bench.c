@@ -0,0 +1,152 @@
+/*--------------------------------------------------------------------*/
+/* path_bench.c                                                       */
+/* Microbenchmark of path validation and splitting                    */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "path.h"
+
+/* Corpus and measurement parameters */
+enum { NUM_PATHS = 100000, NUM_ROUNDS = 20, MAX_PATH_LEN = 512 };
+
+/* Components typical of source and build trees */
+static const char *apcWords[] = {
+   "src", "main", "java", "com", "example", "build", "lib", "include",
+   "node_modules", "test", "resources", "generated", "target",
+   "classes", "internal", "util", "v2", "api", "service", "impl",
+   "third_party", "vendor", "github.com", "protobuf", "release"
+};
+
+/*
+  Fills pcBuf with a random path of about ulTarget characters whose
+  components are drawn from apcWords or are random hex file names.
+  Returns the path's length.
+*/
+static size_t PathBench_makePath(char *pcBuf, size_t ulTarget) {
+   size_t ulLen = 0;
+   size_t ulWords = sizeof(apcWords) / sizeof(apcWords[0]);
+
+   assert(pcBuf != NULL);
+
+   while(ulLen < ulTarget) {
+      const char *pcWord;
+      char acHex[24];
+      size_t ulWordLen;
+      if(rand() % 4 == 0) {
+         sprintf(acHex, "f%08x.dat", (unsigned) rand());
+         pcWord = acHex;
+      }
+      else
+         pcWord = apcWords[(size_t) rand() % ulWords];
+      ulWordLen = strlen(pcWord);
+      if(ulLen + ulWordLen + 1 >= MAX_PATH_LEN)
+         break;
+      if(ulLen != 0)
+         pcBuf[ulLen++] = '/';
+      memcpy(pcBuf + ulLen, pcWord, ulWordLen);
+      ulLen += ulWordLen;
+   }
+   return ulLen;
+}
+
+/* Returns the name of implementation eImpl. */
+static const char *PathBench_implName(enum pathImpl eImpl) {
+   switch(eImpl) {
+      case PATH_IMPL_SCALAR: return "scalar";
+      case PATH_IMPL_SSE2: return "sse2";
+      case PATH_IMPL_AVX2: return "avx2";
+      default: return "auto";
+   }
+}
+
+/*
+  Times validating (Path_initView) and then validating and splitting
+  (Path_newN/Path_free) every path in the corpus apcPaths/aulLens with
+  implementation eImpl, and prints the results.
+*/
+static void PathBench_run(enum pathImpl eImpl, char **apcPaths,
+                          size_t *aulLens, size_t ulBytes) {
+   clock_t tStart;
+   double dView, dNew;
+   size_t ulRound, i;
+   size_t ulDepthSum = 0;
+
+   if(!Path_setImplementation(eImpl)) {
+      printf("%-8s unsupported on this CPU\n", PathBench_implName(eImpl));
+      return;
+   }
+
+   tStart = clock();
+   for(ulRound = 0; ulRound < NUM_ROUNDS; ulRound++)
+      for(i = 0; i < NUM_PATHS; i++) {
+         PathView oView;
+         if(Path_initView(&oView, apcPaths[i], aulLens[i]) != SUCCESS)
+            exit(EXIT_FAILURE);
+         ulDepthSum += oView.ulDepth;
+      }
+   dView = (double) (clock() - tStart) / CLOCKS_PER_SEC;
+
+   tStart = clock();
+   for(ulRound = 0; ulRound < NUM_ROUNDS; ulRound++)
+      for(i = 0; i < NUM_PATHS; i++) {
+         Path_T oPPath;
+         if(Path_newN(apcPaths[i], aulLens[i], &oPPath) != SUCCESS)
+            exit(EXIT_FAILURE);
+         ulDepthSum += Path_getDepth(oPPath);
+         Path_free(oPPath);
+      }
+   dNew = (double) (clock() - tStart) / CLOCKS_PER_SEC;
+
+   printf("%-8s validate %7.1f ns/path %8.1f MB/s   "
+          "split %7.1f ns/path %8.1f MB/s   (%lu)\n",
+          PathBench_implName(eImpl),
+          dView * 1e9 / ((double) NUM_ROUNDS * NUM_PATHS),
+          (double) ulBytes * NUM_ROUNDS / dView / 1e6,
+          dNew * 1e9 / ((double) NUM_ROUNDS * NUM_PATHS),
+          (double) ulBytes * NUM_ROUNDS / dNew / 1e6,
+          (unsigned long) ulDepthSum);
+}
+
+/*
+  Builds corpora of paths averaging 200 and 40 characters, and
+  compares every available implementation on each. Returns 0.
+*/
+int main(void) {
+   static char *apcPaths[NUM_PATHS];
+   static size_t aulLens[NUM_PATHS];
+   size_t aulTargets[2] = { 200, 40 };
+   size_t ulCorpus, i;
+
+   srand(217);
+   for(ulCorpus = 0; ulCorpus < 2; ulCorpus++) {
+      size_t ulBytes = 0;
+      for(i = 0; i < NUM_PATHS; i++) {
+         char acBuf[MAX_PATH_LEN];
+         size_t ulTarget = aulTargets[ulCorpus] / 2
+            + (size_t) rand() % aulTargets[ulCorpus];
+         aulLens[i] = PathBench_makePath(acBuf, ulTarget);
+         apcPaths[i] = malloc(aulLens[i]);
+         if(apcPaths[i] == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+         }
+         memcpy(apcPaths[i], acBuf, aulLens[i]);
+         ulBytes += aulLens[i];
+      }
+      printf("corpus: %d paths, average length %.1f\n", NUM_PATHS,
+             (double) ulBytes / NUM_PATHS);
+
+      PathBench_run(PATH_IMPL_SCALAR, apcPaths, aulLens, ulBytes);
+      PathBench_run(PATH_IMPL_SSE2, apcPaths, aulLens, ulBytes);
+      PathBench_run(PATH_IMPL_AVX2, apcPaths, aulLens, ulBytes);
+
+      for(i = 0; i < NUM_PATHS; i++)
+         free(apcPaths[i]);
+   }
+   return 0;
+}
@@ -0,0 +1,615 @@
+/* Implementation of a succinct, read-only copy of a node hierarchy */
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include "bitsFT.h"
+#include "snapshotFT.h"
+
+/* Names are front-coded in buckets of NAME_BUCKET nodes; the offset
+   of every SIZE_SAMPLE-th file's size is kept; names up to NAME_STACK
+   characters are decoded on the stack */
+enum { NAME_BUCKET = 16, SIZE_SAMPLE = 64, NAME_STACK = 256 };
+
+/* A growing byte stream */
+struct stream {
+   unsigned char *pucBytes;
+   size_t ulLength;
+   size_t ulCapacity;
+};
+
+/* A snapshot */
+struct snapshot {
+   /* the number of nodes, numbered in breadth-first order */
+   size_t ulNodes;
+   /* the shape: "10", then for each node a 1 per child and a 0 */
+   Bits_T oBShape;
+   /* for each node, 1 if it is a file */
+   Bits_T oBFiles;
+   /* the front-coded names, the offset of each bucket's first name
+      among them, and the length of the longest name */
+   unsigned char *pucNames;
+   size_t ulNameLength;
+   size_t *pulBuckets;
+   size_t ulMaxName;
+   /* the files' sizes in order of node, and the offset of every
+      SIZE_SAMPLE-th among them */
+   unsigned char *pucSizes;
+   size_t ulSizeLength;
+   size_t *pulSizeSamples;
+};
+
+/*
+  Appends ulValue to psStream, seven bits a byte from the lowest, with
+  the top bit set on all but the last byte. Returns SUCCESS, or
+  MEMORY_ERROR if the stream could not grow.
+*/
+static int Snapshot_putNumber(struct stream *psStream, size_t ulValue) {
+   unsigned char *pucBytes;
+   size_t ulCapacity;
+   assert(psStream != NULL);
+   /* room for the longest number */
+   if(psStream->ulLength + sizeof(size_t) * 2 > psStream->ulCapacity) {
+      ulCapacity = psStream->ulCapacity * 2 + sizeof(size_t) * 2;
+      pucBytes = realloc(psStream->pucBytes, ulCapacity);
+      if(pucBytes == NULL)
+         return MEMORY_ERROR;
+      psStream->pucBytes = pucBytes;
+      psStream->ulCapacity = ulCapacity;
+   }
+   for(; ulValue >= 0x80; ulValue >>= 7)
+      psStream->pucBytes[psStream->ulLength++] =
+         (unsigned char) (ulValue | 0x80);
+   psStream->pucBytes[psStream->ulLength++] = (unsigned char) ulValue;
+   return SUCCESS;
+}
+
+/*
+  Appends the ulLength characters at pcChars to psStream. Returns
+  SUCCESS, or MEMORY_ERROR if the stream could not grow.
+*/
+static int Snapshot_putChars(struct stream *psStream, const char *pcChars,
+                             size_t ulLength) {
+   unsigned char *pucBytes;
+   size_t ulCapacity;
+   assert(psStream != NULL);
+   assert(pcChars != NULL || ulLength == 0);
+   if(psStream->ulLength + ulLength > psStream->ulCapacity) {
+      ulCapacity = psStream->ulCapacity * 2 + ulLength;
+      pucBytes = realloc(psStream->pucBytes, ulCapacity);
+      if(pucBytes == NULL)
+         return MEMORY_ERROR;
+      psStream->pucBytes = pucBytes;
+      psStream->ulCapacity = ulCapacity;
+   }
+   if(ulLength != 0)
+      memcpy(psStream->pucBytes + psStream->ulLength, pcChars, ulLength);
+   psStream->ulLength += ulLength;
+   return SUCCESS;
+}
+
+/* Reads a number written by Snapshot_putNumber at *ppucPos, and moves
+   *ppucPos past it. */
+static size_t Snapshot_getNumber(const unsigned char **ppucPos) {
+   size_t ulValue = 0;
+   size_t ulShift = 0;
+   const unsigned char *pucPos;
+   assert(ppucPos != NULL);
+   for(pucPos = *ppucPos; (*pucPos & 0x80) != 0; pucPos++) {
+      ulValue |= (size_t) (*pucPos & 0x7F) << ulShift;
+      ulShift += 7;
+   }
+   ulValue |= (size_t) *pucPos << ulShift;
+   *ppucPos = pucPos + 1;
+   return ulValue;
+}
+
+/* Returns the number of nodes in the hierarchy rooted at oNNode. */
+static size_t Snapshot_count(Node_T oNNode) {
+   Node_T oNChild = NULL;
+   size_t ulCount = 1;
+   size_t ulChild;
+   assert(oNNode != NULL);
+   for(ulChild = 0; ulChild < Node_getNumChildren(oNNode); ulChild++) {
+      (void) Node_getChild(oNNode, ulChild, &oNChild);
+      ulCount += Snapshot_count(oNChild);
+   }
+   return ulCount;
+}
+
+/*
+  Appends the name of node ulIndex, oNNode, to the names of oSSnapshot
+  in psNames, given the name of the node before it, ulPrevious
+  characters at pcPrevious. Returns SUCCESS or MEMORY_ERROR.
+*/
+static int Snapshot_putName(Snapshot_T oSSnapshot, struct stream *psNames,
+                            size_t ulIndex, Node_T oNNode,
+                            const char *pcPrevious, size_t ulPrevious) {
+   const char *pcName;
+   size_t ulLength;
+   size_t ulShared = 0;
+   int iStatus;
+   assert(oSSnapshot != NULL);
+   assert(psNames != NULL);
+   pcName = Node_getName(oNNode, &ulLength);
+   if(ulLength > oSSnapshot->ulMaxName)
+      oSSnapshot->ulMaxName = ulLength;
+   if(ulIndex % NAME_BUCKET == 0)
+      oSSnapshot->pulBuckets[ulIndex / NAME_BUCKET] = psNames->ulLength;
+   else {
+      while(ulShared < ulLength && ulShared < ulPrevious &&
+            pcName[ulShared] == pcPrevious[ulShared])
+         ulShared++;
+      iStatus = Snapshot_putNumber(psNames, ulShared);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   iStatus = Snapshot_putNumber(psNames, ulLength - ulShared);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return Snapshot_putChars(psNames, pcName + ulShared,
+                            ulLength - ulShared);
+}
+
+/*
+  Fills in oSSnapshot, of ulNodes nodes, from the hierarchy rooted at
+  oNRoot, using apoNQueue, with room for ulNodes nodes, for the
+  breadth-first order. Returns SUCCESS or MEMORY_ERROR.
+*/
+static int Snapshot_fill(Snapshot_T oSSnapshot, Node_T oNRoot,
+                         Node_T *apoNQueue) {
+   struct stream sNames = {NULL, 0, 0};
+   struct stream sSizes = {NULL, 0, 0};
+   Node_T oNNode;
+   const char *pcPrevious = NULL;
+   size_t ulPrevious = 0;
+   size_t ulFiles = 0;
+   size_t ulNext = 1;
+   size_t ulBit = 2;
+   size_t ulIndex;
+   size_t ulChild;
+   size_t ulNumChildren;
+   int iStatus = SUCCESS;
+   assert(oSSnapshot != NULL);
+   assert(apoNQueue != NULL);
+   Bits_set(oSSnapshot->oBShape, 0);
+   apoNQueue[0] = oNRoot;
+   for(ulIndex = 0; ulIndex < oSSnapshot->ulNodes && iStatus == SUCCESS;
+       ulIndex++) {
+      oNNode = apoNQueue[ulIndex];
+      ulNumChildren = Node_getNumChildren(oNNode);
+      for(ulChild = 0; ulChild < ulNumChildren; ulChild++) {
+         (void) Node_getChild(oNNode, ulChild, &apoNQueue[ulNext++]);
+         Bits_set(oSSnapshot->oBShape, ulBit++);
+      }
+      /* the 0 that ends the node's children */
+      ulBit++;
+      iStatus = Snapshot_putName(oSSnapshot, &sNames, ulIndex, oNNode,
+                                 pcPrevious, ulPrevious);
+      pcPrevious = Node_getName(oNNode, &ulPrevious);
+      if(iStatus == SUCCESS && Node_getType(oNNode)) {
+         Bits_set(oSSnapshot->oBFiles, ulIndex);
+         if(ulFiles % SIZE_SAMPLE == 0)
+            oSSnapshot->pulSizeSamples[ulFiles / SIZE_SAMPLE] =
+               sSizes.ulLength;
+         ulFiles++;
+         iStatus = Snapshot_putNumber(&sSizes,
+                                      Node_getSizeContents(oNNode));
+      }
+   }
+   assert(iStatus != SUCCESS || ulNext == oSSnapshot->ulNodes);
+   /* no more room than is used, if the allocator will give it back */
+   if(iStatus == SUCCESS) {
+      oSSnapshot->pucNames = realloc(sNames.pucBytes, sNames.ulLength + 1);
+      if(oSSnapshot->pucNames == NULL)
+         oSSnapshot->pucNames = sNames.pucBytes;
+      oSSnapshot->ulNameLength = sNames.ulLength;
+      oSSnapshot->pucSizes = realloc(sSizes.pucBytes, sSizes.ulLength + 1);
+      if(oSSnapshot->pucSizes == NULL)
+         oSSnapshot->pucSizes = sSizes.pucBytes;
+      oSSnapshot->ulSizeLength = sSizes.ulLength;
+      Bits_index(oSSnapshot->oBShape);
+      Bits_index(oSSnapshot->oBFiles);
+   }
+   else {
+      free(sNames.pucBytes);
+      free(sSizes.pucBytes);
+   }
+   return iStatus;
+}
+
+/* see snapshotFT.h for specification */
+int Snapshot_new(Node_T oNRoot, Snapshot_T *poSResult) {
+   Snapshot_T oSSnapshot;
+   Node_T *apoNQueue;
+   size_t ulNodes = 0;
+   int iStatus;
+   assert(poSResult != NULL);
+   *poSResult = NULL;
+   if(oNRoot != NULL)
+      ulNodes = Snapshot_count(oNRoot);
+   oSSnapshot = calloc(1, sizeof(struct snapshot));
+   if(oSSnapshot == NULL)
+      return MEMORY_ERROR;
+   oSSnapshot->ulNodes = ulNodes;
+   oSSnapshot->oBShape = Bits_new(2 * ulNodes + 1);
+   oSSnapshot->oBFiles = Bits_new(ulNodes);
+   oSSnapshot->pulBuckets = malloc((ulNodes / NAME_BUCKET + 1)
+                                   * sizeof(size_t));
+   oSSnapshot->pulSizeSamples = malloc((ulNodes / SIZE_SAMPLE + 1)
+                                       * sizeof(size_t));
+   apoNQueue = malloc(ulNodes * sizeof(Node_T) + 1);
+   if(oSSnapshot->oBShape == NULL || oSSnapshot->oBFiles == NULL ||
+      oSSnapshot->pulBuckets == NULL ||
+      oSSnapshot->pulSizeSamples == NULL || apoNQueue == NULL) {
+      free(apoNQueue);
+      Snapshot_free(oSSnapshot);
+      return MEMORY_ERROR;
+   }
+   iStatus = SUCCESS;
+   if(ulNodes != 0)
+      iStatus = Snapshot_fill(oSSnapshot, oNRoot, apoNQueue);
+   free(apoNQueue);
+   if(iStatus != SUCCESS) {
+      Snapshot_free(oSSnapshot);
+      return iStatus;
+   }
+   *poSResult = oSSnapshot;
+   return SUCCESS;
+}
+
+/* see snapshotFT.h for specification */
+void Snapshot_free(Snapshot_T oSSnapshot) {
+   if(oSSnapshot == NULL)
+      return;
+   Bits_free(oSSnapshot->oBShape);
+   Bits_free(oSSnapshot->oBFiles);
+   free(oSSnapshot->pucNames);
+   free(oSSnapshot->pulBuckets);
+   free(oSSnapshot->pucSizes);
+   free(oSSnapshot->pulSizeSamples);
+   free(oSSnapshot);
+}
+
+/*
+  Sets *pulFirst to the number of the first child of node ulNode of
+  oSSnapshot, and returns the number of its children.
+*/
+static size_t Snapshot_children(Snapshot_T oSSnapshot, size_t ulNode,
+                                size_t *pulFirst) {
+   size_t ulStart;
+   assert(oSSnapshot != NULL);
+   assert(pulFirst != NULL);
+   /* node i's 1s follow the i-th 0 (counting the super-root's), and
+      each 1 before them is a node before its first child */
+   ulStart = Bits_select0(oSSnapshot->oBShape, ulNode);
+   *pulFirst = ulStart - ulNode;
+   return Bits_select0(oSSnapshot->oBShape, ulNode + 1) - ulStart - 1;
+}
+
+/*
+  Compares the ulName characters at pcName with the ulLength
+  characters at pcComponent, as siblings are ordered. Returns <0, 0,
+  or >0 if the name is "less than", "equal to", or "greater than" the
+  component, respectively.
+*/
+static int Snapshot_compareName(const char *pcName, size_t ulName,
+                                const char *pcComponent,
+                                size_t ulLength) {
+   int iResult;
+   assert(pcName != NULL || ulName == 0);
+   assert(pcComponent != NULL);
+   iResult = memcmp(pcName, pcComponent,
+                    ulName < ulLength ? ulName : ulLength);
+   if(iResult != 0)
+      return iResult;
+   if(ulName < ulLength)
+      return -1;
+   return ulName > ulLength;
+}
+
+/*
+  Compares the first name of bucket ulBucket of oSSnapshot with the
+  ulLength characters at pcComponent, as Snapshot_compareName does.
+*/
+static int Snapshot_compareBucket(Snapshot_T oSSnapshot, size_t ulBucket,
+                                  const char *pcComponent,
+                                  size_t ulLength) {
+   const unsigned char *pucPos;
+   size_t ulName;
+   assert(oSSnapshot != NULL);
+   pucPos = oSSnapshot->pucNames + oSSnapshot->pulBuckets[ulBucket];
+   ulName = Snapshot_getNumber(&pucPos);
+   return Snapshot_compareName((const char *) pucPos, ulName,
+                               pcComponent, ulLength);
+}
+
+/*
+  Decodes the name of node ulNode, which is either the first of its
+  bucket or the node after the one whose name is in pcName, from the
+  names at *ppucPos into pcName; moves *ppucPos past it, and returns
+  its length.
+*/
+static size_t Snapshot_nextName(const unsigned char **ppucPos,
+                                size_t ulNode, char *pcName) {
+   size_t ulShared = 0;
+   size_t ulRest;
+   assert(ppucPos != NULL);
+   assert(pcName != NULL);
+   if(ulNode % NAME_BUCKET != 0)
+      ulShared = Snapshot_getNumber(ppucPos);
+   ulRest = Snapshot_getNumber(ppucPos);
+   memcpy(pcName + ulShared, *ppucPos, ulRest);
+   *ppucPos += ulRest;
+   return ulShared + ulRest;
+}
+
+/*
+  Decodes the name of node ulNode of oSSnapshot into pcName, which has
+  room for the longest name, and returns its length.
+*/
+static size_t Snapshot_getName(Snapshot_T oSSnapshot, size_t ulNode,
+                               char *pcName) {
+   const unsigned char *pucPos;
+   size_t ulLength = 0;
+   size_t ulIndex;
+   assert(oSSnapshot != NULL);
+   assert(pcName != NULL);
+   pucPos = oSSnapshot->pucNames
+      + oSSnapshot->pulBuckets[ulNode / NAME_BUCKET];
+   for(ulIndex = ulNode - ulNode % NAME_BUCKET; ulIndex <= ulNode;
+       ulIndex++)
+      ulLength = Snapshot_nextName(&pucPos, ulIndex, pcName);
+   return ulLength;
+}
+
+/*
+  Searches the ulCount children of oSSnapshot from node ulFirst for
+  the ulLength characters at pcComponent, using pcName, with room for
+  the longest name, to decode names. Returns TRUE and sets *pulNode to
+  the child's number if found, and FALSE otherwise.
+*/
+static boolean Snapshot_findChild(Snapshot_T oSSnapshot, size_t ulFirst,
+                                  size_t ulCount, const char *pcComponent,
+                                  size_t ulLength, char *pcName,
+                                  size_t *pulNode) {
+   const unsigned char *pucPos;
+   size_t ulEnd = ulFirst + ulCount;
+   size_t ulLow;
+   size_t ulHigh;
+   size_t ulMid;
+   size_t ulStart;
+   size_t ulStop;
+   size_t ulName = 0;
+   size_t ulIndex;
+   int iCompare;
+   assert(oSSnapshot != NULL);
+   assert(pcComponent != NULL);
+   assert(pcName != NULL);
+   assert(pulNode != NULL);
+   if(ulCount == 0)
+      return FALSE;
+   /* the last bucket starting among the children whose first name is
+      not past the component, by its whole first name */
+   ulLow = (ulFirst + NAME_BUCKET - 1) / NAME_BUCKET;
+   ulHigh = (ulEnd - 1) / NAME_BUCKET + 1;
+   ulStart = ulLow;
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      iCompare = Snapshot_compareBucket(oSSnapshot, ulMid, pcComponent,
+                                        ulLength);
+      if(iCompare == 0) {
+         *pulNode = ulMid * NAME_BUCKET;
+         return TRUE;
+      }
+      if(iCompare < 0)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   /* then along that bucket, or from the first child if none */
+   if(ulLow == ulStart)
+      ulStart = ulFirst - ulFirst % NAME_BUCKET;
+   else
+      ulStart = (ulLow - 1) * NAME_BUCKET;
+   ulStop = ulLow * NAME_BUCKET;
+   if(ulStop > ulEnd)
+      ulStop = ulEnd;
+   pucPos = oSSnapshot->pucNames
+      + oSSnapshot->pulBuckets[ulStart / NAME_BUCKET];
+   for(ulIndex = ulStart; ulIndex < ulStop; ulIndex++) {
+      ulName = Snapshot_nextName(&pucPos, ulIndex, pcName);
+      if(ulIndex < ulFirst)
+         continue;
+      iCompare = Snapshot_compareName(pcName, ulName, pcComponent,
+                                      ulLength);
+      if(iCompare == 0) {
+         *pulNode = ulIndex;
+         return TRUE;
+      }
+      if(iCompare > 0)
+         return FALSE;
+   }
+   return FALSE;
+}
+
+/* see snapshotFT.h for specification */
+int Snapshot_find(Snapshot_T oSSnapshot, const PathView *psView,
+                  size_t *pulNode) {
+   char acName[NAME_STACK];
+   char *pcName = acName;
+   size_t ulNode = 0;
+   size_t ulFirst;
+   size_t ulCount;
+   size_t ulStart;
+   size_t ulEnd;
+   int iStatus = SUCCESS;
+   assert(oSSnapshot != NULL);
+   assert(psView != NULL);
+   assert(pulNode != NULL);
+   if(oSSnapshot->ulNodes == 0)
+      return NO_SUCH_PATH;
+   /* the root's name must be the first component of the path */
+   ulEnd = Path_viewComponentEnd(psView, 0);
+   if(Snapshot_compareBucket(oSSnapshot, 0, psView->pcPath, ulEnd))
+      return CONFLICTING_PATH;
+   if(oSSnapshot->ulMaxName > NAME_STACK) {
+      pcName = malloc(oSSnapshot->ulMaxName);
+      if(pcName == NULL)
+         return MEMORY_ERROR;
+   }
+   for(ulStart = ulEnd + 1; ulStart < psView->ulLength;
+       ulStart = ulEnd + 1) {
+      ulEnd = Path_viewComponentEnd(psView, ulStart);
+      ulCount = Snapshot_children(oSSnapshot, ulNode, &ulFirst);
+      if(!Snapshot_findChild(oSSnapshot, ulFirst, ulCount,
+                             psView->pcPath + ulStart, ulEnd - ulStart,
+                             pcName, &ulNode)) {
+         iStatus = NO_SUCH_PATH;
+         break;
+      }
+   }
+   if(pcName != acName)
+      free(pcName);
+   if(iStatus == SUCCESS)
+      *pulNode = ulNode;
+   return iStatus;
+}
+
+/* see snapshotFT.h for specification */
+boolean Snapshot_isFile(Snapshot_T oSSnapshot, size_t ulNode) {
+   assert(oSSnapshot != NULL);
+   assert(ulNode < oSSnapshot->ulNodes);
+   return Bits_get(oSSnapshot->oBFiles, ulNode);
+}
+
+/* see snapshotFT.h for specification */
+size_t Snapshot_getFileSize(Snapshot_T oSSnapshot, size_t ulNode) {
+   const unsigned char *pucPos;
+   size_t ulFile;
+   size_t ulSize;
+   size_t i;
+   assert(oSSnapshot != NULL);
+   assert(Snapshot_isFile(oSSnapshot, ulNode));
+   /* from the sampled file before it, skipping the sizes between */
+   ulFile = Bits_rank1(oSSnapshot->oBFiles, ulNode);
+   pucPos = oSSnapshot->pucSizes
+      + oSSnapshot->pulSizeSamples[ulFile / SIZE_SAMPLE];
+   for(i = ulFile % SIZE_SAMPLE; ; i--) {
+      ulSize = Snapshot_getNumber(&pucPos);
+      if(i == 0)
+         return ulSize;
+   }
+}
+
+/*
+  Adds to *pulAcc the length of the lines of the string representation
+  for the hierarchy rooted at node ulNode of oSSnapshot, whose
+  parent's path has length ulPrefix (0 for the root), using pcName to
+  decode names.
+*/
+static void Snapshot_strlenAccumulate(Snapshot_T oSSnapshot,
+                                      size_t ulNode, size_t ulPrefix,
+                                      char *pcName, size_t *pulAcc) {
+   size_t ulFirst;
+   size_t ulCount;
+   size_t ulChild;
+   assert(oSSnapshot != NULL);
+   assert(pulAcc != NULL);
+   /* the parent's path and a '/', or nothing for the root */
+   if(ulPrefix != 0)
+      ulPrefix++;
+   ulPrefix += Snapshot_getName(oSSnapshot, ulNode, pcName);
+   *pulAcc += ulPrefix + 1;
+   ulCount = Snapshot_children(oSSnapshot, ulNode, &ulFirst);
+   for(ulChild = 0; ulChild < ulCount; ulChild++)
+      Snapshot_strlenAccumulate(oSSnapshot, ulFirst + ulChild, ulPrefix,
+                                pcName, pulAcc);
+}
+
+/*
+  Writes the string representation for the hierarchy rooted at node
+  ulNode of oSSnapshot to pcAcc in pre-order, files before
+  directories, where the ulPrefix characters at pcPrefix are its
+  parent's path (0 for the root), using pcName to decode names, and
+  returns the end of what was written.
+*/
+static char *Snapshot_strcatAccumulate(Snapshot_T oSSnapshot,
+                                       size_t ulNode,
+                                       const char *pcPrefix,
+                                       size_t ulPrefix, char *pcName,
+                                       char *pcAcc) {
+   const char *pcPath = pcAcc;
+   size_t ulPath;
+   size_t ulName;
+   size_t ulFirst;
+   size_t ulCount;
+   size_t ulChild;
+   boolean bFiles;
+   assert(oSSnapshot != NULL);
+   assert(pcAcc != NULL);
+   if(ulPrefix != 0) {
+      memcpy(pcAcc, pcPrefix, ulPrefix);
+      pcAcc += ulPrefix;
+      *pcAcc++ = '/';
+   }
+   ulName = Snapshot_getName(oSSnapshot, ulNode, pcName);
+   memcpy(pcAcc, pcName, ulName);
+   pcAcc += ulName;
+   ulPath = (size_t) (pcAcc - pcPath);
+   *pcAcc++ = '\n';
+   /* goes through children twice: files first, then directories */
+   ulCount = Snapshot_children(oSSnapshot, ulNode, &ulFirst);
+   for(bFiles = TRUE; ; bFiles = FALSE) {
+      for(ulChild = 0; ulChild < ulCount; ulChild++)
+         if(Snapshot_isFile(oSSnapshot, ulFirst + ulChild) == bFiles)
+            pcAcc = Snapshot_strcatAccumulate(oSSnapshot,
+                                              ulFirst + ulChild, pcPath,
+                                              ulPath, pcName, pcAcc);
+      if(!bFiles)
+         break;
+   }
+   return pcAcc;
+}
+
+/* see snapshotFT.h for specification */
+char *Snapshot_toString(Snapshot_T oSSnapshot) {
+   size_t ulTotal = 1;
+   char *pcName;
+   char *pcResult;
+   char *pcEnd;
+   assert(oSSnapshot != NULL);
+   /* one more byte, so that an empty snapshot's is still allocated */
+   pcName = malloc(oSSnapshot->ulMaxName + 1);
+   if(pcName == NULL)
+      return NULL;
+   if(oSSnapshot->ulNodes != 0)
+      Snapshot_strlenAccumulate(oSSnapshot, 0, 0, pcName, &ulTotal);
+   pcResult = malloc(ulTotal);
+   if(pcResult == NULL) {
+      free(pcName);
+      return NULL;
+   }
+   pcEnd = pcResult;
+   if(oSSnapshot->ulNodes != 0)
+      pcEnd = Snapshot_strcatAccumulate(oSSnapshot, 0, NULL, 0, pcName,
+                                        pcResult);
+   *pcEnd = '\0';
+   free(pcName);
+   return pcResult;
+}
+
+/* see snapshotFT.h for specification */
+void Snapshot_getStats(Snapshot_T oSSnapshot,
+                       struct snapshotStats *psStats) {
+   assert(oSSnapshot != NULL);
+   assert(psStats != NULL);
+   psStats->ulNodes = oSSnapshot->ulNodes;
+   psStats->ulShapeBytes = sizeof(struct snapshot)
+      + Bits_getSize(oSSnapshot->oBShape)
+      + Bits_getSize(oSSnapshot->oBFiles);
+   psStats->ulNameBytes = oSSnapshot->ulNameLength
+      + (oSSnapshot->ulNodes / NAME_BUCKET + 1) * sizeof(size_t);
+   psStats->ulSizeBytes = oSSnapshot->ulSizeLength
+      + (oSSnapshot->ulNodes / SIZE_SAMPLE + 1) * sizeof(size_t);
+}
@@ -0,0 +1,66 @@
+/*--------------------------------------------------------------------*/
+/* snapshotFT.h                                                       */
+/*--------------------------------------------------------------------*/
+#ifndef SNAPSHOT_INCLUDED
+#define SNAPSHOT_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+#include "path.h"
+#include "nodeFT.h"
+#include "ft.h"
+
+/*
+  A Snapshot_T (see ft.h) is a succinct, read-only copy of a hierarchy
+  of nodes, numbered in breadth-first order from the root at 0, so
+  that each directory's children are a contiguous range of numbers in
+  order of name. Its shape is a LOUDS bit vector: a 1 and a 0 for a
+  super-root, then for each node one 1 per child and a 0. A second bit
+  vector marks the files. Names are front-coded in buckets of
+  consecutive nodes: a bucket's first name is whole, and each other
+  name is the length of the prefix it shares with the one before and
+  the rest. Files' sizes are variable-length numbers, with the offset
+  of every so many kept for finding the rest.
+*/
+
+/*
+  Copies the hierarchy rooted at oNRoot (which may be NULL, for an
+  empty hierarchy) into a new snapshot, and stores it in *poSResult.
+  Lazy copies are copied with the children they present. Returns
+  SUCCESS, or MEMORY_ERROR (setting *poSResult to NULL) if memory
+  could not be allocated.
+*/
+int Snapshot_new(Node_T oNRoot, Snapshot_T *poSResult);
+
+/* Frees oSSnapshot. Does nothing if NULL. */
+void Snapshot_free(Snapshot_T oSSnapshot);
+
+/*
+  Finds the node with the absolute path viewed by psView in
+  oSSnapshot, one search of a range of children per component.
+  Returns SUCCESS and sets *pulNode to the node's number, or otherwise
+  returns:
+  * CONFLICTING_PATH if the root's name is not the path's first
+                     component
+  * NO_SUCH_PATH if there is no such node
+  * MEMORY_ERROR if memory could not be allocated for a long name
+*/
+int Snapshot_find(Snapshot_T oSSnapshot, const PathView *psView,
+                  size_t *pulNode);
+
+/* Returns TRUE if node ulNode of oSSnapshot is a file, else FALSE. */
+boolean Snapshot_isFile(Snapshot_T oSSnapshot, size_t ulNode);
+
+/* Returns the size of the contents of file ulNode of oSSnapshot. */
+size_t Snapshot_getFileSize(Snapshot_T oSSnapshot, size_t ulNode);
+
+/*
+  Returns the string representation of oSSnapshot's hierarchy, as
+  FT_toString makes it, or NULL if there is an allocation error. The
+  caller owns the string.
+*/
+char *Snapshot_toString(Snapshot_T oSSnapshot);
+
+/* Stores the sizes of oSSnapshot's parts in *psStats. */
+void Snapshot_getStats(Snapshot_T oSSnapshot,
+                       struct snapshotStats *psStats);
+#endif
@@ -0,0 +1,134 @@
+/*--------------------------------------------------------------------*/
+/* snapshot_bench.c                                                   */
+/* Benchmark of the size of snapshots and of lookups in them          */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ft.h"
+
+/* Tree parameters: NUM_FILES files, FILES_PER_DIR per directory */
+enum { NUM_FILES = 200000, FILES_PER_DIR = 50, NUM_LOOKUPS = 2000000,
+       MAX_PATH_LEN = 64 };
+
+/* Writes to pcPath the path of file ulIndex. */
+static void SnapshotBench_path(char *pcPath, size_t ulIndex) {
+   assert(pcPath != NULL);
+   sprintf(pcPath, "bench/src/module%04lu/source_file_%07lu.c",
+           (unsigned long) (ulIndex / FILES_PER_DIR),
+           (unsigned long) ulIndex);
+}
+
+/*
+  Times NUM_LOOKUPS stats of the paths in apcPaths, in oSSnapshot if
+  it is not NULL and in the FT otherwise, checking each size, and
+  returns the nanoseconds per lookup.
+*/
+static double SnapshotBench_lookups(char **apcPaths,
+                                    Snapshot_T oSSnapshot) {
+   clock_t tStart;
+   size_t ulSize = 0;
+   size_t i;
+   boolean bIsFile;
+   int iStatus;
+   tStart = clock();
+   for(i = 0; i < NUM_LOOKUPS; i++) {
+      if(oSSnapshot != NULL)
+         iStatus = FT_snapshotStat(oSSnapshot, apcPaths[i % NUM_FILES],
+                                   &bIsFile, &ulSize);
+      else
+         iStatus = FT_stat(apcPaths[i % NUM_FILES], &bIsFile, &ulSize);
+      if(iStatus != SUCCESS || ulSize != strlen(apcPaths[i % NUM_FILES]))
+         exit(EXIT_FAILURE);
+   }
+   return (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e9
+      / NUM_LOOKUPS;
+}
+
+/*
+  Builds a tree of NUM_FILES files, takes a snapshot of it, and
+  reports the snapshot's size per node beside the frozen layout's,
+  and stats of the files in a random order in the FT and in the
+  snapshot. Returns 0, or EXIT_FAILURE if memory could not be
+  allocated or the snapshot is wrong.
+*/
+int main(void) {
+   static char *apcPaths[NUM_FILES];
+   struct snapshotStats sStats;
+   struct freezeStats sFreeze;
+   Snapshot_T oSSnapshot;
+   clock_t tStart;
+   double dBuild, dLive, dSnapshot;
+   char *pcLive;
+   char *pcCopy;
+   char *pcSwap;
+   size_t ulNames = 0;
+   size_t i, j;
+
+   srand(217);
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < NUM_FILES; i++) {
+      apcPaths[i] = malloc(MAX_PATH_LEN);
+      if(apcPaths[i] == NULL) {
+         fprintf(stderr, "out of memory\n");
+         return EXIT_FAILURE;
+      }
+      SnapshotBench_path(apcPaths[i], i);
+      /* each file's size is its path's length, for checking */
+      if(FT_insertFile(apcPaths[i], apcPaths[i], strlen(apcPaths[i]))
+         != SUCCESS)
+         return EXIT_FAILURE;
+      ulNames += strlen(strrchr(apcPaths[i], '/') + 1);
+   }
+   ulNames += strlen("bench/src") - 1
+      + (NUM_FILES / FILES_PER_DIR) * strlen("module0000");
+   for(i = NUM_FILES - 1; i > 0; i--) {
+      j = (size_t) rand() % (i + 1);
+      pcSwap = apcPaths[i];
+      apcPaths[i] = apcPaths[j];
+      apcPaths[j] = pcSwap;
+   }
+
+   tStart = clock();
+   if(FT_snapshot(&oSSnapshot) != SUCCESS)
+      return EXIT_FAILURE;
+   dBuild = (double) (clock() - tStart) / CLOCKS_PER_SEC * 1e3;
+   pcLive = FT_toString();
+   pcCopy = FT_snapshotToString(oSSnapshot);
+   if(pcLive == NULL || pcCopy == NULL || strcmp(pcLive, pcCopy) != 0)
+      return EXIT_FAILURE;
+   free(pcLive);
+   free(pcCopy);
+   FT_getSnapshotStats(oSSnapshot, &sStats);
+   if(FT_freeze(FT_FREEZE_LAYOUT, &sFreeze) != SUCCESS ||
+      FT_thaw() != SUCCESS)
+      return EXIT_FAILURE;
+
+   printf("%lu nodes, snapshot taken in %.1f ms\n",
+          (unsigned long) sStats.ulNodes, dBuild);
+   printf("shape and file bits: %5.2f bits per node\n",
+          sStats.ulShapeBytes * 8.0 / sStats.ulNodes);
+   printf("names:               %5.2f bits per node "
+          "(%lu bytes, %lu raw)\n",
+          sStats.ulNameBytes * 8.0 / sStats.ulNodes,
+          (unsigned long) sStats.ulNameBytes, (unsigned long) ulNames);
+   printf("sizes:               %5.2f bits per node\n",
+          sStats.ulSizeBytes * 8.0 / sStats.ulNodes);
+   printf("frozen layout:       %5.2f bits per node\n",
+          sFreeze.ulLayoutBytes * 8.0 / sFreeze.ulEntries);
+
+   dLive = SnapshotBench_lookups(apcPaths, NULL);
+   dSnapshot = SnapshotBench_lookups(apcPaths, oSSnapshot);
+   printf("stat: FT %7.1f ns   snapshot %7.1f ns\n", dLive, dSnapshot);
+
+   FT_freeSnapshot(oSSnapshot);
+   for(i = 0; i < NUM_FILES; i++)
+      free(apcPaths[i]);
+   (void) FT_destroy();
+   return 0;
+}
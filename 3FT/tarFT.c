@@ -0,0 +1,630 @@
+/* Implementation of streaming tar archive writing and reading */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include "tarFT.h"
+
+/* The size of a tar block, of a buffer of blocks, and of the largest
+   pax extended header read */
+enum { BLOCK = 512, TAR_BUFFER = 1 << 16, PAX_MAX = 1 << 20 };
+
+/* Offsets and widths of the fields of a ustar header block */
+enum { NAME = 0, NAME_LEN = 100, MODE = 100, UID = 108, GID = 116,
+       SIZE = 124, SIZE_LEN = 12, MTIME = 136, CHKSUM = 148,
+       CHKSUM_LEN = 8, TYPEFLAG = 156, MAGIC = 257, VERSION = 263,
+       PREFIX = 345, PREFIX_LEN = 155 };
+
+/* The largest size that fits in a header's size field: 11 octal
+   digits' worth */
+#define TAR_SIZE_MAX 077777777777UL
+
+/* A writer */
+struct tarWriter {
+   /* the file descriptor written to */
+   int iFd;
+   /* the bytes not yet written to iFd */
+   char acBuf[TAR_BUFFER];
+   size_t ulUsed;
+   /* the bytes of the current member's contents still to come */
+   size_t ulRemaining;
+   /* the zeros owed after them, to end the member on a block */
+   size_t ulPad;
+};
+
+/* A reader */
+struct tarReader {
+   /* the file descriptor read from */
+   int iFd;
+   /* bytes read from iFd: those from ulStart to ulEnd are unused */
+   char acBuf[TAR_BUFFER];
+   size_t ulStart;
+   size_t ulEnd;
+   /* the bytes of the current member's contents not yet read, and
+      the padding after them */
+   size_t ulRemaining;
+   size_t ulPad;
+   /* the current member's '\0'-terminated path, in a buffer of
+      ulPathCapacity bytes */
+   char *pcPath;
+   size_t ulPathCapacity;
+   /* whether a pax or GNU header has given the next member's path,
+      which is then in pcPath, or size */
+   boolean bLongPath;
+   boolean bLongSize;
+   size_t ulLongSize;
+};
+
+/* Returns the padding that ends ulSize bytes of contents on a block. */
+static size_t Tar_padding(size_t ulSize) {
+   return (BLOCK - ulSize % BLOCK) % BLOCK;
+}
+
+/*
+  Writes ulValue into the ulWidth-byte header field at pcField, as
+  ulWidth - 1 octal digits and a '\0'. It must fit.
+*/
+static void Tar_putOctal(char *pcField, size_t ulWidth,
+                         unsigned long ulValue) {
+   size_t ulIndex;
+   assert(pcField != NULL);
+   pcField[ulWidth - 1] = '\0';
+   for(ulIndex = ulWidth - 1; ulIndex > 0; ulIndex--) {
+      pcField[ulIndex - 1] = (char) ('0' + (ulValue & 7));
+      ulValue >>= 3;
+   }
+   assert(ulValue == 0);
+}
+
+/*
+  Returns the checksum of header block pcHeader: the sum of its bytes,
+  with those of the checksum field taken to be spaces.
+*/
+static unsigned long Tar_checksum(const char *pcHeader) {
+   unsigned long ulSum = 0;
+   size_t ulIndex;
+   assert(pcHeader != NULL);
+   for(ulIndex = 0; ulIndex < BLOCK; ulIndex++)
+      if(ulIndex >= CHKSUM && ulIndex < CHKSUM + CHKSUM_LEN)
+         ulSum += ' ';
+      else
+         ulSum += (unsigned char) pcHeader[ulIndex];
+   return ulSum;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Writes out the bytes buffered in oWWriter. Returns SUCCESS, or
+  MEMORY_ERROR if they could not all be written.
+*/
+static int TarWriter_flush(TarWriter_T oWWriter) {
+   size_t ulDone = 0;
+   ssize_t lWritten;
+   assert(oWWriter != NULL);
+   while(ulDone < oWWriter->ulUsed) {
+      lWritten = write(oWWriter->iFd, oWWriter->acBuf + ulDone,
+                       oWWriter->ulUsed - ulDone);
+      if(lWritten <= 0)
+         return MEMORY_ERROR;
+      ulDone += (size_t) lWritten;
+   }
+   oWWriter->ulUsed = 0;
+   return SUCCESS;
+}
+
+/*
+  Writes the ulLength bytes at pvBytes, or ulLength zeros if pvBytes
+  is NULL, to oWWriter's archive. Returns SUCCESS, or MEMORY_ERROR if
+  they could not be written.
+*/
+static int TarWriter_put(TarWriter_T oWWriter, const void *pvBytes,
+                         size_t ulLength) {
+   const char *pcBytes = pvBytes;
+   size_t ulTake;
+   int iStatus;
+   assert(oWWriter != NULL);
+   while(ulLength != 0) {
+      if(oWWriter->ulUsed == TAR_BUFFER) {
+         iStatus = TarWriter_flush(oWWriter);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+      ulTake = TAR_BUFFER - oWWriter->ulUsed;
+      if(ulTake > ulLength)
+         ulTake = ulLength;
+      if(pcBytes != NULL) {
+         memcpy(oWWriter->acBuf + oWWriter->ulUsed, pcBytes, ulTake);
+         pcBytes += ulTake;
+      }
+      else
+         memset(oWWriter->acBuf + oWWriter->ulUsed, 0, ulTake);
+      oWWriter->ulUsed += ulTake;
+      ulLength -= ulTake;
+   }
+   return SUCCESS;
+}
+
+/*
+  Writes a header block to oWWriter's archive for a member of type
+  cType and size ulSize, named by the ulNameLength characters at
+  pcName after the ulPrefixLength characters at pcPrefix, which must
+  fit their fields. A directory's name is given a trailing '/' if
+  there is room. Returns SUCCESS, or MEMORY_ERROR if it could not be
+  written.
+*/
+static int TarWriter_header(TarWriter_T oWWriter, const char *pcPrefix,
+                            size_t ulPrefixLength, const char *pcName,
+                            size_t ulNameLength, char cType,
+                            size_t ulSize) {
+   char acHeader[BLOCK];
+   assert(oWWriter != NULL);
+   assert(ulPrefixLength <= PREFIX_LEN);
+   assert(ulNameLength <= NAME_LEN);
+   memset(acHeader, 0, BLOCK);
+   memcpy(acHeader + NAME, pcName, ulNameLength);
+   if(cType == '5' && ulNameLength < NAME_LEN)
+      acHeader[NAME + ulNameLength] = '/';
+   if(ulPrefixLength != 0)
+      memcpy(acHeader + PREFIX, pcPrefix, ulPrefixLength);
+   Tar_putOctal(acHeader + MODE, 8, cType == '5' ? 0755 : 0644);
+   Tar_putOctal(acHeader + UID, 8, 0);
+   Tar_putOctal(acHeader + GID, 8, 0);
+   Tar_putOctal(acHeader + SIZE, SIZE_LEN,
+                ulSize <= TAR_SIZE_MAX ? (unsigned long) ulSize : 0);
+   Tar_putOctal(acHeader + MTIME, 12, 0);
+   acHeader[TYPEFLAG] = cType;
+   memcpy(acHeader + MAGIC, "ustar", 6);
+   memcpy(acHeader + VERSION, "00", 2);
+   /* six digits, a '\0' and a space */
+   Tar_putOctal(acHeader + CHKSUM, 7, Tar_checksum(acHeader));
+   acHeader[CHKSUM + 7] = ' ';
+   return TarWriter_put(oWWriter, acHeader, BLOCK);
+}
+
+/*
+  Writes a pax extended record "key=value\n", with the ulValueLength
+  characters at pcValue as its value and preceded by its own length,
+  to oWWriter's archive if bWrite is TRUE. Returns the record's
+  length, or 0 if it could not be written.
+*/
+static size_t TarWriter_record(TarWriter_T oWWriter, boolean bWrite,
+                               const char *pcKey, const char *pcValue,
+                               size_t ulValueLength) {
+   char acLength[24];
+   size_t ulLength;
+   size_t ulDigits = 1;
+   assert(oWWriter != NULL);
+   assert(pcKey != NULL);
+   assert(pcValue != NULL);
+   /* the length counts its own digits */
+   for(;;) {
+      ulLength = ulDigits + 1 + strlen(pcKey) + 1 + ulValueLength + 1;
+      sprintf(acLength, "%lu ", (unsigned long) ulLength);
+      if(strlen(acLength) == ulDigits + 1)
+         break;
+      ulDigits++;
+   }
+   if(bWrite &&
+      (TarWriter_put(oWWriter, acLength, strlen(acLength)) != SUCCESS ||
+       TarWriter_put(oWWriter, pcKey, strlen(pcKey)) != SUCCESS ||
+       TarWriter_put(oWWriter, "=", 1) != SUCCESS ||
+       TarWriter_put(oWWriter, pcValue, ulValueLength) != SUCCESS ||
+       TarWriter_put(oWWriter, "\n", 1) != SUCCESS))
+      return 0;
+   return ulLength;
+}
+
+/* see tarFT.h for specification */
+TarWriter_T TarWriter_new(int iFd) {
+   TarWriter_T oWWriter;
+   oWWriter = malloc(sizeof(struct tarWriter));
+   if(oWWriter == NULL)
+      return NULL;
+   oWWriter->iFd = iFd;
+   oWWriter->ulUsed = 0;
+   oWWriter->ulRemaining = 0;
+   oWWriter->ulPad = 0;
+   return oWWriter;
+}
+
+/* see tarFT.h for specification */
+void TarWriter_free(TarWriter_T oWWriter) {
+   free(oWWriter);
+}
+
+/* see tarFT.h for specification */
+int TarWriter_add(TarWriter_T oWWriter, const char *pcPath,
+                  size_t ulLength, boolean bIsFile, size_t ulSize) {
+   char acSize[24];
+   const char *pcName = pcPath;
+   size_t ulNameLength = ulLength;
+   size_t ulPrefixLength = 0;
+   size_t ulSplit;
+   size_t ulRecords = 0;
+   boolean bLongPath;
+   boolean bLongSize;
+   int iStatus;
+   assert(oWWriter != NULL);
+   assert(pcPath != NULL);
+   assert(oWWriter->ulRemaining == 0);
+   if(!bIsFile)
+      ulSize = 0;
+
+   bLongPath = (boolean) (ulLength > NAME_LEN);
+   /* split a long path at a '/' between the prefix and name fields,
+      if that makes it fit */
+   for(ulSplit = ulLength > NAME_LEN + 1 ? ulLength - NAME_LEN - 1 : 1;
+       bLongPath && ulSplit <= PREFIX_LEN && ulSplit < ulLength;
+       ulSplit++)
+      if(pcPath[ulSplit] == '/') {
+         ulPrefixLength = ulSplit;
+         pcName = pcPath + ulSplit + 1;
+         ulNameLength = ulLength - ulSplit - 1;
+         bLongPath = FALSE;
+      }
+   bLongSize = (boolean) (ulSize > TAR_SIZE_MAX);
+
+   /* otherwise a pax extended header gives what does not fit */
+   if(bLongPath || bLongSize) {
+      sprintf(acSize, "%lu", (unsigned long) ulSize);
+      if(bLongPath) {
+         ulRecords += TarWriter_record(oWWriter, FALSE, "path", pcPath,
+                                       ulLength);
+         ulNameLength = NAME_LEN;
+      }
+      if(bLongSize)
+         ulRecords += TarWriter_record(oWWriter, FALSE, "size", acSize,
+                                       strlen(acSize));
+      iStatus = TarWriter_header(oWWriter, NULL, 0, "././@PaxHeader",
+                                 strlen("././@PaxHeader"), 'x',
+                                 ulRecords);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      if(bLongPath &&
+         TarWriter_record(oWWriter, TRUE, "path", pcPath,
+                          ulLength) == 0)
+         return MEMORY_ERROR;
+      if(bLongSize &&
+         TarWriter_record(oWWriter, TRUE, "size", acSize,
+                          strlen(acSize)) == 0)
+         return MEMORY_ERROR;
+      iStatus = TarWriter_put(oWWriter, NULL, Tar_padding(ulRecords));
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   iStatus = TarWriter_header(oWWriter, pcPath, ulPrefixLength, pcName,
+                              ulNameLength, bIsFile ? '0' : '5',
+                              ulSize);
+   oWWriter->ulRemaining = ulSize;
+   oWWriter->ulPad = Tar_padding(ulSize);
+   return iStatus;
+}
+
+/* see tarFT.h for specification */
+int TarWriter_write(TarWriter_T oWWriter, const void *pvBytes,
+                    size_t ulLength) {
+   int iStatus;
+   assert(oWWriter != NULL);
+   assert(pvBytes != NULL || ulLength == 0);
+   assert(ulLength <= oWWriter->ulRemaining);
+   iStatus = TarWriter_put(oWWriter, pvBytes, ulLength);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   oWWriter->ulRemaining -= ulLength;
+   /* end the member on a block once it is all written */
+   if(oWWriter->ulRemaining == 0) {
+      iStatus = TarWriter_put(oWWriter, NULL, oWWriter->ulPad);
+      oWWriter->ulPad = 0;
+   }
+   return iStatus;
+}
+
+/* see tarFT.h for specification */
+int TarWriter_finish(TarWriter_T oWWriter) {
+   int iStatus;
+   assert(oWWriter != NULL);
+   assert(oWWriter->ulRemaining == 0);
+   /* two blocks of zeros end the archive */
+   iStatus = TarWriter_put(oWWriter, NULL, 2 * BLOCK);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return TarWriter_flush(oWWriter);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Reads the next ulLength bytes of oRReader's archive into pvBuf, or
+  skips them if pvBuf is NULL. Returns SUCCESS, or BAD_PATH if the
+  archive ends first, or MEMORY_ERROR if it could not be read.
+*/
+static int TarReader_get(TarReader_T oRReader, void *pvBuf,
+                         size_t ulLength) {
+   char *pcBuf = pvBuf;
+   size_t ulTake;
+   ssize_t lRead;
+   assert(oRReader != NULL);
+   while(ulLength != 0) {
+      if(oRReader->ulStart == oRReader->ulEnd) {
+         lRead = read(oRReader->iFd, oRReader->acBuf, TAR_BUFFER);
+         if(lRead < 0)
+            return MEMORY_ERROR;
+         if(lRead == 0)
+            return BAD_PATH;
+         oRReader->ulStart = 0;
+         oRReader->ulEnd = (size_t) lRead;
+      }
+      ulTake = oRReader->ulEnd - oRReader->ulStart;
+      if(ulTake > ulLength)
+         ulTake = ulLength;
+      if(pcBuf != NULL) {
+         memcpy(pcBuf, oRReader->acBuf + oRReader->ulStart, ulTake);
+         pcBuf += ulTake;
+      }
+      oRReader->ulStart += ulTake;
+      ulLength -= ulTake;
+   }
+   return SUCCESS;
+}
+
+/*
+  Makes oRReader's path buffer hold at least ulLength + 1 bytes.
+  Returns SUCCESS, or MEMORY_ERROR if it could not be grown.
+*/
+static int TarReader_reserve(TarReader_T oRReader, size_t ulLength) {
+   char *pcGrown;
+   assert(oRReader != NULL);
+   if(ulLength < oRReader->ulPathCapacity)
+      return SUCCESS;
+   pcGrown = realloc(oRReader->pcPath, 2 * (ulLength + 1));
+   if(pcGrown == NULL)
+      return MEMORY_ERROR;
+   oRReader->pcPath = pcGrown;
+   oRReader->ulPathCapacity = 2 * (ulLength + 1);
+   return SUCCESS;
+}
+
+/*
+  Parses the ulWidth-byte numeric header field at pcField, in octal
+  or in the base-256 form some writers use for large sizes, into
+  *pulValue. Returns SUCCESS, or BAD_PATH if it is malformed.
+*/
+static int Tar_getNumber(const char *pcField, size_t ulWidth,
+                         size_t *pulValue) {
+   size_t ulValue = 0;
+   size_t ulIndex = 0;
+   assert(pcField != NULL);
+   assert(pulValue != NULL);
+   if((unsigned char) pcField[0] & 0x80) {
+      for(ulIndex = 1; ulIndex < ulWidth; ulIndex++) {
+         if(ulValue >> (8 * sizeof(size_t) - 8) != 0)
+            return BAD_PATH;
+         ulValue = (ulValue << 8) | (unsigned char) pcField[ulIndex];
+      }
+      *pulValue = ulValue;
+      return SUCCESS;
+   }
+   while(ulIndex < ulWidth && pcField[ulIndex] == ' ')
+      ulIndex++;
+   for(; ulIndex < ulWidth && pcField[ulIndex] >= '0' &&
+         pcField[ulIndex] <= '7'; ulIndex++)
+      ulValue = (ulValue << 3) | (size_t) (pcField[ulIndex] - '0');
+   if(ulIndex < ulWidth && pcField[ulIndex] != '\0' &&
+      pcField[ulIndex] != ' ')
+      return BAD_PATH;
+   *pulValue = ulValue;
+   return SUCCESS;
+}
+
+/*
+  Reads the ulSize bytes of pax extended records that follow the
+  current header of oRReader's archive, and keeps the path and size
+  they give for the next member. Returns SUCCESS, or otherwise the
+  statuses described for TarReader_next.
+*/
+static int TarReader_pax(TarReader_T oRReader, size_t ulSize) {
+   char *pcRecords;
+   char *pcRecord;
+   char *pcValue;
+   char *pcEnd;
+   size_t ulLength;
+   int iStatus;
+   assert(oRReader != NULL);
+   if(ulSize > PAX_MAX)
+      return BAD_PATH;
+   pcRecords = malloc(ulSize + 1);
+   if(pcRecords == NULL)
+      return MEMORY_ERROR;
+   iStatus = TarReader_get(oRReader, pcRecords, ulSize);
+   if(iStatus == SUCCESS)
+      iStatus = TarReader_get(oRReader, NULL, Tar_padding(ulSize));
+   pcRecords[ulSize] = '\0';
+   /* each record is "length key=value\n" */
+   for(pcRecord = pcRecords;
+       iStatus == SUCCESS && pcRecord < pcRecords + ulSize;
+       pcRecord += ulLength) {
+      ulLength = (size_t) strtoul(pcRecord, &pcEnd, 10);
+      pcValue = strchr(pcEnd, '=');
+      if(ulLength == 0 || *pcEnd != ' ' || pcValue == NULL ||
+         ulLength > (size_t) (pcRecords + ulSize - pcRecord) ||
+         pcValue >= pcRecord + ulLength ||
+         pcRecord[ulLength - 1] != '\n') {
+         iStatus = BAD_PATH;
+         break;
+      }
+      pcValue++;
+      if(!strncmp(pcEnd + 1, "path=", 5)) {
+         iStatus = TarReader_reserve(oRReader, (size_t)
+                                     (pcRecord + ulLength - 1 - pcValue));
+         if(iStatus == SUCCESS) {
+            memcpy(oRReader->pcPath, pcValue,
+                   (size_t) (pcRecord + ulLength - 1 - pcValue));
+            oRReader->pcPath[pcRecord + ulLength - 1 - pcValue] = '\0';
+            oRReader->bLongPath = TRUE;
+         }
+      }
+      else if(!strncmp(pcEnd + 1, "size=", 5)) {
+         oRReader->ulLongSize = (size_t) strtoul(pcValue, NULL, 10);
+         oRReader->bLongSize = TRUE;
+      }
+   }
+   free(pcRecords);
+   return iStatus;
+}
+
+/* see tarFT.h for specification */
+TarReader_T TarReader_new(int iFd) {
+   TarReader_T oRReader;
+   oRReader = malloc(sizeof(struct tarReader));
+   if(oRReader == NULL)
+      return NULL;
+   oRReader->iFd = iFd;
+   oRReader->ulStart = 0;
+   oRReader->ulEnd = 0;
+   oRReader->ulRemaining = 0;
+   oRReader->ulPad = 0;
+   oRReader->pcPath = NULL;
+   oRReader->ulPathCapacity = 0;
+   oRReader->bLongPath = FALSE;
+   oRReader->bLongSize = FALSE;
+   oRReader->ulLongSize = 0;
+   if(TarReader_reserve(oRReader, NAME_LEN + 1 + PREFIX_LEN)
+      != SUCCESS) {
+      free(oRReader);
+      return NULL;
+   }
+   return oRReader;
+}
+
+/* see tarFT.h for specification */
+void TarReader_free(TarReader_T oRReader) {
+   if(oRReader == NULL)
+      return;
+   free(oRReader->pcPath);
+   free(oRReader);
+}
+
+/* see tarFT.h for specification */
+int TarReader_next(TarReader_T oRReader, const char **ppcPath,
+                   size_t *pulLength, boolean *pbIsFile,
+                   size_t *pulSize) {
+   char acHeader[BLOCK];
+   unsigned long ulSum;
+   size_t ulChecksum;
+   size_t ulSize;
+   size_t ulLength;
+   char *pcPath;
+   char cType;
+   int iStatus;
+   assert(oRReader != NULL);
+   assert(ppcPath != NULL);
+   assert(pulLength != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   for(;;) {
+      /* skip the rest of the previous member */
+      iStatus = TarReader_get(oRReader, NULL,
+                              oRReader->ulRemaining + oRReader->ulPad);
+      oRReader->ulRemaining = 0;
+      oRReader->ulPad = 0;
+      if(iStatus != SUCCESS)
+         return iStatus;
+      iStatus = TarReader_get(oRReader, acHeader, BLOCK);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      /* a block of zeros ends the archive */
+      ulSum = Tar_checksum(acHeader);
+      if(ulSum == ' ' * CHKSUM_LEN && acHeader[CHKSUM] == '\0')
+         return NO_SUCH_PATH;
+      if(Tar_getNumber(acHeader + CHKSUM, CHKSUM_LEN, &ulChecksum)
+         != SUCCESS || ulChecksum != ulSum ||
+         Tar_getNumber(acHeader + SIZE, SIZE_LEN, &ulSize) != SUCCESS)
+         return BAD_PATH;
+      cType = acHeader[TYPEFLAG];
+      if(oRReader->bLongSize && cType != 'x' && cType != 'L')
+         ulSize = oRReader->ulLongSize;
+      oRReader->ulRemaining = ulSize;
+      oRReader->ulPad = Tar_padding(ulSize);
+
+      if(cType == 'x') {
+         /* a pax header for the next member */
+         oRReader->ulRemaining = 0;
+         oRReader->ulPad = 0;
+         iStatus = TarReader_pax(oRReader, ulSize);
+         if(iStatus != SUCCESS)
+            return iStatus;
+         continue;
+      }
+      if(cType == 'L') {
+         /* a GNU long name for the next member */
+         iStatus = TarReader_reserve(oRReader, ulSize);
+         if(iStatus == SUCCESS)
+            iStatus = TarReader_read(oRReader, oRReader->pcPath, ulSize);
+         if(iStatus != SUCCESS)
+            return iStatus;
+         oRReader->pcPath[ulSize] = '\0';
+         oRReader->bLongPath = TRUE;
+         continue;
+      }
+      if(cType != '0' && cType != '\0' && cType != '7' && cType != '5') {
+         /* links, devices, global pax headers and so on are skipped,
+            along with anything given for them */
+         oRReader->bLongPath = FALSE;
+         oRReader->bLongSize = FALSE;
+         continue;
+      }
+
+      if(!oRReader->bLongPath) {
+         /* the ustar prefix, if any, then the name */
+         ulLength = 0;
+         if(!memcmp(acHeader + MAGIC, "ustar", 5) &&
+            acHeader[PREFIX] != '\0') {
+            ulLength = strnlen(acHeader + PREFIX, PREFIX_LEN);
+            memcpy(oRReader->pcPath, acHeader + PREFIX, ulLength);
+            oRReader->pcPath[ulLength++] = '/';
+         }
+         memcpy(oRReader->pcPath + ulLength, acHeader + NAME,
+                strnlen(acHeader + NAME, NAME_LEN));
+         ulLength += strnlen(acHeader + NAME, NAME_LEN);
+         oRReader->pcPath[ulLength] = '\0';
+      }
+      oRReader->bLongPath = FALSE;
+      oRReader->bLongSize = FALSE;
+      pcPath = oRReader->pcPath;
+      ulLength = strlen(pcPath);
+      /* old archives mark directories only by a trailing '/' */
+      if(cType != '5' && ulLength != 0 && pcPath[ulLength - 1] == '/')
+         cType = '5';
+      while(ulLength != 0 && pcPath[ulLength - 1] == '/')
+         pcPath[--ulLength] = '\0';
+      while(!strncmp(pcPath, "./", 2)) {
+         pcPath += 2;
+         ulLength -= 2;
+      }
+      /* the archive's own "." */
+      if(ulLength == 0 || !strcmp(pcPath, "."))
+         continue;
+      *ppcPath = pcPath;
+      *pulLength = ulLength;
+      *pbIsFile = (boolean) (cType != '5');
+      *pulSize = cType != '5' ? ulSize : 0;
+      return SUCCESS;
+   }
+}
+
+/* see tarFT.h for specification */
+int TarReader_read(TarReader_T oRReader, void *pvBuf,
+                   size_t ulLength) {
+   int iStatus;
+   assert(oRReader != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+   assert(ulLength <= oRReader->ulRemaining);
+   iStatus = TarReader_get(oRReader, pvBuf, ulLength);
+   if(iStatus == SUCCESS)
+      oRReader->ulRemaining -= ulLength;
+   return iStatus;
+}
@@ -0,0 +1,92 @@
+/*--------------------------------------------------------------------*/
+/* tarFT.h                                                            */
+/*--------------------------------------------------------------------*/
+#ifndef TAR_INCLUDED
+#define TAR_INCLUDED
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A TarWriter_T streams a tar archive (POSIX ustar, with pax extended
+  headers for paths too long for ustar and sizes of 8GB or more) to a
+  file descriptor, through a buffer of fixed size. Members have mode
+  0755 (directories) or 0644 (files), and no owner or time, so that
+  the same hierarchy always makes the same archive.
+*/
+typedef struct tarWriter *TarWriter_T;
+
+/*
+  A TarReader_T streams the members of a tar archive (ustar, pax or
+  the older v7 format) from a file descriptor, through a buffer of
+  fixed size. Only directories and regular files are reported; other
+  kinds of member are skipped.
+*/
+typedef struct tarReader *TarReader_T;
+
+/*
+  Returns a new writer to the file descriptor iFd, or NULL if there
+  is an allocation error.
+*/
+TarWriter_T TarWriter_new(int iFd);
+
+/* Frees oWWriter, without finishing its archive. */
+void TarWriter_free(TarWriter_T oWWriter);
+
+/*
+  Starts a member of oWWriter's archive: a directory, if bIsFile is
+  FALSE, or otherwise a file of ulSize bytes, to be given with
+  TarWriter_write, at the path made up of the ulLength characters at
+  pcPath. Returns SUCCESS, or MEMORY_ERROR if memory could not be
+  allocated or the archive could not be written.
+*/
+int TarWriter_add(TarWriter_T oWWriter, const char *pcPath,
+                  size_t ulLength, boolean bIsFile, size_t ulSize);
+
+/*
+  Writes the next ulLength bytes of the contents of the file member
+  last started in oWWriter's archive. Returns SUCCESS, or MEMORY_ERROR
+  if the archive could not be written.
+*/
+int TarWriter_write(TarWriter_T oWWriter, const void *pvBytes,
+                    size_t ulLength);
+
+/*
+  Ends oWWriter's archive, after the contents of its last member have
+  all been written, and flushes it. Returns SUCCESS, or MEMORY_ERROR
+  if the archive could not be written.
+*/
+int TarWriter_finish(TarWriter_T oWWriter);
+
+/*
+  Returns a new reader from the file descriptor iFd, or NULL if there
+  is an allocation error.
+*/
+TarReader_T TarReader_new(int iFd);
+
+/* Frees oRReader. */
+void TarReader_free(TarReader_T oRReader);
+
+/*
+  Reads the header of the next member of oRReader's archive, skipping
+  whatever is left of the previous member's contents. Stores in
+  *ppcPath and *pulLength its path, without any leading "./" or
+  trailing '/', which stays valid until the next call; in *pbIsFile
+  whether it is a file; and in *pulSize the size of its contents.
+  Returns SUCCESS; or NO_SUCH_PATH at the end of the archive; or
+  otherwise:
+  * BAD_PATH if the archive is malformed
+  * MEMORY_ERROR if memory could not be allocated or the archive could
+                 not be read
+*/
+int TarReader_next(TarReader_T oRReader, const char **ppcPath,
+                   size_t *pulLength, boolean *pbIsFile,
+                   size_t *pulSize);
+
+/*
+  Reads the next ulLength bytes of the contents of the member last
+  returned by TarReader_next into pvBuf. Returns SUCCESS, or otherwise
+  returns the statuses described for TarReader_next.
+*/
+int TarReader_read(TarReader_T oRReader, void *pvBuf,
+                   size_t ulLength);
+#endif
@@ -0,0 +1,128 @@
+/*--------------------------------------------------------------------*/
+/* tar_bench.c                                                        */
+/* Benchmark of streaming an FT to and from a tar archive             */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ft.h"
+
+/* Tree and contents parameters: many small files and a few large */
+enum { NUM_FILES = 50000, FILES_PER_DIR = 100, MIN_SIZE = 16,
+       MAX_SIZE = 8192, NUM_LARGE = 8, LARGE_SIZE = 16 << 20,
+       MAX_PATH_LEN = 64 };
+
+/*
+  Fills the ulLength bytes at pcBuf with random contents, as from a
+  generated or vendored source file.
+*/
+static void TarBench_fill(char *pcBuf, size_t ulLength) {
+   size_t i;
+   assert(pcBuf != NULL);
+   for(i = 0; i < ulLength; i++)
+      pcBuf[i] = (char) ('a' + rand() % 26);
+}
+
+/*
+  Builds the tree in mode eMode, then times writing it to a temporary
+  file as a tar archive and reading that back into an empty FT, and
+  prints the throughput of each in MB/s of archive.
+*/
+static void TarBench_run(enum contentMode eMode, const char *pcName,
+                         char *pcSmall, char *pcLarge) {
+   clock_t tStart;
+   double dWrite, dRead;
+   double dMB;
+   char *pcBefore;
+   char *pcAfter;
+   char acPath[MAX_PATH_LEN];
+   size_t i;
+   FILE *psFile;
+   int iFd;
+
+   if(FT_setContentMode(eMode) != SUCCESS || FT_init() != SUCCESS)
+      exit(EXIT_FAILURE);
+   for(i = 0; i < NUM_FILES; i++) {
+      sprintf(acPath, "bench/d%05lu/f%07lu",
+              (unsigned long) (i / FILES_PER_DIR), (unsigned long) i);
+      if(FT_insertFile(acPath, pcSmall + i % MAX_SIZE,
+                       MIN_SIZE + (size_t) rand()
+                       % (MAX_SIZE - MIN_SIZE + 1)) != SUCCESS)
+         exit(EXIT_FAILURE);
+   }
+   for(i = 0; i < NUM_LARGE; i++) {
+      sprintf(acPath, "bench/large/l%lu", (unsigned long) i);
+      if(FT_insertFile(acPath, pcLarge, LARGE_SIZE) != SUCCESS)
+         exit(EXIT_FAILURE);
+   }
+   pcBefore = FT_toString();
+
+   psFile = tmpfile();
+   if(psFile == NULL || pcBefore == NULL)
+      exit(EXIT_FAILURE);
+   iFd = fileno(psFile);
+   tStart = clock();
+   if(FT_writeTar(iFd) != SUCCESS)
+      exit(EXIT_FAILURE);
+   dWrite = (double) (clock() - tStart) / CLOCKS_PER_SEC;
+   dMB = (double) lseek(iFd, 0, SEEK_CUR) / 1e6;
+   (void) FT_destroy();
+
+   /* read into an owning FT, since borrowed contents can't be */
+   if(FT_setContentMode(eMode == FT_CONTENTS_BORROWED ?
+                        FT_CONTENTS_OWNED : eMode) != SUCCESS ||
+      FT_init() != SUCCESS || lseek(iFd, 0, SEEK_SET) != 0)
+      exit(EXIT_FAILURE);
+   tStart = clock();
+   if(FT_readTar(iFd) != SUCCESS)
+      exit(EXIT_FAILURE);
+   dRead = (double) (clock() - tStart) / CLOCKS_PER_SEC;
+   pcAfter = FT_toString();
+   if(pcAfter == NULL || strcmp(pcBefore, pcAfter) != 0)
+      exit(EXIT_FAILURE);
+
+   printf("%-8s archive %7.1f MB   write %8.1f MB/s   "
+          "read %8.1f MB/s\n", pcName, dMB,
+          dMB / (dWrite > 0 ? dWrite : 1e-9),
+          dMB / (dRead > 0 ? dRead : 1e-9));
+   free(pcBefore);
+   free(pcAfter);
+   fclose(psFile);
+   (void) FT_destroy();
+}
+
+/*
+  Builds a tree of NUM_FILES small files and NUM_LARGE large ones in
+  each content mode, and times its round trip through a tar archive.
+  Returns 0, or EXIT_FAILURE if memory could not be allocated.
+*/
+int main(void) {
+   char *pcSmall;
+   char *pcLarge;
+
+   srand(217);
+   pcSmall = malloc(2 * MAX_SIZE);
+   pcLarge = malloc(LARGE_SIZE);
+   if(pcSmall == NULL || pcLarge == NULL) {
+      fprintf(stderr, "out of memory\n");
+      return EXIT_FAILURE;
+   }
+   TarBench_fill(pcSmall, 2 * MAX_SIZE);
+   TarBench_fill(pcLarge, LARGE_SIZE);
+   printf("tree: %d files of %d..%d bytes, %d of %d MB\n", NUM_FILES,
+          MIN_SIZE, MAX_SIZE, NUM_LARGE, LARGE_SIZE >> 20);
+
+   TarBench_run(FT_CONTENTS_BORROWED, "borrowed", pcSmall, pcLarge);
+   TarBench_run(FT_CONTENTS_OWNED, "owned", pcSmall, pcLarge);
+   TarBench_run(FT_CONTENTS_DEDUP, "dedup", pcSmall, pcLarge);
+
+   free(pcSmall);
+   free(pcLarge);
+   return 0;
+}